@@ -1,553 +1,11378 @@
+// pread, posix_fadvise e afins são POSIX 2008: com -std=c11 a libc só os
+// declara se isto vier antes de qualquer include
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+#endif
 
 // ============================================
 // DEFINIÇÕES E CONSTANTES
 // ============================================
 
-#define TAMANHO_HASH 13  // Tamanho da tabela hash (número primo)
-#define MAX_SUSPEITOS 5
-#define MAX_PISTAS 20
+#define CAPACIDADE_MINIMA_HASH 16    // Capacidade inicial da tabela hash (potência de 2)
+#define CARGA_MAXIMA_NUMERADOR 7     // A tabela cresce acima de 7/8 de ocupação
+#define CARGA_MAXIMA_DENOMINADOR 8
+#define MAX_GRUPO_PERFEITO 64                  // Pistas por grupo do hash perfeito
+#define LIMITE_DESLOCAMENTO_PERFEITO (1u << 20) // Deslocamentos tentados por grupo
+#define TENTATIVAS_HASH_PERFEITO 4             // Vezes que a tabela perfeita pode dobrar
+
+#define GRAU_CADERNO 16                    // Grau mínimo da árvore B do caderno
+#define MAX_PISTAS_NO (2 * GRAU_CADERNO - 1)
+#define ALTURA_MAXIMA_CADERNO 24           // Suficiente para 16^23 pistas
+#define NIVEIS_CADERNO_COMPARTILHADO 24    // Níveis da lista com saltos da equipe (p = 1/2)
+#define ORDEM_PENDENTE UINT64_MAX          // Nó já ligado à lista, ainda sem número de publicação
+
+#define ASSINATURA_CASO "DTVCASO1" // Assinatura do arquivo de caso binário
+#define VERSAO_CASO 5
+#define SEM_INDICE 0xFFFFFFFFu     // Sala, texto ou ID ausente
+#define ASSINATURA_DIARIO "DTVDIAR1" // Assinatura do diário de eventos
+#define VERSAO_DIARIO 1
+#define ASSINATURA_INSTANTANEO "DTVINST1" // Assinatura do instantâneo de sessão
+#define VERSAO_INSTANTANEO 1
+#define EVENTOS_POR_LOTE_SESSAO 32  // Eventos guardados na sessão antes de ir ao diário
+#define TAMANHO_GRUPO_DIARIO (256 * 1024) // Bytes pendentes que forçam a gravação
+#define MAX_PALAVRA_INDICE 32      // Letras guardadas de cada palavra das pistas
+#define PAGINA_BUSCA 10            // Pistas por página na busca do caderno
+#define TAMANHO_CONSULTA 128       // Maior consulta lida do jogador
+#define TAMANHO_PALPITE 3          // Suspeitos exibidos no palpite
+#define SUSPEITOS_NA_DICA 3        // Suspeitos citados na dica de cada saída do menu
+#define PISTAS_PARA_SUSTENTAR 3    // Pistas contra o acusado para sustentar a acusação
+#define MAX_PESO_EVIDENCIA 15      // Maior peso de uma evidência (4 planos de bits)
+#define BYTES_BLOCO_PONTUACAO (32 * 1024) // Trecho da matriz de evidências visitado por todos os cadernos
+
+// O laço de pontuação ganha uma versão com a instrução POPCNT, escolhida na
+// carga do programa se o processador a tiver (GCC com glibc em x86-64). O
+// seletor roda antes do ThreadSanitizer iniciar, então ele fica de fora.
+#if defined(__x86_64__) && defined(__linux__) && defined(__GNUC__) && !defined(__clang__) && \
+    !defined(__SANITIZE_THREAD__)
+#define VERSOES_POPCOUNT __attribute__((target_clones("popcnt", "default")))
+#else
+#define VERSOES_POPCOUNT
+#endif
+
+#define TRABALHADORES_PADRAO 4        // Threads do servidor se não informado
+#define TAMANHO_LINHA_SERVIDOR 256    // Maior comando aceito pelo servidor
+#define TAMANHO_SAIDA_SERVIDOR 4096   // Respostas acumuladas antes de enviar
+#define TAMANHO_LINHA_ANFITRIAO 4096  // Maior linha de jogador aceita pelo anfitrião
+#define EVENTOS_POR_ESPERA_ANFITRIAO 256 // Eventos tratados por chamada a epoll_wait
+#define CAPACIDADE_INICIAL_TELA 8192  // Bytes do buffer de tela antes de crescer
+#define TAMANHO_BLOCO_ENTRADA (64 * 1024) // Bytes pedidos à entrada padrão de uma vez
+#define SEPARADORES_COMANDO " \t,;"   // Separam comandos numa linha do jogador
+#define COMANDO_PASSAGEM 'A'          // Travessia de passagem no diário e no JSON
+
+#define NUM_MARCOS_ROTAS 8            // Marcos de alcance nas mansões com passagens (até 8)
+
+#define BALDES_HISTOGRAMA 48          // Histogramas em potências de 2; o último acumula o resto
+#define INTERVALO_ESTATISTICAS 5      // Segundos entre duas gravações do arquivo de estatísticas
+
+#define SUSPEITOS_SINTETICOS 8        // Suspeitos dos casos gerados
+#define OPERACOES_MINIMAS_BENCH 1000000 // Casos pequenos repetem até este total
+#define SESSOES_BENCH 200000          // Sessões do teste ponta a ponta
+#define BUSCAS_BENCH 1000             // Buscas por prefixo em cada rodada do benchmark
+#define CADERNOS_BENCH 1000           // Cadernos pontuados juntos no benchmark da matriz
+#define PONTUACOES_BENCH 100000       // Cadernos pontuados em cada modo do benchmark da matriz
+#define PISTAS_CADERNO_BENCH 32       // Pistas de cada caderno do benchmark da matriz
+#define COMANDOS_ROTEIRO_BENCH 32     // Comandos por roteiro sintético
+#define ROTAS_BENCH 1000              // Consultas de rota por mansão no benchmark
+#define INSERCOES_EQUIPE_BENCH 65536  // Menor rodada de pistas anotadas pela equipe no benchmark
+#define MAX_THREADS_BENCH_EQUIPE 64   // Mais threads disputando o caderno da equipe
+#define LEITORES_TESTE_EQUIPE 2       // Threads que só fotografam no --testar-equipe
+#define CONFERENCIA_TESTE_EQUIPE 64   // Pistas entre duas conferências de um escritor
+#define ESCADAS_SINTETICAS 8          // 1 em 8 cômodos gerados com corredores tem escada
+
+#define PROFUNDIDADE_MAXIMA_DIVISAO 32 // Subárvores mais fundas nunca são cedidas
+#define CAPACIDADE_INICIAL_TAREFAS 64   // Tarefas por deque antes de crescer
+
+#define PASSEIOS_PADRAO 1000000          // Passeios por perfil se não informado
+#define PASSEIOS_POR_BLOCO 65536         // Passeios que uma thread pega de uma vez
+#define MAX_COMANDOS_SIMULACAO 256       // Comandos por passeio, contando a saída
+
+#define CAPACIDADE_CACHE_SALAS 4096    // Cômodos decodificados no modo sob demanda
+#define CAPACIDADE_MINIMA_CACHE_SALAS 16
+#define MAX_ANTECIPACAO_SALAS 4096     // Maior faixa de netos avisada ao sistema
+#define TAMANHO_JANELA_TEXTOS (64 * 1024) // Leitura do bloco de textos sob demanda
+#define LEITURA_TEXTO_CACHE 64         // Bytes lidos por vez de um nome ou pista
+#define CHAVE_PISTA 0x80000000u        // Marca as pistas entre as chaves da cache
+
+#define TAMANHO_BLOCO_ARENA (64 * 1024) // Bytes reservados por bloco da arena
+#define ALINHAMENTO_ARENA 16
 
 // ============================================
 // ESTRUTURAS DE DADOS
 // ============================================
 
-// Estrutura para um cômodo da mansão (árvore binária)
+// Bloco de memória da arena (os dados seguem o cabeçalho)
+typedef struct BlocoArena {
+    struct BlocoArena *proximo;
+    size_t capacidade;
+    size_t usado;
+    _Alignas(ALINHAMENTO_ARENA) unsigned char dados[];
+} BlocoArena;
+
+// Arena: alocação por incremento de ponteiro, liberada de uma só vez
+typedef struct {
+    BlocoArena *primeiro;
+    BlocoArena *atual;          // Bloco onde ocorre a próxima alocação
+    size_t bytesAlocados;       // Bytes entregues desde o último reinício
+    size_t alocacoes;           // Alocações atendidas desde o último reinício
+    size_t bytesReservados;     // Bytes obtidos do sistema (todos os blocos)
+} Arena;
+
+// Pool de nós de tamanho fixo com lista de nós devolvidos
+typedef struct {
+    Arena *arena;
+    size_t tamanhoNo;
+    void *livres;               // Lista encadeada de nós devolvidos
+    size_t nosAlocados;         // Nós em uso desde o último reinício
+} PoolNos;
+
+// Memória de uma sessão de jogo: uma arena e um pool por tipo de nó
+typedef struct {
+    Arena arena;
+    PoolNos salas;              // Nós Sala
+    PoolNos pistas;             // Nós do caderno de pistas
+} MemoriaSessao;
+
+// Estrutura para um cômodo da mansão (árvore binária com ponteiros), usada
+// só para montar a mansão antes de compilá-la para a forma compacta.
+// O nome não é copiado: aponta para um literal ou para o buffer do arquivo
+// de caso, que devem sobreviver à sala.
 typedef struct Sala {
-    char nome[30];              // Nome do cômodo
-    char pista[100];            // Pista encontrada neste cômodo
+    const char *nome;           // Nome do cômodo
+    uint32_t pista;             // ID da pista deste cômodo (SEM_INDICE se não houver)
+    uint32_t passagens;         // Primeira passagem que sai daqui (SEM_INDICE se nenhuma)
+    uint32_t indice;            // Uso de compilarMansao (SEM_INDICE antes dela)
     struct Sala *esquerda;      // Cômodo à esquerda
     struct Sala *direita;       // Cômodo à direita
 } Sala;
 
-// Estrutura para uma pista (nó da BST)
-typedef struct PistaBST {
-    char descricao[100];        // Descrição da pista
-    struct PistaBST *esquerda;  // Subárvore esquerda
-    struct PistaBST *direita;   // Subárvore direita
-} PistaBST;
-
-// Estrutura para entrada na tabela hash
-typedef struct EntradaHash {
-    char pista[100];            // Chave: descrição da pista
-    char suspeito[30];          // Valor: nome do suspeito
-    struct EntradaHash *proximo; // Encadeamento para colisões
+// Passagem entre cômodos, além das saídas esquerda e direita, antes da
+// compilação: as que saem de uma mesma sala formam uma lista encadeada no
+// vetor de passagens, a partir de Sala.passagens
+typedef struct {
+    struct Sala *destino;
+    uint32_t proxima;           // Próxima passagem com a mesma origem (SEM_INDICE no fim)
+} PassagemSala;
+
+// Cômodo da mansão compacta: apenas os campos usados na navegação
+typedef struct {
+    uint32_t esquerda;          // Índice do cômodo à esquerda ou SEM_INDICE
+    uint32_t direita;           // Índice do cômodo à direita ou SEM_INDICE
+    uint32_t pista;             // ID da pista ou SEM_INDICE
+} NoMansao;
+
+// Mansão compacta, sem ponteiros: cômodos em ordem de largura (o 0 é a
+// entrada e os filhos vêm sempre depois do pai). Os campos quentes ficam em
+// "nos", 12 bytes por cômodo; os nomes, frios, são deslocamentos em
+// "textos". Tudo ocupa um único bloco, ou aponta para o arquivo mapeado.
+// No modo sob demanda os vetores ficam NULL e os cômodos vêm de "cache".
+// As passagens, que fazem da mansão um grafo, ficam em CSR: as da sala i
+// são passagens[inicioPassagens[i]] até passagens[inicioPassagens[i + 1] - 1],
+// em ordem crescente; numa mansão em árvore os dois vetores ficam NULL.
+typedef struct {
+    NoMansao *nos;
+    uint32_t *nomes;            // Índice → deslocamento do nome em "textos"
+    const char *textos;
+    uint32_t numSalas;
+    uint32_t *inicioPassagens;  // numSalas + 1 posições em "passagens"
+    uint32_t *passagens;        // Destino de cada passagem (só de ida; a volta é outra)
+    uint32_t numPassagens;
+    void *bloco;                // Alocação única (NULL se os vetores são do arquivo)
+    struct CacheSalas *cache;   // Cômodos lidos do arquivo sob demanda (ou NULL)
+} Mansao;
+
+// Registro decodificado na cache do modo sob demanda: um cômodo ou uma pista
+typedef struct {
+    uint32_t chave;             // Índice do cômodo, ou CHAVE_PISTA | ID da pista
+    NoMansao no;                // Só nas entradas de cômodo
+    uint32_t suspeito;          // Só nas entradas de pista
+    uint32_t anterior;          // Entrada usada mais recentemente (SEM_INDICE no início)
+    uint32_t seguinte;          // Entrada usada menos recentemente (SEM_INDICE no fim)
+    uint32_t proximoNoBalde;    // Próxima entrada com o mesmo hash
+    char *texto;                // Nome do cômodo ou texto da pista
+    size_t capacidadeTexto;
+} EntradaCacheSalas;
+
+// Cache LRU de cômodos e pistas lidos com pread do arquivo de caso binário.
+// O número de entradas é fixo, então a memória não cresce com o tamanho da
+// mansão; "baldes" leva da chave à entrada, encadeando colisões.
+typedef struct CacheSalas {
+    int fd;
+    uint64_t inicioNos;         // Posições das seções no arquivo
+    uint64_t inicioNomes;
+    uint64_t inicioPistas;
+    uint64_t inicioTextos;
+    uint32_t tamanhoTextos;
+    uint32_t numSalas;
+    uint32_t numPistas;
+    uint32_t numSuspeitos;
+    EntradaCacheSalas *entradas;
+    uint32_t capacidade;
+    uint32_t usadas;
+    uint32_t *baldes;
+    uint32_t mascaraBaldes;
+    uint32_t maisRecente;
+    uint32_t menosRecente;
+    unsigned long long acertos;
+    unsigned long long faltas;
+    unsigned long long antecipadas; // Cômodos lidos antes de serem pedidos
+} CacheSalas;
+
+// Índice de rotas do comando "ir", montado na primeira consulta. Os nomes
+// ficam numa tabela aberta, com os cômodos homônimos encadeados. Numa
+// mansão em árvore basta o pai de cada cômodo: a rota é a subida do destino
+// até a origem. Com passagens, a busca anda em largura pelos dois lados (da
+// origem pelas saídas e dos destinos pelo CSR reverso) e descarta os
+// cômodos que os marcos provam estar fora de qualquer rota: para cada
+// cômodo, uma máscara diz quais marcos o alcançam e quais ele alcança. Os
+// vetores das buscas não são limpos entre consultas: "visitas" guarda o
+// número da busca que tocou cada cômodo.
+typedef struct {
+    uint32_t numSalas;          // 0 enquanto não montado
+    uint32_t *baldesNomes;      // Primeiro cômodo de cada nome (SEM_INDICE: vazio)
+    uint32_t mascaraNomes;
+    uint32_t *mesmoNome;        // Próximo cômodo com o mesmo nome (SEM_INDICE no fim)
+    uint32_t *pais;             // Só em árvores: pai de cada cômodo
+    uint32_t *inicioReverso;    // Só em grafos (como os demais): saídas que chegam a cada cômodo, em CSR
+    uint32_t *reverso;
+    uint16_t *alcances;         // Bit k: o marco k alcança o cômodo; bit NUM_MARCOS_ROTAS + k: o cômodo alcança o marco k
+    uint32_t numMarcos;
+    uint32_t *distancias;       // Passos da origem até cada cômodo tocado pela ida
+    uint32_t *anteriores;       // Cômodo anterior na ida
+    uint32_t *visitas;          // Busca que tocou o cômodo pela ida
+    uint32_t *distanciasVolta;  // Passos de cada cômodo tocado pela volta até o destino
+    uint32_t *seguintes;        // Cômodo seguinte na volta
+    uint32_t *visitasVolta;     // Busca que tocou o cômodo pela volta
+    uint32_t busca;
+    uint32_t *filaIda;          // Cômodos na ordem em que cada lado os tocou
+    uint32_t *filaVolta;
+    uint32_t *caminho;          // Rota da última consulta, sem a origem
+    size_t capacidadeCaminho;
+} IndiceRotas;
+
+// Pistas adiante de cada cômodo, para as dicas do menu. "contagens" guarda,
+// por cômodo e suspeito, quantos cômodos da subárvore (pelas saídas E e D,
+// com o próprio) têm pista contra o suspeito. Cada subárvore é também um
+// intervalo [entrada, saida) da ordem em profundidade, sem que a mansão
+// seja reordenada. Os cômodos cuja pista a sessão já coletou ficam em
+// "coletadas", com a chave (entrada << 32) | cômodo, em ordem crescente: a
+// dica de uma saída desconta só os que caem no intervalo dela.
+typedef struct {
+    uint32_t numSalas;          // 0 se não há dicas (mansão sob demanda)
+    uint32_t numSuspeitos;
+    uint32_t *contagens;        // [sala * numSuspeitos + suspeito]
+    uint32_t *entrada;          // Posição de cada cômodo na ordem em profundidade
+    uint32_t *saida;            // Posição logo depois da sua subárvore
+    uint32_t *inicioOcorrencias; // Cômodos com cada pista, em CSR
+    uint32_t *ocorrencias;
+    uint64_t *coletadas;
+    uint32_t numColetadas;
+    uint32_t capacidadeColetadas;
+    uint32_t *restantes;        // Contagens da última saída consultada, já descontadas
+} PistasAdiante;
+
+// Nó da árvore B do caderno de pistas (várias pistas ordenadas por nó)
+typedef struct NoCaderno {
+    int quantidade;                            // Pistas em uso neste nó
+    int folha;                                 // 1 se não tem filhos
+    uint32_t pistas[MAX_PISTAS_NO];            // IDs das pistas em ordem crescente
+    struct NoCaderno *filhos[MAX_PISTAS_NO + 1];
+} NoCaderno;
+
+// Caderno de pistas coletadas: árvore B balanceada
+typedef struct {
+    NoCaderno *raiz;
+    PoolNos *pool;              // Pool dos nós (memória da sessão)
+    size_t quantidade;          // Total de pistas no caderno
+} CadernoPistas;
+
+// Iterador em ordem do caderno (pilha explícita, sem recursão)
+typedef struct {
+    const NoCaderno *nos[ALTURA_MAXIMA_CADERNO];
+    int indices[ALTURA_MAXIMA_CADERNO];
+    int topo;
+} IteradorCaderno;
+
+// Nó do caderno compartilhado: a pista e um ponteiro por nível, alocados
+// junto com o nó. A pista e a altura não mudam depois da ligação.
+typedef struct NoCompartilhado {
+    uint32_t pista;
+    uint32_t altura;                               // Níveis em que o nó aparece
+    _Atomic uint64_t ordem;                        // Número de publicação ou ORDEM_PENDENTE
+    _Atomic(struct NoCompartilhado *) proximos[];  // Do nível 0 (todas as pistas) para cima
+} NoCompartilhado;
+
+// Ocorrência de uma palavra numa pista coletada (lista por palavra)
+typedef struct OcorrenciaPista {
+    uint32_t pista;
+    struct OcorrenciaPista *proxima;
+} OcorrenciaPista;
+
+// Nó da trie de palavras das pistas coletadas (filhos numa lista de irmãos)
+typedef struct NoIndicePistas {
+    struct NoIndicePistas *filho;
+    struct NoIndicePistas *irmao;
+    OcorrenciaPista *ocorrencias; // Pistas com a palavra que termina neste nó
+    unsigned char letra;
+} NoIndicePistas;
+
+// Índice invertido das pistas coletadas: palavra normalizada → pistas, numa
+// trie para que um prefixo leve direto às palavras que o completam. Os nós
+// vêm da arena da sessão e somem quando ela é reiniciada.
+typedef struct {
+    NoIndicePistas raiz;
+    Arena *arena;
+    size_t numPalavras;         // Palavras distintas
+    size_t numOcorrencias;      // Pares (palavra, pista)
+} IndicePistas;
+
+// Resultado de uma busca: IDs de pistas em ordem alfabética, sem repetição.
+// Os vetores são reaproveitados de uma busca para a outra.
+typedef struct {
+    uint32_t *pistas;
+    size_t quantidade;
+    size_t capacidade;
+    uint32_t *termo;            // Pistas do termo que está sendo intersectado
+    size_t quantidadeTermo;
+    size_t capacidadeTermo;
+} ResultadoBusca;
+
+// Placar de evidências por suspeito, atualizado a cada pista coletada.
+// "ranking" mantém os IDs em ordem decrescente de contagem; suspeitos com a
+// mesma contagem ficam contíguos e "inicioFaixa[c]" guarda a primeira posição
+// da faixa com contagem c, o que torna cada incremento O(1).
+typedef struct {
+    uint32_t *contagens;        // ID do suspeito → pistas coletadas contra ele
+    uint32_t *ranking;          // Posição → ID do suspeito
+    uint32_t *posicao;          // ID do suspeito → posição no ranking
+    uint32_t *inicioFaixa;      // Contagem → primeira posição com essa contagem
+    uint32_t numSuspeitos;
+} PlacarSuspeitos;
+
+// Matriz de evidências: um bitset por suspeito sobre os IDs das pistas, com
+// os pesos decompostos em planos de bits (plano p = bit p do peso). Para cada
+// palavra de 64 pistas e cada plano há uma palavra por suspeito, contíguas,
+// então com a palavra do caderno fixa o laço sobre os suspeitos lê memória
+// seguida. A pontuação é a soma de popcount(caderno & linha) << p.
+typedef struct {
+    uint64_t *bits;             // [palavra][plano][suspeito]
+    uint32_t numPalavras;       // Palavras de 64 pistas
+    uint32_t numPlanos;         // Bits do maior peso (1 se todos valem 1)
+    uint32_t numSuspeitos;
+} MatrizEvidencias;
+
+// Caderno como bitset esparso: só as palavras não vazias, em ordem crescente
+typedef struct {
+    uint32_t *posicoes;         // Índice de cada palavra no bitset completo
+    uint64_t *palavras;
+    uint32_t quantidade;
+    uint32_t capacidade;
+} BitsCaderno;
+
+// Estrutura para entrada na tabela hash (endereçamento aberto)
+typedef struct {
+    uint64_t hash;              // Hash da chave, calculado uma vez (0 = vazia)
+    const char *chave;          // Texto da chave (não é copiado)
+    uint32_t valor;             // ID associado ao texto
 } EntradaHash;
 
-// Estrutura para tabela hash
+// Estrutura para tabela hash: sondagem linear Robin Hood, capacidade
+// potência de 2, cresce automaticamente pelo fator de carga
 typedef struct {
-    EntradaHash *tabela[TAMANHO_HASH]; // Array de listas encadeadas
+    EntradaHash *entradas;      // Vetor de posições
+    size_t capacidade;
+    size_t quantidade;
 } TabelaHash;
 
+// Entrada da tabela de hash perfeito (texto NULL marca posição vazia)
+typedef struct {
+    const char *texto;
+    uint32_t pista;             // ID da pista
+    uint32_t suspeito;          // ID do suspeito ou SEM_INDICE
+} EntradaPerfeita;
+
+// Hash perfeito das pistas de um caso, sem colisões: o hash do texto escolhe
+// um grupo, e o deslocamento do grupo, a posição. Gerado por --gerar-hash
+// como header C e compilado no programa (a carga interna as pistas por ele),
+// ou montado em tempo de execução pelos benchmarks.
+typedef struct {
+    const uint32_t *deslocamentos; // Grupo → deslocamento
+    const EntradaPerfeita *entradas;
+    uint32_t mascaraGrupos;     // Grupos - 1 (potência de 2)
+    uint32_t mascaraPosicoes;   // Posições - 1 (potência de 2)
+    uint32_t numPistas;
+} TabelaPerfeita;
+
+// Tabela de internação: cada texto distinto recebe um ID denso (0, 1, 2...)
+typedef struct {
+    TabelaHash indice;          // Texto → ID
+    const char **textos;        // ID → texto
+    uint32_t quantidade;
+    uint32_t capacidade;
+    int somenteOrdenado;        // 1 se os textos vieram ordenados de um arquivo
+                                // binário e o índice não foi construído
+} Internador;
+
+// Estrutura com todo o cenário de um caso (mansão, associações e suspeitos).
+// Pistas e suspeitos são representados por IDs; o texto só é consultado
+// para exibição.
+typedef struct {
+    Mansao mansao;              // Cômodos compilados (a sala 0 é a entrada)
+    Internador pistas;          // Textos das pistas (IDs em ordem alfabética)
+    Internador suspeitos;       // Nomes dos suspeitos, usados na acusação
+    uint32_t *suspeitoDaPista;  // ID da pista → suspeito principal (ou SEM_INDICE)
+    struct RegistroEvidencia *evidencias; // Evidências detalhadas, por pista e suspeito
+    uint32_t numEvidencias;
+    uint32_t capacidadeEvidencias;
+    uint32_t pontuacaoMaxima;   // Maior soma de pesos contra um mesmo suspeito
+    const TabelaPerfeita *pistasPerfeitas; // Hash perfeito compilado (NULL: índice dinâmico)
+    uint32_t pistasForaDaTabela; // Textos ausentes da tabela perfeita, durante a carga
+    const char **descricoesSuspeitos; // ID do suspeito → texto exibido
+    uint32_t capacidadePistas;  // Capacidade de suspeitoDaPista
+    uint32_t capacidadeSuspeitos; // Capacidade de descricoesSuspeitos
+    int numAssociacoes;
+    const char *introducao;     // Texto exibido ao entrar na mansão (opcional)
+    const char *segredo;        // Revelação exibida ao final (opcional)
+    char *dados;                // Arquivo mapeado ou lido para a memória
+    size_t tamanhoDados;
+    int dadosMapeados;          // 1 se "dados" veio de mmap
+} Caso;
+
+// Formato binário do arquivo de caso (inteiros na ordem de bytes da máquina):
+// cabeçalho, a mansão compacta (vetor de NoMansao, vetor de deslocamentos
+// dos nomes e, se houver passagens, os dois vetores do CSR, exatamente como
+// na memória), registros de pistas e suspeitos,
+// as evidências detalhadas (ordenadas por pista e suspeito) e por fim o
+// bloco de textos terminados em '\0'. Os registros guardam deslocamentos
+// nesse bloco. As pistas já vêm em ordem alfabética e sem repetição: a
+// posição de cada registro é o ID da pista, e salas e pistas referenciam
+// IDs diretamente.
+typedef struct {
+    char assinatura[8];         // ASSINATURA_CASO
+    uint32_t versao;
+    uint32_t numSalas;          // A sala 0 é a entrada da mansão
+    uint32_t numPistas;
+    uint32_t numSuspeitos;
+    uint32_t tamanhoTextos;
+    uint32_t introducao;        // Deslocamento da introdução ou SEM_INDICE
+    uint32_t segredo;           // Deslocamento do segredo ou SEM_INDICE
+    uint32_t numEvidencias;     // Registros de evidência detalhada
+    uint32_t numPassagens;      // Passagens da mansão (0 numa mansão em árvore)
+} CabecalhoCaso;
+
+typedef struct {
+    uint32_t texto;
+    uint32_t suspeito;          // ID do suspeito ou SEM_INDICE
+} RegistroPista;
+
+typedef struct {
+    uint32_t nome;
+    uint32_t descricao;
+} RegistroSuspeito;
+
+// Evidência detalhada: a pista aponta para o suspeito com um peso de 1 a
+// MAX_PESO_EVIDENCIA. Uma pista com evidências detalhadas usa só elas (o
+// suspeito principal está entre elas); as demais valem 1 contra o principal.
+typedef struct RegistroEvidencia {
+    uint32_t pista;
+    uint32_t suspeito;
+    uint32_t peso;
+} RegistroEvidencia;
+
+// Texto a copiar do arquivo no modo sob demanda: posição no bloco de textos
+// do arquivo e o campo que passa a guardar a posição na cópia
+typedef struct {
+    uint32_t origem;
+    uint32_t *destino;
+} PedidoTexto;
+
+// Tipos de evento do diário
+typedef enum {
+    EVENTO_INICIO,              // Sessão começou (ou recomeçou) na entrada
+    EVENTO_COMANDO,             // Comando de exploração e seu efeito
+    EVENTO_ACUSACAO             // Acusação julgada
+} TipoEvento;
+
+// Registro do diário de eventos (12 bytes, na ordem de bytes da máquina).
+// Guarda também o efeito de cada transição, para que a repetição confira
+// que o caso e o programa ainda levam ao mesmo estado.
+typedef struct {
+    uint32_t sessao;            // ID da sessão no diário
+    uint32_t valor;             // Sala após o comando ou suspeito acusado (SEM_INDICE se nenhum)
+    uint8_t tipo;               // TipoEvento
+    uint8_t comando;            // Letra do comando (EVENTO_COMANDO)
+    uint8_t resultado;          // ResultadoComando ou Veredicto
+    uint8_t reservado;
+} RegistroDiario;
+
+// Cabeçalho do diário: identifica o caso a que os IDs se referem
+typedef struct {
+    char assinatura[8];         // ASSINATURA_DIARIO
+    uint32_t versao;
+    uint32_t numSalas;
+    uint32_t numPistas;
+    uint32_t numSuspeitos;
+} CabecalhoDiario;
+
+// Instantâneo de uma sessão: este cabeçalho, um resumo com um bit por
+// palavra não vazia do bitset e o bitset com um bit por ID de pista
+// (palavras de 64 bits, bit i = pista i coletada). Não há textos nem
+// ponteiros: o arquivo pode ser usado direto de um mmap.
+typedef struct {
+    char assinatura[8];         // ASSINATURA_INSTANTANEO
+    uint32_t versao;
+    uint32_t numSalas;          // Quantidades do caso, para conferência
+    uint32_t numPistas;
+    uint32_t numSuspeitos;
+    uint32_t salaAtual;
+    uint32_t estado;            // EstadoSessao
+    uint32_t veredicto;         // Veredicto
+    uint32_t acusado;           // ID do acusado ou SEM_INDICE
+    uint32_t pistasContraAcusado;
+    uint32_t numColetadas;      // Bits ligados no bitset
+} CabecalhoInstantaneo;         // 48 bytes: o resumo começa alinhado a 8
+
+// Estado de uma sessão de jogo, independente de terminal
+typedef enum {
+    SESSAO_EXPLORANDO,          // Aceita comandos de movimento e coleta
+    SESSAO_AGUARDANDO_ACUSACAO, // Saiu da mansão; falta nomear o culpado
+    SESSAO_ENCERRADA            // Veredicto definido
+} EstadoSessao;
+
+// Efeito de um comando aplicado à sessão
+typedef enum {
+    RESULTADO_PISTA_COLETADA,
+    RESULTADO_PISTA_REPETIDA,
+    RESULTADO_SEM_PISTA,
+    RESULTADO_MOVEU,
+    RESULTADO_SEM_CAMINHO,
+    RESULTADO_PALPITE,          // Consulta ao placar, sem mudar o estado
+    RESULTADO_SAIU,
+    RESULTADO_INVALIDO          // Comando desconhecido ou fora de hora
+} ResultadoComando;
+
+// Desfecho do julgamento, do mais fraco ao mais forte
+typedef enum {
+    VEREDICTO_PENDENTE,         // Sessão ainda não julgada
+    VEREDICTO_ARQUIVADO,        // Saiu sem nenhuma pista coletada
+    VEREDICTO_INFUNDADA,
+    VEREDICTO_FRACA,
+    VEREDICTO_PARCIAL,
+    VEREDICTO_SUSTENTADA
+} Veredicto;
+
+// Caderno de uma equipe de detetives (servidor cooperativo): lista com
+// saltos ordenada pelo ID da pista, só com inserções e sem trava. A pista
+// entra no caderno quando o CAS do nível 0 a liga; os níveis de cima são
+// atalhos ligados depois. Logo após a ligação o nó recebe o próximo número
+// de "publicadas", e uma foto tirada com publicadas = N contém exatamente
+// as pistas de número menor que N, em ordem alfabética. O placar da equipe
+// soma os pesos em contadores atômicos.
+typedef struct {
+    NoCompartilhado *cabeca;    // Sentinela com todos os níveis (sem pista)
+    const Caso *caso;
+    _Atomic uint64_t publicadas; // Pistas já numeradas
+    _Atomic uint32_t *pontos;   // ID do suspeito → pontos da equipe
+} CadernoCompartilhado;
+
+// Sessão de jogo: o caso é compartilhado e somente leitura; posição,
+// caderno, placar e memória pertencem à sessão. O caderno guarda um ponteiro
+// para o pool da própria sessão, então a estrutura não pode ser copiada
+// depois de iniciada. No servidor cooperativo, "equipe" aponta para o
+// caderno compartilhado por todas as sessões. Com um diário ligado, os eventos se acumulam em
+// "eventos" e vão ao diário em lotes.
+typedef struct {
+    const Caso *caso;
+    uint32_t salaAtual;         // Índice na mansão compacta
+    EstadoSessao estado;
+    Veredicto veredicto;
+    uint32_t acusado;           // ID do suspeito acusado ou SEM_INDICE
+    uint32_t pistasContraAcusado;
+    CadernoPistas caderno;
+    IndicePistas indice;        // Palavras das pistas do caderno
+    PlacarSuspeitos placar;
+    MemoriaSessao memoria;
+    CadernoCompartilhado *equipe; // Caderno da equipe (NULL: detetive sozinho)
+    struct Diario *diario;      // Diário de eventos (NULL: sem registro)
+    uint32_t idDiario;          // ID da sessão no diário
+    uint32_t numEventos;        // Eventos ainda não entregues ao diário
+    RegistroDiario eventos[EVENTOS_POR_LOTE_SESSAO];
+} Sessao;
+
+// Roteiro do modo em lote: comandos de uma sessão e o nome a acusar
+typedef struct {
+    const char *comandos;
+    size_t numComandos;
+    const char *acusado;
+} Roteiro;
+
+// Modo de saída do jogo interativo
+typedef enum {
+    SAIDA_NORMAL,               // Telas completas, como no terminal
+    SAIDA_JSON,                 // Uma linha JSON por turno, sem menus
+    SAIDA_SILENCIOSA            // Nada é renderizado
+} ModoSaida;
+
+// Tela: buffer reaproveitado em que cada turno é montado antes de ser
+// enviado com uma única escrita
+typedef struct {
+    char *dados;
+    size_t tamanho;
+    size_t capacidade;
+    ModoSaida modo;
+} Tela;
+
+// Entrada do jogo: a entrada padrão lida em blocos de TAMANHO_BLOCO_ENTRADA
+// e entregue linha a linha, sem passar pelo stdio. Uma linha entregue vale
+// até a próxima leitura.
+typedef struct {
+    char *dados;
+    size_t inicio;              // Primeiro byte ainda não entregue
+    size_t fim;                 // Bytes lidos em "dados"
+    size_t capacidade;          // Sem contar o byte reservado para o '\0' final
+    int terminou;               // 1 após o fim da entrada
+} Entrada;
+
+// Etapa de uma partida: o que ela espera na próxima linha do jogador
+typedef enum {
+    ETAPA_COMANDOS,             // Comandos no menu da sala
+    ETAPA_CONSULTA,             // Consulta da busca no caderno (comando B)
+    ETAPA_PAGINA,               // [Enter] para mais pistas da busca; outra linha a encerra
+    ETAPA_ACUSACAO,             // Nome do suspeito, depois de sair da mansão
+    ETAPA_GUARDADA,             // Investigação guardada com G (fim, sem julgamento)
+    ETAPA_ENCERRADA             // Julgamento concluído (fim)
+} EtapaPartida;
+
+// Partida retomável: o que o jogo precisa entre duas linhas do jogador.
+// A partida nunca lê a entrada nem envia a tela; quem a conduz (o terminal
+// ou o anfitrião de sockets) entrega uma linha por vez a avancarPartida, e
+// entre duas linhas ela fica parada na etapa em que estava. Da busca
+// paginada só se guardam a consulta e as pistas já exibidas; busca, rotas e
+// pistas adiante são vetores reaproveitados.
+typedef struct {
+    Sessao *sessao;
+    const char *caminhoInstantaneo; // Arquivo do comando G (NULL: G é inválido)
+    EtapaPartida etapa;
+    unsigned turno;
+    size_t exibidas;            // Pistas da busca já exibidas (ETAPA_PAGINA)
+    char consulta[TAMANHO_CONSULTA];
+    ResultadoBusca busca;
+    IndiceRotas rotas;
+    PistasAdiante adiante;
+} Partida;
+
+// Formato de saída dos benchmarks
+typedef enum {
+    FORMATO_CSV,
+    FORMATO_JSON
+} FormatoBench;
+
+// Destino dos resultados de benchmark (JSON precisa saber se já houve item)
+typedef struct {
+    FormatoBench formato;
+    int resultados;
+} RelatorioBench;
+
+#ifndef _WIN32
+// Thread do benchmark do caderno da equipe: anota a sua fatia das pistas
+// sorteadas no caderno compartilhado ou, com trava, na árvore B e no
+// placar protegidos por uma trava única
+typedef struct {
+    CadernoCompartilhado *equipe;
+    CadernoPistas *caderno;
+    PlacarSuspeitos *placar;
+    const Caso *caso;
+    pthread_mutex_t *trava;     // NULL: caderno da equipe, sem trava
+    const uint32_t *pistas;
+    uint32_t numPistas;
+} InsercoesBench;
+
+// Thread do --testar-equipe: escritores anotam pistas sorteadas da sua
+// semente e conferem que cada uma aparece na foto seguinte; leitores
+// fotografam sem parar até "encerrar" e conferem cada foto com a anterior
+typedef struct {
+    CadernoCompartilhado *equipe;
+    _Atomic int *encerrar;      // Ligado quando todos os escritores terminam
+    uint64_t semente;           // Sorteio das pistas do escritor
+    uint32_t numPistas;         // Pistas a anotar (0: leitor)
+    uint64_t falhas;            // Conferências que falharam
+    uint64_t fotos;             // Fotos conferidas
+} TesteEquipe;
+#endif
+
+// Resumos da mansão compacta para o resolvedor de rotas, indexados como
+// os cômodos. "mascaras" resume a subárvore: bit (s % 64) ligado se algum
+// cômodo dela tem pista contra o suspeito s. "melhores" guarda, por
+// suspeito, (profundidade << 32) | índice do cômodo em que a rota mais
+// curta conhecida coleta a última pista necessária.
+typedef struct {
+    const Caso *caso;
+    const NoMansao *nos;
+    uint32_t numNos;
+    uint32_t *pai;              // SEM_INDICE na entrada
+    uint32_t *profundidade;
+    uint64_t *mascaras;
+    _Atomic uint64_t *melhores;
+    _Atomic long pendentes;     // Tarefas criadas e ainda não concluídas
+    _Atomic int ociosos;        // Buscadores procurando trabalho
+} Resolvedor;
+
+// Deque de tarefas (raízes de subárvores): o dono empilha e retira no fim,
+// buscadores ociosos roubam do início, onde estão as subárvores mais rasas
+typedef struct {
+    uint32_t *itens;
+    size_t inicio;
+    size_t fim;
+    size_t capacidade;
+#ifndef _WIN32
+    pthread_mutex_t trava;
+#endif
+} DequeTarefas;
+
+// Buscador do resolvedor (uma thread): estado do caminho atual e sua deque
+typedef struct BuscadorRota {
+    Resolvedor *resolvedor;
+    int id;
+    int numBuscadores;
+    struct BuscadorRota *vizinhos; // Todos os buscadores, para o roubo
+    uint32_t *ocorrencias;      // ID da pista → vezes em que aparece no caminho
+    uint32_t *contagens;        // ID do suspeito → pistas distintas no caminho
+    uint32_t *maximos;          // ID do suspeito → maior contagem já vista
+    uint64_t *pilha;            // (índice << 1) | 1 marca a saída de um nó
+    size_t capacidadePilha;
+    DequeTarefas tarefas;
+    unsigned long long visitados;
+    unsigned long long roubos;
+#ifndef _WIN32
+    pthread_t thread;
+#endif
+} BuscadorRota;
+
+// Perfis de jogador do simulador
+typedef enum {
+    PERFIL_ALEATORIO,           // Comandos sorteados, acusa qualquer suspeito
+    PERFIL_HEURISTICO,          // Coleta tudo, desce ao acaso, acusa o líder do placar
+    NUM_PERFIS
+} PerfilJogador;
+
+// Resultados de um perfil: veredictos e comandos gastos por passeio
+typedef struct {
+    unsigned long long veredictos[VEREDICTO_SUSTENTADA + 1];
+    unsigned long long comandos[MAX_COMANDOS_SIMULACAO + 1];
+} HistogramaSimulacao;
+
+// Simulação compartilhada: os passeios são divididos em blocos de
+// PASSEIOS_POR_BLOCO, cada um com semente própria, para que o resultado
+// não dependa de quantas threads o executam
+typedef struct {
+    const Caso *caso;
+    unsigned long long numPasseios; // Por perfil
+    uint64_t semente;
+    _Atomic unsigned long long proximoBloco;
+} Simulacao;
+
+// Thread do simulador: sessão e histogramas só dela, somados no final
+typedef struct {
+    Simulacao *simulacao;
+    HistogramaSimulacao *histogramas; // Um por perfil, reservado pela própria thread
+    unsigned long long blocos;
+#ifndef _WIN32
+    pthread_t thread;
+#endif
+} SimuladorJogador;
+
+#ifndef _WIN32
+// Diário de eventos compartilhado pelas sessões. Os lotes das sessões se
+// juntam em "pendentes"; quem precisa gravar vira líder se ninguém estiver
+// gravando, troca os buffers e grava o grupo inteiro com um write (e um
+// fdatasync no modo síncrono), enquanto as demais esperam em "gravado" e
+// continuam entregando eventos no outro buffer.
+typedef struct Diario {
+    int fd;
+    int sincrono;               // 1: a sessão encerrada espera o fdatasync do seu grupo
+    char *pendentes;            // Registros entregues e ainda não gravados
+    size_t usados;
+    size_t capacidade;
+    char *gravacao;             // Buffer do grupo sendo gravado pelo líder
+    size_t capacidadeGravacao;
+    uint64_t entregues;         // Registros entregues desde a abertura
+    uint64_t gravados;          // Registros já gravados no arquivo
+    int gravando;               // 1 enquanto um líder grava um grupo
+    int falhou;                 // 1 após um erro de gravação (avisado uma vez)
+    _Atomic uint32_t proximaSessao;
+    unsigned long long grupos;
+    pthread_mutex_t trava;
+    pthread_cond_t gravado;
+} Diario;
+
+// Conexão do servidor: uma sessão e a linha de comando ainda incompleta.
+// Fica com a thread principal enquanto ociosa e com um trabalhador enquanto
+// há dados a processar, nunca com os dois ao mesmo tempo. O socket não
+// bloqueia: o que o cliente ainda não aceitou fica em "pendente", e a
+// conexão só volta a ser lida depois que isso sair.
+typedef struct {
+    int fd;
+    int fechar;                 // 1 quando o cliente saiu ou houve erro
+    char *pendente;             // Respostas ainda não enviadas (NULL se não há)
+    size_t tamanhoPendente;
+    size_t usados;              // Bytes pendentes em "entrada"
+    char entrada[TAMANHO_LINHA_SERVIDOR];
+    Sessao sessao;
+} Conexao;
+
+// Fila circular de conexões protegida por trava
+typedef struct {
+    Conexao **itens;
+    size_t capacidade;
+    size_t inicio;
+    size_t quantidade;
+    int encerrando;             // Acorda e dispensa os trabalhadores
+    pthread_mutex_t trava;
+    pthread_cond_t temItens;
+} FilaConexoes;
+
+// Servidor de sessões: o caso é compartilhado, somente leitura, por todas
+// as threads; "prontas" leva conexões com dados aos trabalhadores e
+// "devolvidas" as traz de volta, com um byte no pipe de aviso para
+// acordar o poll da thread principal.
+typedef struct {
+    const Caso *caso;
+    FilaConexoes prontas;
+    FilaConexoes devolvidas;
+    int aviso[2];               // Pipe: [0] lido pelo poll, [1] escrito pelos trabalhadores
+    CadernoCompartilhado *equipe; // Caderno da equipe (NULL: sessões independentes)
+} Servidor;
+
+// Thread do pool de trabalhadores
+typedef struct {
+    pthread_t thread;
+    Servidor *servidor;
+    unsigned long long comandos; // Linhas processadas por esta thread
+} Trabalhador;
+
+#ifdef __linux__
+// Partida estacionada no anfitrião enquanto a conexão espera o jogador:
+// só o que não se refaz a partir do caso. Caderno, índice e placar são
+// remontados de "pistas" quando a conexão volta a ter dados, então uma
+// conexão ociosa custa esta estrutura e 4 bytes por pista coletada e por
+// suspeito. Os buffers só existem enquanto têm conteúdo.
+typedef struct {
+    int fd;
+    uint32_t salaAtual;
+    uint32_t turno;
+    uint32_t exibidas;          // Pistas da busca já exibidas (ETAPA_PAGINA)
+    uint32_t numPistas;         // Pistas coletadas (0: "pistas" ausente)
+    uint32_t tamanhoLinha;      // Bytes em "linha"
+    uint32_t tamanhoSaida;      // Bytes em "saida"
+    uint8_t etapa;              // EtapaPartida
+    uint8_t estado;             // EstadoSessao
+    uint8_t fechar;             // 1: fecha a conexão depois de enviar "saida"
+    uint32_t *pistas;           // IDs em ordem crescente, seguidos do ranking do placar
+    char *consulta;             // Consulta da busca paginada (só em ETAPA_PAGINA)
+    char *linha;                // Começo de uma linha ainda incompleta
+    char *saida;                // Resposta que o socket ainda não aceitou
+} PartidaEmEspera;
+
+// Anfitrião de partidas: uma só thread atende todas as conexões com epoll.
+// Há uma única sessão e uma única partida de trabalho, e a conexão com dados
+// tem a sua partida retomada nelas, avança as linhas que chegaram e volta a
+// esperar estacionada. O caso, as rotas e as pistas adiante são montados uma
+// vez e servem a todas as conexões.
+typedef struct {
+    const Caso *caso;
+    int epoll;
+    int escuta;
+    int aceitando;              // 0 enquanto faltam descritores para novas conexões
+    Sessao sessao;
+    Partida partida;
+    Tela tela;
+    PartidaEmEspera *ativa;     // Conexão cuja partida está na sessão de trabalho
+    PartidaEmEspera **porDescritor; // Conexões abertas, pelo descritor do socket
+    size_t capacidadeDescritores;
+    char *leitura;              // Linha incompleta seguida do bloco recebido
+    size_t abertas;
+    size_t picoAbertas;
+    unsigned long long partidas;
+    unsigned long long linhas;
+    unsigned long long retomadas; // Sessões remontadas para outra conexão
+} Anfitriao;
+#endif
+#endif
+
+// Histograma em potências de 2: o balde i conta os valores em (2^(i-1), 2^i]
+// e o balde 0 conta 0 e 1. Os contadores são atômicos relaxados: as threads
+// do servidor somam sem trava e a exportação lê uma foto aproximada.
+typedef struct {
+    _Atomic uint64_t baldes[BALDES_HISTOGRAMA];
+    _Atomic uint64_t soma;
+} HistogramaEstatistica;
+
+// Estatísticas de execução (--estatisticas). Desligadas, cada ponto de
+// medição custa apenas o teste de "ligadas".
+typedef struct {
+    int ligadas;                               // Fixado antes de criar qualquer thread
+    HistogramaEstatistica sondagensHash;       // Posições visitadas por busca de texto
+    HistogramaEstatistica profundidadeCaderno; // Nós da árvore B visitados por inserção
+    HistogramaEstatistica comparacoesCaderno;  // Comparações de IDs por inserção
+    HistogramaEstatistica alocacoesSessao;     // Alocações na arena por sessão
+    HistogramaEstatistica bytesSessao;         // Bytes alocados na arena por sessão
+    HistogramaEstatistica latenciaComando;     // Nanossegundos por comando (jogo e servidor)
+    _Atomic uint64_t veredictos[VEREDICTO_SUSTENTADA + 1];
+} Estatisticas;
+
+static Estatisticas estatisticas;
+
+#ifndef _WIN32
+// Exportador das estatísticas: uma thread que regrava um arquivo a cada
+// INTERVALO_ESTATISTICAS segundos ou responde cada conexão de um socket
+// Unix com uma foto
+typedef struct {
+    const char *destino;        // Arquivo ou caminho do socket
+    int prometheus;             // 1: formato de texto do Prometheus; 0: JSON
+    int escuta;                 // Socket de escuta (-1: grava em arquivo)
+    int aviso[2];               // Pipe que acorda a thread para encerrar
+    double inicio;              // agoraEmSegundos() ao ligar
+    pthread_t thread;
+} ExportadorEstatisticas;
+#endif
+
+// Hash perfeito de um caso, gerado por --gerar-hash
+#ifdef CASO_HASH_PERFEITO
+#include CASO_HASH_PERFEITO
+#endif
+
 // ============================================
 // PROTÓTIPOS DAS FUNÇÕES
 // ============================================
 
-// Funções para a mansão (árvore binária)
-Sala* criarSala(const char* nome, const char* pista);
-void construirMansao(Sala** raiz);
-void explorarMansao(Sala* salaAtual, PistaBST** raizPistas, TabelaHash* tabela);
-void liberarMansao(Sala* raiz);
+// Funções para arena e pools de nós
+void inicializarArena(Arena* arena);
+void* alocarNaArena(Arena* arena, size_t tamanho);
+void reiniciarArena(Arena* arena);
+void liberarArena(Arena* arena);
+void inicializarPool(PoolNos* pool, Arena* arena, size_t tamanhoNo);
+void* alocarNo(PoolNos* pool);
+void liberarNo(PoolNos* pool, void* no);
+void inicializarMemoriaSessao(MemoriaSessao* memoria);
+void reiniciarMemoriaSessao(MemoriaSessao* memoria);
+void liberarMemoriaSessao(MemoriaSessao* memoria);
+void exibirMemoriaSessao(Tela* tela, const MemoriaSessao* memoria);
+
+// Funções de saída
+void inicializarTela(Tela* tela, ModoSaida modo);
+void escreverTela(Tela* tela, const char* formato, ...);
+void escreverJsonTexto(Tela* tela, const char* texto);
+void descarregarTela(Tela* tela);
+void liberarTela(Tela* tela);
+void renderizarSala(Tela* tela, const Sessao* sessao, PistasAdiante* adiante);
+void renderizarResultado(Tela* tela, const Sessao* sessao, uint32_t salaAnterior,
+                         char comando, ResultadoComando resultado);
+void renderizarTurnoJson(Tela* tela, const Sessao* sessao, unsigned turno, char comando,
+                         ResultadoComando resultado);
+
+// Funções de entrada (linhas de comandos do jogador)
+void inicializarEntrada(Entrada* entrada);
+char* lerLinhaEntrada(Entrada* entrada);
+int linhaPronta(const Entrada* entrada);
+char* restoDaLinha(char* resto);
+void liberarEntrada(Entrada* entrada);
+
+// Funções para a mansão (árvore binária e forma compacta)
+Sala* criarSala(PoolNos* pool, const char* nome, uint32_t pista);
+void construirMansao(Caso* caso);
+char* reservarMansao(Mansao* mansao, uint32_t numSalas, uint32_t numPassagens,
+                     size_t tamanhoTextos);
+int compilarMansao(Mansao* mansao, Sala* raiz, uint32_t maxSalas, const PassagemSala* passagens);
+const char* nomeSala(const Mansao* mansao, uint32_t sala);
+const NoMansao* salaDaMansao(const Mansao* mansao, uint32_t sala);
+uint32_t passagensDaSala(const Mansao* mansao, uint32_t sala, const uint32_t** destinos);
+int temPassagem(const Mansao* mansao, uint32_t origem, uint32_t destino);
+const char* textoPista(const Caso* caso, uint32_t pista);
+uint32_t suspeitoDePista(const Caso* caso, uint32_t pista);
+void anteciparFilhos(const Mansao* mansao, uint32_t sala);
+void liberarMansao(Mansao* mansao);
+int irParaSala(Sessao* sessao, Tela* tela, IndiceRotas* rotas, const char* nome, unsigned* turno);
+void executarLinha(Partida* partida, Tela* tela, char* linha);
 
-// Funções para árvore BST de pistas
-PistaBST* criarNoPista(const char* descricao);
-PistaBST* inserirPista(PistaBST* raiz, const char* descricao);
-void listarPistasOrdenadas(PistaBST* raiz);
-void liberarPistas(PistaBST* raiz);
+// Funções da partida retomável (uma linha do jogador por vez)
+void inicializarPartida(Partida* partida, Sessao* sessao, const char* caminhoInstantaneo, int dicas);
+void comecarPartida(Partida* partida, Tela* tela);
+void avancarPartida(Partida* partida, Tela* tela, char* linha);
+int partidaConcluida(const Partida* partida);
+int jogarPartida(Sessao* sessao, Tela* tela, Entrada* entrada, const char* caminhoInstantaneo);
+void liberarPartida(Partida* partida);
+
+// Funções de rotas do comando "ir" (nomes, subida na árvore e busca pelos dois lados)
+void inicializarIndiceRotas(IndiceRotas* indice);
+void montarIndiceRotas(IndiceRotas* indice, const Mansao* mansao);
+void medirMarco(IndiceRotas* indice, const Mansao* mansao, uint32_t marco, uint32_t k, int chegada);
+uint32_t procurarSalaPorNome(const IndiceRotas* indice, const Mansao* mansao, const char* nome);
+long buscarRotaArvore(IndiceRotas* indice, uint32_t origem, uint32_t primeiroAlvo);
+long buscarRotaNoGrafo(IndiceRotas* indice, const Mansao* mansao, uint32_t origem,
+                       uint32_t primeiroAlvo);
+long calcularRota(IndiceRotas* indice, const Mansao* mansao, uint32_t origem, const char* nome);
+void liberarIndiceRotas(IndiceRotas* indice);
+
+// Funções das pistas adiante (dicas das saídas no menu)
+void montarPistasAdiante(PistasAdiante* adiante, const Sessao* sessao);
+void recolherPistasAdiante(PistasAdiante* adiante, const CadernoPistas* caderno);
+void descontarPistaAdiante(PistasAdiante* adiante, uint32_t pista);
+const uint32_t* contarPistasAdiante(PistasAdiante* adiante, const Caso* caso, uint32_t sala);
+void escreverDicaAdiante(Tela* tela, PistasAdiante* adiante, const Caso* caso, uint32_t sala);
+void liberarPistasAdiante(PistasAdiante* adiante);
+
+// Funções para a mansão sob demanda (cache LRU de cômodos)
+#ifndef _WIN32
+int lerNoArquivo(int fd, void* destino, size_t tamanho, uint64_t posicao);
+CacheSalas* criarCacheSalas(int fd, const CabecalhoCaso* cabecalho, uint32_t capacidade);
+uint32_t procurarNaCache(const CacheSalas* cache, uint32_t chave);
+void usarEntradaCache(CacheSalas* cache, uint32_t entrada);
+uint32_t reservarEntradaCache(CacheSalas* cache, uint32_t chave);
+void lerTextoDaEntrada(CacheSalas* cache, EntradaCacheSalas* entrada, uint32_t deslocamento);
+void carregarSalasNaCache(CacheSalas* cache, uint32_t primeira, uint32_t quantidade);
+EntradaCacheSalas* obterSalaDaCache(CacheSalas* cache, uint32_t sala);
+EntradaCacheSalas* obterPistaDaCache(CacheSalas* cache, uint32_t pista);
+void exibirCacheSalas(Tela* tela, const CacheSalas* cache);
+void liberarCacheSalas(CacheSalas* cache);
+#endif
+
+// Funções para o caderno de pistas (árvore B)
+void inicializarCaderno(CadernoPistas* caderno, PoolNos* pool);
+NoCaderno* criarNoCaderno(CadernoPistas* caderno, int folha);
+int posicaoNoCaderno(const NoCaderno* no, uint32_t pista, int* encontrada);
+void dividirFilhoCaderno(CadernoPistas* caderno, NoCaderno* pai, int i);
+void juntarFilhosCaderno(CadernoPistas* caderno, NoCaderno* pai, int i);
+int reforcarFilhoCaderno(CadernoPistas* caderno, NoCaderno* pai, int i);
+int buscarPista(const CadernoPistas* caderno, uint32_t pista);
+int inserirPista(CadernoPistas* caderno, uint32_t pista);
+int removerPista(CadernoPistas* caderno, uint32_t pista);
+void iniciarIteradorCaderno(IteradorCaderno* iterador, const CadernoPistas* caderno);
+int proximaPistaCaderno(IteradorCaderno* iterador, uint32_t* pista);
+void listarPistasOrdenadas(Tela* tela, const CadernoPistas* caderno, const Caso* caso);
+
+// Funções do caderno compartilhado da equipe (lista com saltos sem trava)
+void inicializarCadernoCompartilhado(CadernoCompartilhado* caderno, const Caso* caso);
+uint32_t alturaNoCompartilhado(uint32_t pista);
+NoCompartilhado* criarNoCompartilhado(uint32_t pista, uint32_t altura);
+void procurarNoCompartilhado(const CadernoCompartilhado* caderno, uint32_t pista,
+                             NoCompartilhado** antecessores, NoCompartilhado** sucessores);
+uint64_t esperarOrdemCompartilhada(NoCompartilhado* no);
+int inserirNoCompartilhado(CadernoCompartilhado* caderno, uint32_t pista);
+uint32_t* fotografarCadernoCompartilhado(const CadernoCompartilhado* caderno, size_t* quantidade);
+void listarPistasCompartilhadas(Tela* tela, const CadernoCompartilhado* caderno);
+void liberarCadernoCompartilhado(CadernoCompartilhado* caderno);
+
+// Funções do índice de palavras das pistas
+size_t proximaPalavra(const char** cursor, char* palavra);
+void inicializarIndicePistas(IndicePistas* indice, Arena* arena);
+void indexarPista(IndicePistas* indice, const char* texto, uint32_t pista);
+void coletarOcorrencias(const NoIndicePistas* no, ResultadoBusca* resultado);
+size_t buscarPistas(const IndicePistas* indice, const char* consulta, ResultadoBusca* resultado);
+void inicializarResultadoBusca(ResultadoBusca* resultado);
+void liberarResultadoBusca(ResultadoBusca* resultado);
+int compararIds(const void* a, const void* b);
 
 // Funções para tabela hash
-unsigned int hash(const char* chave);
+uint64_t hash(const char* chave);
 void inicializarHash(TabelaHash* tabela);
-void inserirNaHash(TabelaHash* tabela, const char* pista, const char* suspeito);
-const char* encontrarSuspeito(TabelaHash* tabela, const char* pista);
+void redimensionarHash(TabelaHash* tabela, size_t capacidade);
+void reservarHash(TabelaHash* tabela, size_t quantidade);
+void inserirEntradaHash(TabelaHash* tabela, EntradaHash entrada);
+void inserirNaHash(TabelaHash* tabela, const char* chave, uint32_t valor);
+const EntradaHash* procurarNaHash(const TabelaHash* tabela, const char* chave, uint64_t valorHash);
+uint32_t buscarNaHash(const TabelaHash* tabela, const char* chave);
 void liberarHash(TabelaHash* tabela);
 
+// Funções para hash perfeito
+uint32_t posicaoPerfeita(uint64_t valorHash, uint32_t deslocamento, uint32_t mascara);
+const EntradaPerfeita* procurarNaTabelaPerfeita(const TabelaPerfeita* tabela, const char* texto);
+int construirTabelaPerfeita(TabelaPerfeita* tabela, const Caso* caso);
+void liberarTabelaPerfeita(TabelaPerfeita* tabela);
+void escreverLiteralC(FILE* arquivo, const char* texto);
+int gerarHashPerfeito(const Caso* caso, const char* origem, const char* caminho);
+const TabelaPerfeita* tabelaPerfeitaCompilada(void);
+void prepararCargaPerfeita(Caso* caso, const TabelaPerfeita* tabela);
+uint32_t internarPistaPerfeita(Caso* caso, const char* texto);
+int conferirTabelaPerfeita(const Caso* caso, const TabelaPerfeita* tabela, int textosConferidos);
+void associarTabelaPerfeita(Caso* caso);
+
+// Funções para internação de textos
+void inicializarInternador(Internador* internador);
+void reservarInternador(Internador* internador, uint32_t quantidade);
+uint32_t internarTexto(Internador* internador, const char* texto);
+uint32_t buscarIdTexto(const Internador* internador, const char* texto);
+void liberarInternador(Internador* internador);
+
 // Funções de jogo
-void coletarPista(Sala* sala, PistaBST** raizPistas, TabelaHash* tabela);
-int contarPistasPorSuspeito(TabelaHash* tabela, const char* suspeito, PistaBST* raizPistas);
-void verificarSuspeitoFinal(TabelaHash* tabela, PistaBST* raizPistas);
+ResultadoComando coletarPista(Sessao* sessao);
+int anotarPista(Sessao* sessao, uint32_t pista);
+void pesquisarCaderno(Partida* partida, Tela* tela, const char* consulta);
+void mostrarPaginaBusca(Partida* partida, Tela* tela);
+const char* encontrarSuspeito(const Caso* caso, const char* pista);
+void iniciarJulgamento(Partida* partida, Tela* tela);
+void concluirJulgamento(Partida* partida, Tela* tela, const char* linha);
+void escreverVeredictoJson(Tela* tela, const Sessao* sessao);
+
+// Funções de sessão (máquina de estados, sem entrada e saída)
+void iniciarSessao(Sessao* sessao, const Caso* caso);
+void reiniciarSessao(Sessao* sessao);
+void liberarSessao(Sessao* sessao);
+ResultadoComando aplicarComando(Sessao* sessao, char comando);
+ResultadoComando atravessarPassagem(Sessao* sessao, uint32_t destino);
+Veredicto acusarSuspeito(Sessao* sessao, const char* nome);
+Veredicto classificarEvidencias(uint32_t pistas);
+const char* nomeVeredicto(Veredicto veredicto);
+const char* nomeResultado(ResultadoComando resultado);
+
+// Funções do diário de eventos
+void registrarEvento(Sessao* sessao, TipoEvento tipo, uint8_t comando, uint8_t resultado,
+                     uint32_t valor);
+void descarregarEventos(Sessao* sessao, int confirmar);
+int repetirEvento(Sessao* sessao, const RegistroDiario* registro);
+int compararChavesCrescente(const void* a, const void* b);
+int repetirDiario(const Caso* caso, const char* caminho, long sessaoEscolhida);
+
+// Funções de instantâneos de sessão
+size_t tamanhoInstantaneo(const Caso* caso);
+int conferirInstantaneo(const Caso* caso, const void* dados, size_t tamanho);
+void gravarInstantaneo(const Sessao* sessao, void* destino);
+int restaurarInstantaneo(Sessao* sessao, const void* dados, size_t tamanho);
+int salvarInstantaneo(const Sessao* sessao, const char* caminho);
+int carregarInstantaneo(Sessao* sessao, const char* caminho);
+int compararChavesDecrescente(const void* a, const void* b);
+int executarHipoteses(const Caso* caso, char** caminhos, int numCaminhos);
+#ifndef _WIN32
+int abrirDiario(Diario* diario, const char* caminho, const Caso* caso, int sincrono);
+uint64_t entregarAoDiario(Diario* diario, const RegistroDiario* registros, uint32_t quantidade);
+void confirmarDiario(Diario* diario, uint64_t posicao);
+void fecharDiario(Diario* diario);
+void ligarDiario(Sessao* sessao, Diario* diario);
+#endif
+
+// Funções do modo em lote
+Roteiro* lerRoteiros(char* dados, size_t* numRoteiros);
+Veredicto executarRoteiro(Sessao* sessao, const Roteiro* roteiro);
+int executarLote(const Caso* caso, const char* caminho, long repeticoes, struct Diario* diario);
+
+// Funções do servidor de sessões
+size_t responderLinha(Sessao* sessao, char* linha, char* resposta, size_t capacidade);
+#ifndef _WIN32
+void inicializarFila(FilaConexoes* fila);
+void empurrarFila(FilaConexoes* fila, Conexao* conexao);
+Conexao* retirarFila(FilaConexoes* fila, int esperar);
+void liberarFila(FilaConexoes* fila);
+int escreverTudo(int fd, const char* dados, size_t tamanho);
+int enviarParaConexao(Conexao* conexao, const char* dados, size_t tamanho);
+int continuarEnvioConexao(Conexao* conexao);
+void atenderConexao(Trabalhador* trabalhador, Conexao* conexao);
+void* executarTrabalhador(void* argumento);
+void fecharConexao(Conexao* conexao);
+void pedirEncerramento(int sinal);
+int executarServidor(const Caso* caso, const char* caminho, int numTrabalhadores, Diario* diario,
+                     int cooperativo);
+#endif
+
+// Funções do anfitrião de partidas
+#ifdef __linux__
+void retomarPartida(Anfitriao* anfitriao, PartidaEmEspera* espera);
+void suspenderPartida(Anfitriao* anfitriao, PartidaEmEspera* espera);
+int vigiarConexao(Anfitriao* anfitriao, PartidaEmEspera* espera);
+int enviarResposta(Anfitriao* anfitriao, PartidaEmEspera* espera);
+int continuarEnvio(Anfitriao* anfitriao, PartidaEmEspera* espera);
+int atenderPartida(Anfitriao* anfitriao, PartidaEmEspera* espera);
+void receberConexoes(Anfitriao* anfitriao);
+void fecharPartidaEmEspera(Anfitriao* anfitriao, PartidaEmEspera* espera);
+int executarAnfitriao(const Caso* caso, const char* caminho, ModoSaida modo);
+#endif
+
+// Funções de estatísticas de execução
+void registrarEmHistograma(HistogramaEstatistica* histograma, uint64_t valor);
+void registrarMemoriaDaSessao(const MemoriaSessao* memoria);
+void medirInsercaoCaderno(const CadernoPistas* caderno, uint32_t pista);
+void escreverHistograma(Tela* tela, int prometheus, const char* nome, const char* ajuda,
+                        const HistogramaEstatistica* histograma);
+void montarEstatisticas(Tela* tela, int prometheus, double segundos);
+#ifndef _WIN32
+int gravarEstatisticas(const char* caminho, Tela* tela);
+void* executarExportador(void* argumento);
+int ligarEstatisticas(const char* destino);
+void desligarEstatisticas(void);
+#endif
+
+// Funções de benchmark e casos sintéticos
+uint64_t proximoAleatorio(uint64_t* estado);
+void gerarCasoSintetico(Caso* caso, uint32_t numSalas, uint64_t semente, int corredores);
+int salvarCasoTexto(const Caso* caso, const char* caminho);
+void embaralharIds(uint32_t* ids, uint32_t quantidade, uint64_t* estado);
+Sala** criarArvoreDePonteiros(const Mansao* mansao, uint64_t* estado);
+void medirMansao(RelatorioBench* relatorio, const Caso* caso, uint64_t semente);
+void medirRotas(RelatorioBench* relatorio, const Caso* caso, uint64_t semente);
+void medirPistasAdiante(RelatorioBench* relatorio, const Caso* caso, uint64_t semente);
+#ifndef _WIN32
+void* executarInsercoesBench(void* argumento);
+void medirCadernoCompartilhado(RelatorioBench* relatorio, const Caso* caso, uint64_t semente);
+void* executarTesteEquipe(void* argumento);
+int testarCadernoCompartilhado(uint32_t numSalas, int numEscritores, uint32_t pistasPorEscritor);
+#endif
+void registrarResultadoBench(RelatorioBench* relatorio, const char* teste, uint32_t tamanho,
+                             uint64_t operacoes, double segundos);
+void medirCaso(RelatorioBench* relatorio, const Caso* caso, uint64_t semente);
+int executarBench(FormatoBench formato, const uint32_t* tamanhos, int numTamanhos);
+
+// Funções do resolvedor de rotas
+void prepararResolvedor(Resolvedor* resolvedor, const Caso* caso);
+void liberarResolvedor(Resolvedor* resolvedor);
+void inicializarDeque(DequeTarefas* deque);
+void empurrarTarefa(DequeTarefas* deque, uint32_t no);
+int retirarTarefa(DequeTarefas* deque, uint32_t* no);
+int roubarTarefa(DequeTarefas* deque, uint32_t* no);
+void liberarDeque(DequeTarefas* deque);
+void entrarNoCaminho(BuscadorRota* buscador, uint32_t no, int registrar);
+void sairDoCaminho(BuscadorRota* buscador, uint32_t no);
+int subarvorePromissora(const BuscadorRota* buscador, uint32_t no);
+void explorarTarefa(BuscadorRota* buscador, uint32_t raiz);
+void* executarBuscador(void* argumento);
+size_t montarRota(const Resolvedor* resolvedor, uint32_t suspeito, char* rota);
+int conferirRota(const Caso* caso, uint32_t suspeito, const char* rota);
+int resolverCaso(const Caso* caso, int numBuscadores);
+
+// Funções do simulador de jogadores
+uint64_t sementeDoBloco(uint64_t semente, unsigned long long bloco);
+uint32_t sortearAte(uint64_t* estado, uint32_t limite);
+Veredicto simularPasseio(Sessao* sessao, PerfilJogador perfil, uint64_t* estado,
+                         uint32_t* comandos);
+void* executarSimulador(void* argumento);
+void exibirHistograma(const HistogramaSimulacao* histograma, const char* perfil);
+int simularJogadores(const Caso* caso, unsigned long long numPasseios, int numThreads,
+                     uint64_t semente);
+
+// Funções para o placar de evidências
+void inicializarPlacar(PlacarSuspeitos* placar, uint32_t numSuspeitos, uint32_t pontuacaoMaxima,
+                       Arena* arena);
+void registrarEvidencia(PlacarSuspeitos* placar, uint32_t suspeito, uint32_t peso);
+uint32_t pistasContraSuspeito(const PlacarSuspeitos* placar, uint32_t suspeito);
+uint32_t suspeitoNaPosicao(const PlacarSuspeitos* placar, uint32_t posicao);
+void restaurarRankingPlacar(PlacarSuspeitos* placar, const uint32_t* ranking);
+void exibirPalpite(Tela* tela, const PlacarSuspeitos* placar, const Caso* caso, uint32_t k);
+
+// Funções para a matriz de evidências
+uint32_t buscarEvidencias(const Caso* caso, uint32_t pista, uint32_t* fim);
+void registrarEvidenciasDaPista(PlacarSuspeitos* placar, const Caso* caso, uint32_t pista);
+int compararEvidencias(const void* a, const void* b);
+void calcularPontuacaoMaxima(Caso* caso, uint32_t* totais);
+void concluirEvidencias(Caso* caso);
+void montarMatrizEvidencias(const Caso* caso, MatrizEvidencias* matriz);
+void liberarMatrizEvidencias(MatrizEvidencias* matriz);
+void inicializarBitsCaderno(BitsCaderno* caderno);
+void acrescentarPalavraCaderno(BitsCaderno* caderno, uint32_t posicao, uint64_t palavra);
+void montarBitsCaderno(BitsCaderno* caderno, const uint32_t* pistas, uint32_t quantidade);
+void liberarBitsCaderno(BitsCaderno* caderno);
+void pontuarCadernos(const MatrizEvidencias* matriz, const BitsCaderno* cadernos,
+                     uint32_t numCadernos, uint32_t* pontuacoes);
+
+// Funções para arquivos de caso
+void construirCasoPadrao(Caso* caso);
+int montarCasoPadrao(Caso* caso, const TabelaPerfeita* tabela);
+uint32_t internarPista(Caso* caso, const char* texto);
+uint32_t internarSuspeito(Caso* caso, const char* nome);
+void associarPista(Caso* caso, const char* pista, const char* suspeito);
+const char* associarEvidencias(Caso* caso, const char* pista, char* lista);
+void declararSuspeito(Caso* caso, const char* nome, const char* descricao);
+int compararTextos(const void* a, const void* b);
+void ordenarPistasDoCaso(Caso* caso);
+int concluirPistasDoCaso(Caso* caso);
+int carregarCaso(Caso* caso, const char* caminho);
+int carregarCasoTexto(Caso* caso, const char* caminho, const TabelaPerfeita* tabela);
+int carregarCasoBinario(Caso* caso, const char* caminho);
+const char* conferirCabecalhoCaso(const CabecalhoCaso* cabecalho, uint64_t tamanhoArquivo);
+uint64_t bytesMansaoNoArquivo(const CabecalhoCaso* cabecalho);
+const char* conferirPassagens(const uint32_t* inicio, const uint32_t* passagens, uint32_t numSalas,
+                              uint32_t numPassagens);
+const char* registrarSuspeitos(Caso* caso, const RegistroSuspeito* regSuspeitos,
+                              uint32_t numSuspeitos, const char* textos, uint32_t tamanhoTextos);
+const char* registrarPistas(Caso* caso, const RegistroPista* regPistas, uint32_t numPistas,
+                            const char* textos, uint32_t tamanhoTextos);
+const char* registrarEvidencias(Caso* caso, const RegistroEvidencia* registros,
+                                uint32_t numEvidencias);
+int compararPedidosTexto(const void* a, const void* b);
+#ifndef _WIN32
+const char* copiarTextosDoArquivo(int fd, uint64_t inicioTextos, uint32_t tamanhoTextos,
+                                  PedidoTexto* pedidos, size_t numPedidos, char** bloco,
+                                  size_t* tamanho);
+#endif
+int carregarCasoSobDemanda(Caso* caso, const char* caminho, uint32_t capacidadeCache);
+int salvarCasoBinario(const Caso* caso, const char* caminho);
+void liberarCaso(Caso* caso);
+char* proximoCampo(char** cursor);
+long lerIndiceSala(const char* campo, long numSalas);
+uint32_t acrescentarTexto(char** bloco, size_t* tamanho, size_t* capacidade,
+                          const char* texto);
 
 // Funções auxiliares
-void limparBuffer();
-void exibirTitulo();
-void exibirInstrucoes();
+int mesmoNomeSemCaixa(const char* a, const char* b);
+void exibirTitulo(Tela* tela);
+void exibirInstrucoes(Tela* tela);
 void toLowerString(char* str);
+double agoraEmSegundos();
+uint64_t agoraEmNanossegundos();
+char* lerArquivo(const char* caminho, size_t* tamanho);
+char* mapearArquivo(const char* caminho, size_t* tamanho, int* mapeado);
+void desmapearArquivo(char* dados, size_t tamanho, int mapeado);
 
 // ============================================
 // IMPLEMENTAÇÃO DAS FUNÇÕES
 // ============================================
 
-// ========== FUNÇÕES PARA A MANSÃO ==========
+// ========== FUNÇÕES PARA ARENA E POOLS ==========
 
 /**
- * @brief Cria dinamicamente um novo cômodo da mansão
- * @param nome Nome do cômodo
- * @param pista Pista associada ao cômodo
- * @return Ponteiro para a sala criada
+ * @brief Inicializa uma arena vazia (nenhum bloco é reservado até o 1º uso)
+ * @param arena Arena a ser inicializada
  */
-Sala* criarSala(const char* nome, const char* pista) {
-    Sala* novaSala = (Sala*)malloc(sizeof(Sala));
-    if (novaSala == NULL) {
-        printf("Erro de alocação de memória!\n");
-        exit(1);
+void inicializarArena(Arena* arena) {
+    arena->primeiro = NULL;
+    arena->atual = NULL;
+    arena->bytesAlocados = 0;
+    arena->alocacoes = 0;
+    arena->bytesReservados = 0;
+}
+
+/**
+ * @brief Aloca memória alinhada da arena por incremento de ponteiro
+ * @param arena Arena de origem
+ * @param tamanho Quantidade de bytes
+ * @return Ponteiro para a memória (nunca NULL)
+ */
+void* alocarNaArena(Arena* arena, size_t tamanho) {
+    tamanho = (tamanho + ALINHAMENTO_ARENA - 1) & ~(size_t)(ALINHAMENTO_ARENA - 1);
+
+    // Procura espaço no bloco atual ou nos blocos já reservados à frente
+    // (depois de um reinício, os blocos antigos são reaproveitados em ordem)
+    while (arena->atual != NULL &&
+           arena->atual->usado + tamanho > arena->atual->capacidade) {
+        if (arena->atual->proximo == NULL) break;
+        arena->atual = arena->atual->proximo;
+        arena->atual->usado = 0;
     }
-    
-    strcpy(novaSala->nome, nome);
-    strcpy(novaSala->pista, pista);
-    novaSala->esquerda = NULL;
-    novaSala->direita = NULL;
-    
-    return novaSala;
+
+    if (arena->atual == NULL || arena->atual->usado + tamanho > arena->atual->capacidade) {
+        size_t capacidade = TAMANHO_BLOCO_ARENA;
+        if (tamanho > capacidade) capacidade = tamanho;
+
+        BlocoArena* bloco = (BlocoArena*)malloc(sizeof(BlocoArena) + capacidade);
+        if (bloco == NULL) {
+            printf("Erro de alocação de memória!\n");
+            exit(1);
+        }
+        bloco->capacidade = capacidade;
+        bloco->usado = 0;
+        bloco->proximo = NULL;
+        arena->bytesReservados += capacidade;
+
+        // Encadeia depois do bloco atual, preservando os blocos à frente
+        if (arena->atual == NULL) {
+            bloco->proximo = arena->primeiro;
+            arena->primeiro = bloco;
+        } else {
+            bloco->proximo = arena->atual->proximo;
+            arena->atual->proximo = bloco;
+        }
+        arena->atual = bloco;
+    }
+
+    void* memoria = arena->atual->dados + arena->atual->usado;
+    arena->atual->usado += tamanho;
+    arena->bytesAlocados += tamanho;
+    arena->alocacoes++;
+    return memoria;
 }
 
 /**
- * @brief Constrói a mansão com cômodos e pistas pré-definidas
- * @param raiz Ponteiro para a raiz da árvore da mansão
+ * @brief Descarta tudo o que foi alocado na arena, mantendo os blocos
+ *        reservados para a próxima sessão (custo O(1))
+ * @param arena Arena a ser reiniciada
  */
-void construirMansao(Sala** raiz) {
-    // Criação dos cômodos com suas pistas
-    *raiz = criarSala("Entrada", 
-        "Uma carta rasgada com a assinatura 'A' parcialmente visível");
-    
-    (*raiz)->esquerda = criarSala("Biblioteca", 
-        "Um livro sobre venenos com a página 13 marcada");
-    (*raiz)->direita = criarSala("Sala de Estar", 
-        "Um copo quebrado com resíduos de um líquido roxo");
-    
-    (*raiz)->esquerda->esquerda = criarSala("Escritório", 
-        "Extrato bancário mostrando uma grande transferência para 'Carlos'");
-    (*raiz)->esquerda->direita = criarSala("Jardim de Inverno", 
-        "Uma luva de jardinagem manchada de terra vermelha");
-    
-    (*raiz)->direita->esquerda = criarSala("Cozinha", 
-        "Uma faca de chef ausente do estojo");
-    (*raiz)->direita->direita = criarSala("Quarto Principal", 
-        "Um diário com a entrada do dia do crime apagada");
-    
-    (*raiz)->esquerda->esquerda->esquerda = criarSala("Porão", 
-        "Uma caixa com documentos antigos sobre herança familiar");
-    (*raiz)->esquerda->esquerda->direita = criarSala("Varanda", 
-        "Pegadas de sapato masculino tamanho 42 na lama");
-    
-    printf("✅ Mansão construída com 10 cômodos misteriosos!\n");
+void reiniciarArena(Arena* arena) {
+    arena->atual = arena->primeiro;
+    if (arena->atual != NULL) arena->atual->usado = 0;
+    arena->bytesAlocados = 0;
+    arena->alocacoes = 0;
 }
 
 /**
- * @brief Explora a mansão de forma interativa
- * @param salaAtual Cômodo atual do jogador
- * @param raizPistas Raiz da árvore BST de pistas
- * @param tabela Tabela hash de associações pista-suspeito
+ * @brief Devolve ao sistema todos os blocos da arena
+ * @param arena Arena a ser liberada
  */
-void explorarMansao(Sala* salaAtual, PistaBST** raizPistas, TabelaHash* tabela) {
-    char escolha;
-    
-    do {
-        printf("\n══════════════════════════════════════════════════════\n");
-        printf("📍 VOCÊ ESTÁ NA/NO: %s\n", salaAtual->nome);
-        printf("══════════════════════════════════════════════════════\n");
-        
-        printf("\nPistas nesta sala:\n");
-        printf("🔍 %s\n", salaAtual->pista);
-        
-        printf("\nO que deseja fazer?\n");
-        printf("[C] Coletar esta pista\n");
-        
-        if (salaAtual->esquerda != NULL) {
-            printf("[E] Ir para %s (esquerda)\n", salaAtual->esquerda->nome);
-        }
-        
-        if (salaAtual->direita != NULL) {
-            printf("[D] Ir para %s (direita)\n", salaAtual->direita->nome);
+void liberarArena(Arena* arena) {
+    BlocoArena* bloco = arena->primeiro;
+    while (bloco != NULL) {
+        BlocoArena* proximo = bloco->proximo;
+        free(bloco);
+        bloco = proximo;
+    }
+    inicializarArena(arena);
+}
+
+/**
+ * @brief Inicializa um pool de nós de tamanho fixo sobre uma arena
+ * @param pool Pool a ser inicializado
+ * @param arena Arena de onde os nós são retirados
+ * @param tamanhoNo Tamanho de cada nó em bytes
+ */
+void inicializarPool(PoolNos* pool, Arena* arena, size_t tamanhoNo) {
+    pool->arena = arena;
+    pool->tamanhoNo = tamanhoNo < sizeof(void*) ? sizeof(void*) : tamanhoNo;
+    pool->livres = NULL;
+    pool->nosAlocados = 0;
+}
+
+/**
+ * @brief Retira um nó do pool (reaproveita nós devolvidos antes de usar a arena)
+ * @param pool Pool de origem
+ * @return Ponteiro para o nó (nunca NULL)
+ */
+void* alocarNo(PoolNos* pool) {
+    void* no = pool->livres;
+    if (no != NULL) {
+        pool->livres = *(void**)no;
+    } else {
+        no = alocarNaArena(pool->arena, pool->tamanhoNo);
+    }
+    pool->nosAlocados++;
+    return no;
+}
+
+/**
+ * @brief Devolve um nó ao pool para reaproveitamento
+ * @param pool Pool de origem do nó
+ * @param no Nó a ser devolvido
+ */
+void liberarNo(PoolNos* pool, void* no) {
+    *(void**)no = pool->livres;
+    pool->livres = no;
+    pool->nosAlocados--;
+}
+
+/**
+ * @brief Inicializa a arena da sessão e os pools de cada tipo de nó
+ * @param memoria Memória da sessão
+ */
+void inicializarMemoriaSessao(MemoriaSessao* memoria) {
+    inicializarArena(&memoria->arena);
+    inicializarPool(&memoria->salas, &memoria->arena, sizeof(Sala));
+    inicializarPool(&memoria->pistas, &memoria->arena, sizeof(NoCaderno));
+}
+
+/**
+ * @brief Encerra a sessão: todas as salas e pistas alocadas nela
+ *        são descartadas de uma vez, sem percorrer as estruturas
+ * @param memoria Memória da sessão
+ */
+void reiniciarMemoriaSessao(MemoriaSessao* memoria) {
+    reiniciarArena(&memoria->arena);
+    inicializarPool(&memoria->salas, &memoria->arena, sizeof(Sala));
+    inicializarPool(&memoria->pistas, &memoria->arena, sizeof(NoCaderno));
+}
+
+/**
+ * @brief Libera definitivamente a memória da sessão
+ * @param memoria Memória da sessão
+ */
+void liberarMemoriaSessao(MemoriaSessao* memoria) {
+    liberarArena(&memoria->arena);
+    inicializarMemoriaSessao(memoria);
+}
+
+/**
+ * @brief Exibe os contadores de alocação da sessão
+ * @param tela Tela de saída
+ * @param memoria Memória da sessão
+ */
+void exibirMemoriaSessao(Tela* tela, const MemoriaSessao* memoria) {
+    escreverTela(tela, "📊 Memória da sessão: %zu salas, %zu nós do caderno "
+                 "(%zu bytes alocados, %zu reservados)\n",
+                 memoria->salas.nosAlocados, memoria->pistas.nosAlocados,
+                 memoria->arena.bytesAlocados, memoria->arena.bytesReservados);
+}
+
+// ========== FUNÇÕES DE SAÍDA (TELA) ==========
+
+/**
+ * @brief Prepara uma tela vazia no modo de saída escolhido
+ * @param tela Tela a ser inicializada
+ * @param modo Normal, JSON ou silencioso
+ */
+void inicializarTela(Tela* tela, ModoSaida modo) {
+    tela->dados = NULL;
+    tela->tamanho = 0;
+    tela->capacidade = 0;
+    tela->modo = modo;
+}
+
+/**
+ * @brief Acrescenta texto formatado ao buffer da tela (nada no modo silencioso)
+ * @param tela Tela de saída
+ * @param formato Formato no estilo printf
+ */
+void escreverTela(Tela* tela, const char* formato, ...) {
+    if (tela->modo == SAIDA_SILENCIOSA) return;
+
+    va_list argumentos;
+    for (;;) {
+        size_t livre = tela->capacidade - tela->tamanho;
+        va_start(argumentos, formato);
+        int escritos = vsnprintf(tela->dados ? tela->dados + tela->tamanho : NULL,
+                                 livre, formato, argumentos);
+        va_end(argumentos);
+        if (escritos < 0) return;
+        if ((size_t)escritos < livre) {
+            tela->tamanho += (size_t)escritos;
+            return;
         }
-        
-        printf("[S] Sair da mansão e acusar suspeito\n");
-        printf("\nEscolha: ");
-        
-        scanf(" %c", &escolha);
-        limparBuffer();
-        escolha = toupper(escolha);
-        
-        switch (escolha) {
-            case 'C':
-                coletarPista(salaAtual, raizPistas, tabela);
-                break;
-                
-            case 'E':
-                if (salaAtual->esquerda != NULL) {
-                    salaAtual = salaAtual->esquerda;
-                } else {
-                    printf("❌ Não há cômodo à esquerda!\n");
-                }
-                break;
-                
-            case 'D':
-                if (salaAtual->direita != NULL) {
-                    salaAtual = salaAtual->direita;
-                } else {
-                    printf("❌ Não há cômodo à direita!\n");
-                }
-                break;
-                
-            case 'S':
-                printf("\n🚪 Saindo da mansão...\n");
-                return;
-                
-            default:
-                printf("❌ Opção inválida! Use C, E, D ou S.\n");
+
+        // Não coube: cresce e formata de novo
+        size_t capacidade = tela->capacidade ? tela->capacidade : CAPACIDADE_INICIAL_TELA;
+        while (capacidade - tela->tamanho <= (size_t)escritos) capacidade *= 2;
+        tela->dados = (char*)realloc(tela->dados, capacidade);
+        if (tela->dados == NULL) {
+            printf("Erro de alocação de memória!\n");
+            exit(1);
         }
-        
-    } while (1);
+        tela->capacidade = capacidade;
+    }
 }
 
 /**
- * @brief Libera a memória alocada para a mansão
- * @param raiz Raiz da árvore da mansão
+ * @brief Escreve um texto como string JSON (entre aspas, com escapes)
+ * @param tela Tela de saída
+ * @param texto Texto a escrever (NULL vira null)
  */
-void liberarMansao(Sala* raiz) {
-    if (raiz == NULL) return;
-    
-    liberarMansao(raiz->esquerda);
-    liberarMansao(raiz->direita);
-    free(raiz);
+void escreverJsonTexto(Tela* tela, const char* texto) {
+    if (texto == NULL) {
+        escreverTela(tela, "null");
+        return;
+    }
+    escreverTela(tela, "\"");
+    const char* inicio = texto;
+    for (const char* c = texto; ; c++) {
+        unsigned char atual = (unsigned char)*c;
+        if (atual != '\0' && atual != '"' && atual != '\\' && atual >= 0x20) continue;
+
+        // Copia o trecho sem escapes de uma vez
+        if (c > inicio) escreverTela(tela, "%.*s", (int)(c - inicio), inicio);
+        if (atual == '\0') break;
+        if (atual == '"' || atual == '\\') escreverTela(tela, "\\%c", atual);
+        else escreverTela(tela, "\\u%04x", atual);
+        inicio = c + 1;
+    }
+    escreverTela(tela, "\"");
 }
 
-// ========== FUNÇÕES PARA ÁRVORE BST DE PISTAS ==========
+/**
+ * @brief Envia o conteúdo acumulado com uma única escrita e esvazia a tela
+ * @param tela Tela de saída
+ */
+void descarregarTela(Tela* tela) {
+    if (tela->tamanho == 0) return;
+    fflush(stdout); // Mantém a ordem com eventuais printf anteriores
+#ifndef _WIN32
+    escreverTudo(STDOUT_FILENO, tela->dados, tela->tamanho);
+#else
+    fwrite(tela->dados, 1, tela->tamanho, stdout);
+    fflush(stdout);
+#endif
+    tela->tamanho = 0;
+}
+
+/**
+ * @brief Libera o buffer da tela
+ * @param tela Tela de saída
+ */
+void liberarTela(Tela* tela) {
+    free(tela->dados);
+    inicializarTela(tela, tela->modo);
+}
+
+/**
+ * @brief Monta a tela de um cômodo: pista visível, menu e pedido de escolha
+ * @param tela Tela de saída
+ * @param sessao Sessão em andamento
+ * @param adiante Pistas adiante, para a dica de cada saída (NULL: sem dicas)
+ */
+void renderizarSala(Tela* tela, const Sessao* sessao, PistasAdiante* adiante) {
+    const Mansao* mansao = &sessao->caso->mansao;
+    const NoMansao* salaAtual = salaDaMansao(mansao, sessao->salaAtual);
+    escreverTela(tela, "\n══════════════════════════════════════════════════════\n");
+    escreverTela(tela, "📍 VOCÊ ESTÁ NA/NO: %s\n", nomeSala(mansao, sessao->salaAtual));
+    escreverTela(tela, "══════════════════════════════════════════════════════\n");
+    
+    escreverTela(tela, "\nPistas nesta sala:\n");
+    if (salaAtual->pista != SEM_INDICE) {
+        escreverTela(tela, "🔍 %s\n", textoPista(sessao->caso, salaAtual->pista));
+    } else {
+        escreverTela(tela, "🔍 (nenhuma pista à vista)\n");
+    }
+    
+    escreverTela(tela, "\nO que deseja fazer?\n");
+    escreverTela(tela, "[C] Coletar esta pista\n");
+    
+    int dicas = adiante != NULL && adiante->numSalas > 0;
+    if (salaAtual->esquerda != SEM_INDICE) {
+        escreverTela(tela, "[E] Ir para %s (esquerda)\n", nomeSala(mansao, salaAtual->esquerda));
+        if (dicas) escreverDicaAdiante(tela, adiante, sessao->caso, salaAtual->esquerda);
+    }
+    
+    if (salaAtual->direita != SEM_INDICE) {
+        escreverTela(tela, "[D] Ir para %s (direita)\n", nomeSala(mansao, salaAtual->direita));
+        if (dicas) escreverDicaAdiante(tela, adiante, sessao->caso, salaAtual->direita);
+    }
+    
+    const uint32_t* destinos;
+    uint32_t numDestinos = passagensDaSala(mansao, sessao->salaAtual, &destinos);
+    for (uint32_t i = 0; i < numDestinos; i++) {
+        escreverTela(tela, "[ir %s] Atravessar a passagem\n", nomeSala(mansao, destinos[i]));
+    }
+    
+    escreverTela(tela, "[P] Pedir um palpite sobre o culpado\n");
+    if (sessao->caderno.quantidade > 0) {
+        escreverTela(tela, "[B] Buscar nas pistas coletadas\n");
+    }
+    escreverTela(tela, "[S] Sair da mansão e acusar suspeito\n");
+    escreverTela(tela, "\nEscolha: ");
+}
+
+/**
+ * @brief Narra o efeito de um comando no modo normal
+ * @param tela Tela de saída
+ * @param sessao Sessão após o comando
+ * @param salaAnterior Índice da sala em que o comando foi dado
+ * @param comando Letra do comando
+ * @param resultado Efeito devolvido por aplicarComando
+ */
+void renderizarResultado(Tela* tela, const Sessao* sessao, uint32_t salaAnterior,
+                         char comando, ResultadoComando resultado) {
+    const Caso* caso = sessao->caso;
+    uint32_t pistaAnterior = salaDaMansao(&caso->mansao, salaAnterior)->pista;
+    switch (resultado) {
+        case RESULTADO_PISTA_COLETADA:
+            escreverTela(tela, "\n🔎 COLETANDO PISTA...\n");
+            escreverTela(tela, "Pista coletada: %s\n", textoPista(caso, pistaAnterior));
+            escreverTela(tela, "✅ Pista adicionada ao seu caderno de investigação!\n");
+            escreverTela(tela, "Pistas coletadas até agora: %zu\n", sessao->caderno.quantidade);
+            break;
+            
+        case RESULTADO_PISTA_REPETIDA:
+            escreverTela(tela, "\n🔎 COLETANDO PISTA...\n");
+            escreverTela(tela, "Pista coletada: %s\n", textoPista(caso, pistaAnterior));
+            escreverTela(tela, "⚠️  Pista já coletada!\n");
+            break;
+            
+        case RESULTADO_SEM_PISTA:
+            escreverTela(tela, "\n🔎 COLETANDO PISTA...\n");
+            escreverTela(tela, "❌ Não há pista neste cômodo!\n");
+            break;
+            
+        case RESULTADO_MOVEU:
+            break;
+            
+        case RESULTADO_SEM_CAMINHO:
+            escreverTela(tela, "❌ Não há cômodo à %s!\n", comando == 'E' ? "esquerda" : "direita");
+            break;
+            
+        case RESULTADO_PALPITE:
+            exibirPalpite(tela, &sessao->placar, caso, TAMANHO_PALPITE);
+            break;
+            
+        case RESULTADO_SAIU:
+            escreverTela(tela, "\n🚪 Saindo da mansão...\n");
+            break;
+            
+        default:
+            escreverTela(tela, "❌ Opção inválida! Use C, E, D, P ou S.\n");
+    }
+}
+
+/**
+ * @brief Emite um turno como uma linha JSON (modo de máquina)
+ *
+ * O turno 0 descreve apenas a sala inicial; os demais trazem também o
+ * comando, o resultado e, para palpites, o ranking de suspeitos.
+ *
+ * @param tela Tela de saída
+ * @param sessao Sessão após o comando
+ * @param turno Número do turno
+ * @param comando Letra do comando (0 no turno inicial)
+ * @param resultado Efeito devolvido por aplicarComando
+ */
+void renderizarTurnoJson(Tela* tela, const Sessao* sessao, unsigned turno, char comando,
+                         ResultadoComando resultado) {
+    const Caso* caso = sessao->caso;
+    const Mansao* mansao = &caso->mansao;
+    const NoMansao* sala = salaDaMansao(mansao, sessao->salaAtual);
+    
+    escreverTela(tela, "{\"turno\":%u", turno);
+    if (comando != 0) {
+        escreverTela(tela, ",\"comando\":\"%c\",\"resultado\":\"%s\"",
+                     isprint((unsigned char)comando) && comando != '"' && comando != '\\'
+                         ? comando : '?',
+                     nomeResultado(resultado));
+    }
+    escreverTela(tela, ",\"sala\":");
+    escreverJsonTexto(tela, nomeSala(mansao, sessao->salaAtual));
+    escreverTela(tela, ",\"pista\":");
+    escreverJsonTexto(tela, sala->pista != SEM_INDICE ? textoPista(caso, sala->pista) : NULL);
+    escreverTela(tela, ",\"esquerda\":");
+    escreverJsonTexto(tela, sala->esquerda != SEM_INDICE ? nomeSala(mansao, sala->esquerda) : NULL);
+    escreverTela(tela, ",\"direita\":");
+    escreverJsonTexto(tela, sala->direita != SEM_INDICE ? nomeSala(mansao, sala->direita) : NULL);
+    const uint32_t* destinos;
+    uint32_t numDestinos = passagensDaSala(mansao, sessao->salaAtual, &destinos);
+    if (numDestinos > 0) {
+        escreverTela(tela, ",\"passagens\":[");
+        for (uint32_t i = 0; i < numDestinos; i++) {
+            if (i > 0) escreverTela(tela, ",");
+            escreverJsonTexto(tela, nomeSala(mansao, destinos[i]));
+        }
+        escreverTela(tela, "]");
+    }
+    escreverTela(tela, ",\"pistas\":%zu", sessao->caderno.quantidade);
+    
+    if (resultado == RESULTADO_PALPITE && comando != 0) {
+        escreverTela(tela, ",\"palpite\":[");
+        for (uint32_t i = 0; i < TAMANHO_PALPITE; i++) {
+            uint32_t suspeito = suspeitoNaPosicao(&sessao->placar, i);
+            if (suspeito == SEM_INDICE || pistasContraSuspeito(&sessao->placar, suspeito) == 0) break;
+            escreverTela(tela, "%s{\"suspeito\":", i ? "," : "");
+            escreverJsonTexto(tela, caso->suspeitos.textos[suspeito]);
+            escreverTela(tela, ",\"pistas\":%u}", pistasContraSuspeito(&sessao->placar, suspeito));
+        }
+        escreverTela(tela, "]");
+    }
+    escreverTela(tela, "}\n");
+}
+
+// ========== FUNÇÕES DE ENTRADA ==========
+
+/**
+ * @brief Prepara a leitura da entrada padrão (nada é lido ainda)
+ * @param entrada Entrada a ser inicializada
+ */
+void inicializarEntrada(Entrada* entrada) {
+    entrada->dados = NULL;
+    entrada->inicio = 0;
+    entrada->fim = 0;
+    entrada->capacidade = 0;
+    entrada->terminou = 0;
+}
+
+/**
+ * @brief Entrega a próxima linha, sem o '\n' (e sem '\r' final)
+ *
+ * Lê um bloco inteiro de uma vez: com a entrada num pipe, uma única leitura
+ * traz centenas de linhas. A última linha pode não ter '\n'.
+ *
+ * @param entrada Entrada do jogo
+ * @return Linha terminada em '\0', válida até a próxima leitura, ou NULL no fim
+ */
+char* lerLinhaEntrada(Entrada* entrada) {
+    for (;;) {
+        char* inicio = entrada->dados + entrada->inicio;
+        size_t pendentes = entrada->fim - entrada->inicio;
+        char* quebra = pendentes > 0 ? (char*)memchr(inicio, '\n', pendentes) : NULL;
+        if (quebra != NULL || (entrada->terminou && pendentes > 0)) {
+            char* fimLinha = quebra != NULL ? quebra : inicio + pendentes;
+            entrada->inicio += (size_t)(fimLinha - inicio) + (quebra != NULL);
+            if (fimLinha > inicio && fimLinha[-1] == '\r') fimLinha--;
+            *fimLinha = '\0';
+            return inicio;
+        }
+        if (entrada->terminou) return NULL;
+        
+        // Sem linha completa: o trecho pendente vai para o início e lê-se mais
+        if (entrada->inicio > 0) memmove(entrada->dados, inicio, pendentes);
+        entrada->inicio = 0;
+        entrada->fim = pendentes;
+        if (entrada->fim == entrada->capacidade) {
+            size_t capacidade = entrada->capacidade ? entrada->capacidade * 2 : TAMANHO_BLOCO_ENTRADA;
+            entrada->dados = (char*)realloc(entrada->dados, capacidade + 1);
+            if (entrada->dados == NULL) {
+                printf("Erro de alocação de memória!\n");
+                exit(1);
+            }
+            entrada->capacidade = capacidade;
+        }
+        size_t livre = entrada->capacidade - entrada->fim;
+#ifndef _WIN32
+        ssize_t lidos = read(STDIN_FILENO, entrada->dados + entrada->fim, livre);
+        if (lidos < 0 && errno == EINTR) continue;
+        if (lidos <= 0) entrada->terminou = 1;
+        else entrada->fim += (size_t)lidos;
+#else
+        if (fgets(entrada->dados + entrada->fim, (int)livre + 1, stdin) == NULL) entrada->terminou = 1;
+        else entrada->fim += strlen(entrada->dados + entrada->fim);
+#endif
+    }
+}
+
+/**
+ * @brief Diz se a próxima linha já está no buffer (lê-la não bloqueia)
+ * @param entrada Entrada do jogo
+ * @return 1 se há uma linha completa (ou o fim da entrada) à espera
+ */
+int linhaPronta(const Entrada* entrada) {
+    size_t pendentes = entrada->fim - entrada->inicio;
+    return entrada->terminou ||
+           (pendentes > 0 && memchr(entrada->dados + entrada->inicio, '\n', pendentes) != NULL);
+}
+
+/**
+ * @brief Resto de uma linha depois de um comando, usado como resposta
+ *        (espaços e um ';' no começo são ignorados)
+ * @param resto Trecho da linha depois do comando
+ * @return Começo da resposta ("" se o resto é vazio)
+ */
+char* restoDaLinha(char* resto) {
+    resto += strspn(resto, " \t");
+    if (*resto == ';') resto += 1 + strspn(resto + 1, " \t");
+    return resto;
+}
+
+/**
+ * @brief Libera o buffer da entrada
+ * @param entrada Entrada do jogo
+ */
+void liberarEntrada(Entrada* entrada) {
+    free(entrada->dados);
+    inicializarEntrada(entrada);
+}
+
+// ========== FUNÇÕES PARA A MANSÃO ==========
+
+/**
+ * @brief Cria um novo cômodo da mansão a partir do pool de salas
+ * @param pool Pool de salas da sessão
+ * @param nome Nome do cômodo (não é copiado; deve sobreviver à sala)
+ * @param pista ID da pista associada ao cômodo
+ * @return Ponteiro para a sala criada
+ */
+Sala* criarSala(PoolNos* pool, const char* nome, uint32_t pista) {
+    Sala* novaSala = (Sala*)alocarNo(pool);
+    
+    novaSala->nome = nome;
+    novaSala->pista = pista;
+    novaSala->passagens = SEM_INDICE;
+    novaSala->indice = SEM_INDICE;
+    novaSala->esquerda = NULL;
+    novaSala->direita = NULL;
+    
+    return novaSala;
+}
+
+/**
+ * @brief Constrói a mansão com cômodos e pistas pré-definidas
+ *
+ * A árvore de ponteiros é montada numa memória temporária e compilada para
+ * a forma compacta do caso, descartando-se em seguida.
+ *
+ * @param caso Caso embutido (recebe a mansão compacta e as pistas internadas)
+ */
+void construirMansao(Caso* caso) {
+    MemoriaSessao memoria;
+    inicializarMemoriaSessao(&memoria);
+    PoolNos* pool = &memoria.salas;
+    Sala* entrada = NULL;
+    Sala** raiz = &entrada;
+    
+    // Criação dos cômodos com suas pistas
+    *raiz = criarSala(pool, "Entrada", 
+        internarPista(caso, "Uma carta rasgada com a assinatura 'A' parcialmente visível"));
+    
+    (*raiz)->esquerda = criarSala(pool, "Biblioteca", 
+        internarPista(caso, "Um livro sobre venenos com a página 13 marcada"));
+    (*raiz)->direita = criarSala(pool, "Sala de Estar", 
+        internarPista(caso, "Um copo quebrado com resíduos de um líquido roxo"));
+    
+    (*raiz)->esquerda->esquerda = criarSala(pool, "Escritório", 
+        internarPista(caso, "Extrato bancário mostrando uma grande transferência para 'Carlos'"));
+    (*raiz)->esquerda->direita = criarSala(pool, "Jardim de Inverno", 
+        internarPista(caso, "Uma luva de jardinagem manchada de terra vermelha"));
+    
+    (*raiz)->direita->esquerda = criarSala(pool, "Cozinha", 
+        internarPista(caso, "Uma faca de chef ausente do estojo"));
+    (*raiz)->direita->direita = criarSala(pool, "Quarto Principal", 
+        internarPista(caso, "Um diário com a entrada do dia do crime apagada"));
+    
+    (*raiz)->esquerda->esquerda->esquerda = criarSala(pool, "Porão", 
+        internarPista(caso, "Uma caixa com documentos antigos sobre herança familiar"));
+    (*raiz)->esquerda->esquerda->direita = criarSala(pool, "Varanda", 
+        internarPista(caso, "Pegadas de sapato masculino tamanho 42 na lama"));
+    
+    compilarMansao(&caso->mansao, entrada, (uint32_t)memoria.salas.nosAlocados, NULL);
+    liberarMemoriaSessao(&memoria);
+}
+
+/**
+ * @brief Aloca o bloco único de uma mansão compacta
+ * @param mansao Mansão a ser preenchida (cômodos ainda não inicializados)
+ * @param numSalas Quantidade de cômodos
+ * @param numPassagens Passagens a reservar (0: mansão em árvore, sem CSR)
+ * @param tamanhoTextos Bytes dos nomes, com os terminadores
+ * @return Início da área de textos, onde os nomes devem ser escritos
+ */
+char* reservarMansao(Mansao* mansao, uint32_t numSalas, uint32_t numPassagens,
+                     size_t tamanhoTextos) {
+    size_t bytesNos = (size_t)numSalas * sizeof(NoMansao);
+    size_t bytesNomes = (size_t)numSalas * sizeof(uint32_t);
+    size_t bytesPassagens =
+        numPassagens > 0 ? ((size_t)numSalas + 1 + numPassagens) * sizeof(uint32_t) : 0;
+    mansao->bloco = malloc(bytesNos + bytesNomes + bytesPassagens + tamanhoTextos + 1);
+    if (mansao->bloco == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    mansao->nos = (NoMansao*)mansao->bloco;
+    mansao->nomes = (uint32_t*)((char*)mansao->bloco + bytesNos);
+    if (numPassagens > 0) {
+        mansao->inicioPassagens = mansao->nomes + numSalas;
+        mansao->passagens = mansao->inicioPassagens + numSalas + 1;
+    }
+    mansao->textos = (char*)mansao->bloco + bytesNos + bytesNomes + bytesPassagens;
+    mansao->numSalas = numSalas;
+    mansao->numPassagens = numPassagens;
+    return (char*)mansao->textos;
+}
+
+/**
+ * @brief Compila uma mansão de salas ligadas por ponteiros para a forma compacta
+ *
+ * Uma busca em largura a partir da raiz, pela esquerda, pela direita e
+ * pelas passagens, descobre os cômodos; a própria lista de salas visitadas
+ * serve de fila e os não alcançáveis ficam de fora. Sem passagens, essa já
+ * é a numeração final. Com elas, um cômodo alcançado só por passagem pode
+ * ter sido descoberto antes do pai, então a numeração é refeita em largura
+ * pelas saídas E/D a partir de cada cômodo sem pai, a entrada primeiro:
+ * assim todo filho continua depois do pai.
+ *
+ * @param mansao Mansão compacta a ser preenchida
+ * @param raiz Entrada da mansão (NULL gera uma mansão vazia)
+ * @param maxSalas Limite de cômodos; uma mansão maior é rejeitada
+ * @param passagens Vetor das passagens referenciadas pelas salas (ou NULL)
+ * @return 1 em caso de sucesso, 0 se a mansão excede o limite ou se as
+ *         saídas E/D de cômodos alcançados por passagens formam um ciclo
+ */
+int compilarMansao(Mansao* mansao, Sala* raiz, uint32_t maxSalas, const PassagemSala* passagens) {
+    memset(mansao, 0, sizeof(Mansao));
+    Sala** ordem = (Sala**)malloc(((size_t)maxSalas + 1) * sizeof(Sala*));
+    if (ordem == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    
+    // Descoberta: Sala.indice guarda a posição em "ordem"
+    uint32_t numSalas = 0, numPassagens = 0;
+    size_t tamanhoTextos = 0;
+    if (raiz != NULL && maxSalas > 0) {
+        raiz->indice = 0;
+        ordem[numSalas++] = raiz;
+    }
+    for (uint32_t i = 0; i < numSalas; i++) {
+        Sala* sala = ordem[i];
+        uint32_t passagem = sala->passagens;
+        for (int j = 0; j < 2 || passagem != SEM_INDICE; j++) {
+            Sala* vizinha;
+            if (j < 2) {
+                vizinha = j == 0 ? sala->esquerda : sala->direita;
+            } else {
+                vizinha = passagens[passagem].destino;
+                passagem = passagens[passagem].proxima;
+                numPassagens++;
+            }
+            if (vizinha == NULL || vizinha->indice != SEM_INDICE) continue;
+            if (numSalas == maxSalas) {
+                free(ordem);
+                return 0;
+            }
+            vizinha->indice = numSalas;
+            ordem[numSalas++] = vizinha;
+        }
+        tamanhoTextos += strlen(sala->nome) + 1;
+    }
+    
+    if (numPassagens > 0) {
+        char* temPai = (char*)calloc((size_t)numSalas + 1, 1);
+        Sala** arvore = (Sala**)malloc(((size_t)numSalas + 1) * sizeof(Sala*));
+        if (temPai == NULL || arvore == NULL) {
+            printf("Erro de alocação de memória!\n");
+            exit(1);
+        }
+        for (uint32_t i = 0; i < numSalas; i++) {
+            if (ordem[i]->esquerda != NULL) temPai[ordem[i]->esquerda->indice] = 1;
+            if (ordem[i]->direita != NULL) temPai[ordem[i]->direita->indice] = 1;
+        }
+        
+        // Cada cômodo tem no máximo um pai, então entra uma única vez; os
+        // que sobram estão num ciclo de saídas E/D, sem cômodo sem pai
+        uint32_t numerados = 0;
+        for (uint32_t i = 0; i < numSalas; i++) {
+            if (temPai[i]) continue;
+            arvore[numerados++] = ordem[i];
+            for (uint32_t j = numerados - 1; j < numerados; j++) {
+                Sala* filhos[2] = {arvore[j]->esquerda, arvore[j]->direita};
+                for (int lado = 0; lado < 2; lado++) {
+                    if (filhos[lado] != NULL && numerados < numSalas) arvore[numerados++] = filhos[lado];
+                }
+            }
+        }
+        free(temPai);
+        free(ordem);
+        ordem = arvore;
+        if (numerados != numSalas) {
+            free(ordem);
+            return 0;
+        }
+        for (uint32_t i = 0; i < numSalas; i++) ordem[i]->indice = i;
+    }
+    
+    // Os índices finais já estão nas salas; as passagens de cada cômodo vão
+    // para o CSR em ordem crescente e sem repetição
+    char* textos = reservarMansao(mansao, numSalas, numPassagens, tamanhoTextos);
+    size_t usados = 0;
+    uint32_t ocupadas = 0;
+    for (uint32_t i = 0; i < numSalas; i++) {
+        const Sala* sala = ordem[i];
+        NoMansao* no = &mansao->nos[i];
+        no->pista = sala->pista;
+        no->esquerda = sala->esquerda != NULL ? sala->esquerda->indice : SEM_INDICE;
+        no->direita = sala->direita != NULL ? sala->direita->indice : SEM_INDICE;
+        
+        size_t comprimento = strlen(sala->nome) + 1;
+        memcpy(textos + usados, sala->nome, comprimento);
+        mansao->nomes[i] = (uint32_t)usados;
+        usados += comprimento;
+        
+        if (numPassagens == 0) continue;
+        uint32_t* destinos = mansao->passagens + ocupadas;
+        uint32_t quantidade = 0, distintos = 0;
+        for (uint32_t p = sala->passagens; p != SEM_INDICE; p = passagens[p].proxima) {
+            destinos[quantidade++] = passagens[p].destino->indice;
+        }
+        qsort(destinos, quantidade, sizeof(uint32_t), compararIds);
+        for (uint32_t k = 0; k < quantidade; k++) {
+            if (distintos == 0 || destinos[distintos - 1] != destinos[k]) destinos[distintos++] = destinos[k];
+        }
+        mansao->inicioPassagens[i] = ocupadas;
+        ocupadas += distintos;
+    }
+    if (numPassagens > 0) {
+        mansao->inicioPassagens[numSalas] = ocupadas;
+        mansao->numPassagens = ocupadas;
+    }
+    
+    free(ordem);
+    return 1;
+}
+
+/**
+ * @brief Nome de um cômodo da mansão compacta
+ * @param mansao Mansão compacta
+ * @param sala Índice do cômodo
+ * @return Nome do cômodo
+ */
+const char* nomeSala(const Mansao* mansao, uint32_t sala) {
+#ifndef _WIN32
+    if (mansao->cache != NULL) return obterSalaDaCache(mansao->cache, sala)->texto;
+#endif
+    return mansao->textos + mansao->nomes[sala];
+}
+
+/**
+ * @brief Cômodo da mansão, vindo dos vetores compactos ou da cache sob demanda
+ *
+ * Na cache, o ponteiro vale até que outros CAPACIDADE_MINIMA_CACHE_SALAS
+ * cômodos sejam consultados.
+ *
+ * @param mansao Mansão do caso
+ * @param sala Índice do cômodo
+ * @return Cômodo
+ */
+const NoMansao* salaDaMansao(const Mansao* mansao, uint32_t sala) {
+#ifndef _WIN32
+    if (mansao->cache != NULL) return &obterSalaDaCache(mansao->cache, sala)->no;
+#endif
+    return &mansao->nos[sala];
+}
+
+/**
+ * @brief Passagens que saem de um cômodo
+ * @param mansao Mansão compacta
+ * @param sala Índice do cômodo
+ * @param destinos Recebe os índices dos cômodos de destino, em ordem crescente
+ * @return Quantidade de passagens (0 numa mansão em árvore)
+ */
+uint32_t passagensDaSala(const Mansao* mansao, uint32_t sala, const uint32_t** destinos) {
+    if (mansao->numPassagens == 0) {
+        *destinos = NULL;
+        return 0;
+    }
+    *destinos = mansao->passagens + mansao->inicioPassagens[sala];
+    return mansao->inicioPassagens[sala + 1] - mansao->inicioPassagens[sala];
+}
+
+/**
+ * @brief Verifica se há passagem de um cômodo para outro (busca binária)
+ * @param mansao Mansão compacta
+ * @param origem Cômodo de partida
+ * @param destino Cômodo de chegada
+ * @return 1 se a passagem existe, 0 caso contrário
+ */
+int temPassagem(const Mansao* mansao, uint32_t origem, uint32_t destino) {
+    const uint32_t* destinos;
+    uint32_t inicio = 0, fim = passagensDaSala(mansao, origem, &destinos);
+    while (inicio < fim) {
+        uint32_t meio = inicio + (fim - inicio) / 2;
+        if (destinos[meio] == destino) return 1;
+        if (destinos[meio] < destino) inicio = meio + 1;
+        else fim = meio;
+    }
+    return 0;
+}
+
+/**
+ * @brief Texto de uma pista, da tabela do caso ou da cache sob demanda
+ * @param caso Caso em andamento
+ * @param pista ID da pista
+ * @return Texto da pista
+ */
+const char* textoPista(const Caso* caso, uint32_t pista) {
+#ifndef _WIN32
+    if (caso->mansao.cache != NULL) return obterPistaDaCache(caso->mansao.cache, pista)->texto;
+#endif
+    return caso->pistas.textos[pista];
+}
+
+/**
+ * @brief Suspeito apontado por uma pista, da tabela do caso ou da cache sob demanda
+ * @param caso Caso em andamento
+ * @param pista ID da pista
+ * @return ID do suspeito ou SEM_INDICE
+ */
+uint32_t suspeitoDePista(const Caso* caso, uint32_t pista) {
+#ifndef _WIN32
+    if (caso->mansao.cache != NULL) return obterPistaDaCache(caso->mansao.cache, pista)->suspeito;
+#endif
+    return caso->suspeitoDaPista[pista];
+}
+
+/**
+ * @brief Libera a mansão compacta (uma única liberação)
+ * @param mansao Mansão a ser liberada
+ */
+void liberarMansao(Mansao* mansao) {
+#ifndef _WIN32
+    if (mansao->cache != NULL) liberarCacheSalas(mansao->cache);
+#endif
+    free(mansao->bloco);
+    memset(mansao, 0, sizeof(Mansao));
+}
+
+/**
+ * @brief Comando "ir <sala>": segue a rota mais curta até o cômodo com esse
+ *        nome, um passo de cada vez pela sessão (o diário registra cada
+ *        movimento, inclusive as passagens)
+ * @param sessao Sessão em andamento
+ * @param tela Tela de saída
+ * @param rotas Índice de rotas (montado na primeira consulta)
+ * @param nome Nome do cômodo de destino (sem diferença de maiúsculas)
+ * @param turno Contador de turnos (um por passo)
+ * @return 1 se chegou, 0 se não há cômodo com esse nome ou caminho até ele
+ *         (ou se a mansão é lida sob demanda, onde o comando é recusado)
+ */
+int irParaSala(Sessao* sessao, Tela* tela, IndiceRotas* rotas, const char* nome, unsigned* turno) {
+    const Mansao* mansao = &sessao->caso->mansao;
+    if (mansao->cache != NULL) {
+        // O índice de rotas leria a mansão inteira do disco
+        if (tela->modo == SAIDA_NORMAL) {
+            escreverTela(tela, "❌ O comando 'ir' não está disponível no modo sob demanda!\n");
+        } else if (tela->modo == SAIDA_JSON) {
+            escreverTela(tela, "{\"erro\":\"ir indisponível sob demanda\",\"destino\":");
+            escreverJsonTexto(tela, nome);
+            escreverTela(tela, "}\n");
+        }
+        return 0;
+    }
+    long passos = calcularRota(rotas, mansao, sessao->salaAtual, nome);
+    if (passos < 0) {
+        if (tela->modo == SAIDA_NORMAL) {
+            if (passos == -1) escreverTela(tela, "❌ Nenhum cômodo chamado '%s'!\n", nome);
+            else escreverTela(tela, "❌ Não há caminho daqui até '%s'!\n", nome);
+        } else if (tela->modo == SAIDA_JSON) {
+            escreverTela(tela, "{\"erro\":\"%s\",\"destino\":",
+                         passos == -1 ? "sala não encontrada" : "sala inalcançável");
+            escreverJsonTexto(tela, nome);
+            escreverTela(tela, "}\n");
+        }
+        return 0;
+    }
+
+    if (tela->modo == SAIDA_NORMAL) {
+        if (passos == 0) {
+            escreverTela(tela, "📍 Você já está na/no %s.\n", nomeSala(mansao, sessao->salaAtual));
+        } else {
+            escreverTela(tela, "🚶 Caminho até %s: ", nomeSala(mansao, rotas->caminho[passos - 1]));
+        }
+    }
+    for (long i = 0; i < passos; i++) {
+        // Cada passo é uma saída E/D ou, se não for, uma passagem
+        uint32_t destino = rotas->caminho[i];
+        const NoMansao* atual = salaDaMansao(mansao, sessao->salaAtual);
+        char comando = atual->esquerda == destino ? 'E'
+                     : atual->direita == destino  ? 'D'
+                                                  : COMANDO_PASSAGEM;
+        ResultadoComando resultado = comando == COMANDO_PASSAGEM
+                                         ? atravessarPassagem(sessao, destino)
+                                         : aplicarComando(sessao, comando);
+        (*turno)++;
+        if (tela->modo == SAIDA_JSON) {
+            renderizarTurnoJson(tela, sessao, *turno, comando, resultado);
+        } else if (tela->modo == SAIDA_NORMAL) {
+            if (comando == COMANDO_PASSAGEM) escreverTela(tela, "(%s)", nomeSala(mansao, destino));
+            else escreverTela(tela, "%c", comando);
+        }
+    }
+    if (tela->modo == SAIDA_NORMAL && passos > 0) escreverTela(tela, "\n");
+    return 1;
+}
+
+/**
+ * @brief Executa em ordem os comandos de uma linha do jogador
+ *
+ * Cada letra é um comando e espaços, vírgulas e ';' podem separá-los
+ * ("EECDC" ou "E, E; C"); "ir <sala>" (ou "goto <sala>") vai até o ';'
+ * seguinte. O efeito é o mesmo de digitar um comando por linha: um comando
+ * inválido é avisado e os demais continuam. B e S usam o resto da linha
+ * como resposta (consulta e acusação); sem resto, a partida passa a esperar
+ * a resposta na próxima linha. G encerra a linha. No modo normal, com mais
+ * de um comando, cada um é numerado, e a tela do cômodo só é montada no
+ * final.
+ *
+ * @param partida Partida na etapa ETAPA_COMANDOS
+ * @param tela Tela de saída
+ * @param linha Linha lida (é modificada)
+ */
+void executarLinha(Partida* partida, Tela* tela, char* linha) {
+    Sessao* sessao = partida->sessao;
+    int encerrarLinha = 0;
+    unsigned numero = 0;
+    char* cursor = linha;
+
+    while (!encerrarLinha) {
+        cursor += strspn(cursor, SEPARADORES_COMANDO);
+        if (*cursor == '\0') break;
+        uint64_t inicioComando = estatisticas.ligadas ? agoraEmNanossegundos() : 0;
+        numero++;
+
+        // ir <sala>: só no começo de uma palavra, com o nome até o próximo ';'
+        size_t tamanhoPalavra = strcspn(cursor, SEPARADORES_COMANDO);
+        int inicioPalavra = cursor == linha || strchr(SEPARADORES_COMANDO, cursor[-1]) != NULL;
+        if (inicioPalavra && (cursor[tamanhoPalavra] == ' ' || cursor[tamanhoPalavra] == '\t') &&
+            ((tamanhoPalavra == 2 && tolower((unsigned char)cursor[0]) == 'i' &&
+              tolower((unsigned char)cursor[1]) == 'r') ||
+             (tamanhoPalavra == 4 && tolower((unsigned char)cursor[0]) == 'g' &&
+              tolower((unsigned char)cursor[1]) == 'o' && tolower((unsigned char)cursor[2]) == 't' &&
+              tolower((unsigned char)cursor[3]) == 'o'))) {
+            char* nome = cursor + tamanhoPalavra;
+            nome += strspn(nome, " \t");
+            char* fimNome = nome + strcspn(nome, ";");
+            cursor = *fimNome == ';' ? fimNome + 1 : fimNome;
+            while (fimNome > nome && isspace((unsigned char)fimNome[-1])) fimNome--;
+            *fimNome = '\0';
+            int numerar = tela->modo == SAIDA_NORMAL &&
+                          (numero > 1 || cursor[strspn(cursor, SEPARADORES_COMANDO)] != '\0');
+            if (numerar) escreverTela(tela, "\n▶ Comando %u: ir %s\n", numero, nome);
+            irParaSala(sessao, tela, &partida->rotas, nome, &partida->turno);
+        } else {
+            char escolha = (char)toupper((unsigned char)*cursor++);
+            int respondeComResto = escolha == 'B' || escolha == 'S';
+            int numerar = tela->modo == SAIDA_NORMAL &&
+                          (numero > 1 || (!respondeComResto &&
+                                          cursor[strspn(cursor, SEPARADORES_COMANDO)] != '\0'));
+            if (numerar) escreverTela(tela, "\n▶ Comando %u: %c\n", numero, escolha);
+
+            if (escolha == 'B') {
+                // Busca no caderno: não muda a sessão, só mostra pistas
+                char* consulta = restoDaLinha(cursor);
+                if (*consulta != '\0') {
+                    pesquisarCaderno(partida, tela, consulta);
+                } else {
+                    if (tela->modo == SAIDA_NORMAL) {
+                        escreverTela(tela, "\n🔎 Buscar nas pistas coletadas (palavras ou prefixos; vazio lista todas): ");
+                    }
+                    partida->etapa = ETAPA_CONSULTA;
+                }
+                encerrarLinha = 1;
+            } else if (escolha == 'G' && partida->caminhoInstantaneo != NULL &&
+                       salvarInstantaneo(sessao, partida->caminhoInstantaneo)) {
+                // Guardar suspende a investigação sem julgamento
+                if (tela->modo == SAIDA_NORMAL) {
+                    escreverTela(tela, "\n💾 Investigação guardada em '%s' (%zu pistas).\n",
+                                 partida->caminhoInstantaneo, sessao->caderno.quantidade);
+                } else if (tela->modo == SAIDA_JSON) {
+                    escreverTela(tela, "{\"guardado\":");
+                    escreverJsonTexto(tela, partida->caminhoInstantaneo);
+                    escreverTela(tela, ",\"pistas\":%zu}\n", sessao->caderno.quantidade);
+                }
+                partida->etapa = ETAPA_GUARDADA;
+                encerrarLinha = 1;
+            } else {
+                // A lógica fica na sessão; aqui apenas se narra o resultado
+                uint32_t salaAnterior = sessao->salaAtual;
+                ResultadoComando resultado = aplicarComando(sessao, escolha);
+                partida->turno++;
+                if (resultado == RESULTADO_PISTA_COLETADA) {
+                    descontarPistaAdiante(&partida->adiante,
+                                          salaDaMansao(&sessao->caso->mansao, salaAnterior)->pista);
+                }
+
+                if (tela->modo == SAIDA_NORMAL) {
+                    renderizarResultado(tela, sessao, salaAnterior, escolha, resultado);
+                    if (numerar && resultado == RESULTADO_MOVEU) {
+                        escreverTela(tela, "🚶 %s\n", nomeSala(&sessao->caso->mansao, sessao->salaAtual));
+                    }
+                } else if (tela->modo == SAIDA_JSON) {
+                    renderizarTurnoJson(tela, sessao, partida->turno, escolha, resultado);
+                }
+                if (resultado == RESULTADO_SAIU) {
+                    // A acusação pode vir no resto da linha
+                    char* acusacao = restoDaLinha(cursor);
+                    iniciarJulgamento(partida, tela);
+                    if (partida->etapa == ETAPA_ACUSACAO && *acusacao != '\0') {
+                        concluirJulgamento(partida, tela, acusacao);
+                    }
+                    encerrarLinha = 1;
+                }
+            }
+        }
+
+        if (estatisticas.ligadas) {
+            registrarEmHistograma(&estatisticas.latenciaComando,
+                                  agoraEmNanossegundos() - inicioComando);
+        }
+    }
+
+    if (numero > 0 && partida->etapa == ETAPA_COMANDOS && tela->modo == SAIDA_NORMAL) {
+        renderizarSala(tela, sessao, &partida->adiante);
+    }
+}
+
+// ========== FUNÇÕES DA PARTIDA RETOMÁVEL ==========
+
+/**
+ * @brief Prepara uma partida para uma sessão já iniciada
+ * @param partida Partida a ser preparada
+ * @param sessao Sessão jogada (continua do chamador)
+ * @param caminhoInstantaneo Arquivo para o comando G (NULL: G é inválido)
+ * @param dicas 1 para montar as pistas adiante do menu (veja montarPistasAdiante)
+ */
+void inicializarPartida(Partida* partida, Sessao* sessao, const char* caminhoInstantaneo, int dicas) {
+    partida->sessao = sessao;
+    partida->caminhoInstantaneo = caminhoInstantaneo;
+    partida->etapa = ETAPA_COMANDOS;
+    partida->turno = 0;
+    partida->exibidas = 0;
+    partida->consulta[0] = '\0';
+    inicializarResultadoBusca(&partida->busca);
+    inicializarIndiceRotas(&partida->rotas);
+    if (dicas) montarPistasAdiante(&partida->adiante, sessao);
+    else memset(&partida->adiante, 0, sizeof(PistasAdiante));
+}
+
+/**
+ * @brief Começa a partida na sala atual da sessão, ou direto no julgamento
+ *        se a sessão (retomada) já saiu da mansão
+ * @param partida Partida preparada
+ * @param tela Tela de saída
+ */
+void comecarPartida(Partida* partida, Tela* tela) {
+    Sessao* sessao = partida->sessao;
+    if (sessao->estado != SESSAO_EXPLORANDO) {
+        iniciarJulgamento(partida, tela);
+        return;
+    }
+    partida->etapa = ETAPA_COMANDOS;
+    if (tela->modo == SAIDA_NORMAL) renderizarSala(tela, sessao, &partida->adiante);
+    else if (tela->modo == SAIDA_JSON) renderizarTurnoJson(tela, sessao, partida->turno, 0, RESULTADO_MOVEU);
+}
+
+/**
+ * @brief Entrega uma linha do jogador à partida parada
+ *
+ * A linha é interpretada conforme a etapa em que a partida estava, e a
+ * partida para de novo na etapa seguinte; ao fim de uma busca volta a tela
+ * da sala. O fim da entrada (linha NULL) vale como sair da mansão e como
+ * uma acusação vazia.
+ *
+ * @param partida Partida parada numa etapa que espera resposta
+ * @param tela Tela de saída
+ * @param linha Linha sem o '\n' (é modificada) ou NULL no fim da entrada
+ */
+void avancarPartida(Partida* partida, Tela* tela, char* linha) {
+    char fimDaEntrada[] = "S";
+    switch (partida->etapa) {
+        case ETAPA_COMANDOS:
+            executarLinha(partida, tela, linha != NULL ? linha : fimDaEntrada);
+            return;
+        case ETAPA_CONSULTA:
+            pesquisarCaderno(partida, tela, linha != NULL ? linha : "");
+            break;
+        case ETAPA_PAGINA:
+            // [Enter] mostra a próxima página; qualquer outra resposta encerra a busca
+            if (linha != NULL && linha[0] == '\0') mostrarPaginaBusca(partida, tela);
+            else partida->etapa = ETAPA_COMANDOS;
+            break;
+        case ETAPA_ACUSACAO:
+            concluirJulgamento(partida, tela, linha != NULL ? linha : "");
+            return;
+        default:
+            return;
+    }
+    if (partida->etapa == ETAPA_COMANDOS && tela->modo == SAIDA_NORMAL) {
+        renderizarSala(tela, partida->sessao, &partida->adiante);
+    }
+}
+
+/**
+ * @brief Diz se a partida terminou (guardada ou julgada)
+ * @param partida Partida em andamento
+ * @return 1 se não espera mais linhas do jogador, 0 caso contrário
+ */
+int partidaConcluida(const Partida* partida) {
+    return partida->etapa == ETAPA_GUARDADA || partida->etapa == ETAPA_ENCERRADA;
+}
+
+/**
+ * @brief Joga uma partida no terminal, da sala atual até o veredicto
+ *
+ * Cada linha da entrada vai para avancarPartida (veja executarLinha). Com
+ * mais linhas já lidas (entrada num pipe), as respostas se acumulam e saem
+ * juntas; a tela só é enviada antes de esperar por mais entrada.
+ *
+ * Com um arquivo de instantâneo, o comando G guarda a sessão nele e
+ * suspende a investigação. No modo normal, cada saída do menu traz as
+ * pistas por coletar naquela direção (veja montarPistasAdiante).
+ *
+ * @param sessao Sessão em andamento (começa na sala atual da sessão)
+ * @param tela Tela de saída (define o modo de renderização)
+ * @param entrada Entrada do jogo
+ * @param caminhoInstantaneo Arquivo para o comando G (NULL: G é inválido)
+ * @return 1 se a investigação foi guardada, 0 se foi julgada
+ */
+int jogarPartida(Sessao* sessao, Tela* tela, Entrada* entrada, const char* caminhoInstantaneo) {
+    Partida partida;
+    inicializarPartida(&partida, sessao, caminhoInstantaneo,
+                       tela->modo == SAIDA_NORMAL && sessao->estado == SESSAO_EXPLORANDO);
+    comecarPartida(&partida, tela);
+
+    while (!partidaConcluida(&partida)) {
+        if (!linhaPronta(entrada) || tela->tamanho >= TAMANHO_BLOCO_ENTRADA) descarregarTela(tela);
+        avancarPartida(&partida, tela, lerLinhaEntrada(entrada));
+    }
+    descarregarTela(tela);
+
+    int guardada = partida.etapa == ETAPA_GUARDADA;
+    liberarPartida(&partida);
+    return guardada;
+}
+
+/**
+ * @brief Libera os vetores da partida (a sessão continua do chamador)
+ * @param partida Partida a ser liberada
+ */
+void liberarPartida(Partida* partida) {
+    liberarResultadoBusca(&partida->busca);
+    liberarIndiceRotas(&partida->rotas);
+    liberarPistasAdiante(&partida->adiante);
+}
+
+// ========== FUNÇÕES DE ROTAS (COMANDO IR) ==========
+
+/**
+ * @brief Espalhamento de um nome de cômodo sem diferença de maiúsculas (FNV-1a)
+ */
+static inline uint64_t hashNomeSala(const char* nome) {
+    uint64_t valor = 0xCBF29CE484222325ull;
+    for (; *nome != '\0'; nome++) {
+        valor = (valor ^ (uint64_t)tolower((unsigned char)*nome)) * 0x100000001B3ull;
+    }
+    return valor;
+}
+
+/**
+ * @brief Balde da tabela de nomes em que começa a procura por um nome
+ */
+static inline uint32_t baldeDoNome(const IndiceRotas* indice, const char* nome) {
+    return (uint32_t)((hashNomeSala(nome) * 0x9E3779B97F4A7C15ull) >> 32) & indice->mascaraNomes;
+}
+
+/**
+ * @brief Prepara um índice de rotas vazio (montado na primeira consulta)
+ * @param indice Índice a ser inicializado
+ */
+void inicializarIndiceRotas(IndiceRotas* indice) {
+    memset(indice, 0, sizeof(IndiceRotas));
+}
+
+/**
+ * @brief Monta o índice de rotas de uma mansão
+ *
+ * Os nomes vão para a tabela do último cômodo para o primeiro, então cada
+ * lista de homônimos fica em ordem crescente. Numa árvore, guarda o pai de
+ * cada cômodo. Num grafo, monta o CSR reverso e mede os marcos: a entrada
+ * é o primeiro e cada um dos seguintes é o primeiro cômodo que nenhum marco
+ * alcança (ou, se não há, que não alcança nenhum). Quando todos alcançam e
+ * são alcançados, não há mais o que descartar e os marcos param.
+ *
+ * @param indice Índice vazio
+ * @param mansao Mansão compacta
+ */
+void montarIndiceRotas(IndiceRotas* indice, const Mansao* mansao) {
+    uint32_t n = mansao->numSalas;
+    uint32_t numBaldes = 1;
+    while (numBaldes < n && numBaldes < 0x80000000u) numBaldes <<= 1;
+    if (numBaldes < 0x80000000u) numBaldes <<= 1; // Ocupação de no máximo metade
+
+    indice->numSalas = n;
+    indice->mascaraNomes = numBaldes - 1;
+    indice->baldesNomes = (uint32_t*)malloc((size_t)numBaldes * sizeof(uint32_t));
+    indice->mesmoNome = (uint32_t*)malloc((size_t)n * sizeof(uint32_t));
+    if (indice->baldesNomes == NULL || indice->mesmoNome == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    memset(indice->baldesNomes, 0xFF, (size_t)numBaldes * sizeof(uint32_t));
+
+    for (uint32_t i = n; i-- > 0;) {
+        const char* nome = nomeSala(mansao, i);
+        uint32_t balde = baldeDoNome(indice, nome);
+        while (indice->baldesNomes[balde] != SEM_INDICE &&
+               !mesmoNomeSemCaixa(nomeSala(mansao, indice->baldesNomes[balde]), nome)) {
+            balde = (balde + 1) & indice->mascaraNomes;
+        }
+        indice->mesmoNome[i] = indice->baldesNomes[balde];
+        indice->baldesNomes[balde] = i;
+    }
+
+    if (mansao->numPassagens == 0) {
+        indice->pais = (uint32_t*)malloc((size_t)n * sizeof(uint32_t));
+        if (indice->pais == NULL) {
+            printf("Erro de alocação de memória!\n");
+            exit(1);
+        }
+        memset(indice->pais, 0xFF, (size_t)n * sizeof(uint32_t));
+        for (uint32_t i = 0; i < n; i++) {
+            const NoMansao* no = salaDaMansao(mansao, i);
+            if (no->esquerda != SEM_INDICE) indice->pais[no->esquerda] = i;
+            if (no->direita != SEM_INDICE) indice->pais[no->direita] = i;
+        }
+        return;
+    }
+
+    indice->inicioReverso = (uint32_t*)calloc((size_t)n + 1, sizeof(uint32_t));
+    indice->reverso = (uint32_t*)malloc(((size_t)2 * n + mansao->numPassagens) * sizeof(uint32_t));
+    indice->alcances = (uint16_t*)calloc(n, sizeof(uint16_t));
+    indice->distancias = (uint32_t*)malloc((size_t)n * sizeof(uint32_t));
+    indice->anteriores = (uint32_t*)malloc((size_t)n * sizeof(uint32_t));
+    indice->visitas = (uint32_t*)calloc(n, sizeof(uint32_t));
+    indice->distanciasVolta = (uint32_t*)malloc((size_t)n * sizeof(uint32_t));
+    indice->seguintes = (uint32_t*)malloc((size_t)n * sizeof(uint32_t));
+    indice->visitasVolta = (uint32_t*)calloc(n, sizeof(uint32_t));
+    indice->filaIda = (uint32_t*)malloc((size_t)n * sizeof(uint32_t));
+    indice->filaVolta = (uint32_t*)malloc((size_t)n * sizeof(uint32_t));
+    if (indice->inicioReverso == NULL || indice->reverso == NULL || indice->alcances == NULL ||
+        indice->distancias == NULL || indice->anteriores == NULL || indice->visitas == NULL ||
+        indice->distanciasVolta == NULL || indice->seguintes == NULL ||
+        indice->visitasVolta == NULL || indice->filaIda == NULL || indice->filaVolta == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+
+    // CSR reverso: contagem das chegadas, soma de prefixos e preenchimento
+    for (int etapa = 0; etapa < 2; etapa++) {
+        for (uint32_t i = 0; i < n; i++) {
+            const NoMansao* no = salaDaMansao(mansao, i);
+            const uint32_t* destinos;
+            uint32_t numDestinos = passagensDaSala(mansao, i, &destinos);
+            for (uint32_t k = 0; k < 2 + numDestinos; k++) {
+                uint32_t destino = k == 0 ? no->esquerda : k == 1 ? no->direita : destinos[k - 2];
+                if (destino == SEM_INDICE) continue;
+                if (etapa == 0) indice->inicioReverso[destino + 1]++;
+                else indice->reverso[indice->anteriores[destino]++] = i;
+            }
+        }
+        if (etapa == 0) {
+            for (uint32_t i = 0; i < n; i++) {
+                indice->inicioReverso[i + 1] += indice->inicioReverso[i];
+                indice->anteriores[i] = indice->inicioReverso[i]; // Próxima posição livre
+            }
+        }
+    }
+
+    uint32_t marco = 0;
+    for (indice->numMarcos = 0; indice->numMarcos < NUM_MARCOS_ROTAS && marco != SEM_INDICE;) {
+        medirMarco(indice, mansao, marco, indice->numMarcos, 0);
+        medirMarco(indice, mansao, marco, indice->numMarcos, 1);
+        indice->numMarcos++;
+
+        marco = SEM_INDICE;
+        for (uint32_t i = 0; i < n && marco == SEM_INDICE; i++) {
+            if ((indice->alcances[i] & 0x00FF) == 0) marco = i;
+        }
+        for (uint32_t i = 0; i < n && marco == SEM_INDICE; i++) {
+            if ((indice->alcances[i] & 0xFF00) == 0) marco = i;
+        }
+    }
+}
+
+/**
+ * @brief Marca, por busca em largura, os cômodos que um marco alcança
+ *        (pelas saídas) ou que o alcançam (pelo CSR reverso)
+ * @param indice Índice em montagem ("filaIda" serve de fila)
+ * @param mansao Mansão compacta
+ * @param marco Cômodo escolhido como marco
+ * @param k Posição do marco
+ * @param chegada 0: cômodos alcançados pelo marco; 1: cômodos que o alcançam
+ */
+void medirMarco(IndiceRotas* indice, const Mansao* mansao, uint32_t marco, uint32_t k, int chegada) {
+    uint16_t bit = (uint16_t)(1u << (k + (chegada ? NUM_MARCOS_ROTAS : 0)));
+    uint32_t* fila = indice->filaIda;
+    size_t inicio = 0, fim = 0;
+    indice->alcances[marco] |= bit;
+    fila[fim++] = marco;
+
+    while (inicio < fim) {
+        uint32_t sala = fila[inicio++];
+        const uint32_t* vizinhos;
+        uint32_t numVizinhos, lados[2] = {SEM_INDICE, SEM_INDICE};
+        if (chegada) {
+            vizinhos = indice->reverso + indice->inicioReverso[sala];
+            numVizinhos = indice->inicioReverso[sala + 1] - indice->inicioReverso[sala];
+        } else {
+            const NoMansao* no = salaDaMansao(mansao, sala);
+            lados[0] = no->esquerda;
+            lados[1] = no->direita;
+            numVizinhos = passagensDaSala(mansao, sala, &vizinhos);
+        }
+        for (uint32_t j = 0; j < 2 + numVizinhos; j++) {
+            uint32_t vizinho = j < 2 ? lados[j] : vizinhos[j - 2];
+            if (vizinho == SEM_INDICE || (indice->alcances[vizinho] & bit) != 0) continue;
+            indice->alcances[vizinho] |= bit;
+            fila[fim++] = vizinho;
+        }
+    }
+}
+
+/**
+ * @brief Procura o primeiro cômodo com um nome (sem diferença de maiúsculas)
+ * @param indice Índice montado
+ * @param mansao Mansão compacta
+ * @param nome Nome procurado
+ * @return Índice do cômodo (os homônimos seguem em "mesmoNome") ou SEM_INDICE
+ */
+uint32_t procurarSalaPorNome(const IndiceRotas* indice, const Mansao* mansao, const char* nome) {
+    uint32_t balde = baldeDoNome(indice, nome);
+    while (indice->baldesNomes[balde] != SEM_INDICE) {
+        if (mesmoNomeSemCaixa(nomeSala(mansao, indice->baldesNomes[balde]), nome)) {
+            return indice->baldesNomes[balde];
+        }
+        balde = (balde + 1) & indice->mascaraNomes;
+    }
+    return SEM_INDICE;
+}
+
+/**
+ * @brief Diz se os marcos provam que um cômodo não alcança outro
+ *
+ * Se um marco alcança "de" mas não "para", ou se "para" alcança um marco
+ * que "de" não alcança, não há caminho de "de" até "para".
+ *
+ * @param de Alcances do cômodo de partida
+ * @param para Alcances do cômodo de chegada
+ * @return 1 se não há caminho, 0 se pode haver
+ */
+static inline int marcosSeparam(uint16_t de, uint16_t para) {
+    uint16_t marcosAlcancam = (uint16_t)((1u << NUM_MARCOS_ROTAS) - 1);
+    return ((de & ~para) & marcosAlcancam) != 0 || ((para & ~de) & ~marcosAlcancam) != 0;
+}
+
+/**
+ * @brief Garante espaço para uma rota de um certo número de passos
+ */
+static void reservarCaminho(IndiceRotas* indice, size_t passos) {
+    if (passos <= indice->capacidadeCaminho) return;
+    indice->capacidadeCaminho = passos * 2;
+    indice->caminho = (uint32_t*)realloc(indice->caminho,
+                                         indice->capacidadeCaminho * sizeof(uint32_t));
+    if (indice->caminho == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+}
+
+/**
+ * @brief Rota numa mansão em árvore: só se desce, então a origem tem de ser
+ *        ancestral do destino; sobe-se de cada homônimo até ela
+ * @param indice Índice montado (árvore)
+ * @param origem Cômodo de partida
+ * @param primeiroAlvo Primeiro cômodo com o nome procurado
+ * @return Passos da rota (em indice->caminho) ou -2 se nenhum está adiante
+ */
+long buscarRotaArvore(IndiceRotas* indice, uint32_t origem, uint32_t primeiroAlvo) {
+    long melhor = -2;
+    uint32_t escolhido = SEM_INDICE;
+    for (uint32_t alvo = primeiroAlvo; alvo != SEM_INDICE; alvo = indice->mesmoNome[alvo]) {
+        long passos = 0;
+        uint32_t sala = alvo;
+        while (sala != origem && sala != SEM_INDICE && (melhor < 0 || passos < melhor)) {
+            sala = indice->pais[sala];
+            passos++;
+        }
+        if (sala == origem && (melhor < 0 || passos < melhor)) {
+            melhor = passos;
+            escolhido = alvo;
+        }
+    }
+    if (melhor < 0) return melhor;
+
+    reservarCaminho(indice, (size_t)melhor);
+    long posicao = melhor;
+    for (uint32_t sala = escolhido; sala != origem; sala = indice->pais[sala]) {
+        indice->caminho[--posicao] = sala;
+    }
+    return melhor;
+}
+
+/**
+ * @brief Rota numa mansão com passagens: busca em largura pelos dois lados
+ *
+ * A ida parte da origem pelas saídas; a volta parte de todos os homônimos
+ * pelo CSR reverso. A cada rodada, o lado de fronteira menor avança um
+ * nível inteiro; a primeira rodada que encontra o outro lado dá a rota mais
+ * curta até o destino mais próximo. A ida descarta cômodos que os marcos
+ * dizem não alcançar nenhum destino; a volta, os que a origem não alcança.
+ *
+ * @param indice Índice montado (grafo)
+ * @param mansao Mansão compacta
+ * @param origem Cômodo de partida
+ * @param primeiroAlvo Primeiro cômodo com o nome procurado
+ * @return Passos da rota (em indice->caminho) ou -2 se nenhum é alcançável
+ */
+long buscarRotaNoGrafo(IndiceRotas* indice, const Mansao* mansao, uint32_t origem,
+                       uint32_t primeiroAlvo) {
+    if (++indice->busca == 0) {
+        memset(indice->visitas, 0, (size_t)indice->numSalas * sizeof(uint32_t));
+        memset(indice->visitasVolta, 0, (size_t)indice->numSalas * sizeof(uint32_t));
+        indice->busca = 1;
+    }
+    uint32_t busca = indice->busca;
+
+    // Os alcances "de algum destino" resumem todos os homônimos de uma vez
+    uint16_t marcosAlcancam = (uint16_t)((1u << NUM_MARCOS_ROTAS) - 1);
+    uint16_t algumAlcancado = 0, todosAlcancam = (uint16_t)~marcosAlcancam;
+    size_t inicioVolta = 0, fimVolta = 0;
+    for (uint32_t alvo = primeiroAlvo; alvo != SEM_INDICE; alvo = indice->mesmoNome[alvo]) {
+        if (alvo == origem) return 0;
+        indice->visitasVolta[alvo] = busca;
+        indice->distanciasVolta[alvo] = 0;
+        indice->seguintes[alvo] = SEM_INDICE;
+        indice->filaVolta[fimVolta++] = alvo;
+        algumAlcancado |= indice->alcances[alvo] & marcosAlcancam;
+        todosAlcancam &= indice->alcances[alvo];
+    }
+    uint16_t alcanceAlvos = algumAlcancado | todosAlcancam;
+    uint16_t alcanceOrigem = indice->alcances[origem];
+    if (marcosSeparam(alcanceOrigem, alcanceAlvos)) return -2;
+
+    size_t inicioIda = 0, fimIda = 0;
+    indice->visitas[origem] = busca;
+    indice->distancias[origem] = 0;
+    indice->anteriores[origem] = SEM_INDICE;
+    indice->filaIda[fimIda++] = origem;
+
+    uint32_t encontro = SEM_INDICE, melhor = SEM_INDICE;
+    while (encontro == SEM_INDICE && inicioIda < fimIda && inicioVolta < fimVolta) {
+        int ida = fimIda - inicioIda <= fimVolta - inicioVolta;
+        size_t fimNivel = ida ? fimIda : fimVolta;
+        for (size_t posicao = ida ? inicioIda : inicioVolta; posicao < fimNivel; posicao++) {
+            uint32_t sala = ida ? indice->filaIda[posicao] : indice->filaVolta[posicao];
+            const uint32_t* vizinhos;
+            uint32_t numVizinhos, lados[2] = {SEM_INDICE, SEM_INDICE};
+            if (ida) {
+                const NoMansao* no = salaDaMansao(mansao, sala);
+                lados[0] = no->esquerda;
+                lados[1] = no->direita;
+                numVizinhos = passagensDaSala(mansao, sala, &vizinhos);
+            } else {
+                vizinhos = indice->reverso + indice->inicioReverso[sala];
+                numVizinhos = indice->inicioReverso[sala + 1] - indice->inicioReverso[sala];
+            }
+
+            for (uint32_t j = 0; j < 2 + numVizinhos; j++) {
+                uint32_t vizinho = j < 2 ? lados[j] : vizinhos[j - 2];
+                if (vizinho == SEM_INDICE) continue;
+                if (ida) {
+                    if (indice->visitas[vizinho] == busca) continue;
+                    indice->visitas[vizinho] = busca;
+                    if (marcosSeparam(indice->alcances[vizinho], alcanceAlvos)) continue;
+                    indice->distancias[vizinho] = indice->distancias[sala] + 1;
+                    indice->anteriores[vizinho] = sala;
+                    indice->filaIda[fimIda++] = vizinho;
+                } else {
+                    if (indice->visitasVolta[vizinho] == busca) continue;
+                    indice->visitasVolta[vizinho] = busca;
+                    if (marcosSeparam(alcanceOrigem, indice->alcances[vizinho])) continue;
+                    indice->distanciasVolta[vizinho] = indice->distanciasVolta[sala] + 1;
+                    indice->seguintes[vizinho] = sala;
+                    indice->filaVolta[fimVolta++] = vizinho;
+                }
+                // Cômodo já tocado pelo outro lado: candidato a meio da rota
+                if (indice->visitas[vizinho] == busca && indice->visitasVolta[vizinho] == busca) {
+                    uint32_t passos = indice->distancias[vizinho] + indice->distanciasVolta[vizinho];
+                    if (passos < melhor) {
+                        melhor = passos;
+                        encontro = vizinho;
+                    }
+                }
+            }
+        }
+        if (ida) inicioIda = fimNivel;
+        else inicioVolta = fimNivel;
+    }
+    if (encontro == SEM_INDICE) return -2;
+
+    reservarCaminho(indice, melhor);
+    size_t posicao = indice->distancias[encontro];
+    for (uint32_t sala = encontro; sala != origem; sala = indice->anteriores[sala]) {
+        indice->caminho[--posicao] = sala;
+    }
+    posicao = indice->distancias[encontro];
+    for (uint32_t sala = indice->seguintes[encontro]; sala != SEM_INDICE; sala = indice->seguintes[sala]) {
+        indice->caminho[posicao++] = sala;
+    }
+    return (long)melhor;
+}
+
+/**
+ * @brief Rota mais curta até o cômodo mais próximo com um nome
+ * @param indice Índice de rotas (montado aqui na primeira consulta)
+ * @param mansao Mansão compacta
+ * @param origem Cômodo de partida
+ * @param nome Nome do destino (sem diferença de maiúsculas)
+ * @return Passos da rota, com os cômodos em indice->caminho (0 se já está
+ *         lá), -1 se não há cômodo com esse nome ou -2 se nenhum é alcançável
+ */
+long calcularRota(IndiceRotas* indice, const Mansao* mansao, uint32_t origem, const char* nome) {
+    if (indice->numSalas == 0) montarIndiceRotas(indice, mansao);
+    uint32_t primeiro = procurarSalaPorNome(indice, mansao, nome);
+    if (primeiro == SEM_INDICE) return -1;
+    return indice->pais != NULL ? buscarRotaArvore(indice, origem, primeiro)
+                                : buscarRotaNoGrafo(indice, mansao, origem, primeiro);
+}
+
+/**
+ * @brief Libera o índice de rotas
+ * @param indice Índice a ser liberado
+ */
+void liberarIndiceRotas(IndiceRotas* indice) {
+    free(indice->baldesNomes);
+    free(indice->mesmoNome);
+    free(indice->pais);
+    free(indice->inicioReverso);
+    free(indice->reverso);
+    free(indice->alcances);
+    free(indice->distancias);
+    free(indice->anteriores);
+    free(indice->visitas);
+    free(indice->distanciasVolta);
+    free(indice->seguintes);
+    free(indice->visitasVolta);
+    free(indice->filaIda);
+    free(indice->filaVolta);
+    free(indice->caminho);
+    memset(indice, 0, sizeof(IndiceRotas));
+}
+
+// ========== FUNÇÕES DAS PISTAS ADIANTE (DICAS DO MENU) ==========
+
+/**
+ * @brief Soma (ou desconta) uma pista nas contagens por suspeito
+ *
+ * A pista conta 1 para cada suspeito com evidência nela (sem evidências
+ * detalhadas, para o suspeito principal), como no placar, mas sem os pesos.
+ *
+ * @param contagens Contagens por suspeito
+ * @param caso Caso em andamento
+ * @param pista ID da pista
+ * @param sinal 1 para somar, -1 para descontar
+ */
+static void contarPistaAdiante(uint32_t* contagens, const Caso* caso, uint32_t pista, int sinal) {
+    uint32_t fim;
+    uint32_t i = buscarEvidencias(caso, pista, &fim);
+    if (i == fim) {
+        uint32_t suspeito = caso->suspeitoDaPista[pista];
+        if (suspeito != SEM_INDICE) contagens[suspeito] += (uint32_t)sinal;
+        return;
+    }
+    for (; i < fim; i++) contagens[caso->evidencias[i].suspeito] += (uint32_t)sinal;
+}
+
+/**
+ * @brief Garante espaço para uma quantidade de cômodos coletados
+ */
+static void reservarColetadas(PistasAdiante* adiante, uint32_t quantidade) {
+    if (quantidade <= adiante->capacidadeColetadas) return;
+    adiante->capacidadeColetadas = adiante->capacidadeColetadas ? adiante->capacidadeColetadas * 2 : 16;
+    if (adiante->capacidadeColetadas < quantidade) adiante->capacidadeColetadas = quantidade;
+    adiante->coletadas = (uint64_t*)realloc(adiante->coletadas,
+                                            adiante->capacidadeColetadas * sizeof(uint64_t));
+    if (adiante->coletadas == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+}
+
+/**
+ * @brief Monta as pistas adiante de cada cômodo para a sessão
+ *
+ * Os cômodos vêm sempre depois do pai, então uma passada do último para o
+ * primeiro soma as contagens e os tamanhos das subárvores, e outra, do
+ * primeiro para o último, dá a cada filho o começo do seu intervalo (um
+ * cômodo sem pai abre um intervalo novo). Nada é recursivo, e o custo é
+ * O(cômodos × suspeitos) uma única vez. As pistas que a sessão já tem
+ * (investigação retomada) entram como coletadas. No modo sob demanda a
+ * mansão não está na memória e não há dicas.
+ *
+ * @param adiante Estrutura a ser montada
+ * @param sessao Sessão em andamento
+ */
+void montarPistasAdiante(PistasAdiante* adiante, const Sessao* sessao) {
+    const Caso* caso = sessao->caso;
+    const Mansao* mansao = &caso->mansao;
+    memset(adiante, 0, sizeof(PistasAdiante));
+    if (mansao->cache != NULL) return;
+
+    uint32_t n = mansao->numSalas, s = caso->suspeitos.quantidade;
+    uint32_t numPistas = caso->pistas.quantidade;
+    adiante->numSalas = n;
+    adiante->numSuspeitos = s;
+    adiante->contagens = (uint32_t*)calloc((size_t)n * s + 1, sizeof(uint32_t));
+    adiante->entrada = (uint32_t*)malloc((size_t)n * sizeof(uint32_t));
+    adiante->saida = (uint32_t*)malloc((size_t)n * sizeof(uint32_t));
+    adiante->inicioOcorrencias = (uint32_t*)calloc((size_t)numPistas + 1, sizeof(uint32_t));
+    adiante->restantes = (uint32_t*)malloc(((size_t)s + 1) * sizeof(uint32_t));
+    if (adiante->contagens == NULL || adiante->entrada == NULL || adiante->saida == NULL ||
+        adiante->inicioOcorrencias == NULL || adiante->restantes == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+
+    // Das folhas para a entrada: contagens e tamanhos (em "saida", por ora)
+    for (uint32_t i = n; i-- > 0;) {
+        const NoMansao* no = salaDaMansao(mansao, i);
+        uint32_t* contagens = adiante->contagens + (size_t)i * s;
+        uint32_t tamanho = 1;
+        if (no->pista != SEM_INDICE) {
+            contarPistaAdiante(contagens, caso, no->pista, 1);
+            adiante->inicioOcorrencias[no->pista + 1]++;
+        }
+        uint32_t filhos[2] = {no->esquerda, no->direita};
+        for (int lado = 0; lado < 2; lado++) {
+            if (filhos[lado] == SEM_INDICE) continue;
+            const uint32_t* doFilho = adiante->contagens + (size_t)filhos[lado] * s;
+            for (uint32_t k = 0; k < s; k++) contagens[k] += doFilho[k];
+            tamanho += adiante->saida[filhos[lado]];
+        }
+        adiante->saida[i] = tamanho;
+    }
+
+    // Da entrada para as folhas: intervalos [entrada, saida) em profundidade
+    memset(adiante->entrada, 0xFF, (size_t)n * sizeof(uint32_t));
+    uint32_t proximaRaiz = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        if (adiante->entrada[i] == SEM_INDICE) {
+            adiante->entrada[i] = proximaRaiz;
+            proximaRaiz += adiante->saida[i];
+        }
+        const NoMansao* no = salaDaMansao(mansao, i);
+        uint32_t posicao = adiante->entrada[i] + 1;
+        if (no->esquerda != SEM_INDICE) {
+            adiante->entrada[no->esquerda] = posicao;
+            posicao += adiante->saida[no->esquerda];
+        }
+        if (no->direita != SEM_INDICE) adiante->entrada[no->direita] = posicao;
+        adiante->saida[i] += adiante->entrada[i];
+    }
+
+    // CSR dos cômodos de cada pista
+    for (uint32_t p = 0; p < numPistas; p++) {
+        adiante->inicioOcorrencias[p + 1] += adiante->inicioOcorrencias[p];
+    }
+    uint32_t numOcorrencias = adiante->inicioOcorrencias[numPistas];
+    adiante->ocorrencias = (uint32_t*)malloc(((size_t)numOcorrencias + 1) * sizeof(uint32_t));
+    if (adiante->ocorrencias == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    for (uint32_t i = n; i-- > 0;) {
+        uint32_t pista = salaDaMansao(mansao, i)->pista;
+        if (pista != SEM_INDICE) adiante->ocorrencias[--adiante->inicioOcorrencias[pista + 1]] = i;
+    }
+    for (uint32_t p = 0; p < numPistas; p++) {
+        adiante->inicioOcorrencias[p] = adiante->inicioOcorrencias[p + 1]; // Começo da pista p
+    }
+    adiante->inicioOcorrencias[numPistas] = numOcorrencias;
+    recolherPistasAdiante(adiante, &sessao->caderno);
+}
+
+/**
+ * @brief Refaz os cômodos coletados a partir das pistas de um caderno
+ *
+ * Todas as pistas de uma vez e uma única ordenação: serve à montagem
+ * (investigação retomada) e a quem troca de sessão sem remontar as
+ * contagens, como o anfitrião de partidas.
+ *
+ * @param adiante Pistas adiante montadas (sem efeito se não há dicas)
+ * @param caderno Caderno da sessão em andamento
+ */
+void recolherPistasAdiante(PistasAdiante* adiante, const CadernoPistas* caderno) {
+    adiante->numColetadas = 0;
+    if (adiante->numSalas == 0) return;
+    IteradorCaderno iterador;
+    uint32_t pista;
+    iniciarIteradorCaderno(&iterador, caderno);
+    while (proximaPistaCaderno(&iterador, &pista)) {
+        for (uint32_t j = adiante->inicioOcorrencias[pista]; j < adiante->inicioOcorrencias[pista + 1]; j++) {
+            reservarColetadas(adiante, adiante->numColetadas + 1);
+            uint32_t sala = adiante->ocorrencias[j];
+            adiante->coletadas[adiante->numColetadas++] = ((uint64_t)adiante->entrada[sala] << 32) | sala;
+        }
+    }
+    if (adiante->numColetadas > 1) {
+        qsort(adiante->coletadas, adiante->numColetadas, sizeof(uint64_t), compararChavesCrescente);
+    }
+}
+
+/**
+ * @brief Primeira posição de "coletadas" com chave maior ou igual a uma dada
+ */
+static uint32_t procurarColetada(const PistasAdiante* adiante, uint64_t chave) {
+    uint32_t inicio = 0, limite = adiante->numColetadas;
+    while (inicio < limite) {
+        uint32_t meio = inicio + (limite - inicio) / 2;
+        if (adiante->coletadas[meio] < chave) inicio = meio + 1;
+        else limite = meio;
+    }
+    return inicio;
+}
+
+/**
+ * @brief Registra uma pista recém-coletada: os cômodos que a têm deixam de
+ *        contar nas dicas (só esses cômodos; nada é recalculado)
+ * @param adiante Pistas adiante montadas (sem efeito se não há dicas)
+ * @param pista ID da pista nova no caderno
+ */
+void descontarPistaAdiante(PistasAdiante* adiante, uint32_t pista) {
+    if (adiante->numSalas == 0) return;
+    for (uint32_t j = adiante->inicioOcorrencias[pista]; j < adiante->inicioOcorrencias[pista + 1]; j++) {
+        uint32_t sala = adiante->ocorrencias[j];
+        uint64_t chave = ((uint64_t)adiante->entrada[sala] << 32) | sala;
+        uint32_t posicao = procurarColetada(adiante, chave);
+        if (posicao < adiante->numColetadas && adiante->coletadas[posicao] == chave) continue;
+        reservarColetadas(adiante, adiante->numColetadas + 1);
+        memmove(adiante->coletadas + posicao + 1, adiante->coletadas + posicao,
+                (adiante->numColetadas - posicao) * sizeof(uint64_t));
+        adiante->coletadas[posicao] = chave;
+        adiante->numColetadas++;
+    }
+}
+
+/**
+ * @brief Conta, por suspeito, as pistas ainda por coletar na subárvore de
+ *        um cômodo
+ *
+ * Parte das contagens montadas e desconta só os cômodos coletados dentro
+ * do intervalo do cômodo. Sem passagens só se desce, e os cômodos já
+ * coletados ficam acima: o desconto quase sempre é vazio e o custo é
+ * O(suspeitos), qualquer que seja a profundidade da mansão.
+ *
+ * @param adiante Pistas adiante montadas
+ * @param caso Caso em andamento
+ * @param sala Cômodo (uma saída da sala atual)
+ * @return Contagens por suspeito (em adiante->restantes)
+ */
+const uint32_t* contarPistasAdiante(PistasAdiante* adiante, const Caso* caso, uint32_t sala) {
+    uint32_t s = adiante->numSuspeitos;
+    memcpy(adiante->restantes, adiante->contagens + (size_t)sala * s, (size_t)s * sizeof(uint32_t));
+    uint32_t fim = adiante->saida[sala];
+    for (uint32_t j = procurarColetada(adiante, (uint64_t)adiante->entrada[sala] << 32);
+         j < adiante->numColetadas && (uint32_t)(adiante->coletadas[j] >> 32) < fim; j++) {
+        uint32_t coletada = (uint32_t)adiante->coletadas[j];
+        contarPistaAdiante(adiante->restantes, caso, salaDaMansao(&caso->mansao, coletada)->pista, -1);
+    }
+    return adiante->restantes;
+}
+
+/**
+ * @brief Escreve a dica de uma saída: os suspeitos com mais pistas por
+ *        coletar naquela direção (até SUSPEITOS_NA_DICA)
+ * @param tela Tela de saída
+ * @param adiante Pistas adiante montadas
+ * @param caso Caso em andamento
+ * @param sala Cômodo da saída
+ */
+void escreverDicaAdiante(Tela* tela, PistasAdiante* adiante, const Caso* caso, uint32_t sala) {
+    const uint32_t* restantes = contarPistasAdiante(adiante, caso, sala);
+    uint32_t melhores[SUSPEITOS_NA_DICA], numMelhores = 0;
+    for (uint32_t k = 0; k < adiante->numSuspeitos; k++) {
+        if (restantes[k] == 0) continue;
+        uint32_t posicao = numMelhores < SUSPEITOS_NA_DICA ? numMelhores++ : SUSPEITOS_NA_DICA;
+        while (posicao > 0 && restantes[melhores[posicao - 1]] < restantes[k]) {
+            if (posicao < SUSPEITOS_NA_DICA) melhores[posicao] = melhores[posicao - 1];
+            posicao--;
+        }
+        if (posicao < SUSPEITOS_NA_DICA) melhores[posicao] = k;
+    }
+
+    if (numMelhores == 0) {
+        escreverTela(tela, "    🧭 Adiante: nenhuma pista por coletar\n");
+        return;
+    }
+    escreverTela(tela, "    🧭 Adiante: %u pista(s) contra %s", restantes[melhores[0]],
+                 caso->suspeitos.textos[melhores[0]]);
+    for (uint32_t i = 1; i < numMelhores; i++) {
+        escreverTela(tela, ", %u contra %s", restantes[melhores[i]],
+                     caso->suspeitos.textos[melhores[i]]);
+    }
+    escreverTela(tela, "\n");
+}
+
+/**
+ * @brief Libera as pistas adiante
+ * @param adiante Estrutura a ser liberada
+ */
+void liberarPistasAdiante(PistasAdiante* adiante) {
+    free(adiante->contagens);
+    free(adiante->entrada);
+    free(adiante->saida);
+    free(adiante->inicioOcorrencias);
+    free(adiante->ocorrencias);
+    free(adiante->coletadas);
+    free(adiante->restantes);
+    memset(adiante, 0, sizeof(PistasAdiante));
+}
+
+// ========== FUNÇÕES PARA A MANSÃO SOB DEMANDA ==========
+
+#ifndef _WIN32
+/**
+ * @brief Lê exatamente "tamanho" bytes de uma posição do arquivo
+ * @param fd Descritor do arquivo
+ * @param destino Destino dos bytes
+ * @param tamanho Bytes a ler
+ * @param posicao Posição no arquivo
+ * @return 1 em caso de sucesso, 0 em erro ou fim prematuro do arquivo
+ */
+int lerNoArquivo(int fd, void* destino, size_t tamanho, uint64_t posicao) {
+    char* cursor = (char*)destino;
+    while (tamanho > 0) {
+        ssize_t lidos = pread(fd, cursor, tamanho, (off_t)posicao);
+        if (lidos < 0 && errno == EINTR) continue;
+        if (lidos <= 0) return 0;
+        cursor += lidos;
+        tamanho -= (size_t)lidos;
+        posicao += (uint64_t)lidos;
+    }
+    return 1;
+}
+
+/**
+ * @brief Cria a cache de cômodos de um caso binário já conferido
+ * @param fd Descritor do arquivo (passa a pertencer à cache)
+ * @param cabecalho Cabeçalho do caso
+ * @param capacidade Cômodos mantidos na memória (mínimo CAPACIDADE_MINIMA_CACHE_SALAS)
+ * @return Cache vazia
+ */
+CacheSalas* criarCacheSalas(int fd, const CabecalhoCaso* cabecalho, uint32_t capacidade) {
+    if (capacidade < CAPACIDADE_MINIMA_CACHE_SALAS) capacidade = CAPACIDADE_MINIMA_CACHE_SALAS;
+    uint32_t numBaldes = 1;
+    while (numBaldes < capacidade * 2) numBaldes <<= 1;
+
+    CacheSalas* cache = (CacheSalas*)calloc(1, sizeof(CacheSalas));
+    if (cache != NULL) {
+        cache->entradas = (EntradaCacheSalas*)calloc(capacidade, sizeof(EntradaCacheSalas));
+        cache->baldes = (uint32_t*)malloc(numBaldes * sizeof(uint32_t));
+    }
+    if (cache == NULL || cache->entradas == NULL || cache->baldes == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    memset(cache->baldes, 0xFF, numBaldes * sizeof(uint32_t));
+
+    cache->fd = fd;
+    cache->inicioNos = sizeof(CabecalhoCaso);
+    cache->inicioNomes = cache->inicioNos + (uint64_t)cabecalho->numSalas * sizeof(NoMansao);
+    cache->inicioPistas = cache->inicioNos + bytesMansaoNoArquivo(cabecalho);
+    cache->inicioTextos = cache->inicioPistas +
+                          (uint64_t)cabecalho->numPistas * sizeof(RegistroPista) +
+                          (uint64_t)cabecalho->numSuspeitos * sizeof(RegistroSuspeito) +
+                          (uint64_t)cabecalho->numEvidencias * sizeof(RegistroEvidencia);
+    cache->tamanhoTextos = cabecalho->tamanhoTextos;
+    cache->numSalas = cabecalho->numSalas;
+    cache->numPistas = cabecalho->numPistas;
+    cache->numSuspeitos = cabecalho->numSuspeitos;
+    cache->capacidade = capacidade;
+    cache->mascaraBaldes = numBaldes - 1;
+    cache->maisRecente = SEM_INDICE;
+    cache->menosRecente = SEM_INDICE;
+    return cache;
+}
+
+/**
+ * @brief Balde da tabela de índices em que fica uma chave
+ */
+static inline uint32_t baldeDaChave(const CacheSalas* cache, uint32_t chave) {
+    return (uint32_t)(((uint64_t)chave * 0x9E3779B97F4A7C15ull) >> 32) & cache->mascaraBaldes;
+}
+
+/**
+ * @brief Procura um registro na cache, sem alterar a ordem de uso
+ * @param cache Cache de cômodos
+ * @param chave Índice do cômodo, ou CHAVE_PISTA | ID da pista
+ * @return Índice da entrada ou SEM_INDICE se o registro não está na cache
+ */
+uint32_t procurarNaCache(const CacheSalas* cache, uint32_t chave) {
+    uint32_t entrada = cache->baldes[baldeDaChave(cache, chave)];
+    while (entrada != SEM_INDICE && cache->entradas[entrada].chave != chave) {
+        entrada = cache->entradas[entrada].proximoNoBalde;
+    }
+    return entrada;
+}
+
+/**
+ * @brief Tira uma entrada da lista de uso (ela continua na tabela de índices)
+ */
+static inline void desligarEntradaCache(CacheSalas* cache, uint32_t entrada) {
+    EntradaCacheSalas* atual = &cache->entradas[entrada];
+    if (atual->anterior != SEM_INDICE) cache->entradas[atual->anterior].seguinte = atual->seguinte;
+    else cache->maisRecente = atual->seguinte;
+    if (atual->seguinte != SEM_INDICE) cache->entradas[atual->seguinte].anterior = atual->anterior;
+    else cache->menosRecente = atual->anterior;
+}
+
+/**
+ * @brief Põe uma entrada fora da lista de uso no início (a mais recente)
+ */
+static inline void ligarEntradaCache(CacheSalas* cache, uint32_t entrada) {
+    EntradaCacheSalas* atual = &cache->entradas[entrada];
+    atual->anterior = SEM_INDICE;
+    atual->seguinte = cache->maisRecente;
+    if (cache->maisRecente != SEM_INDICE) cache->entradas[cache->maisRecente].anterior = entrada;
+    cache->maisRecente = entrada;
+    if (cache->menosRecente == SEM_INDICE) cache->menosRecente = entrada;
+}
+
+/**
+ * @brief Marca uma entrada como a usada mais recentemente
+ * @param cache Cache de cômodos
+ * @param entrada Índice da entrada
+ */
+void usarEntradaCache(CacheSalas* cache, uint32_t entrada) {
+    if (cache->maisRecente == entrada) return;
+    desligarEntradaCache(cache, entrada);
+    ligarEntradaCache(cache, entrada);
+}
+
+/**
+ * @brief Reserva uma entrada para um registro, descartando a menos usada se a cache está cheia
+ * @param cache Cache de cômodos
+ * @param chave Chave do registro (ainda fora da cache)
+ * @return Índice da entrada, já a mais recente e registrada para "chave"
+ */
+uint32_t reservarEntradaCache(CacheSalas* cache, uint32_t chave) {
+    uint32_t entrada;
+    if (cache->usadas < cache->capacidade) {
+        entrada = cache->usadas++;
+    } else {
+        entrada = cache->menosRecente;
+        desligarEntradaCache(cache, entrada);
+        uint32_t* elo = &cache->baldes[baldeDaChave(cache, cache->entradas[entrada].chave)];
+        while (*elo != entrada) elo = &cache->entradas[*elo].proximoNoBalde;
+        *elo = cache->entradas[entrada].proximoNoBalde;
+    }
+
+    uint32_t balde = baldeDaChave(cache, chave);
+    cache->entradas[entrada].chave = chave;
+    cache->entradas[entrada].proximoNoBalde = cache->baldes[balde];
+    cache->baldes[balde] = entrada;
+    ligarEntradaCache(cache, entrada);
+    return entrada;
+}
+
+/**
+ * @brief Lê do arquivo o texto de uma entrada (nome ou pista), aos poucos
+ * @param cache Cache de cômodos
+ * @param entrada Entrada que recebe o texto (o buffer é reaproveitado)
+ * @param deslocamento Deslocamento do texto no bloco de textos
+ */
+void lerTextoDaEntrada(CacheSalas* cache, EntradaCacheSalas* entrada, uint32_t deslocamento) {
+    size_t usados = 0;
+    for (;;) {
+        uint64_t restantes = deslocamento < cache->tamanhoTextos
+                                 ? (uint64_t)cache->tamanhoTextos - deslocamento - usados : 0;
+        size_t pedir = restantes < LEITURA_TEXTO_CACHE ? (size_t)restantes : LEITURA_TEXTO_CACHE;
+        if (entrada->capacidadeTexto < usados + pedir + 1) {
+            size_t capacidade = entrada->capacidadeTexto ? entrada->capacidadeTexto * 2
+                                                         : LEITURA_TEXTO_CACHE + 1;
+            while (capacidade < usados + pedir + 1) capacidade *= 2;
+            entrada->texto = (char*)realloc(entrada->texto, capacidade);
+            if (entrada->texto == NULL) {
+                printf("Erro de alocação de memória!\n");
+                exit(1);
+            }
+            entrada->capacidadeTexto = capacidade;
+        }
+        if (pedir == 0) {
+            // Texto fora do bloco ou sem terminador: fica o que foi lido
+            entrada->texto[usados] = '\0';
+            return;
+        }
+        if (!lerNoArquivo(cache->fd, entrada->texto + usados, pedir,
+                          cache->inicioTextos + deslocamento + usados)) {
+            fprintf(stderr, "❌ Falha ao ler o arquivo de caso\n");
+            exit(1);
+        }
+        if (memchr(entrada->texto + usados, '\0', pedir) != NULL) return;
+        usados += pedir;
+    }
+}
+
+/**
+ * @brief Lê do arquivo um ou dois cômodos vizinhos que ainda não estão na cache
+ *
+ * Cômodos consecutivos ocupam registros consecutivos, então os dois filhos
+ * de uma sala (vizinhos na ordem de largura) custam uma leitura de cada
+ * seção. Ligações inválidas no arquivo são descartadas com um aviso.
+ *
+ * @param cache Cache de cômodos
+ * @param primeira Índice do primeiro cômodo
+ * @param quantidade 1 ou 2
+ */
+void carregarSalasNaCache(CacheSalas* cache, uint32_t primeira, uint32_t quantidade) {
+    NoMansao nos[2];
+    uint32_t nomes[2];
+    if (!lerNoArquivo(cache->fd, nos, quantidade * sizeof(NoMansao),
+                      cache->inicioNos + (uint64_t)primeira * sizeof(NoMansao)) ||
+        !lerNoArquivo(cache->fd, nomes, quantidade * sizeof(uint32_t),
+                      cache->inicioNomes + (uint64_t)primeira * sizeof(uint32_t))) {
+        fprintf(stderr, "❌ Falha ao ler o cômodo %u do arquivo de caso\n", primeira);
+        exit(1);
+    }
+
+    for (uint32_t k = 0; k < quantidade; k++) {
+        uint32_t sala = primeira + k;
+        if (procurarNaCache(cache, sala) != SEM_INDICE) continue;
+
+        EntradaCacheSalas* entrada = &cache->entradas[reservarEntradaCache(cache, sala)];
+        NoMansao* no = &entrada->no;
+        *no = nos[k];
+
+        // Filhos sempre depois do pai: sem isso um ciclo prenderia o jogador
+        int corrompido = 0;
+        if (no->esquerda != SEM_INDICE && (no->esquerda <= sala || no->esquerda >= cache->numSalas)) {
+            no->esquerda = SEM_INDICE;
+            corrompido = 1;
+        }
+        if (no->direita != SEM_INDICE && (no->direita <= sala || no->direita >= cache->numSalas)) {
+            no->direita = SEM_INDICE;
+            corrompido = 1;
+        }
+        if (no->pista != SEM_INDICE && no->pista >= cache->numPistas) {
+            no->pista = SEM_INDICE;
+            corrompido = 1;
+        }
+        if (corrompido) {
+            fprintf(stderr, "⚠️  Cômodo %u corrompido no arquivo: ligações inválidas ignoradas\n",
+                    sala);
+        }
+        lerTextoDaEntrada(cache, entrada, nomes[k]);
+    }
+}
+
+/**
+ * @brief Devolve um cômodo da cache, lendo-o do arquivo se necessário
+ *
+ * A entrada devolvida continua válida enquanto menos de
+ * CAPACIDADE_MINIMA_CACHE_SALAS outros cômodos forem consultados.
+ *
+ * @param cache Cache de cômodos
+ * @param sala Índice do cômodo (menor que o número de cômodos)
+ * @return Entrada do cômodo
+ */
+EntradaCacheSalas* obterSalaDaCache(CacheSalas* cache, uint32_t sala) {
+    uint32_t entrada = procurarNaCache(cache, sala);
+    if (entrada != SEM_INDICE) {
+        cache->acertos++;
+        usarEntradaCache(cache, entrada);
+        return &cache->entradas[entrada];
+    }
+    cache->faltas++;
+    carregarSalasNaCache(cache, sala, 1);
+    return &cache->entradas[cache->maisRecente];
+}
+
+/**
+ * @brief Devolve uma pista (texto e suspeito) da cache, lendo-a do arquivo se necessário
+ * @param cache Cache de cômodos
+ * @param pista ID da pista (menor que o número de pistas)
+ * @return Entrada da pista, válida como em obterSalaDaCache
+ */
+EntradaCacheSalas* obterPistaDaCache(CacheSalas* cache, uint32_t pista) {
+    uint32_t entrada = procurarNaCache(cache, CHAVE_PISTA | pista);
+    if (entrada != SEM_INDICE) {
+        cache->acertos++;
+        usarEntradaCache(cache, entrada);
+        return &cache->entradas[entrada];
+    }
+    cache->faltas++;
+
+    RegistroPista registro;
+    if (!lerNoArquivo(cache->fd, &registro, sizeof(registro),
+                      cache->inicioPistas + (uint64_t)pista * sizeof(RegistroPista))) {
+        fprintf(stderr, "❌ Falha ao ler o arquivo de caso\n");
+        exit(1);
+    }
+    EntradaCacheSalas* nova = &cache->entradas[reservarEntradaCache(cache, CHAVE_PISTA | pista)];
+    nova->suspeito = registro.suspeito < cache->numSuspeitos ? registro.suspeito : SEM_INDICE;
+    lerTextoDaEntrada(cache, nova, registro.texto);
+    return nova;
+}
+
+/**
+ * @brief Mostra o uso da cache de cômodos
+ * @param tela Tela de saída
+ * @param cache Cache de cômodos
+ */
+void exibirCacheSalas(Tela* tela, const CacheSalas* cache) {
+    escreverTela(tela, "🗄️  Cache sob demanda: %u de %u entradas em uso (%u cômodos e %u pistas "
+                       "no arquivo), %llu acertos, %llu faltas, %llu cômodos antecipados\n",
+                 cache->usadas, cache->capacidade, cache->numSalas, cache->numPistas,
+                 cache->acertos, cache->faltas, cache->antecipadas);
+}
+
+/**
+ * @brief Libera a cache de cômodos e fecha o arquivo do caso
+ * @param cache Cache a ser liberada
+ */
+void liberarCacheSalas(CacheSalas* cache) {
+    for (uint32_t i = 0; i < cache->usadas; i++) {
+        free(cache->entradas[i].texto);
+    }
+    free(cache->entradas);
+    free(cache->baldes);
+    close(cache->fd);
+    free(cache);
+}
+#endif
+
+/**
+ * @brief Lê de antemão os dois filhos de um cômodo
+ *
+ * O menu da sala sempre mostra as duas saídas, então os filhos são lidos
+ * ao entrar no cômodo, numa só leitura quando são vizinhos no arquivo. Os
+ * registros dos netos são só anunciados ao sistema (POSIX_FADV_WILLNEED),
+ * que os traz para o cache de páginas sem bloquear o jogo. Sem cache (mansão
+ * compacta na memória), não faz nada.
+ *
+ * @param mansao Mansão do caso
+ * @param sala Cômodo em que o jogador acabou de entrar
+ */
+void anteciparFilhos(const Mansao* mansao, uint32_t sala) {
+#ifndef _WIN32
+    CacheSalas* cache = mansao->cache;
+    if (cache == NULL) return;
+
+    NoMansao no = obterSalaDaCache(cache, sala)->no;
+    uint32_t filhos[2] = {no.esquerda, no.direita};
+    int faltam[2];
+    for (int j = 0; j < 2; j++) {
+        faltam[j] = filhos[j] != SEM_INDICE && procurarNaCache(cache, filhos[j]) == SEM_INDICE;
+    }
+    if (faltam[0] && faltam[1] && filhos[1] == filhos[0] + 1) {
+        carregarSalasNaCache(cache, filhos[0], 2);
+        cache->antecipadas += 2;
+    } else {
+        for (int j = 0; j < 2; j++) {
+            if (!faltam[j]) continue;
+            carregarSalasNaCache(cache, filhos[j], 1);
+            cache->antecipadas++;
+        }
+    }
+
+    uint32_t menor = SEM_INDICE, maior = 0;
+    for (int j = 0; j < 2; j++) {
+        uint32_t entrada = filhos[j] != SEM_INDICE ? procurarNaCache(cache, filhos[j]) : SEM_INDICE;
+        if (entrada == SEM_INDICE) continue;
+        uint32_t netos[2] = {cache->entradas[entrada].no.esquerda,
+                             cache->entradas[entrada].no.direita};
+        for (int k = 0; k < 2; k++) {
+            if (netos[k] == SEM_INDICE) continue;
+            if (netos[k] < menor) menor = netos[k];
+            if (netos[k] > maior) maior = netos[k];
+        }
+    }
+    if (menor != SEM_INDICE && maior - menor < MAX_ANTECIPACAO_SALAS) {
+        uint64_t quantidade = (uint64_t)(maior - menor) + 1;
+        posix_fadvise(cache->fd, (off_t)(cache->inicioNos + (uint64_t)menor * sizeof(NoMansao)),
+                      (off_t)(quantidade * sizeof(NoMansao)), POSIX_FADV_WILLNEED);
+        posix_fadvise(cache->fd, (off_t)(cache->inicioNomes + (uint64_t)menor * sizeof(uint32_t)),
+                      (off_t)(quantidade * sizeof(uint32_t)), POSIX_FADV_WILLNEED);
+    }
+#else
+    (void)mansao;
+    (void)sala;
+#endif
+}
+
+// ========== FUNÇÕES PARA O CADERNO DE PISTAS (ÁRVORE B) ==========
+
+/**
+ * @brief Inicializa um caderno de pistas vazio
+ * @param caderno Caderno a ser inicializado
+ * @param pool Pool de onde os nós da árvore B são alocados
+ */
+void inicializarCaderno(CadernoPistas* caderno, PoolNos* pool) {
+    caderno->raiz = NULL;
+    caderno->pool = pool;
+    caderno->quantidade = 0;
+}
+
+/**
+ * @brief Cria um nó vazio da árvore B
+ * @param caderno Caderno dono do nó
+ * @param folha 1 se o nó é folha
+ * @return Ponteiro para o nó criado
+ */
+NoCaderno* criarNoCaderno(CadernoPistas* caderno, int folha) {
+    NoCaderno* no = (NoCaderno*)alocarNo(caderno->pool);
+    no->quantidade = 0;
+    no->folha = folha;
+    return no;
+}
+
+/**
+ * @brief Busca binária dentro de um nó
+ * @param no Nó da árvore B
+ * @param pista ID da pista procurada
+ * @param encontrada Recebe 1 se a pista está no nó
+ * @return Índice da primeira pista do nó maior ou igual à procurada
+ */
+int posicaoNoCaderno(const NoCaderno* no, uint32_t pista, int* encontrada) {
+    int inicio = 0, fim = no->quantidade;
+
+    while (inicio < fim) {
+        int meio = (inicio + fim) / 2;
+        if (no->pistas[meio] < pista) inicio = meio + 1;
+        else fim = meio;
+    }
+    *encontrada = inicio < no->quantidade && no->pistas[inicio] == pista;
+    return inicio;
+}
+
+/**
+ * @brief Divide o filho cheio pai->filhos[i], subindo a pista do meio para o pai
+ * @param caderno Caderno dono dos nós
+ * @param pai Nó pai (não cheio)
+ * @param i Índice do filho cheio
+ */
+void dividirFilhoCaderno(CadernoPistas* caderno, NoCaderno* pai, int i) {
+    NoCaderno* cheio = pai->filhos[i];
+    NoCaderno* novo = criarNoCaderno(caderno, cheio->folha);
+
+    novo->quantidade = GRAU_CADERNO - 1;
+    memcpy(novo->pistas, cheio->pistas + GRAU_CADERNO, (GRAU_CADERNO - 1) * sizeof(uint32_t));
+    if (!cheio->folha) {
+        memcpy(novo->filhos, cheio->filhos + GRAU_CADERNO, GRAU_CADERNO * sizeof(NoCaderno*));
+    }
+    cheio->quantidade = GRAU_CADERNO - 1;
+
+    memmove(pai->filhos + i + 2, pai->filhos + i + 1, (pai->quantidade - i) * sizeof(NoCaderno*));
+    memmove(pai->pistas + i + 1, pai->pistas + i, (pai->quantidade - i) * sizeof(uint32_t));
+    pai->filhos[i + 1] = novo;
+    pai->pistas[i] = cheio->pistas[GRAU_CADERNO - 1];
+    pai->quantidade++;
+}
+
+/**
+ * @brief Verifica se uma pista já está no caderno
+ * @param caderno Caderno de pistas
+ * @param pista ID da pista procurada
+ * @return 1 se a pista foi coletada, 0 caso contrário
+ */
+int buscarPista(const CadernoPistas* caderno, uint32_t pista) {
+    const NoCaderno* no = caderno->raiz;
+
+    while (no != NULL) {
+        int encontrada;
+        int i = posicaoNoCaderno(no, pista, &encontrada);
+        if (encontrada) return 1;
+        no = no->folha ? NULL : no->filhos[i];
+    }
+    return 0;
+}
+
+/**
+ * @brief Insere uma pista no caderno mantendo a ordem alfabética (a ordem
+ *        dos IDs). A descida é iterativa e divide nós cheios no caminho,
+ *        então a árvore nunca precisa ser percorrida de volta.
+ * @param caderno Caderno de pistas
+ * @param pista ID da pista a ser inserida
+ * @return 1 se inserida, 0 se a pista já estava no caderno
+ */
+int inserirPista(CadernoPistas* caderno, uint32_t pista) {
+    if (estatisticas.ligadas) medirInsercaoCaderno(caderno, pista);
+    
+    // Pista duplicada (não insere)
+    if (buscarPista(caderno, pista)) return 0;
+
+    if (caderno->raiz == NULL) {
+        caderno->raiz = criarNoCaderno(caderno, 1);
+    } else if (caderno->raiz->quantidade == MAX_PISTAS_NO) {
+        // Raiz cheia: a árvore cresce um nível
+        NoCaderno* novaRaiz = criarNoCaderno(caderno, 0);
+        novaRaiz->filhos[0] = caderno->raiz;
+        caderno->raiz = novaRaiz;
+        dividirFilhoCaderno(caderno, novaRaiz, 0);
+    }
+
+    NoCaderno* no = caderno->raiz;
+    int encontrada;
+    while (!no->folha) {
+        int i = posicaoNoCaderno(no, pista, &encontrada);
+        if (no->filhos[i]->quantidade == MAX_PISTAS_NO) {
+            dividirFilhoCaderno(caderno, no, i);
+            if (pista > no->pistas[i]) i++;
+        }
+        no = no->filhos[i];
+    }
+
+    int i = posicaoNoCaderno(no, pista, &encontrada);
+    memmove(no->pistas + i + 1, no->pistas + i, (no->quantidade - i) * sizeof(uint32_t));
+    no->pistas[i] = pista;
+    no->quantidade++;
+    caderno->quantidade++;
+    return 1;
+}
+
+/**
+ * @brief Junta pai->filhos[i], a pista pai->pistas[i] e pai->filhos[i + 1]
+ *        em um único nó (os dois filhos têm GRAU_CADERNO - 1 pistas)
+ * @param caderno Caderno dono dos nós
+ * @param pai Nó pai
+ * @param i Índice do filho da esquerda
+ */
+void juntarFilhosCaderno(CadernoPistas* caderno, NoCaderno* pai, int i) {
+    NoCaderno* esquerdo = pai->filhos[i];
+    NoCaderno* direito = pai->filhos[i + 1];
+
+    esquerdo->pistas[esquerdo->quantidade] = pai->pistas[i];
+    memcpy(esquerdo->pistas + esquerdo->quantidade + 1, direito->pistas,
+           direito->quantidade * sizeof(uint32_t));
+    if (!esquerdo->folha) {
+        memcpy(esquerdo->filhos + esquerdo->quantidade + 1, direito->filhos,
+               (direito->quantidade + 1) * sizeof(NoCaderno*));
+    }
+    esquerdo->quantidade += direito->quantidade + 1;
+
+    memmove(pai->pistas + i, pai->pistas + i + 1, (pai->quantidade - i - 1) * sizeof(uint32_t));
+    memmove(pai->filhos + i + 1, pai->filhos + i + 2, (pai->quantidade - i - 1) * sizeof(NoCaderno*));
+    pai->quantidade--;
+
+    liberarNo(caderno->pool, direito);
+}
+
+/**
+ * @brief Garante que pai->filhos[i] tenha ao menos GRAU_CADERNO pistas antes
+ *        da descida, emprestando de um irmão ou juntando-se a ele
+ * @param caderno Caderno dono dos nós
+ * @param pai Nó pai
+ * @param i Índice do filho
+ * @return Índice do filho que contém o intervalo original após o ajuste
+ */
+int reforcarFilhoCaderno(CadernoPistas* caderno, NoCaderno* pai, int i) {
+    NoCaderno* filho = pai->filhos[i];
+    if (filho->quantidade >= GRAU_CADERNO) return i;
+
+    if (i > 0 && pai->filhos[i - 1]->quantidade >= GRAU_CADERNO) {
+        // Empresta a última pista do irmão esquerdo através do pai
+        NoCaderno* irmao = pai->filhos[i - 1];
+        memmove(filho->pistas + 1, filho->pistas, filho->quantidade * sizeof(uint32_t));
+        if (!filho->folha) {
+            memmove(filho->filhos + 1, filho->filhos, (filho->quantidade + 1) * sizeof(NoCaderno*));
+            filho->filhos[0] = irmao->filhos[irmao->quantidade];
+        }
+        filho->pistas[0] = pai->pistas[i - 1];
+        pai->pistas[i - 1] = irmao->pistas[irmao->quantidade - 1];
+        filho->quantidade++;
+        irmao->quantidade--;
+        return i;
+    }
+
+    if (i < pai->quantidade && pai->filhos[i + 1]->quantidade >= GRAU_CADERNO) {
+        // Empresta a primeira pista do irmão direito através do pai
+        NoCaderno* irmao = pai->filhos[i + 1];
+        filho->pistas[filho->quantidade] = pai->pistas[i];
+        if (!filho->folha) {
+            filho->filhos[filho->quantidade + 1] = irmao->filhos[0];
+            memmove(irmao->filhos, irmao->filhos + 1, irmao->quantidade * sizeof(NoCaderno*));
+        }
+        pai->pistas[i] = irmao->pistas[0];
+        memmove(irmao->pistas, irmao->pistas + 1, (irmao->quantidade - 1) * sizeof(uint32_t));
+        filho->quantidade++;
+        irmao->quantidade--;
+        return i;
+    }
+
+    if (i < pai->quantidade) {
+        juntarFilhosCaderno(caderno, pai, i);
+        return i;
+    }
+    juntarFilhosCaderno(caderno, pai, i - 1);
+    return i - 1;
+}
+
+/**
+ * @brief Remove uma pista do caderno (descida única, sem recursão)
+ * @param caderno Caderno de pistas
+ * @param pista ID da pista a ser removida
+ * @return 1 se removida, 0 se a pista não estava no caderno
+ */
+int removerPista(CadernoPistas* caderno, uint32_t pista) {
+    if (!buscarPista(caderno, pista)) return 0;
+
+    NoCaderno* no = caderno->raiz;
+    uint32_t alvo = pista;
+
+    while (1) {
+        int encontrada;
+        int i = posicaoNoCaderno(no, alvo, &encontrada);
+
+        if (no->folha) {
+            // A pista está aqui: a descida garantiu que a folha pode perdê-la
+            memmove(no->pistas + i, no->pistas + i + 1, (no->quantidade - i - 1) * sizeof(uint32_t));
+            no->quantidade--;
+            break;
+        }
+
+        if (encontrada) {
+            NoCaderno* esquerdo = no->filhos[i];
+            NoCaderno* direito = no->filhos[i + 1];
+
+            if (esquerdo->quantidade >= GRAU_CADERNO) {
+                // Substitui pelo predecessor e passa a removê-lo da subárvore esquerda
+                const NoCaderno* atual = esquerdo;
+                while (!atual->folha) atual = atual->filhos[atual->quantidade];
+                alvo = no->pistas[i] = atual->pistas[atual->quantidade - 1];
+                no = esquerdo;
+            } else if (direito->quantidade >= GRAU_CADERNO) {
+                // Substitui pelo sucessor e passa a removê-lo da subárvore direita
+                const NoCaderno* atual = direito;
+                while (!atual->folha) atual = atual->filhos[0];
+                alvo = no->pistas[i] = atual->pistas[0];
+                no = direito;
+            } else {
+                // Os dois filhos estão no mínimo: junta e continua no nó resultante
+                juntarFilhosCaderno(caderno, no, i);
+                no = esquerdo;
+            }
+            continue;
+        }
+
+        no = no->filhos[reforcarFilhoCaderno(caderno, no, i)];
+    }
+
+    // A raiz esvaziada dá lugar ao único filho (ou a árvore fica vazia)
+    NoCaderno* raiz = caderno->raiz;
+    if (raiz->quantidade == 0) {
+        caderno->raiz = raiz->folha ? NULL : raiz->filhos[0];
+        liberarNo(caderno->pool, raiz);
+    }
+
+    caderno->quantidade--;
+    return 1;
+}
+
+/**
+ * @brief Posiciona um iterador na primeira pista (ordem alfabética)
+ * @param iterador Iterador a ser iniciado
+ * @param caderno Caderno a ser percorrido
+ */
+void iniciarIteradorCaderno(IteradorCaderno* iterador, const CadernoPistas* caderno) {
+    iterador->topo = -1;
+
+    const NoCaderno* no = caderno->raiz;
+    while (no != NULL) {
+        iterador->topo++;
+        iterador->nos[iterador->topo] = no;
+        iterador->indices[iterador->topo] = 0;
+        no = no->folha ? NULL : no->filhos[0];
+    }
+}
+
+/**
+ * @brief Avança o iterador em ordem (percurso in-order com pilha explícita)
+ * @param iterador Iterador iniciado por iniciarIteradorCaderno
+ * @param pista Recebe o ID da próxima pista
+ * @return 1 se havia uma pista, 0 ao final do caderno
+ */
+int proximaPistaCaderno(IteradorCaderno* iterador, uint32_t* pista) {
+    while (iterador->topo >= 0) {
+        const NoCaderno* no = iterador->nos[iterador->topo];
+        int i = iterador->indices[iterador->topo];
+
+        if (i >= no->quantidade) {
+            iterador->topo--;
+            continue;
+        }
+
+        *pista = no->pistas[i];
+        iterador->indices[iterador->topo] = i + 1;
+
+        // Antes da próxima pista deste nó vem toda a subárvore à sua direita
+        if (!no->folha) {
+            const NoCaderno* filho = no->filhos[i + 1];
+            while (filho != NULL) {
+                iterador->topo++;
+                iterador->nos[iterador->topo] = filho;
+                iterador->indices[iterador->topo] = 0;
+                filho = filho->folha ? NULL : filho->filhos[0];
+            }
+        }
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Lista todas as pistas coletadas em ordem alfabética (in-order traversal)
+ * @param tela Tela de saída
+ * @param caderno Caderno de pistas
+ * @param caso Caso com os textos das pistas
+ */
+void listarPistasOrdenadas(Tela* tela, const CadernoPistas* caderno, const Caso* caso) {
+    IteradorCaderno iterador;
+    iniciarIteradorCaderno(&iterador, caderno);
+
+    uint32_t pista;
+    while (proximaPistaCaderno(&iterador, &pista)) {
+        escreverTela(tela, "• %s\n", textoPista(caso, pista));
+    }
+}
+
+// ========== FUNÇÕES DO CADERNO COMPARTILHADO DA EQUIPE ==========
+
+/**
+ * @brief Inicia um caderno de equipe vazio
+ * @param caderno Caderno a ser iniciado
+ * @param caso Caso investigado pela equipe
+ */
+void inicializarCadernoCompartilhado(CadernoCompartilhado* caderno, const Caso* caso) {
+    caderno->cabeca = criarNoCompartilhado(SEM_INDICE, NIVEIS_CADERNO_COMPARTILHADO);
+    caderno->caso = caso;
+    atomic_init(&caderno->publicadas, 0);
+    caderno->pontos = (_Atomic uint32_t*)malloc(((size_t)caso->suspeitos.quantidade + 1) *
+                                                sizeof(_Atomic uint32_t));
+    if (caderno->pontos == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    // Um contador a mais, para o vetor nunca ter tamanho zero; todos começam zerados
+    for (uint32_t s = 0; s <= caso->suspeitos.quantidade; s++) atomic_init(&caderno->pontos[s], 0);
+}
+
+/**
+ * @brief Sorteia a altura de uma pista na lista com saltos
+ *
+ * O sorteio parte do próprio ID, então a mesma pista tem sempre a mesma
+ * altura: cada nível tem metade dos nós do nível de baixo.
+ *
+ * @param pista ID da pista
+ * @return Altura entre 1 e NIVEIS_CADERNO_COMPARTILHADO
+ */
+uint32_t alturaNoCompartilhado(uint32_t pista) {
+    uint64_t estado = ((uint64_t)pista + 1) * 0x9E3779B97F4A7C15ULL;
+    uint64_t bits = proximoAleatorio(&estado) | (1ULL << (NIVEIS_CADERNO_COMPARTILHADO - 1));
+    uint32_t altura = 1;
+    while (!(bits & 1)) {
+        bits >>= 1;
+        altura++;
+    }
+    return altura;
+}
+
+/**
+ * @brief Aloca um nó ainda sem número de publicação
+ * @param pista ID da pista (SEM_INDICE na sentinela)
+ * @param altura Níveis do nó
+ * @return Nó com os ponteiros nulos
+ */
+NoCompartilhado* criarNoCompartilhado(uint32_t pista, uint32_t altura) {
+    NoCompartilhado* no = (NoCompartilhado*)malloc(sizeof(NoCompartilhado) +
+                                                   altura * sizeof(_Atomic(NoCompartilhado*)));
+    if (no == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    no->pista = pista;
+    no->altura = altura;
+    atomic_init(&no->ordem, ORDEM_PENDENTE);
+    for (uint32_t nivel = 0; nivel < altura; nivel++) atomic_init(&no->proximos[nivel], NULL);
+    return no;
+}
+
+/**
+ * @brief Encontra, em cada nível, o último nó antes da pista e o seguinte
+ * @param caderno Caderno da equipe
+ * @param pista ID procurado
+ * @param antecessores Recebe, por nível, o último nó com ID menor (ou a cabeça)
+ * @param sucessores Recebe, por nível, o primeiro nó com ID maior ou igual (ou NULL)
+ */
+void procurarNoCompartilhado(const CadernoCompartilhado* caderno, uint32_t pista,
+                             NoCompartilhado** antecessores, NoCompartilhado** sucessores) {
+    NoCompartilhado* atual = caderno->cabeca;
+    for (int nivel = NIVEIS_CADERNO_COMPARTILHADO - 1; nivel >= 0; nivel--) {
+        NoCompartilhado* proximo = atomic_load_explicit(&atual->proximos[nivel], memory_order_acquire);
+        while (proximo != NULL && proximo->pista < pista) {
+            atual = proximo;
+            proximo = atomic_load_explicit(&atual->proximos[nivel], memory_order_acquire);
+        }
+        antecessores[nivel] = atual;
+        sucessores[nivel] = proximo;
+    }
+}
+
+/**
+ * @brief Espera o número de publicação de um nó recém-ligado
+ *
+ * Entre o CAS que liga o nó e a numeração há só um incremento atômico,
+ * então a espera é curta e só acontece com a mesma pista em disputa.
+ *
+ * @param no Nó já ligado ao nível 0
+ * @return Número de publicação do nó
+ */
+uint64_t esperarOrdemCompartilhada(NoCompartilhado* no) {
+    uint64_t ordem;
+    while ((ordem = atomic_load_explicit(&no->ordem, memory_order_acquire)) == ORDEM_PENDENTE) {
+#ifndef _WIN32
+        sched_yield();
+#endif
+    }
+    return ordem;
+}
+
+/**
+ * @brief Anota uma pista no caderno da equipe, sem trava
+ *
+ * A pista entra com o CAS no nível 0; se outro detetive ligou um nó no
+ * mesmo lugar antes, a busca é refeita e, achando a mesma pista, o nó novo
+ * é descartado. Depois da ligação vêm o número de publicação, os pontos da
+ * equipe e os atalhos dos níveis de cima. Quem perde a disputa só volta
+ * depois que a pista do vencedor foi numerada, para que uma foto tirada em
+ * seguida já a contenha.
+ *
+ * @param caderno Caderno da equipe
+ * @param pista ID da pista
+ * @return 1 se a pista era nova para a equipe, 0 se já estava no caderno
+ */
+int inserirNoCompartilhado(CadernoCompartilhado* caderno, uint32_t pista) {
+    NoCompartilhado* antecessores[NIVEIS_CADERNO_COMPARTILHADO];
+    NoCompartilhado* sucessores[NIVEIS_CADERNO_COMPARTILHADO];
+    NoCompartilhado* novo = NULL;
+
+    for (;;) {
+        procurarNoCompartilhado(caderno, pista, antecessores, sucessores);
+        if (sucessores[0] != NULL && sucessores[0]->pista == pista) {
+            free(novo);
+            esperarOrdemCompartilhada(sucessores[0]);
+            return 0;
+        }
+        if (novo == NULL) novo = criarNoCompartilhado(pista, alturaNoCompartilhado(pista));
+        for (uint32_t nivel = 0; nivel < novo->altura; nivel++) {
+            atomic_store_explicit(&novo->proximos[nivel], sucessores[nivel], memory_order_relaxed);
+        }
+        NoCompartilhado* esperado = sucessores[0];
+        if (atomic_compare_exchange_strong_explicit(&antecessores[0]->proximos[0], &esperado, novo,
+                                                    memory_order_release, memory_order_relaxed)) {
+            break;
+        }
+    }
+
+    // Liberação: quem lê "publicadas" já enxerga a ligação deste nó
+    uint64_t ordem = atomic_fetch_add_explicit(&caderno->publicadas, 1, memory_order_acq_rel);
+    atomic_store_explicit(&novo->ordem, ordem, memory_order_release);
+
+    // Pontos da equipe, com os mesmos pesos do placar de cada sessão
+    const Caso* caso = caderno->caso;
+    uint32_t fim;
+    uint32_t i = buscarEvidencias(caso, pista, &fim);
+    if (i == fim) {
+        uint32_t suspeito = suspeitoDePista(caso, pista);
+        if (suspeito != SEM_INDICE) {
+            atomic_fetch_add_explicit(&caderno->pontos[suspeito], 1, memory_order_relaxed);
+        }
+    }
+    for (; i < fim; i++) {
+        atomic_fetch_add_explicit(&caderno->pontos[caso->evidencias[i].suspeito],
+                                  caso->evidencias[i].peso, memory_order_relaxed);
+    }
+
+    // Atalhos: um CAS por nível, refazendo a busca quando a vizinhança mudou
+    for (uint32_t nivel = 1; nivel < novo->altura; nivel++) {
+        for (;;) {
+            NoCompartilhado* esperado = sucessores[nivel];
+            atomic_store_explicit(&novo->proximos[nivel], esperado, memory_order_relaxed);
+            if (atomic_compare_exchange_strong_explicit(&antecessores[nivel]->proximos[nivel],
+                                                        &esperado, novo, memory_order_release,
+                                                        memory_order_relaxed)) {
+                break;
+            }
+            procurarNoCompartilhado(caderno, pista, antecessores, sucessores);
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Tira uma foto consistente do caderno da equipe, sem bloquear ninguém
+ *
+ * Com publicadas = N na hora da foto, entram exatamente as pistas de número
+ * menor que N: todas já estão ligadas, e as ligadas depois recebem números
+ * maiores. O percurso do nível 0 sai em ordem de ID (alfabética) e para ao
+ * juntar as N pistas.
+ *
+ * @param caderno Caderno da equipe
+ * @param quantidade Recebe o número de pistas da foto
+ * @return IDs das pistas em ordem (liberar com free)
+ */
+uint32_t* fotografarCadernoCompartilhado(const CadernoCompartilhado* caderno, size_t* quantidade) {
+    uint64_t publicadas = atomic_load_explicit(&caderno->publicadas, memory_order_acquire);
+    uint32_t* pistas = (uint32_t*)malloc(((size_t)publicadas + 1) * sizeof(uint32_t));
+    if (pistas == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+
+    size_t total = 0;
+    NoCompartilhado* no = atomic_load_explicit(&caderno->cabeca->proximos[0], memory_order_acquire);
+    while (total < publicadas && no != NULL) {
+        if (esperarOrdemCompartilhada(no) < publicadas) pistas[total++] = no->pista;
+        no = atomic_load_explicit(&no->proximos[0], memory_order_acquire);
+    }
+    *quantidade = total;
+    return pistas;
+}
+
+/**
+ * @brief Lista as pistas da equipe em ordem alfabética, a partir de uma foto
+ * @param tela Tela de saída
+ * @param caderno Caderno da equipe
+ */
+void listarPistasCompartilhadas(Tela* tela, const CadernoCompartilhado* caderno) {
+    size_t quantidade;
+    uint32_t* pistas = fotografarCadernoCompartilhado(caderno, &quantidade);
+    for (size_t i = 0; i < quantidade; i++) {
+        escreverTela(tela, "• %s\n", textoPista(caderno->caso, pistas[i]));
+    }
+    free(pistas);
+}
+
+/**
+ * @brief Libera o caderno da equipe (nenhuma sessão pode estar usando)
+ * @param caderno Caderno da equipe
+ */
+void liberarCadernoCompartilhado(CadernoCompartilhado* caderno) {
+    NoCompartilhado* no = caderno->cabeca;
+    while (no != NULL) {
+        NoCompartilhado* proximo = atomic_load_explicit(&no->proximos[0], memory_order_relaxed);
+        free(no);
+        no = proximo;
+    }
+    free((void*)caderno->pontos);
+    caderno->cabeca = NULL;
+    caderno->pontos = NULL;
+}
+
+// ========== FUNÇÕES DO ÍNDICE DE PALAVRAS DAS PISTAS ==========
+
+// Letra base de cada caractere Latin-1 de U+00C0 a U+00DF (e de U+00E0 a
+// U+00FF, mesma posição); '\0' separa palavras (× e ÷)
+static const char LETRAS_LATIN1[] = "aaaaaaaceeeeiiiidnooooo\0ouuuuyts";
+
+/**
+ * @brief Extrai a próxima palavra de um texto, normalizada para a busca
+ *
+ * Palavras são sequências de letras e dígitos; maiúsculas viram minúsculas
+ * e letras acentuadas (UTF-8 de U+00C0 a U+00FF) perdem o acento, então
+ * "Página" e "pagina" são a mesma palavra. Outros caracteres UTF-8 entram
+ * como estão. Só as MAX_PALAVRA_INDICE primeiras letras são guardadas.
+ *
+ * @param cursor Posição no texto (avança até depois da palavra)
+ * @param palavra Destino com MAX_PALAVRA_INDICE + 1 bytes
+ * @return Tamanho da palavra, ou 0 se o texto acabou
+ */
+size_t proximaPalavra(const char** cursor, char* palavra) {
+    const unsigned char* c = (const unsigned char*)*cursor;
+    size_t tamanho = 0;
+    while (*c != '\0') {
+        char letra = 0;
+        size_t largura = 1;
+        if (*c < 0x80) {
+            if (isalnum(*c)) letra = (char)tolower(*c);
+        } else if (*c == 0xC3 && c[1] >= 0x80 && c[1] <= 0xBF) {
+            largura = 2;
+            letra = c[1] == 0xBF ? 'y' : LETRAS_LATIN1[c[1] & 0x1F];
+        } else {
+            letra = (char)*c;
+        }
+        
+        if (letra == 0) {
+            c += largura;
+            if (tamanho > 0) break;
+            continue;
+        }
+        if (tamanho < MAX_PALAVRA_INDICE) palavra[tamanho++] = letra;
+        c += largura;
+    }
+    *cursor = (const char*)c;
+    palavra[tamanho] = '\0';
+    return tamanho;
+}
+
+/**
+ * @brief Prepara um índice vazio
+ * @param indice Índice a ser iniciado
+ * @param arena Arena da sessão, de onde vêm os nós
+ */
+void inicializarIndicePistas(IndicePistas* indice, Arena* arena) {
+    memset(indice, 0, sizeof(IndicePistas));
+    indice->arena = arena;
+}
+
+/**
+ * @brief Acrescenta as palavras de uma pista recém-coletada ao índice
+ *
+ * Cada palavra desce pela trie criando os nós que faltam e ganha a pista
+ * na frente da sua lista; como as palavras de uma pista são indexadas
+ * juntas, uma palavra repetida na mesma pista é reconhecida pela cabeça da
+ * lista.
+ *
+ * @param indice Índice da sessão
+ * @param texto Texto da pista
+ * @param pista ID da pista
+ */
+void indexarPista(IndicePistas* indice, const char* texto, uint32_t pista) {
+    char palavra[MAX_PALAVRA_INDICE + 1];
+    size_t tamanho;
+    while ((tamanho = proximaPalavra(&texto, palavra)) > 0) {
+        NoIndicePistas* no = &indice->raiz;
+        for (size_t i = 0; i < tamanho; i++) {
+            unsigned char letra = (unsigned char)palavra[i];
+            NoIndicePistas* filho = no->filho;
+            while (filho != NULL && filho->letra != letra) filho = filho->irmao;
+            if (filho == NULL) {
+                filho = (NoIndicePistas*)alocarNaArena(indice->arena, sizeof(NoIndicePistas));
+                filho->filho = NULL;
+                filho->irmao = no->filho;
+                filho->ocorrencias = NULL;
+                filho->letra = letra;
+                no->filho = filho;
+            }
+            no = filho;
+        }
+        
+        if (no->ocorrencias != NULL && no->ocorrencias->pista == pista) continue;
+        if (no->ocorrencias == NULL) indice->numPalavras++;
+        OcorrenciaPista* ocorrencia =
+            (OcorrenciaPista*)alocarNaArena(indice->arena, sizeof(OcorrenciaPista));
+        ocorrencia->pista = pista;
+        ocorrencia->proxima = no->ocorrencias;
+        no->ocorrencias = ocorrencia;
+        indice->numOcorrencias++;
+    }
+}
+
+/**
+ * @brief Junta ao termo atual as pistas de um nó e de todas as palavras abaixo dele
+ * @param no Nó onde termina o prefixo procurado
+ * @param resultado Resultado com o vetor "termo" a preencher
+ */
+void coletarOcorrencias(const NoIndicePistas* no, ResultadoBusca* resultado) {
+    for (const OcorrenciaPista* ocorrencia = no->ocorrencias; ocorrencia != NULL;
+         ocorrencia = ocorrencia->proxima) {
+        if (resultado->quantidadeTermo == resultado->capacidadeTermo) {
+            resultado->capacidadeTermo = resultado->capacidadeTermo ? resultado->capacidadeTermo * 2 : 64;
+            resultado->termo = (uint32_t*)realloc(resultado->termo,
+                                                  resultado->capacidadeTermo * sizeof(uint32_t));
+            if (resultado->termo == NULL) {
+                printf("Erro de alocação de memória!\n");
+                exit(1);
+            }
+        }
+        resultado->termo[resultado->quantidadeTermo++] = ocorrencia->pista;
+    }
+    
+    // A profundidade é limitada por MAX_PALAVRA_INDICE
+    for (const NoIndicePistas* filho = no->filho; filho != NULL; filho = filho->irmao) {
+        coletarOcorrencias(filho, resultado);
+    }
+}
+
+/**
+ * @brief Busca as pistas coletadas que contêm palavras com os prefixos dados
+ *
+ * Cada palavra da consulta é um prefixo ("ven" acha "veneno" e "venenos");
+ * com mais de uma, valem as pistas que atendem a todas. Cada termo desce
+ * pela trie até o fim do prefixo e junta só as ocorrências abaixo dele, então
+ * o custo acompanha o tamanho do resultado, não o do caderno.
+ *
+ * @param indice Índice da sessão
+ * @param consulta Palavras ou prefixos separados por espaços
+ * @param resultado Recebe os IDs das pistas em ordem alfabética
+ * @return Quantidade de pistas encontradas (0 para consulta vazia)
+ */
+size_t buscarPistas(const IndicePistas* indice, const char* consulta, ResultadoBusca* resultado) {
+    char termo[MAX_PALAVRA_INDICE + 1];
+    size_t tamanho;
+    int primeiro = 1;
+    resultado->quantidade = 0;
+    
+    while ((tamanho = proximaPalavra(&consulta, termo)) > 0) {
+        const NoIndicePistas* no = &indice->raiz;
+        for (size_t i = 0; i < tamanho && no != NULL; i++) {
+            no = no->filho;
+            while (no != NULL && no->letra != (unsigned char)termo[i]) no = no->irmao;
+        }
+        
+        // Pistas do termo, ordenadas e sem repetição (uma pista pode ter
+        // várias palavras com o mesmo prefixo)
+        resultado->quantidadeTermo = 0;
+        if (no != NULL) coletarOcorrencias(no, resultado);
+        if (resultado->quantidadeTermo > 1) {
+            qsort(resultado->termo, resultado->quantidadeTermo, sizeof(uint32_t), compararIds);
+        }
+        size_t unicas = 0;
+        for (size_t i = 0; i < resultado->quantidadeTermo; i++) {
+            if (unicas == 0 || resultado->termo[unicas - 1] != resultado->termo[i]) {
+                resultado->termo[unicas++] = resultado->termo[i];
+            }
+        }
+        
+        if (primeiro) {
+            // O primeiro termo vira o resultado (troca de vetores, sem cópia)
+            uint32_t* pistas = resultado->pistas;
+            size_t capacidade = resultado->capacidade;
+            resultado->pistas = resultado->termo;
+            resultado->capacidade = resultado->capacidadeTermo;
+            resultado->quantidade = unicas;
+            resultado->termo = pistas;
+            resultado->capacidadeTermo = capacidade;
+            primeiro = 0;
+        } else {
+            // Interseção de duas listas ordenadas, no lugar
+            size_t i = 0, j = 0, mantidas = 0;
+            while (i < resultado->quantidade && j < unicas) {
+                if (resultado->pistas[i] < resultado->termo[j]) i++;
+                else if (resultado->pistas[i] > resultado->termo[j]) j++;
+                else {
+                    resultado->pistas[mantidas++] = resultado->pistas[i];
+                    i++;
+                    j++;
+                }
+            }
+            resultado->quantidade = mantidas;
+        }
+        if (resultado->quantidade == 0) break;
+    }
+    return resultado->quantidade;
+}
+
+/**
+ * @brief Prepara um resultado de busca vazio
+ * @param resultado Resultado a ser iniciado
+ */
+void inicializarResultadoBusca(ResultadoBusca* resultado) {
+    memset(resultado, 0, sizeof(ResultadoBusca));
+}
+
+/**
+ * @brief Libera os vetores de um resultado de busca
+ * @param resultado Resultado a ser liberado
+ */
+void liberarResultadoBusca(ResultadoBusca* resultado) {
+    free(resultado->pistas);
+    free(resultado->termo);
+    inicializarResultadoBusca(resultado);
+}
+
+/**
+ * @brief Compara dois IDs de 32 bits (para qsort)
+ */
+int compararIds(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+// ========== FUNÇÕES PARA TABELA HASH ==========
+
+/**
+ * @brief Rotaciona um inteiro de 64 bits para a esquerda
+ */
+static inline uint64_t rotacionar64(uint64_t valor, int bits) {
+    return (valor << bits) | (valor >> (64 - bits));
+}
+
+/**
+ * @brief Mistura um bloco de 8 bytes da chave (etapa do MurmurHash3)
+ */
+static inline uint64_t misturarBloco(uint64_t bloco) {
+    bloco *= 0x87c37b91114253d5ull;
+    bloco = rotacionar64(bloco, 31);
+    return bloco * 0x4cf5ad432745937full;
+}
+
+/**
+ * @brief Função hash de 64 bits, lendo a chave 8 bytes por vez
+ * @param chave String a ser hasheada
+ * @return Hash da chave (nunca 0, valor reservado para posição vazia)
+ */
+uint64_t hash(const char* chave) {
+    size_t comprimento = strlen(chave);
+    const unsigned char* bytes = (const unsigned char*)chave;
+    uint64_t valor = 0x9e3779b97f4a7c15ull ^ comprimento;
+    size_t restante = comprimento;
+
+    while (restante >= 8) {
+        uint64_t bloco;
+        memcpy(&bloco, bytes, 8);
+        valor ^= misturarBloco(bloco);
+        valor = rotacionar64(valor, 27) * 5 + 0x52dce729;
+        bytes += 8;
+        restante -= 8;
+    }
+
+    uint64_t cauda = 0;
+    for (size_t i = 0; i < restante; i++) {
+        cauda |= (uint64_t)bytes[i] << (8 * i);
+    }
+    valor ^= misturarBloco(cauda);
+
+    // Finalização (fmix64) para espalhar os bits altos nos baixos
+    valor ^= valor >> 33;
+    valor *= 0xff51afd7ed558ccdull;
+    valor ^= valor >> 33;
+    valor *= 0xc4ceb9fe1a85ec53ull;
+    valor ^= valor >> 33;
+
+    return valor != 0 ? valor : 1;
+}
+
+/**
+ * @brief Inicializa a tabela hash vazia (a memória é reservada no 1º uso)
+ * @param tabela Ponteiro para a tabela hash
+ */
+void inicializarHash(TabelaHash* tabela) {
+    tabela->entradas = NULL;
+    tabela->capacidade = 0;
+    tabela->quantidade = 0;
+}
+
+/**
+ * @brief Realoca a tabela com nova capacidade e reinsere as entradas
+ * @param tabela Ponteiro para a tabela hash
+ * @param capacidade Nova capacidade (potência de 2)
+ */
+void redimensionarHash(TabelaHash* tabela, size_t capacidade) {
+    EntradaHash* antigas = tabela->entradas;
+    size_t capacidadeAntiga = tabela->capacidade;
+
+    tabela->entradas = (EntradaHash*)calloc(capacidade, sizeof(EntradaHash));
+    if (tabela->entradas == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    tabela->capacidade = capacidade;
+    tabela->quantidade = 0;
+
+    for (size_t i = 0; i < capacidadeAntiga; i++) {
+        if (antigas[i].hash != 0) {
+            inserirEntradaHash(tabela, antigas[i]);
+        }
+    }
+    free(antigas);
+}
+
+/**
+ * @brief Garante espaço para uma quantidade de entradas sem novos redimensionamentos
+ * @param tabela Ponteiro para a tabela hash
+ * @param quantidade Total de entradas esperado
+ */
+void reservarHash(TabelaHash* tabela, size_t quantidade) {
+    size_t capacidade = CAPACIDADE_MINIMA_HASH;
+    while (quantidade * CARGA_MAXIMA_DENOMINADOR > capacidade * CARGA_MAXIMA_NUMERADOR) {
+        capacidade *= 2;
+    }
+    if (capacidade > tabela->capacidade) {
+        redimensionarHash(tabela, capacidade);
+    }
+}
+
+/**
+ * @brief Insere uma entrada com hash já calculado (Robin Hood: quem está
+ *        mais longe da posição ideal toma o lugar de quem está mais perto)
+ * @param tabela Ponteiro para a tabela hash (com espaço livre)
+ * @param entrada Entrada a ser inserida
+ */
+void inserirEntradaHash(TabelaHash* tabela, EntradaHash entrada) {
+    size_t mascara = tabela->capacidade - 1;
+    size_t posicao = entrada.hash & mascara;
+    size_t distancia = 0;
+
+    while (1) {
+        EntradaHash* atual = &tabela->entradas[posicao];
+
+        if (atual->hash == 0) {
+            *atual = entrada;
+            tabela->quantidade++;
+            return;
+        }
+
+        // Mesma chave: o valor mais recente prevalece
+        if (atual->hash == entrada.hash && strcmp(atual->chave, entrada.chave) == 0) {
+            atual->valor = entrada.valor;
+            return;
+        }
+
+        size_t distanciaAtual = (posicao - (atual->hash & mascara)) & mascara;
+        if (distanciaAtual < distancia) {
+            EntradaHash deslocada = *atual;
+            *atual = entrada;
+            entrada = deslocada;
+            distancia = distanciaAtual;
+        }
+
+        posicao = (posicao + 1) & mascara;
+        distancia++;
+    }
+}
+
+/**
+ * @brief Associa um valor a um texto na tabela hash
+ * @param tabela Ponteiro para a tabela hash
+ * @param chave Texto da chave (não é copiado)
+ * @param valor ID associado ao texto
+ */
+void inserirNaHash(TabelaHash* tabela, const char* chave, uint32_t valor) {
+    // Cresce ao atingir o fator de carga máximo
+    if ((tabela->quantidade + 1) * CARGA_MAXIMA_DENOMINADOR >
+        tabela->capacidade * CARGA_MAXIMA_NUMERADOR) {
+        redimensionarHash(tabela, tabela->capacidade ? tabela->capacidade * 2
+                                                     : CAPACIDADE_MINIMA_HASH);
+    }
+
+    EntradaHash entrada;
+    entrada.hash = hash(chave);
+    entrada.chave = chave;
+    entrada.valor = valor;
+    inserirEntradaHash(tabela, entrada);
+}
+
+/**
+ * @brief Procura a entrada de uma chave cujo hash já foi calculado
+ * @param tabela Ponteiro para a tabela hash
+ * @param chave Texto procurado
+ * @param valorHash hash(chave)
+ * @return Entrada encontrada ou NULL
+ */
+const EntradaHash* procurarNaHash(const TabelaHash* tabela, const char* chave, uint64_t valorHash) {
+    if (tabela->quantidade == 0) return NULL;
+
+    size_t mascara = tabela->capacidade - 1;
+    size_t posicao = valorHash & mascara;
+
+    // Sonda até uma posição vazia ou uma entrada mais perto da posição ideal
+    // do que a chave buscada estaria; só compara texto quando o hash coincide
+    const EntradaHash* encontrada = NULL;
+    size_t distancia;
+    for (distancia = 0; ; distancia++) {
+        const EntradaHash* atual = &tabela->entradas[posicao];
+        if (atual->hash == 0) break;
+        if (((posicao - (atual->hash & mascara)) & mascara) < distancia) break;
+
+        if (atual->hash == valorHash && strcmp(atual->chave, chave) == 0) {
+            encontrada = atual;
+            break;
+        }
+        posicao = (posicao + 1) & mascara;
+    }
+    if (estatisticas.ligadas) registrarEmHistograma(&estatisticas.sondagensHash, distancia + 1);
+    return encontrada;
+}
+
+/**
+ * @brief Busca o valor associado a um texto na tabela hash
+ * @param tabela Ponteiro para a tabela hash
+ * @param chave Texto procurado
+ * @return Valor associado ou SEM_INDICE se não encontrado
+ */
+uint32_t buscarNaHash(const TabelaHash* tabela, const char* chave) {
+    const EntradaHash* entrada = procurarNaHash(tabela, chave, hash(chave));
+    return entrada != NULL ? entrada->valor : SEM_INDICE;
+}
+
+/**
+ * @brief Libera a memória alocada para a tabela hash
+ * @param tabela Ponteiro para a tabela hash
+ */
+void liberarHash(TabelaHash* tabela) {
+    free(tabela->entradas);
+    inicializarHash(tabela);
+}
+
+// ========== FUNÇÕES PARA HASH PERFEITO ==========
+
+/**
+ * @brief Posição de uma chave na tabela perfeita, dado o deslocamento do grupo
+ *
+ * O passo é ímpar e a capacidade é potência de 2, então deslocamentos
+ * diferentes levam a mesma chave a posições diferentes.
+ *
+ * @param valorHash Hash da chave
+ * @param deslocamento Deslocamento do grupo da chave
+ * @param mascara Capacidade da tabela menos 1
+ * @return Posição na tabela
+ */
+uint32_t posicaoPerfeita(uint64_t valorHash, uint32_t deslocamento, uint32_t mascara) {
+    uint32_t base = (uint32_t)(valorHash >> 32);
+    uint32_t passo = (uint32_t)(valorHash >> 8) | 1;
+    return (base + deslocamento * passo) & mascara;
+}
+
+/**
+ * @brief Busca uma pista na tabela perfeita: uma leitura e uma comparação
+ * @param tabela Tabela gerada por --gerar-hash
+ * @param texto Texto da pista
+ * @return Entrada da pista ou NULL se o texto não é uma pista do caso
+ */
+const EntradaPerfeita* procurarNaTabelaPerfeita(const TabelaPerfeita* tabela, const char* texto) {
+    uint64_t valorHash = hash(texto);
+    uint32_t deslocamento = tabela->deslocamentos[(uint32_t)valorHash & tabela->mascaraGrupos];
+    const EntradaPerfeita* entrada =
+        &tabela->entradas[posicaoPerfeita(valorHash, deslocamento, tabela->mascaraPosicoes)];
+    if (estatisticas.ligadas) registrarEmHistograma(&estatisticas.sondagensHash, 1);
+    return entrada->texto != NULL && strcmp(entrada->texto, texto) == 0 ? entrada : NULL;
+}
+
+/**
+ * @brief Monta a tabela perfeita das pistas de um caso (hash e deslocamento)
+ *
+ * As pistas são divididas em grupos pelo hash, cerca de 4 por grupo. Os
+ * grupos maiores são posicionados primeiro: para cada um procura-se o menor
+ * deslocamento que leva todas as suas pistas a posições livres e
+ * distintas. Se algum grupo não couber, a capacidade dobra e tudo recomeça.
+ *
+ * @param tabela Tabela a ser preenchida (vetores alocados aqui)
+ * @param caso Caso de origem (os textos das entradas apontam para ele)
+ * @return 1 em caso de sucesso, 0 se não foi possível separar as pistas
+ */
+int construirTabelaPerfeita(TabelaPerfeita* tabela, const Caso* caso) {
+    uint32_t n = caso->pistas.quantidade;
+    uint32_t numGrupos = 1, capacidade = 1;
+    while (numGrupos < n / 4) numGrupos <<= 1;
+    while (capacidade < n + n / 4) capacidade <<= 1;
+
+    uint64_t* hashes = (uint64_t*)malloc(((size_t)n + 1) * sizeof(uint64_t));
+    uint32_t* inicioGrupo = (uint32_t*)malloc(((size_t)numGrupos + 1) * sizeof(uint32_t));
+    uint32_t* membros = (uint32_t*)malloc(((size_t)n + 1) * sizeof(uint32_t));
+    uint32_t* ordemGrupos = (uint32_t*)malloc((size_t)numGrupos * sizeof(uint32_t));
+    uint32_t* deslocamentos = (uint32_t*)calloc(numGrupos, sizeof(uint32_t));
+    if (hashes == NULL || inicioGrupo == NULL || membros == NULL ||
+        ordemGrupos == NULL || deslocamentos == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+
+    // Grupos por contagem: inicioGrupo[g] .. inicioGrupo[g + 1] em "membros"
+    memset(inicioGrupo, 0, ((size_t)numGrupos + 1) * sizeof(uint32_t));
+    for (uint32_t i = 0; i < n; i++) {
+        hashes[i] = hash(caso->pistas.textos[i]);
+        inicioGrupo[((uint32_t)hashes[i] & (numGrupos - 1)) + 1]++;
+    }
+    for (uint32_t g = 0; g < numGrupos; g++) inicioGrupo[g + 1] += inicioGrupo[g];
+    uint32_t maiorGrupo = 0;
+    for (uint32_t g = 0; g < numGrupos; g++) {
+        uint32_t tamanho = inicioGrupo[g + 1] - inicioGrupo[g];
+        if (tamanho > maiorGrupo) maiorGrupo = tamanho;
+    }
+    uint32_t* cursor = (uint32_t*)malloc(((size_t)numGrupos + 1) * sizeof(uint32_t));
+    uint32_t* porTamanho = (uint32_t*)calloc((size_t)maiorGrupo + 2, sizeof(uint32_t));
+    if (cursor == NULL || porTamanho == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    memcpy(cursor, inicioGrupo, ((size_t)numGrupos + 1) * sizeof(uint32_t));
+    for (uint32_t i = 0; i < n; i++) membros[cursor[(uint32_t)hashes[i] & (numGrupos - 1)]++] = i;
+
+    // Ordem decrescente de tamanho, por contagem
+    for (uint32_t g = 0; g < numGrupos; g++) {
+        porTamanho[maiorGrupo - (inicioGrupo[g + 1] - inicioGrupo[g]) + 1]++;
+    }
+    for (uint32_t t = 0; t <= maiorGrupo; t++) porTamanho[t + 1] += porTamanho[t];
+    for (uint32_t g = 0; g < numGrupos; g++) {
+        ordemGrupos[porTamanho[maiorGrupo - (inicioGrupo[g + 1] - inicioGrupo[g])]++] = g;
+    }
+    free(cursor);
+    free(porTamanho);
+
+    EntradaPerfeita* entradas = NULL;
+    uint32_t* marcas = NULL;
+    uint32_t posicoes[MAX_GRUPO_PERFEITO];
+    int sucesso = 0;
+    for (int tentativa = 0; !sucesso && tentativa < TENTATIVAS_HASH_PERFEITO; tentativa++, capacidade <<= 1) {
+        free(entradas);
+        free(marcas);
+        entradas = (EntradaPerfeita*)malloc((size_t)capacidade * sizeof(EntradaPerfeita));
+        marcas = (uint32_t*)calloc(capacidade, sizeof(uint32_t));
+        if (entradas == NULL || marcas == NULL) {
+            printf("Erro de alocação de memória!\n");
+            exit(1);
+        }
+        for (uint32_t p = 0; p < capacidade; p++) {
+            entradas[p].texto = NULL;
+            entradas[p].pista = SEM_INDICE;
+            entradas[p].suspeito = SEM_INDICE;
+        }
+
+        // "marcas" guarda a última tentativa que usou cada posição livre,
+        // o que detecta colisões dentro do grupo sem limpar nada
+        uint32_t marca = 0;
+        sucesso = maiorGrupo <= MAX_GRUPO_PERFEITO;
+        for (uint32_t k = 0; sucesso && k < numGrupos; k++) {
+            uint32_t g = ordemGrupos[k];
+            uint32_t inicio = inicioGrupo[g], tamanho = inicioGrupo[g + 1] - inicio;
+            if (tamanho == 0) break;
+
+            int posicionado = 0;
+            for (uint32_t d = 0; !posicionado && d < LIMITE_DESLOCAMENTO_PERFEITO; d++) {
+                marca++;
+                posicionado = 1;
+                for (uint32_t j = 0; j < tamanho; j++) {
+                    uint32_t p = posicaoPerfeita(hashes[membros[inicio + j]], d, capacidade - 1);
+                    if (entradas[p].texto != NULL || marcas[p] == marca) {
+                        posicionado = 0;
+                        break;
+                    }
+                    marcas[p] = marca;
+                    posicoes[j] = p;
+                }
+                if (posicionado) {
+                    deslocamentos[g] = d;
+                    for (uint32_t j = 0; j < tamanho; j++) {
+                        uint32_t pista = membros[inicio + j];
+                        entradas[posicoes[j]].texto = caso->pistas.textos[pista];
+                        entradas[posicoes[j]].pista = pista;
+                        entradas[posicoes[j]].suspeito = caso->suspeitoDaPista[pista];
+                    }
+                }
+            }
+            if (!posicionado) sucesso = 0;
+        }
+        if (sucesso) break;
+        memset(deslocamentos, 0, (size_t)numGrupos * sizeof(uint32_t));
+    }
+
+    free(hashes);
+    free(inicioGrupo);
+    free(membros);
+    free(ordemGrupos);
+    free(marcas);
+    if (!sucesso) {
+        free(entradas);
+        free(deslocamentos);
+        return 0;
+    }
+
+    tabela->deslocamentos = deslocamentos;
+    tabela->entradas = entradas;
+    tabela->mascaraGrupos = numGrupos - 1;
+    tabela->mascaraPosicoes = capacidade - 1;
+    tabela->numPistas = n;
+    return 1;
+}
+
+/**
+ * @brief Libera uma tabela perfeita montada em tempo de execução
+ * @param tabela Tabela preenchida por construirTabelaPerfeita
+ */
+void liberarTabelaPerfeita(TabelaPerfeita* tabela) {
+    free((void*)tabela->deslocamentos);
+    free((void*)tabela->entradas);
+    memset(tabela, 0, sizeof(TabelaPerfeita));
+}
+
+/**
+ * @brief Escreve um texto como literal de string C
+ * @param arquivo Destino
+ * @param texto Texto (NULL vira NULL)
+ */
+void escreverLiteralC(FILE* arquivo, const char* texto) {
+    if (texto == NULL) {
+        fputs("NULL", arquivo);
+        return;
+    }
+    fputc('"', arquivo);
+    for (const unsigned char* c = (const unsigned char*)texto; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') fprintf(arquivo, "\\%c", *c);
+        else if (*c < 0x20 || *c == 0x7f) fprintf(arquivo, "\\%03o", *c);
+        else fputc(*c, arquivo);
+    }
+    fputc('"', arquivo);
+}
+
+/**
+ * @brief Modo --gerar-hash: grava a tabela perfeita de um caso como header C
+ *
+ * O header define TABELA_PERFEITA_CASO; compilado com
+ * -DCASO_HASH_PERFEITO='"arquivo.h"', ele passa a internar as pistas do
+ * caso durante a carga (sem índice dinâmico nem renumeração) e atende as
+ * buscas de pista por texto (encontrarSuspeito).
+ *
+ * @param caso Caso de origem
+ * @param origem Nome do caso, registrado no comentário do header
+ * @param caminho Header a gravar
+ * @return 1 em caso de sucesso, 0 em erro
+ */
+int gerarHashPerfeito(const Caso* caso, const char* origem, const char* caminho) {
+    TabelaPerfeita tabela;
+    if (!construirTabelaPerfeita(&tabela, caso)) {
+        fprintf(stderr, "❌ Não foi possível separar as pistas sem colisões\n");
+        return 0;
+    }
+
+    FILE* arquivo = fopen(caminho, "w");
+    if (arquivo == NULL) {
+        fprintf(stderr, "❌ Não foi possível gravar o hash perfeito em '%s'\n", caminho);
+        liberarTabelaPerfeita(&tabela);
+        return 0;
+    }
+
+    fprintf(arquivo, "// Hash perfeito das pistas do caso '%s'.\n", origem);
+    fprintf(arquivo, "// Gerado por: detetive --gerar-hash. Não edite à mão.\n");
+    fprintf(arquivo, "// Compile com: gcc -O2 -pthread -DCASO_HASH_PERFEITO='\"%s\"' "
+                     "-o detetive detetive.c\n\n", caminho);
+
+    fprintf(arquivo, "static const uint32_t DESLOCAMENTOS_PERFEITOS_CASO[%u] = {",
+            tabela.mascaraGrupos + 1);
+    for (uint32_t g = 0; g <= tabela.mascaraGrupos; g++) {
+        fprintf(arquivo, "%s%u", g == 0 ? "\n    " : (g % 16 ? ", " : ",\n    "),
+                tabela.deslocamentos[g]);
+    }
+    fprintf(arquivo, "\n};\n\n");
+
+    fprintf(arquivo, "static const EntradaPerfeita ENTRADAS_PERFEITAS_CASO[%u] = {\n",
+            tabela.mascaraPosicoes + 1);
+    for (uint32_t p = 0; p <= tabela.mascaraPosicoes; p++) {
+        const EntradaPerfeita* entrada = &tabela.entradas[p];
+        fprintf(arquivo, "    {");
+        escreverLiteralC(arquivo, entrada->texto);
+        fprintf(arquivo, ", 0x%08Xu, 0x%08Xu},\n", entrada->pista, entrada->suspeito);
+    }
+    fprintf(arquivo, "};\n\n");
+
+    fprintf(arquivo, "static const TabelaPerfeita TABELA_PERFEITA_CASO = {\n"
+                     "    DESLOCAMENTOS_PERFEITOS_CASO, ENTRADAS_PERFEITAS_CASO,\n"
+                     "    0x%Xu, 0x%Xu, %uu\n};\n",
+            tabela.mascaraGrupos, tabela.mascaraPosicoes, tabela.numPistas);
+
+    int sucesso = !ferror(arquivo);
+    sucesso = (fclose(arquivo) == 0) && sucesso;
+    if (sucesso) {
+        printf("✅ Hash perfeito: %u pistas em %u posições (%u grupos) → %s\n",
+               tabela.numPistas, tabela.mascaraPosicoes + 1, tabela.mascaraGrupos + 1, caminho);
+    } else {
+        fprintf(stderr, "❌ Não foi possível gravar o hash perfeito em '%s'\n", caminho);
+    }
+    liberarTabelaPerfeita(&tabela);
+    return sucesso;
+}
+
+/**
+ * @brief Tabela perfeita compilada no programa por CASO_HASH_PERFEITO
+ * @return TABELA_PERFEITA_CASO, ou NULL se o programa foi compilado sem ela
+ */
+const TabelaPerfeita* tabelaPerfeitaCompilada(void) {
+#ifdef CASO_HASH_PERFEITO
+    return &TABELA_PERFEITA_CASO;
+#else
+    return NULL;
+#endif
+}
+
+/**
+ * @brief Prepara um caso recém-zerado para internar as pistas pela tabela
+ *
+ * Os IDs da tabela já são os IDs finais, em ordem alfabética: cada pista
+ * lida vai direto para a sua posição, sem índice dinâmico e sem a
+ * renumeração de ordenarPistasDoCaso. As buscas por ID de texto usam a
+ * busca binária, como no caso binário.
+ *
+ * @param caso Caso em construção
+ * @param tabela Tabela perfeita do caso esperado
+ */
+void prepararCargaPerfeita(Caso* caso, const TabelaPerfeita* tabela) {
+    uint32_t quantidade = tabela->numPistas;
+    caso->pistas.textos = (const char**)calloc((size_t)quantidade + 1, sizeof(const char*));
+    caso->suspeitoDaPista = (uint32_t*)malloc(((size_t)quantidade + 1) * sizeof(uint32_t));
+    if (caso->pistas.textos == NULL || caso->suspeitoDaPista == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    for (uint32_t i = 0; i <= quantidade; i++) caso->suspeitoDaPista[i] = SEM_INDICE;
+    caso->pistas.quantidade = quantidade;
+    caso->pistas.capacidade = quantidade + 1;
+    caso->pistas.somenteOrdenado = 1;
+    caso->capacidadePistas = quantidade + 1;
+    caso->pistasPerfeitas = tabela;
+    caso->pistasForaDaTabela = 0;
+}
+
+/**
+ * @brief Interna o texto de uma pista pela tabela perfeita do caso em carga
+ * @param caso Caso preparado por prepararCargaPerfeita
+ * @param texto Texto da pista (não vazio)
+ * @return ID da pista ou SEM_INDICE se o texto não está na tabela (o caso
+ *         não é o da tabela, e a carga será refeita sem ela)
+ */
+uint32_t internarPistaPerfeita(Caso* caso, const char* texto) {
+    const EntradaPerfeita* entrada = procurarNaTabelaPerfeita(caso->pistasPerfeitas, texto);
+    if (entrada == NULL) {
+        caso->pistasForaDaTabela++;
+        return SEM_INDICE;
+    }
+    caso->pistas.textos[entrada->pista] = texto;
+    return entrada->pista;
+}
+
+/**
+ * @brief Confere se uma tabela perfeita descreve exatamente as pistas e as
+ *        associações principais de um caso
+ * @param caso Caso carregado
+ * @param tabela Tabela a conferir
+ * @param textosConferidos 1 se as pistas foram internadas pela própria
+ *        tabela (os textos já foram comparados um a um)
+ * @return 1 se a tabela vale para o caso, 0 caso contrário
+ */
+int conferirTabelaPerfeita(const Caso* caso, const TabelaPerfeita* tabela, int textosConferidos) {
+    if (tabela->numPistas != caso->pistas.quantidade || caso->pistasForaDaTabela > 0) return 0;
+
+    // Toda pista da tabela precisa ter aparecido no caso
+    for (uint32_t i = 0; i < caso->pistas.quantidade; i++) {
+        if (caso->pistas.textos[i] == NULL) return 0;
+    }
+    for (uint32_t p = 0; p <= tabela->mascaraPosicoes; p++) {
+        const EntradaPerfeita* entrada = &tabela->entradas[p];
+        if (entrada->texto == NULL) continue;
+        if (entrada->pista >= caso->pistas.quantidade ||
+            caso->suspeitoDaPista[entrada->pista] != entrada->suspeito) {
+            return 0;
+        }
+        if (!textosConferidos && strcmp(caso->pistas.textos[entrada->pista], entrada->texto) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Liga a um caso binário a tabela perfeita compilada, se ela for
+ *        deste caso
+ *
+ * O caso binário não interna pistas (os IDs são as posições no arquivo);
+ * a tabela só atende as buscas por texto, depois de conferida.
+ *
+ * @param caso Caso recém-carregado do formato binário
+ */
+void associarTabelaPerfeita(Caso* caso) {
+    const TabelaPerfeita* tabela = tabelaPerfeitaCompilada();
+    if (tabela != NULL && conferirTabelaPerfeita(caso, tabela, 0)) {
+        caso->pistasPerfeitas = tabela;
+    }
+}
+
+// ========== FUNÇÕES PARA INTERNAÇÃO DE TEXTOS ==========
+
+/**
+ * @brief Inicializa uma tabela de internação vazia
+ * @param internador Tabela de internação
+ */
+void inicializarInternador(Internador* internador) {
+    inicializarHash(&internador->indice);
+    internador->textos = NULL;
+    internador->quantidade = 0;
+    internador->capacidade = 0;
+    internador->somenteOrdenado = 0;
+}
+
+/**
+ * @brief Reserva espaço para uma quantidade de textos distintos
+ * @param internador Tabela de internação
+ * @param quantidade Total de textos esperado
+ */
+void reservarInternador(Internador* internador, uint32_t quantidade) {
+    if (quantidade <= internador->capacidade) return;
+
+    internador->textos = (const char**)realloc((void*)internador->textos,
+                                               quantidade * sizeof(const char*));
+    if (internador->textos == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    internador->capacidade = quantidade;
+    reservarHash(&internador->indice, quantidade);
+}
+
+/**
+ * @brief Retorna o ID de um texto, atribuindo o próximo ID livre se for novo
+ * @param internador Tabela de internação
+ * @param texto Texto a internar (não é copiado)
+ * @return ID denso do texto
+ */
+uint32_t internarTexto(Internador* internador, const char* texto) {
+    uint64_t valorHash = hash(texto);
+    const EntradaHash* existente = procurarNaHash(&internador->indice, texto, valorHash);
+    if (existente != NULL) return existente->valor;
+
+    if (internador->quantidade == internador->capacidade) {
+        reservarInternador(internador, internador->capacidade ? internador->capacidade * 2 : 16);
+    }
+    if ((internador->indice.quantidade + 1) * CARGA_MAXIMA_DENOMINADOR >
+        internador->indice.capacidade * CARGA_MAXIMA_NUMERADOR) {
+        reservarHash(&internador->indice, internador->indice.quantidade + 1);
+    }
+
+    uint32_t id = internador->quantidade++;
+    internador->textos[id] = texto;
+
+    EntradaHash entrada;
+    entrada.hash = valorHash;
+    entrada.chave = texto;
+    entrada.valor = id;
+    inserirEntradaHash(&internador->indice, entrada);
+    return id;
+}
+
+/**
+ * @brief Busca o ID de um texto já internado
+ * @param internador Tabela de internação
+ * @param texto Texto procurado
+ * @return ID do texto ou SEM_INDICE
+ */
+uint32_t buscarIdTexto(const Internador* internador, const char* texto) {
+    if (!internador->somenteOrdenado) {
+        return buscarNaHash(&internador->indice, texto);
+    }
+
+    // Sem índice: os IDs seguem a ordem alfabética, então a busca é binária
+    uint32_t inicio = 0, fim = internador->quantidade;
+    while (inicio < fim) {
+        uint32_t meio = inicio + (fim - inicio) / 2;
+        int comparacao = strcmp(internador->textos[meio], texto);
+        if (comparacao == 0) return meio;
+        if (comparacao < 0) inicio = meio + 1;
+        else fim = meio;
+    }
+    return SEM_INDICE;
+}
+
+/**
+ * @brief Libera a tabela de internação (os textos pertencem ao chamador)
+ * @param internador Tabela de internação
+ */
+void liberarInternador(Internador* internador) {
+    liberarHash(&internador->indice);
+    free((void*)internador->textos);
+    inicializarInternador(internador);
+}
+
+// ========== FUNÇÕES DE JOGO ==========
+
+/**
+ * @brief Coleta a pista da sala atual e a adiciona ao caderno e ao placar
+ * @param sessao Sessão em andamento
+ * @return RESULTADO_PISTA_COLETADA, RESULTADO_PISTA_REPETIDA ou RESULTADO_SEM_PISTA
+ */
+ResultadoComando coletarPista(Sessao* sessao) {
+    uint32_t pista = salaDaMansao(&sessao->caso->mansao, sessao->salaAtual)->pista;
+    if (pista == SEM_INDICE) return RESULTADO_SEM_PISTA;
+    
+    return anotarPista(sessao, pista) ? RESULTADO_PISTA_COLETADA : RESULTADO_PISTA_REPETIDA;
+}
+
+/**
+ * @brief Registra uma pista no caderno, no índice de palavras e no placar
+ *        (e no caderno da equipe, se houver)
+ * @param sessao Sessão em andamento
+ * @param pista ID da pista
+ * @return 1 se a pista é nova, 0 se já estava no caderno
+ */
+int anotarPista(Sessao* sessao, uint32_t pista) {
+    // Insere no caderno (árvore B)
+    if (!inserirPista(&sessao->caderno, pista)) return 0;
+    
+    // Índice e placar são atualizados agora, para que buscas e veredicto
+    // não precisem percorrer o caderno
+    indexarPista(&sessao->indice, textoPista(sessao->caso, pista), pista);
+    registrarEvidenciasDaPista(&sessao->placar, sessao->caso, pista);
+    
+    // No servidor cooperativo a pista também vai para o caderno da equipe
+    if (sessao->equipe != NULL) inserirNoCompartilhado(sessao->equipe, pista);
+    return 1;
+}
+
+/**
+ * @brief Mostra as pistas coletadas que atendem a uma consulta
+ *
+ * A consulta vazia lista o caderno inteiro. No modo normal as pistas saem
+ * em páginas de PAGINA_BUSCA; havendo mais, a partida espera na etapa
+ * ETAPA_PAGINA, e cada [Enter] mostra a página seguinte. No modo JSON sai
+ * uma linha com todas.
+ *
+ * @param partida Partida em andamento
+ * @param tela Tela de saída
+ * @param consulta Palavras ou prefixos procurados
+ */
+void pesquisarCaderno(Partida* partida, Tela* tela, const char* consulta) {
+    Sessao* sessao = partida->sessao;
+    const Caso* caso = sessao->caso;
+    snprintf(partida->consulta, sizeof(partida->consulta), "%s", consulta);
+    partida->exibidas = 0;
+    partida->etapa = ETAPA_COMANDOS;
+
+    char palavra[MAX_PALAVRA_INDICE + 1];
+    const char* cursor = partida->consulta;
+    int todas = proximaPalavra(&cursor, palavra) == 0;
+    size_t total = todas ? sessao->caderno.quantidade
+                         : buscarPistas(&sessao->indice, partida->consulta, &partida->busca);
+
+    if (tela->modo == SAIDA_JSON) {
+        IteradorCaderno iterador;
+        iniciarIteradorCaderno(&iterador, &sessao->caderno);
+        uint32_t pista;
+        escreverTela(tela, "{\"busca\":");
+        escreverJsonTexto(tela, partida->consulta);
+        escreverTela(tela, ",\"total\":%zu,\"pistas\":[", total);
+        for (size_t i = 0; i < total; i++) {
+            if (todas) proximaPistaCaderno(&iterador, &pista);
+            else pista = partida->busca.pistas[i];
+            if (i > 0) escreverTela(tela, ",");
+            escreverJsonTexto(tela, textoPista(caso, pista));
+        }
+        escreverTela(tela, "]}\n");
+        return;
+    }
+    if (tela->modo != SAIDA_NORMAL) return;
+
+    if (total == 0) {
+        escreverTela(tela, todas ? "❌ Nenhuma pista coletada ainda.\n"
+                                 : "❌ Nenhuma pista coletada menciona \"%s\".\n", partida->consulta);
+        return;
+    }
+    escreverTela(tela, todas ? "📋 %zu pista(s) no caderno:\n" : "📋 %zu pista(s) encontradas:\n", total);
+    mostrarPaginaBusca(partida, tela);
+}
+
+/**
+ * @brief Mostra a próxima página da busca da partida
+ *
+ * A busca é refeita a partir da consulta guardada, pois entre duas páginas
+ * os vetores de busca podem ter servido a outra partida, e a página começa
+ * onde a anterior parou. Havendo mais pistas, a partida fica na etapa
+ * ETAPA_PAGINA; senão, volta a ETAPA_COMANDOS.
+ *
+ * @param partida Partida com uma busca em andamento
+ * @param tela Tela de saída
+ */
+void mostrarPaginaBusca(Partida* partida, Tela* tela) {
+    Sessao* sessao = partida->sessao;
+    char palavra[MAX_PALAVRA_INDICE + 1];
+    const char* cursor = partida->consulta;
+    int todas = proximaPalavra(&cursor, palavra) == 0;
+    size_t total = todas ? sessao->caderno.quantidade
+                         : buscarPistas(&sessao->indice, partida->consulta, &partida->busca);
+
+    IteradorCaderno iterador;
+    iniciarIteradorCaderno(&iterador, &sessao->caderno);
+    uint32_t pista;
+    for (size_t i = 0; todas && i < partida->exibidas; i++) proximaPistaCaderno(&iterador, &pista);
+
+    size_t fimPagina = partida->exibidas + PAGINA_BUSCA < total ? partida->exibidas + PAGINA_BUSCA : total;
+    for (; partida->exibidas < fimPagina; partida->exibidas++) {
+        if (todas) proximaPistaCaderno(&iterador, &pista);
+        else pista = partida->busca.pistas[partida->exibidas];
+        escreverTela(tela, "• %s\n", textoPista(sessao->caso, pista));
+    }
+
+    if (partida->exibidas < total) {
+        escreverTela(tela, "(%zu de %zu) [Enter] mais pistas, [V] voltar: ", partida->exibidas, total);
+        partida->etapa = ETAPA_PAGINA;
+    } else {
+        partida->etapa = ETAPA_COMANDOS;
+    }
+}
+
+/**
+ * @brief Busca o suspeito associado ao texto de uma pista
+ *
+ * Com a tabela perfeita do caso compilada no programa, a busca é uma
+ * leitura e uma comparação; sem ela, usa o índice dinâmico das pistas.
+ *
+ * @param caso Caso com as associações
+ * @param pista Texto da pista
+ * @return Nome do suspeito ou NULL se não encontrado
+ */
+const char* encontrarSuspeito(const Caso* caso, const char* pista) {
+    if (caso->pistasPerfeitas != NULL) {
+        const EntradaPerfeita* entrada = procurarNaTabelaPerfeita(caso->pistasPerfeitas, pista);
+        if (entrada == NULL || entrada->suspeito == SEM_INDICE) return NULL;
+        return caso->suspeitos.textos[entrada->suspeito];
+    }
+    
+    uint32_t idPista = buscarIdTexto(&caso->pistas, pista);
+    if (idPista == SEM_INDICE) return NULL;
+    
+    uint32_t idSuspeito = caso->suspeitoDaPista[idPista];
+    return idSuspeito != SEM_INDICE ? caso->suspeitos.textos[idSuspeito] : NULL;
+}
+
+/**
+ * @brief Abre a fase final de julgamento de uma sessão que saiu da mansão
+ *
+ * No modo normal lista as pistas e os suspeitos e pede a acusação: a
+ * partida passa a esperar o nome na etapa ETAPA_ACUSACAO (veja
+ * concluirJulgamento). Sem pistas, o caso é arquivado sem pergunta. Nos
+ * modos de máquina não há telas: só se espera a acusação se a sessão ainda
+ * a aguarda, e em JSON o veredicto sai em uma linha.
+ *
+ * @param partida Partida cuja sessão acabou de sair da mansão
+ * @param tela Tela de saída
+ */
+void iniciarJulgamento(Partida* partida, Tela* tela) {
+    const Sessao* sessao = partida->sessao;
+    const Caso* caso = sessao->caso;
+    partida->etapa = ETAPA_ENCERRADA;
+
+    // Modos de máquina: só a acusação e, em JSON, o veredicto
+    if (tela->modo != SAIDA_NORMAL) {
+        if (sessao->estado == SESSAO_AGUARDANDO_ACUSACAO) partida->etapa = ETAPA_ACUSACAO;
+        else if (tela->modo == SAIDA_JSON) escreverVeredictoJson(tela, sessao);
+        return;
+    }
+
+    escreverTela(tela, "\n══════════════════════════════════════════════════════\n");
+    escreverTela(tela, "                    FASE FINAL                       \n");
+    escreverTela(tela, "                 JULGAMENTO DO CRIME                 \n");
+    escreverTela(tela, "══════════════════════════════════════════════════════\n");
+
+    // Lista as pistas coletadas
+    escreverTela(tela, "\n📋 PISTAS COLETADAS (em ordem alfabética):\n");
+    escreverTela(tela, "══════════════════════════════════════════════════════\n");
+
+    if (sessao->veredicto == VEREDICTO_ARQUIVADO) {
+        escreverTela(tela, "❌ Nenhuma pista coletada! Você não tem evidências suficientes.\n");
+        escreverTela(tela, "💀 RESULTADO: Caso arquivado por falta de provas.\n");
+        return;
+    }
+
+    listarPistasOrdenadas(tela, &sessao->caderno, caso);
+
+    // Lista os suspeitos possíveis
+    escreverTela(tela, "\n🔎 SUSPEITOS POSSÍVEIS:\n");
+    for (uint32_t i = 0; i < caso->suspeitos.quantidade; i++) {
+        escreverTela(tela, "%u. %s\n", i + 1, caso->descricoesSuspeitos[i]);
+    }
+
+    // Solicita a acusação do jogador
+    escreverTela(tela, "\n🕵️  QUEM É O CULPADO?\n");
+    escreverTela(tela, "Digite o nome do suspeito (exatamente como listado): ");
+    partida->etapa = ETAPA_ACUSACAO;
+}
+
+/**
+ * @brief Julga a acusação do jogador e narra o veredicto
+ * @param partida Partida na etapa ETAPA_ACUSACAO
+ * @param tela Tela de saída
+ * @param linha Nome do suspeito, como digitado
+ */
+void concluirJulgamento(Partida* partida, Tela* tela, const char* linha) {
+    Sessao* sessao = partida->sessao;
+    const Caso* caso = sessao->caso;
+    const PlacarSuspeitos* placar = &sessao->placar;
+    char acusacao[30];
+
+    // Converte para minúsculas para comparação case-insensitive
+    snprintf(acusacao, sizeof(acusacao), "%s", linha);
+    toLowerString(acusacao);
+    partida->etapa = ETAPA_ENCERRADA;
+
+    Veredicto veredicto = acusarSuspeito(sessao, acusacao);
+    if (tela->modo != SAIDA_NORMAL) {
+        if (tela->modo == SAIDA_JSON) escreverVeredictoJson(tela, sessao);
+        return;
+    }
+    uint32_t pistasParaSuspeito = sessao->pistasContraAcusado;
+
+    escreverTela(tela, "\n══════════════════════════════════════════════════════\n");
+    escreverTela(tela, "                    VEREDICTO                         \n");
+    escreverTela(tela, "══════════════════════════════════════════════════════\n");
+
+    escreverTela(tela, "Suspeito acusado: %s\n", acusacao);
+    escreverTela(tela, "Pistas que apontam para %s: %u\n", acusacao, pistasParaSuspeito);
+
+    // Narra o resultado decidido pela sessão
+    if (veredicto == VEREDICTO_SUSTENTADA) {
+        escreverTela(tela, "\n🎉 RESULTADO: ACUSAÇÃO SUSTENTADA!\n");
+        escreverTela(tela, "✅ O júri aceitou as evidências contra %s!\n", acusacao);
+        escreverTela(tela, "🏆 DETETIVE BEM-SUCEDIDO! Caso resolvido com maestria!\n");
+    } else if (veredicto == VEREDICTO_PARCIAL) {
+        escreverTela(tela, "\n⚠️  RESULTADO: ACUSAÇÃO PARCIALMENTE SUSTENTADA\n");
+        escreverTela(tela, "📋 Há algumas evidências, mas não são conclusivas.\n");
+        escreverTela(tela, "💼 O caso permanece em investigação.\n");
+    } else if (veredicto == VEREDICTO_FRACA) {
+        escreverTela(tela, "\n❌ RESULTADO: ACUSAÇÃO FRACA\n");
+        escreverTela(tela, "📉 Evidências insuficientes para sustentar a acusação.\n");
+        escreverTela(tela, "🔍 Continue investigando!\n");
+    } else {
+        escreverTela(tela, "\n💀 RESULTADO: ACUSAÇÃO INFUNDADA\n");
+        escreverTela(tela, "🚫 Nenhuma pista aponta para %s!\n", acusacao);
+        escreverTela(tela, "😞 O verdadeiro culpado escapou da justiça...\n");
+    }
+
+    // O líder do ranking é o suspeito com mais evidências coletadas
+    uint32_t lider = suspeitoNaPosicao(placar, 0);
+    if (lider != SEM_INDICE && lider != sessao->acusado &&
+        pistasContraSuspeito(placar, lider) > pistasParaSuspeito) {
+        escreverTela(tela, "\n💡 Suas pistas apontavam mais para %s (%u pistas).\n",
+               caso->suspeitos.textos[lider], pistasContraSuspeito(placar, lider));
+    }
+
+    // Revela o culpado real (para fins educacionais)
+    if (caso->segredo != NULL) {
+        escreverTela(tela, "\n🤫 SEGREDO DO DESENVOLVEDOR:\n");
+        escreverTela(tela, "%s\n", caso->segredo);
+    }
+}
+
+/**
+ * @brief Escreve o veredicto da sessão em uma linha JSON
+ * @param tela Tela de saída
+ * @param sessao Sessão julgada (ou arquivada)
+ */
+void escreverVeredictoJson(Tela* tela, const Sessao* sessao) {
+    const Caso* caso = sessao->caso;
+    escreverTela(tela, "{\"veredicto\":\"%s\",\"acusado\":", nomeVeredicto(sessao->veredicto));
+    escreverJsonTexto(tela, sessao->acusado != SEM_INDICE
+                                ? caso->suspeitos.textos[sessao->acusado] : NULL);
+    escreverTela(tela, ",\"pistasContraAcusado\":%u,\"pistas\":%zu}\n",
+                 sessao->pistasContraAcusado, sessao->caderno.quantidade);
+}
+
+// ========== FUNÇÕES DE SESSÃO ==========
+
+/**
+ * @brief Inicia uma sessão na entrada da mansão do caso
+ * @param sessao Sessão a ser iniciada (não deve ser copiada depois)
+ * @param caso Caso compartilhado, somente leitura
+ */
+void iniciarSessao(Sessao* sessao, const Caso* caso) {
+    sessao->caso = caso;
+    sessao->equipe = NULL;
+    sessao->diario = NULL;
+    sessao->numEventos = 0;
+    inicializarMemoriaSessao(&sessao->memoria);
+    reiniciarSessao(sessao);
+}
+
+/**
+ * @brief Volta a sessão ao início do caso, reaproveitando a memória reservada
+ * @param sessao Sessão já iniciada
+ */
+void reiniciarSessao(Sessao* sessao) {
+    const Caso* caso = sessao->caso;
+    if (estatisticas.ligadas) registrarMemoriaDaSessao(&sessao->memoria);
+    reiniciarMemoriaSessao(&sessao->memoria);
+    inicializarCaderno(&sessao->caderno, &sessao->memoria.pistas);
+    inicializarIndicePistas(&sessao->indice, &sessao->memoria.arena);
+    inicializarPlacar(&sessao->placar, caso->suspeitos.quantidade, caso->pontuacaoMaxima,
+                      &sessao->memoria.arena);
+    sessao->salaAtual = 0;
+    anteciparFilhos(&caso->mansao, 0);
+    sessao->estado = SESSAO_EXPLORANDO;
+    sessao->veredicto = VEREDICTO_PENDENTE;
+    sessao->acusado = SEM_INDICE;
+    sessao->pistasContraAcusado = 0;
+    
+#ifndef _WIN32
+    // Recomeçar é uma nova sessão no diário, com ID próprio; recomeçar sem
+    // ter jogado nada continua na sessão que acabou de começar
+    int intocada = sessao->numEventos == 1 && sessao->eventos[0].tipo == EVENTO_INICIO;
+    if (sessao->diario != NULL && !intocada) {
+        descarregarEventos(sessao, 0);
+        ligarDiario(sessao, sessao->diario);
+    }
+#endif
+}
+
+/**
+ * @brief Libera a memória da sessão (o caso não é afetado)
+ * @param sessao Sessão a ser liberada
+ */
+void liberarSessao(Sessao* sessao) {
+    descarregarEventos(sessao, 0);
+    if (estatisticas.ligadas) registrarMemoriaDaSessao(&sessao->memoria);
+    liberarMemoriaSessao(&sessao->memoria);
+}
+
+/**
+ * @brief Aplica um comando de exploração: C, E, D, P ou S (maiúsculos)
+ * @param sessao Sessão em andamento
+ * @param comando Letra do comando
+ * @return Efeito do comando; RESULTADO_INVALIDO se a sessão não está explorando
+ */
+ResultadoComando aplicarComando(Sessao* sessao, char comando) {
+    if (sessao->estado != SESSAO_EXPLORANDO) return RESULTADO_INVALIDO;
+    
+    const NoMansao* atual = salaDaMansao(&sessao->caso->mansao, sessao->salaAtual);
+    ResultadoComando resultado;
+    uint32_t destino;
+    switch (comando) {
+        case 'C':
+            resultado = coletarPista(sessao);
+            break;
+            
+        case 'E':
+        case 'D':
+            destino = comando == 'E' ? atual->esquerda : atual->direita;
+            if (destino == SEM_INDICE) {
+                resultado = RESULTADO_SEM_CAMINHO;
+                break;
+            }
+            sessao->salaAtual = destino;
+            anteciparFilhos(&sessao->caso->mansao, destino);
+            resultado = RESULTADO_MOVEU;
+            break;
+            
+        case 'P':
+            resultado = RESULTADO_PALPITE;
+            break;
+            
+        case 'S':
+            // Sem pistas não há julgamento: o caso é arquivado na saída
+            if (sessao->caderno.quantidade == 0) {
+                sessao->estado = SESSAO_ENCERRADA;
+                sessao->veredicto = VEREDICTO_ARQUIVADO;
+                if (estatisticas.ligadas) {
+                    atomic_fetch_add_explicit(&estatisticas.veredictos[VEREDICTO_ARQUIVADO], 1,
+                                              memory_order_relaxed);
+                }
+            } else {
+                sessao->estado = SESSAO_AGUARDANDO_ACUSACAO;
+            }
+            resultado = RESULTADO_SAIU;
+            break;
+            
+        default:
+            return RESULTADO_INVALIDO;
+    }
+    
+    if (sessao->diario != NULL) {
+        registrarEvento(sessao, EVENTO_COMANDO, (uint8_t)comando, (uint8_t)resultado,
+                        sessao->salaAtual);
+        // Arquivado na saída: a sessão termina aqui
+        if (sessao->estado == SESSAO_ENCERRADA) descarregarEventos(sessao, 1);
+    }
+    return resultado;
+}
+
+/**
+ * @brief Atravessa uma passagem da sala atual (um passo do comando "ir")
+ * @param sessao Sessão em andamento
+ * @param destino Cômodo do outro lado da passagem
+ * @return RESULTADO_MOVEU, RESULTADO_SEM_CAMINHO se não há passagem para
+ *         esse cômodo, ou RESULTADO_INVALIDO se a sessão não está explorando
+ */
+ResultadoComando atravessarPassagem(Sessao* sessao, uint32_t destino) {
+    if (sessao->estado != SESSAO_EXPLORANDO) return RESULTADO_INVALIDO;
+    
+    const Mansao* mansao = &sessao->caso->mansao;
+    ResultadoComando resultado = RESULTADO_SEM_CAMINHO;
+    if (temPassagem(mansao, sessao->salaAtual, destino)) {
+        sessao->salaAtual = destino;
+        anteciparFilhos(mansao, destino);
+        resultado = RESULTADO_MOVEU;
+    }
+    if (sessao->diario != NULL) {
+        registrarEvento(sessao, EVENTO_COMANDO, (uint8_t)COMANDO_PASSAGEM, (uint8_t)resultado,
+                        sessao->salaAtual);
+    }
+    return resultado;
+}
+
+/**
+ * @brief Julga a acusação contra um suspeito e encerra a sessão
+ * @param sessao Sessão aguardando acusação
+ * @param nome Nome do suspeito, já em minúsculas
+ * @return Veredicto (o atual, se a sessão não aguardava acusação)
+ */
+Veredicto acusarSuspeito(Sessao* sessao, const char* nome) {
+    if (sessao->estado != SESSAO_AGUARDANDO_ACUSACAO) return sessao->veredicto;
+    
+    // Contagem já mantida pelo placar: basta converter o nome em ID
+    sessao->acusado = buscarIdTexto(&sessao->caso->suspeitos, nome);
+    sessao->pistasContraAcusado = sessao->acusado != SEM_INDICE
+                                      ? pistasContraSuspeito(&sessao->placar, sessao->acusado)
+                                      : 0;
+    sessao->veredicto = classificarEvidencias(sessao->pistasContraAcusado);
+    sessao->estado = SESSAO_ENCERRADA;
+    if (estatisticas.ligadas) {
+        atomic_fetch_add_explicit(&estatisticas.veredictos[sessao->veredicto], 1,
+                                  memory_order_relaxed);
+    }
+    
+    if (sessao->diario != NULL) {
+        registrarEvento(sessao, EVENTO_ACUSACAO, 0, (uint8_t)sessao->veredicto, sessao->acusado);
+        descarregarEventos(sessao, 1);
+    }
+    return sessao->veredicto;
+}
+
+/**
+ * @brief Converte o número de pistas contra o acusado em veredicto
+ * @param pistas Pistas que apontam para o acusado
+ * @return Veredicto correspondente
+ */
+Veredicto classificarEvidencias(uint32_t pistas) {
+    if (pistas >= PISTAS_PARA_SUSTENTAR) return VEREDICTO_SUSTENTADA;
+    if (pistas >= 2) return VEREDICTO_PARCIAL;
+    if (pistas == 1) return VEREDICTO_FRACA;
+    return VEREDICTO_INFUNDADA;
+}
+
+/**
+ * @brief Nome curto de um veredicto, para saídas legíveis por máquina
+ * @param veredicto Veredicto
+ * @return Texto estático
+ */
+const char* nomeVeredicto(Veredicto veredicto) {
+    switch (veredicto) {
+        case VEREDICTO_ARQUIVADO: return "arquivado";
+        case VEREDICTO_INFUNDADA: return "infundada";
+        case VEREDICTO_FRACA: return "fraca";
+        case VEREDICTO_PARCIAL: return "parcial";
+        case VEREDICTO_SUSTENTADA: return "sustentada";
+        default: return "pendente";
+    }
+}
+
+/**
+ * @brief Nome curto do efeito de um comando, para saídas legíveis por máquina
+ * @param resultado Efeito devolvido por aplicarComando
+ * @return Texto estático
+ */
+const char* nomeResultado(ResultadoComando resultado) {
+    static const char* NOMES_RESULTADO[] = {
+        "pista-coletada", "pista-repetida", "sem-pista", "moveu",
+        "sem-caminho", "palpite", "saiu", "invalido"
+    };
+    return (unsigned)resultado <= RESULTADO_INVALIDO ? NOMES_RESULTADO[resultado] : "?";
+}
+
+// ========== FUNÇÕES DO DIÁRIO DE EVENTOS ==========
+
+/**
+ * @brief Guarda um evento da sessão para o diário
+ *
+ * Os eventos ficam num vetor da própria sessão e vão ao diário em lotes,
+ * então a trava compartilhada é tomada uma vez a cada
+ * EVENTOS_POR_LOTE_SESSAO eventos, e não a cada comando.
+ *
+ * @param sessao Sessão com diário ligado
+ * @param tipo Tipo do evento
+ * @param comando Letra do comando (0 se não houver)
+ * @param resultado ResultadoComando ou Veredicto
+ * @param valor Sala após o comando ou suspeito acusado
+ */
+void registrarEvento(Sessao* sessao, TipoEvento tipo, uint8_t comando, uint8_t resultado,
+                     uint32_t valor) {
+    if (sessao->numEventos == EVENTOS_POR_LOTE_SESSAO) descarregarEventos(sessao, 0);
+    RegistroDiario* registro = &sessao->eventos[sessao->numEventos++];
+    registro->sessao = sessao->idDiario;
+    registro->valor = valor;
+    registro->tipo = (uint8_t)tipo;
+    registro->comando = comando;
+    registro->resultado = resultado;
+    registro->reservado = 0;
+}
+
+/**
+ * @brief Entrega ao diário os eventos guardados na sessão
+ * @param sessao Sessão (sem efeito se não houver diário ligado)
+ * @param confirmar 1 para esperar o grupo chegar ao disco (diário síncrono)
+ */
+void descarregarEventos(Sessao* sessao, int confirmar) {
+#ifndef _WIN32
+    Diario* diario = sessao->diario;
+    if (diario == NULL || sessao->numEventos == 0) return;
+    uint64_t posicao = entregarAoDiario(diario, sessao->eventos, sessao->numEventos);
+    sessao->numEventos = 0;
+    if (confirmar && diario->sincrono) confirmarDiario(diario, posicao);
+#else
+    (void)confirmar;
+    sessao->numEventos = 0;
+#endif
+}
+
+#ifndef _WIN32
+/**
+ * @brief Abre (ou cria) um diário de eventos para o caso
+ *
+ * Um diário existente precisa ter sido gravado para um caso com as mesmas
+ * quantidades de salas, pistas e suspeitos. Um registro incompleto no fim
+ * (gravação interrompida) é descartado, e os IDs de sessão continuam
+ * depois do maior ID já gravado.
+ *
+ * @param diario Diário a abrir
+ * @param caminho Arquivo do diário (aberto só para acréscimos)
+ * @param caso Caso jogado
+ * @param sincrono 1 para confirmar cada sessão encerrada com fdatasync
+ * @return 1 em caso de sucesso, 0 em erro (já relatado)
+ */
+int abrirDiario(Diario* diario, const char* caminho, const Caso* caso, int sincrono) {
+    memset(diario, 0, sizeof(Diario));
+    diario->sincrono = sincrono;
+    diario->fd = open(caminho, O_RDWR | O_CREAT | O_APPEND, 0644);
+    struct stat info;
+    if (diario->fd < 0 || fstat(diario->fd, &info) < 0) {
+        fprintf(stderr, "❌ Não foi possível abrir o diário '%s'\n", caminho);
+        if (diario->fd >= 0) close(diario->fd);
+        return 0;
+    }
+    
+    CabecalhoDiario esperado;
+    memset(&esperado, 0, sizeof(esperado));
+    memcpy(esperado.assinatura, ASSINATURA_DIARIO, sizeof(esperado.assinatura));
+    esperado.versao = VERSAO_DIARIO;
+    esperado.numSalas = caso->mansao.numSalas;
+    esperado.numPistas = caso->pistas.quantidade;
+    esperado.numSuspeitos = caso->suspeitos.quantidade;
+    
+    uint32_t proxima = 0;
+    if (info.st_size == 0) {
+        if (!escreverTudo(diario->fd, (const char*)&esperado, sizeof(esperado))) {
+            fprintf(stderr, "❌ Não foi possível gravar o diário '%s'\n", caminho);
+            close(diario->fd);
+            return 0;
+        }
+    } else {
+        CabecalhoDiario cabecalho;
+        if ((size_t)info.st_size < sizeof(cabecalho) ||
+            !lerNoArquivo(diario->fd, &cabecalho, sizeof(cabecalho), 0) ||
+            memcmp(&cabecalho, &esperado, sizeof(cabecalho)) != 0) {
+            fprintf(stderr, "❌ O diário '%s' não pertence a este caso\n", caminho);
+            close(diario->fd);
+            return 0;
+        }
+        
+        uint64_t numRegistros = ((uint64_t)info.st_size - sizeof(cabecalho)) / sizeof(RegistroDiario);
+        uint64_t fim = sizeof(cabecalho) + numRegistros * sizeof(RegistroDiario);
+        if (fim != (uint64_t)info.st_size) {
+            fprintf(stderr, "⚠️  Diário com registro incompleto no fim; descartado\n");
+            if (ftruncate(diario->fd, (off_t)fim) < 0) {
+                fprintf(stderr, "❌ Não foi possível corrigir o diário '%s'\n", caminho);
+                close(diario->fd);
+                return 0;
+            }
+        }
+        
+        // Os IDs novos continuam depois do maior já usado
+        RegistroDiario bloco[4096];
+        for (uint64_t i = 0; i < numRegistros; i += 4096) {
+            size_t quantidade = numRegistros - i < 4096 ? (size_t)(numRegistros - i) : 4096;
+            if (!lerNoArquivo(diario->fd, bloco, quantidade * sizeof(RegistroDiario),
+                              sizeof(cabecalho) + i * sizeof(RegistroDiario))) {
+                fprintf(stderr, "❌ Não foi possível ler o diário '%s'\n", caminho);
+                close(diario->fd);
+                return 0;
+            }
+            for (size_t j = 0; j < quantidade; j++) {
+                if (bloco[j].sessao >= proxima) proxima = bloco[j].sessao + 1;
+            }
+        }
+    }
+    atomic_init(&diario->proximaSessao, proxima);
+    
+    diario->capacidade = diario->capacidadeGravacao = TAMANHO_GRUPO_DIARIO;
+    diario->pendentes = (char*)malloc(diario->capacidade);
+    diario->gravacao = (char*)malloc(diario->capacidadeGravacao);
+    if (diario->pendentes == NULL || diario->gravacao == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    pthread_mutex_init(&diario->trava, NULL);
+    pthread_cond_init(&diario->gravado, NULL);
+    return 1;
+}
+
+/**
+ * @brief Acrescenta registros ao grupo pendente do diário
+ *
+ * Quando o grupo passa de TAMANHO_GRUPO_DIARIO bytes, quem o encheu o
+ * grava, o que limita a memória do diário assíncrono.
+ *
+ * @param diario Diário aberto
+ * @param registros Registros a acrescentar
+ * @param quantidade Número de registros
+ * @return Posição do último registro entregue (para confirmarDiario)
+ */
+uint64_t entregarAoDiario(Diario* diario, const RegistroDiario* registros, uint32_t quantidade) {
+    size_t bytes = (size_t)quantidade * sizeof(RegistroDiario);
+    pthread_mutex_lock(&diario->trava);
+    if (diario->usados + bytes > diario->capacidade) {
+        while (diario->usados + bytes > diario->capacidade) diario->capacidade *= 2;
+        diario->pendentes = (char*)realloc(diario->pendentes, diario->capacidade);
+        if (diario->pendentes == NULL) {
+            printf("Erro de alocação de memória!\n");
+            exit(1);
+        }
+    }
+    memcpy(diario->pendentes + diario->usados, registros, bytes);
+    diario->usados += bytes;
+    diario->entregues += quantidade;
+    uint64_t posicao = diario->entregues;
+    int cheio = diario->usados >= TAMANHO_GRUPO_DIARIO && !diario->gravando;
+    pthread_mutex_unlock(&diario->trava);
+    
+    if (cheio) confirmarDiario(diario, posicao);
+    return posicao;
+}
+
+/**
+ * @brief Espera até que os registros entregues até "posicao" estejam gravados
+ *
+ * Group commit: se ninguém está gravando, a thread vira líder, troca os
+ * buffers e grava todo o grupo pendente (com fdatasync no modo síncrono)
+ * fora da trava; as outras threads esperam o líder e, se ainda faltar,
+ * uma delas lidera o próximo grupo. Assim cada fdatasync confirma as
+ * sessões de todas as threads que chegaram enquanto o anterior rodava.
+ *
+ * @param diario Diário aberto
+ * @param posicao Posição devolvida por entregarAoDiario
+ */
+void confirmarDiario(Diario* diario, uint64_t posicao) {
+    pthread_mutex_lock(&diario->trava);
+    while (diario->gravados < posicao && !diario->falhou) {
+        if (diario->gravando) {
+            pthread_cond_wait(&diario->gravado, &diario->trava);
+            continue;
+        }
+        
+        // Líder: leva o grupo inteiro e libera "pendentes" para os demais
+        diario->gravando = 1;
+        char* grupo = diario->pendentes;
+        size_t tamanhoGrupo = diario->usados;
+        size_t capacidadeGrupo = diario->capacidade;
+        uint64_t alvo = diario->entregues;
+        diario->pendentes = diario->gravacao;
+        diario->capacidade = diario->capacidadeGravacao;
+        diario->usados = 0;
+        diario->gravacao = grupo;
+        diario->capacidadeGravacao = capacidadeGrupo;
+        pthread_mutex_unlock(&diario->trava);
+        
+        int sucesso = escreverTudo(diario->fd, grupo, tamanhoGrupo) &&
+                      (!diario->sincrono || fdatasync(diario->fd) == 0);
+        
+        pthread_mutex_lock(&diario->trava);
+        diario->gravando = 0;
+        diario->grupos++;
+        if (sucesso) {
+            diario->gravados = alvo;
+        } else {
+            fprintf(stderr, "❌ Falha ao gravar o diário: %s\n", strerror(errno));
+            diario->falhou = 1;
+        }
+        pthread_cond_broadcast(&diario->gravado);
+    }
+    pthread_mutex_unlock(&diario->trava);
+}
+
+/**
+ * @brief Grava o que falta, sincroniza com o disco e fecha o diário
+ * @param diario Diário aberto (as sessões ligadas já devem ter sido liberadas)
+ */
+void fecharDiario(Diario* diario) {
+    confirmarDiario(diario, diario->entregues);
+    if (!diario->falhou && fdatasync(diario->fd) < 0) {
+        fprintf(stderr, "❌ Falha ao sincronizar o diário: %s\n", strerror(errno));
+    }
+    close(diario->fd);
+    free(diario->pendentes);
+    free(diario->gravacao);
+    pthread_mutex_destroy(&diario->trava);
+    pthread_cond_destroy(&diario->gravado);
+}
+
+/**
+ * @brief Liga a sessão ao diário com um ID novo e registra o início
+ * @param sessao Sessão na entrada da mansão
+ * @param diario Diário aberto, compartilhado entre threads
+ */
+void ligarDiario(Sessao* sessao, Diario* diario) {
+    sessao->diario = diario;
+    sessao->idDiario = atomic_fetch_add(&diario->proximaSessao, 1);
+    registrarEvento(sessao, EVENTO_INICIO, 0, 0, sessao->salaAtual);
+}
+#endif
+
+/**
+ * @brief Aplica um registro do diário à sessão e confere o efeito gravado
+ * @param sessao Sessão sem diário ligado
+ * @param registro Registro a repetir
+ * @return 1 se a sessão chegou ao mesmo estado gravado, 0 se divergiu
+ */
+int repetirEvento(Sessao* sessao, const RegistroDiario* registro) {
+    const Caso* caso = sessao->caso;
+    switch (registro->tipo) {
+        case EVENTO_INICIO:
+            reiniciarSessao(sessao);
+            return sessao->salaAtual == registro->valor;
+            
+        case EVENTO_COMANDO: {
+            // A passagem é repetida pelo destino gravado; se ela não existia,
+            // o destino gravado é a própria sala e a travessia falha de novo
+            ResultadoComando resultado =
+                registro->comando == COMANDO_PASSAGEM
+                    ? atravessarPassagem(sessao, registro->valor)
+                    : aplicarComando(sessao, (char)registro->comando);
+            return resultado == (ResultadoComando)registro->resultado &&
+                   sessao->salaAtual == registro->valor;
+        }
+        
+        case EVENTO_ACUSACAO: {
+            if (registro->valor != SEM_INDICE && registro->valor >= caso->suspeitos.quantidade) {
+                return 0;
+            }
+            // Um acusado fora da lista é repetido com um nome que não existe
+            const char* nome = registro->valor != SEM_INDICE ? caso->suspeitos.textos[registro->valor] : "";
+            Veredicto veredicto = acusarSuspeito(sessao, nome);
+            return veredicto == (Veredicto)registro->resultado && sessao->acusado == registro->valor;
+        }
+        
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Ordena chaves de 64 bits em ordem crescente
+ */
+int compararChavesCrescente(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Repete as sessões gravadas num diário contra um caso
+ *
+ * Com uma sessão escolhida, mostra cada evento e o estado final dela. Sem
+ * sessão escolhida, avança rapidamente por todas: os registros são
+ * agrupados por ID ordenando os pares (ID, posição no arquivo), o que não
+ * depende dos valores dos IDs (um diário corrompido pode trazer qualquer
+ * um), e cada sessão é repetida
+ * sem terminal numa única Sessao reaproveitada. Em ambos os casos cada
+ * efeito é conferido com o gravado.
+ *
+ * @param caso Caso em que o diário foi gravado
+ * @param caminho Arquivo do diário
+ * @param sessaoEscolhida ID da sessão a mostrar, ou -1 para todas
+ * @return 1 se tudo foi repetido sem divergências, 0 caso contrário
+ */
+int repetirDiario(const Caso* caso, const char* caminho, long sessaoEscolhida) {
+    size_t tamanho = 0;
+    int mapeado = 0;
+    char* dados = mapearArquivo(caminho, &tamanho, &mapeado);
+    if (dados == NULL) {
+        fprintf(stderr, "❌ Não foi possível ler o diário '%s'\n", caminho);
+        return 0;
+    }
+    
+    CabecalhoDiario cabecalho;
+    if (tamanho < sizeof(cabecalho)) {
+        fprintf(stderr, "❌ Diário inválido: %s\n", caminho);
+        desmapearArquivo(dados, tamanho, mapeado);
+        return 0;
+    }
+    memcpy(&cabecalho, dados, sizeof(cabecalho));
+    if (memcmp(cabecalho.assinatura, ASSINATURA_DIARIO, sizeof(cabecalho.assinatura)) != 0 ||
+        cabecalho.versao != VERSAO_DIARIO) {
+        fprintf(stderr, "❌ Diário inválido: %s\n", caminho);
+        desmapearArquivo(dados, tamanho, mapeado);
+        return 0;
+    }
+    if (cabecalho.numSalas != caso->mansao.numSalas ||
+        cabecalho.numPistas != caso->pistas.quantidade ||
+        cabecalho.numSuspeitos != caso->suspeitos.quantidade) {
+        fprintf(stderr, "❌ O diário '%s' não pertence a este caso\n", caminho);
+        desmapearArquivo(dados, tamanho, mapeado);
+        return 0;
+    }
+    
+    const RegistroDiario* registros = (const RegistroDiario*)(dados + sizeof(cabecalho));
+    size_t numRegistros = (tamanho - sizeof(cabecalho)) / sizeof(RegistroDiario);
+    
+    Sessao sessao;
+    iniciarSessao(&sessao, caso);
+    int sucesso = 1;
+    
+    if (sessaoEscolhida >= 0) {
+        // Uma sessão: os registros dela, na ordem do arquivo, com o rastro
+        uint32_t id = (uint32_t)sessaoEscolhida;
+        unsigned turno = 0;
+        int encontrada = 0;
+        for (size_t i = 0; i < numRegistros; i++) {
+            const RegistroDiario* registro = &registros[i];
+            if (registro->sessao != id) continue;
+            encontrada = 1;
+            int confere = repetirEvento(&sessao, registro);
+            if (registro->tipo == EVENTO_COMANDO) {
+                printf("%u|%c|%s|%s%s\n", ++turno, registro->comando,
+                       nomeResultado((ResultadoComando)registro->resultado),
+                       nomeSala(&caso->mansao, sessao.salaAtual), confere ? "" : "|divergiu");
+            } else if (registro->tipo == EVENTO_ACUSACAO) {
+                printf("acusacao|%s|%s|%u%s\n",
+                       sessao.acusado != SEM_INDICE ? caso->suspeitos.textos[sessao.acusado] : "-",
+                       nomeVeredicto(sessao.veredicto), sessao.pistasContraAcusado,
+                       confere ? "" : "|divergiu");
+            } else {
+                printf("inicio|%s%s\n", nomeSala(&caso->mansao, sessao.salaAtual),
+                       confere ? "" : "|divergiu");
+            }
+            if (!confere) sucesso = 0;
+        }
+        
+        if (!encontrada) {
+            fprintf(stderr, "❌ Sessão %u não está no diário\n", id);
+            sucesso = 0;
+        } else {
+            Tela tela;
+            inicializarTela(&tela, SAIDA_NORMAL);
+            escreverTela(&tela, "# sala final: %s\n", nomeSala(&caso->mansao, sessao.salaAtual));
+            escreverTela(&tela, "# pistas: %zu\n", sessao.caderno.quantidade);
+            listarPistasOrdenadas(&tela, &sessao.caderno, caso);
+            escreverTela(&tela, "# veredicto: %s\n", nomeVeredicto(sessao.veredicto));
+            descarregarTela(&tela);
+            liberarTela(&tela);
+        }
+    } else {
+        // Todas as sessões: chaves (ID << 32) | posição, em ordem crescente,
+        // deixam os registros de cada sessão juntos e na ordem do arquivo
+        uint64_t* ordem = (uint64_t*)malloc((numRegistros ? numRegistros : 1) * sizeof(uint64_t));
+        if (ordem == NULL) {
+            printf("Erro de alocação de memória!\n");
+            exit(1);
+        }
+        for (size_t i = 0; i < numRegistros; i++) {
+            ordem[i] = ((uint64_t)registros[i].sessao << 32) | (uint32_t)i;
+        }
+        if (numRegistros > 1) qsort(ordem, numRegistros, sizeof(uint64_t), compararChavesCrescente);
+        
+        unsigned long long totais[VEREDICTO_SUSTENTADA + 1] = {0};
+        unsigned long long repetidas = 0, divergentes = 0, incompletas = 0;
+        double inicio = agoraEmSegundos();
+        size_t cursor = 0;
+        while (cursor < numRegistros) {
+            uint32_t id = (uint32_t)(ordem[cursor] >> 32);
+            size_t fim = cursor;
+            while (fim < numRegistros && (uint32_t)(ordem[fim] >> 32) == id) fim++;
+            repetidas++;
+            int confere = registros[(uint32_t)ordem[cursor]].tipo == EVENTO_INICIO;
+            for (; cursor < fim && confere; cursor++) {
+                confere = repetirEvento(&sessao, &registros[(uint32_t)ordem[cursor]]);
+            }
+            cursor = fim;
+            if (!confere) {
+                divergentes++;
+            } else if (sessao.estado != SESSAO_ENCERRADA) {
+                incompletas++;
+            } else {
+                totais[sessao.veredicto]++;
+            }
+        }
+        double segundos = agoraEmSegundos() - inicio;
+        
+        printf("# %llu sessões, %zu registros em %.3f s (%.0f sessões/s)\n", repetidas,
+               numRegistros, segundos, segundos > 0 ? (double)repetidas / segundos : 0.0);
+        for (int v = VEREDICTO_ARQUIVADO; v <= VEREDICTO_SUSTENTADA; v++) {
+            printf("# %s: %llu\n", nomeVeredicto((Veredicto)v), totais[v]);
+        }
+        printf("# em andamento: %llu\n", incompletas);
+        printf("# divergentes: %llu\n", divergentes);
+        sucesso = divergentes == 0;
+        free(ordem);
+    }
+    
+    liberarSessao(&sessao);
+    desmapearArquivo(dados, tamanho, mapeado);
+    return sucesso;
+}
+
+// ========== FUNÇÕES DE INSTANTÂNEOS DE SESSÃO ==========
+
+/**
+ * @brief Tamanho do instantâneo de qualquer sessão de um caso
+ * @param caso Caso jogado
+ * @return Bytes do cabeçalho, do resumo e do bitset das pistas
+ */
+size_t tamanhoInstantaneo(const Caso* caso) {
+    size_t palavras = ((size_t)caso->pistas.quantidade + 63) / 64;
+    return sizeof(CabecalhoInstantaneo) + ((palavras + 63) / 64 + palavras) * sizeof(uint64_t);
+}
+
+/**
+ * @brief Grava o estado da sessão num buffer plano
+ *
+ * O caderno vira um bitset dos IDs coletados; o placar não é gravado,
+ * pois é refeito a partir das pistas na restauração.
+ *
+ * @param sessao Sessão em qualquer estado
+ * @param destino Buffer com tamanhoInstantaneo(caso) bytes, alinhado a 8
+ */
+void gravarInstantaneo(const Sessao* sessao, void* destino) {
+    const Caso* caso = sessao->caso;
+    CabecalhoInstantaneo* cabecalho = (CabecalhoInstantaneo*)destino;
+    memset(cabecalho, 0, sizeof(CabecalhoInstantaneo));
+    memcpy(cabecalho->assinatura, ASSINATURA_INSTANTANEO, sizeof(cabecalho->assinatura));
+    cabecalho->versao = VERSAO_INSTANTANEO;
+    cabecalho->numSalas = caso->mansao.numSalas;
+    cabecalho->numPistas = caso->pistas.quantidade;
+    cabecalho->numSuspeitos = caso->suspeitos.quantidade;
+    cabecalho->salaAtual = sessao->salaAtual;
+    cabecalho->estado = (uint32_t)sessao->estado;
+    cabecalho->veredicto = (uint32_t)sessao->veredicto;
+    cabecalho->acusado = sessao->acusado;
+    cabecalho->pistasContraAcusado = sessao->pistasContraAcusado;
+    cabecalho->numColetadas = (uint32_t)sessao->caderno.quantidade;
+    
+    size_t palavras = ((size_t)caso->pistas.quantidade + 63) / 64;
+    uint64_t* resumo = (uint64_t*)(cabecalho + 1);
+    uint64_t* bits = resumo + (palavras + 63) / 64;
+    memset(resumo, 0, ((palavras + 63) / 64 + palavras) * sizeof(uint64_t));
+    IteradorCaderno iterador;
+    iniciarIteradorCaderno(&iterador, &sessao->caderno);
+    uint32_t pista;
+    while (proximaPistaCaderno(&iterador, &pista)) {
+        bits[pista >> 6] |= 1ull << (pista & 63);
+        resumo[pista >> 12] |= 1ull << ((pista >> 6) & 63);
+    }
+}
+
+/**
+ * @brief Restaura uma sessão a partir de um instantâneo
+ *
+ * O buffer é só lido (pode ser um arquivo mapeado). A sessão volta ao
+ * início e recebe as pistas do bitset em ordem crescente de ID, refazendo
+ * caderno, índice de palavras e placar; com um instantâneo inválido ela fica no início.
+ *
+ * @param sessao Sessão já iniciada no mesmo caso
+ * @param dados Instantâneo, alinhado a 8
+ * @param tamanho Bytes disponíveis em "dados"
+ * @return 1 em caso de sucesso, 0 se o instantâneo não serve para o caso
+ */
+int restaurarInstantaneo(Sessao* sessao, const void* dados, size_t tamanho) {
+    const Caso* caso = sessao->caso;
+    const CabecalhoInstantaneo* cabecalho = (const CabecalhoInstantaneo*)dados;
+    if (!conferirInstantaneo(caso, dados, tamanho)) return 0;
+    
+    // O resumo leva direto às palavras com pistas, então o custo depende das
+    // pistas coletadas e não do tamanho do caso. Se a contagem não bater, a
+    // sessão volta ao início em vez de ficar com um estado parcial.
+    size_t palavras = ((size_t)caso->pistas.quantidade + 63) / 64;
+    size_t palavrasResumo = (palavras + 63) / 64;
+    const uint64_t* resumo = (const uint64_t*)(cabecalho + 1);
+    const uint64_t* bits = resumo + palavrasResumo;
+    reiniciarSessao(sessao);
+    for (size_t r = 0; r < palavrasResumo; r++) {
+        for (uint64_t cheias = resumo[r]; cheias != 0; cheias &= cheias - 1) {
+            size_t i = r * 64 + (size_t)__builtin_ctzll(cheias);
+            for (uint64_t palavra = bits[i]; palavra != 0; palavra &= palavra - 1) {
+                anotarPista(sessao, (uint32_t)(i * 64) + (uint32_t)__builtin_ctzll(palavra));
+            }
+        }
+    }
+    if (sessao->caderno.quantidade != cabecalho->numColetadas) {
+        reiniciarSessao(sessao);
+        return 0;
+    }
+    sessao->salaAtual = cabecalho->salaAtual;
+    anteciparFilhos(&caso->mansao, sessao->salaAtual);
+    sessao->estado = (EstadoSessao)cabecalho->estado;
+    sessao->veredicto = (Veredicto)cabecalho->veredicto;
+    sessao->acusado = cabecalho->acusado;
+    sessao->pistasContraAcusado = cabecalho->pistasContraAcusado;
+    return 1;
+}
+
+/**
+ * @brief Confere se um instantâneo pertence ao caso e tem campos válidos
+ *
+ * Não confere a contagem de pistas, que depende de percorrer o bitset.
+ *
+ * @param caso Caso do instantâneo
+ * @param dados Instantâneo, alinhado a 8
+ * @param tamanho Bytes disponíveis em "dados"
+ * @return 1 se o instantâneo é válido para o caso, 0 se não
+ */
+int conferirInstantaneo(const Caso* caso, const void* dados, size_t tamanho) {
+    const CabecalhoInstantaneo* cabecalho = (const CabecalhoInstantaneo*)dados;
+    if (tamanho != tamanhoInstantaneo(caso) ||
+        memcmp(cabecalho->assinatura, ASSINATURA_INSTANTANEO, sizeof(cabecalho->assinatura)) != 0 ||
+        cabecalho->versao != VERSAO_INSTANTANEO ||
+        cabecalho->numSalas != caso->mansao.numSalas ||
+        cabecalho->numPistas != caso->pistas.quantidade ||
+        cabecalho->numSuspeitos != caso->suspeitos.quantidade ||
+        cabecalho->salaAtual >= caso->mansao.numSalas ||
+        cabecalho->estado > SESSAO_ENCERRADA ||
+        cabecalho->veredicto > VEREDICTO_SUSTENTADA ||
+        (cabecalho->acusado != SEM_INDICE && cabecalho->acusado >= caso->suspeitos.quantidade)) {
+        return 0;
+    }
+    
+    // Bits além da última pista ou da última palavra do caso
+    size_t palavras = ((size_t)caso->pistas.quantidade + 63) / 64;
+    size_t palavrasResumo = (palavras + 63) / 64;
+    const uint64_t* resumo = (const uint64_t*)(cabecalho + 1);
+    const uint64_t* bits = resumo + palavrasResumo;
+    uint32_t sobra = caso->pistas.quantidade & 63;
+    if (sobra != 0 && (bits[palavras - 1] >> sobra) != 0) return 0;
+    if ((palavras & 63) != 0 && (resumo[palavrasResumo - 1] >> (palavras & 63)) != 0) return 0;
+    return 1;
+}
+
+/**
+ * @brief Grava o instantâneo da sessão num arquivo
+ * @param sessao Sessão a guardar
+ * @param caminho Arquivo de destino (sobrescrito)
+ * @return 1 em caso de sucesso, 0 em erro (já relatado)
+ */
+int salvarInstantaneo(const Sessao* sessao, const char* caminho) {
+    size_t tamanho = tamanhoInstantaneo(sessao->caso);
+    uint64_t* buffer = (uint64_t*)malloc(tamanho);
+    if (buffer == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    gravarInstantaneo(sessao, buffer);
+    
+    int sucesso = 0;
+    FILE* arquivo = fopen(caminho, "wb");
+    if (arquivo != NULL) {
+        sucesso = fwrite(buffer, 1, tamanho, arquivo) == tamanho;
+        sucesso = (fclose(arquivo) == 0) && sucesso;
+    }
+    if (!sucesso) {
+        fprintf(stderr, "❌ Não foi possível gravar o instantâneo em '%s'\n", caminho);
+    }
+    free(buffer);
+    return sucesso;
+}
+
+/**
+ * @brief Restaura a sessão de um arquivo de instantâneo, lido com mmap
+ * @param sessao Sessão já iniciada no caso do instantâneo
+ * @param caminho Arquivo do instantâneo
+ * @return 1 em caso de sucesso, 0 em erro (já relatado)
+ */
+int carregarInstantaneo(Sessao* sessao, const char* caminho) {
+    size_t tamanho = 0;
+    int mapeado = 0;
+    char* dados = mapearArquivo(caminho, &tamanho, &mapeado);
+    if (dados == NULL) {
+        fprintf(stderr, "❌ Não foi possível ler o instantâneo '%s'\n", caminho);
+        return 0;
+    }
+    int sucesso = restaurarInstantaneo(sessao, dados, tamanho);
+    if (!sucesso) {
+        fprintf(stderr, "❌ O instantâneo '%s' é inválido ou de outro caso\n", caminho);
+    }
+    desmapearArquivo(dados, tamanho, mapeado);
+    return sucesso;
+}
+
+/**
+ * @brief Ordena chaves de 64 bits em ordem decrescente
+ */
+int compararChavesDecrescente(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x < y) - (x > y);
+}
+
+/**
+ * @brief Pontua todas as acusações possíveis de investigações guardadas
+ *
+ * Cada instantâneo vira um caderno esparso, lido pelas palavras marcadas no
+ * resumo, e todos são pontuados juntos contra a matriz de evidências. Sai
+ * uma linha por suspeito com pontos, do mais ao menos apontado, no formato
+ * "instantâneo|suspeito|pontos|veredicto", e uma linha final de resumo.
+ *
+ * @param caso Caso dos instantâneos
+ * @param caminhos Arquivos de instantâneo
+ * @param numCaminhos Quantidade de arquivos
+ * @return 1 em caso de sucesso, 0 se algum instantâneo é inválido
+ */
+int executarHipoteses(const Caso* caso, char** caminhos, int numCaminhos) {
+    BitsCaderno* cadernos = (BitsCaderno*)malloc((size_t)numCaminhos * sizeof(BitsCaderno));
+    if (cadernos == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    
+    int sucesso = 1;
+    size_t palavras = ((size_t)caso->pistas.quantidade + 63) / 64;
+    size_t palavrasResumo = (palavras + 63) / 64;
+    for (int c = 0; c < numCaminhos; c++) {
+        inicializarBitsCaderno(&cadernos[c]);
+        if (!sucesso) continue;
+        
+        size_t tamanho = 0;
+        int mapeado = 0;
+        char* dados = mapearArquivo(caminhos[c], &tamanho, &mapeado);
+        if (dados == NULL) {
+            fprintf(stderr, "❌ Não foi possível ler o instantâneo '%s'\n", caminhos[c]);
+            sucesso = 0;
+            continue;
+        }
+        
+        uint32_t coletadas = 0;
+        if (conferirInstantaneo(caso, dados, tamanho)) {
+            const uint64_t* resumo = (const uint64_t*)(dados + sizeof(CabecalhoInstantaneo));
+            const uint64_t* bits = resumo + palavrasResumo;
+            for (size_t r = 0; r < palavrasResumo; r++) {
+                for (uint64_t cheias = resumo[r]; cheias != 0; cheias &= cheias - 1) {
+                    size_t i = r * 64 + (size_t)__builtin_ctzll(cheias);
+                    if (bits[i] == 0) continue;
+                    acrescentarPalavraCaderno(&cadernos[c], (uint32_t)i, bits[i]);
+                    coletadas += (uint32_t)__builtin_popcountll(bits[i]);
+                }
+            }
+        }
+        if (coletadas == 0 || coletadas != ((const CabecalhoInstantaneo*)dados)->numColetadas) {
+            fprintf(stderr, "❌ O instantâneo '%s' é inválido, de outro caso ou sem pistas\n",
+                    caminhos[c]);
+            sucesso = 0;
+        }
+        desmapearArquivo(dados, tamanho, mapeado);
+    }
+    
+    if (sucesso) {
+        MatrizEvidencias matriz;
+        montarMatrizEvidencias(caso, &matriz);
+        uint32_t numSuspeitos = matriz.numSuspeitos;
+        uint32_t* pontuacoes =
+            (uint32_t*)malloc(((size_t)numCaminhos * numSuspeitos + 1) * sizeof(uint32_t));
+        uint64_t* chaves = (uint64_t*)malloc(((size_t)numSuspeitos + 1) * sizeof(uint64_t));
+        if (pontuacoes == NULL || chaves == NULL) {
+            printf("Erro de alocação de memória!\n");
+            exit(1);
+        }
+        
+        double inicio = agoraEmSegundos();
+        pontuarCadernos(&matriz, cadernos, (uint32_t)numCaminhos, pontuacoes);
+        double segundos = agoraEmSegundos() - inicio;
+        
+        // Mais pontos primeiro; no empate, o menor ID
+        for (int c = 0; c < numCaminhos; c++) {
+            const uint32_t* pontos = pontuacoes + (size_t)c * numSuspeitos;
+            uint32_t quantidade = 0;
+            for (uint32_t s = 0; s < numSuspeitos; s++) {
+                if (pontos[s] > 0) chaves[quantidade++] = ((uint64_t)pontos[s] << 32) | (SEM_INDICE - s);
+            }
+            qsort(chaves, quantidade, sizeof(uint64_t), compararChavesDecrescente);
+            for (uint32_t i = 0; i < quantidade; i++) {
+                uint32_t suspeito = SEM_INDICE - (uint32_t)chaves[i];
+                uint32_t total = (uint32_t)(chaves[i] >> 32);
+                printf("%s|%s|%u|%s\n", caminhos[c], caso->suspeitos.textos[suspeito], total,
+                       nomeVeredicto(classificarEvidencias(total)));
+            }
+        }
+        printf("# %d investigações × %u suspeitos (%u plano(s) de peso) pontuadas em %.1f µs\n",
+               numCaminhos, numSuspeitos, matriz.numPlanos, segundos * 1e6);
+        free(pontuacoes);
+        free(chaves);
+        liberarMatrizEvidencias(&matriz);
+    }
+    
+    for (int c = 0; c < numCaminhos; c++) liberarBitsCaderno(&cadernos[c]);
+    free(cadernos);
+    return sucesso;
+}
+
+// ========== FUNÇÕES DO MODO EM LOTE ==========
+
+/**
+ * @brief Separa um arquivo de roteiros em sessões, sem copiar textos
+ *
+ * Cada linha não vazia é uma sessão no formato "comandos|suspeito", por
+ * exemplo "CECEDCS|carlos". Espaços entre os comandos são ignorados e
+ * linhas iniciadas por '#' são comentários. O buffer é modificado.
+ *
+ * @param dados Conteúdo do arquivo terminado em '\0'
+ * @param numRoteiros Saída: quantidade de roteiros
+ * @return Vetor de roteiros (liberar com free)
+ */
+Roteiro* lerRoteiros(char* dados, size_t* numRoteiros) {
+    size_t capacidade = 1;
+    for (const char* c = dados; *c != '\0'; c++) {
+        if (*c == '\n') capacidade++;
+    }
+    
+    Roteiro* roteiros = (Roteiro*)malloc(capacidade * sizeof(Roteiro));
+    if (roteiros == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    
+    size_t quantidade = 0;
+    char* cursor = dados;
+    while (*cursor != '\0') {
+        char* linha = cursor;
+        char* fim = strchr(cursor, '\n');
+        if (fim != NULL) {
+            *fim = '\0';
+            cursor = fim + 1;
+        } else {
+            cursor += strlen(cursor);
+        }
+        linha[strcspn(linha, "\r")] = '\0';
+        if (linha[0] == '\0' || linha[0] == '#') continue;
+        
+        char* separador = strchr(linha, '|');
+        const char* acusado = "";
+        if (separador != NULL) {
+            *separador = '\0';
+            acusado = separador + 1;
+            toLowerString(separador + 1);
+        }
+        
+        // Normaliza os comandos no próprio buffer: maiúsculos, sem espaços
+        size_t n = 0;
+        for (char* c = linha; *c != '\0'; c++) {
+            if (!isspace((unsigned char)*c)) linha[n++] = (char)toupper((unsigned char)*c);
+        }
+        linha[n] = '\0';
+        
+        roteiros[quantidade].comandos = linha;
+        roteiros[quantidade].numComandos = n;
+        roteiros[quantidade].acusado = acusado;
+        quantidade++;
+    }
+    
+    *numRoteiros = quantidade;
+    return roteiros;
+}
+
+/**
+ * @brief Executa um roteiro do início ao fim em uma sessão já reiniciada
+ * @param sessao Sessão na entrada da mansão
+ * @param roteiro Comandos e suspeito a acusar
+ * @return Veredicto final (VEREDICTO_PENDENTE se o roteiro não sai da mansão)
+ */
+Veredicto executarRoteiro(Sessao* sessao, const Roteiro* roteiro) {
+    for (size_t i = 0; i < roteiro->numComandos && sessao->estado == SESSAO_EXPLORANDO; i++) {
+        aplicarComando(sessao, roteiro->comandos[i]);
+    }
+    return acusarSuspeito(sessao, roteiro->acusado);
+}
+
+/**
+ * @brief Modo em lote: roda todos os roteiros de um arquivo sem terminal
+ *
+ * Na primeira rodada imprime uma linha por roteiro
+ * ("linha|veredicto|pistas coletadas|pistas contra o acusado|sala final");
+ * as demais repetições servem para teste de carga. Ao final, imprime os
+ * totais por veredicto e a vazão em sessões por segundo.
+ *
+ * @param caso Caso compartilhado por todas as sessões
+ * @param caminho Arquivo de roteiros
+ * @param repeticoes Quantas vezes o arquivo inteiro é executado
+ * @param diario Diário onde cada sessão é registrada (NULL: nenhum)
+ * @return 1 em caso de sucesso, 0 se o arquivo não pôde ser lido
+ */
+int executarLote(const Caso* caso, const char* caminho, long repeticoes, struct Diario* diario) {
+    size_t tamanho = 0;
+    char* dados = lerArquivo(caminho, &tamanho);
+    if (dados == NULL) {
+        fprintf(stderr, "❌ Não foi possível ler os roteiros '%s'\n", caminho);
+        return 0;
+    }
+    
+    size_t numRoteiros = 0;
+    Roteiro* roteiros = lerRoteiros(dados, &numRoteiros);
+    
+    // Uma única sessão reaproveitada: reiniciar descarta a arena em O(1)
+    Sessao sessao;
+    iniciarSessao(&sessao, caso);
+#ifndef _WIN32
+    if (diario != NULL) ligarDiario(&sessao, diario);
+#else
+    (void)diario;
+#endif
+    
+    unsigned long long totais[VEREDICTO_SUSTENTADA + 1] = {0};
+    double inicio = agoraEmSegundos();
+    for (long r = 0; r < repeticoes; r++) {
+        for (size_t i = 0; i < numRoteiros; i++) {
+            reiniciarSessao(&sessao);
+            Veredicto veredicto = executarRoteiro(&sessao, &roteiros[i]);
+            totais[veredicto]++;
+            if (r == 0) {
+                printf("%zu|%s|%zu|%u|%s\n", i + 1, nomeVeredicto(veredicto),
+                       sessao.caderno.quantidade, sessao.pistasContraAcusado,
+                       nomeSala(&caso->mansao, sessao.salaAtual));
+            }
+        }
+    }
+    double segundos = agoraEmSegundos() - inicio;
+    
+    unsigned long long sessoes = (unsigned long long)numRoteiros * (unsigned long long)repeticoes;
+    printf("# %llu sessões em %.3f s (%.0f sessões/s)\n", sessoes, segundos,
+           segundos > 0 ? (double)sessoes / segundos : 0.0);
+    for (int v = VEREDICTO_PENDENTE; v <= VEREDICTO_SUSTENTADA; v++) {
+        printf("# %s: %llu\n", nomeVeredicto((Veredicto)v), totais[v]);
+    }
+    
+    liberarSessao(&sessao);
+    free(roteiros);
+    free(dados);
+    return 1;
+}
+
+// ========== FUNÇÕES DO SERVIDOR DE SESSÕES ==========
+
+/**
+ * @brief Interpreta uma linha do protocolo do servidor e formata a resposta
+ *
+ * Comandos (letra sem diferença de maiúsculas): C, E, D, P, S, "A nome"
+ * para acusar, R para reiniciar e ? para consultar o estado; no servidor
+ * cooperativo, T dá os pontos da equipe e L lista o caderno da equipe. Cada
+ * comando produz exatamente uma linha de resposta com campos separados por '|'.
+ *
+ * @param sessao Sessão da conexão
+ * @param linha Linha recebida, sem o '\n' (é modificada)
+ * @param resposta Buffer de saída
+ * @param capacidade Tamanho do buffer de saída
+ * @return Bytes escritos em "resposta"
+ */
+size_t responderLinha(Sessao* sessao, char* linha, char* resposta, size_t capacidade) {
+    const Caso* caso = sessao->caso;
+    uint64_t inicio = estatisticas.ligadas ? agoraEmNanossegundos() : 0;
+    linha[strcspn(linha, "\r")] = '\0';
+    char comando = (char)toupper((unsigned char)linha[0]);
+    int escritos;
+    
+    if (comando == 'A') {
+        char* nome = linha + 1;
+        while (isspace((unsigned char)*nome)) nome++;
+        toLowerString(nome);
+        if (sessao->estado != SESSAO_AGUARDANDO_ACUSACAO) {
+            escritos = snprintf(resposta, capacidade, "erro|fora de hora\n");
+        } else {
+            Veredicto veredicto = acusarSuspeito(sessao, nome);
+            escritos = snprintf(resposta, capacidade, "veredicto|%s|%u\n",
+                                nomeVeredicto(veredicto), sessao->pistasContraAcusado);
+        }
+    } else if (comando == 'R') {
+        reiniciarSessao(sessao);
+        escritos = snprintf(resposta, capacidade, "sala|%s\n", nomeSala(&caso->mansao, sessao->salaAtual));
+    } else if (comando == '?') {
+        escritos = snprintf(resposta, capacidade, "estado|%s|%zu|%s\n",
+                            nomeSala(&caso->mansao, sessao->salaAtual), sessao->caderno.quantidade,
+                            nomeVeredicto(sessao->veredicto));
+    } else if ((comando == 'T' || comando == 'L') && linha[1] == '\0' && sessao->equipe == NULL) {
+        escritos = snprintf(resposta, capacidade, "erro|servidor sem equipe\n");
+    } else if (comando == 'T' && linha[1] == '\0') {
+        // Pontos ao vivo: cada contador é lido sem parar os demais detetives
+        const CadernoCompartilhado* equipe = sessao->equipe;
+        escritos = snprintf(resposta, capacidade, "equipe|%llu",
+                            (unsigned long long)atomic_load(&equipe->publicadas));
+        for (uint32_t s = 0; s < caso->suspeitos.quantidade && (size_t)escritos < capacidade; s++) {
+            uint32_t pontos = atomic_load_explicit(&equipe->pontos[s], memory_order_relaxed);
+            if (pontos == 0) continue;
+            escritos += snprintf(resposta + escritos, capacidade - escritos, "|%s:%u",
+                                 caso->suspeitos.textos[s], pontos);
+        }
+        if ((size_t)escritos < capacidade) {
+            escritos += snprintf(resposta + escritos, capacidade - escritos, "\n");
+        }
+    } else if (comando == 'L' && linha[1] == '\0') {
+        // Foto consistente do caderno da equipe, em ordem alfabética
+        size_t quantidade;
+        uint32_t* pistas = fotografarCadernoCompartilhado(sessao->equipe, &quantidade);
+        escritos = snprintf(resposta, capacidade, "caderno|%zu", quantidade);
+        for (size_t i = 0; i < quantidade && (size_t)escritos < capacidade; i++) {
+            escritos += snprintf(resposta + escritos, capacidade - escritos, "|%s",
+                                 caso->pistas.textos[pistas[i]]);
+        }
+        if ((size_t)escritos < capacidade) {
+            escritos += snprintf(resposta + escritos, capacidade - escritos, "\n");
+        }
+        free(pistas);
+    } else if (linha[0] != '\0' && linha[1] != '\0') {
+        escritos = snprintf(resposta, capacidade, "erro|comando inválido\n");
+    } else {
+        uint32_t pista = salaDaMansao(&caso->mansao, sessao->salaAtual)->pista;
+        switch (aplicarComando(sessao, comando)) {
+            case RESULTADO_PISTA_COLETADA:
+                escritos = snprintf(resposta, capacidade, "pista|%s\n", caso->pistas.textos[pista]);
+                break;
+            case RESULTADO_PISTA_REPETIDA:
+                escritos = snprintf(resposta, capacidade, "repetida|%s\n", caso->pistas.textos[pista]);
+                break;
+            case RESULTADO_SEM_PISTA:
+                escritos = snprintf(resposta, capacidade, "sem-pista\n");
+                break;
+            case RESULTADO_MOVEU:
+                escritos = snprintf(resposta, capacidade, "sala|%s\n", nomeSala(&caso->mansao, sessao->salaAtual));
+                break;
+            case RESULTADO_SEM_CAMINHO:
+                escritos = snprintf(resposta, capacidade, "sem-caminho\n");
+                break;
+            case RESULTADO_PALPITE: {
+                escritos = snprintf(resposta, capacidade, "palpite");
+                for (uint32_t i = 0; i < TAMANHO_PALPITE; i++) {
+                    uint32_t suspeito = suspeitoNaPosicao(&sessao->placar, i);
+                    if (suspeito == SEM_INDICE ||
+                        pistasContraSuspeito(&sessao->placar, suspeito) == 0 ||
+                        (size_t)escritos >= capacidade) break;
+                    escritos += snprintf(resposta + escritos, capacidade - escritos, "|%s:%u",
+                                         caso->suspeitos.textos[suspeito],
+                                         pistasContraSuspeito(&sessao->placar, suspeito));
+                }
+                if ((size_t)escritos < capacidade) {
+                    escritos += snprintf(resposta + escritos, capacidade - escritos, "\n");
+                }
+                break;
+            }
+            case RESULTADO_SAIU:
+                escritos = snprintf(resposta, capacidade, "saiu|%s\n",
+                                    sessao->estado == SESSAO_ENCERRADA
+                                        ? nomeVeredicto(sessao->veredicto)
+                                        : "aguardando-acusacao");
+                break;
+            default:
+                escritos = snprintf(resposta, capacidade, "erro|comando inválido\n");
+        }
+    }
+    
+    // Respostas truncadas ainda terminam a linha
+    if (escritos < 0) escritos = 0;
+    if ((size_t)escritos >= capacidade) {
+        escritos = (int)capacidade - 1;
+        resposta[escritos - 1] = '\n';
+    }
+    if (estatisticas.ligadas) {
+        registrarEmHistograma(&estatisticas.latenciaComando, agoraEmNanossegundos() - inicio);
+    }
+    return (size_t)escritos;
+}
+
+#ifndef _WIN32
+static volatile sig_atomic_t servidorEncerrando = 0;
+
+/**
+ * @brief Inicializa uma fila de conexões vazia
+ * @param fila Fila a ser inicializada
+ */
+void inicializarFila(FilaConexoes* fila) {
+    fila->itens = NULL;
+    fila->capacidade = 0;
+    fila->inicio = 0;
+    fila->quantidade = 0;
+    fila->encerrando = 0;
+    pthread_mutex_init(&fila->trava, NULL);
+    pthread_cond_init(&fila->temItens, NULL);
+}
+
+/**
+ * @brief Coloca uma conexão no fim da fila e acorda um consumidor
+ * @param fila Fila de destino
+ * @param conexao Conexão a enfileirar
+ */
+void empurrarFila(FilaConexoes* fila, Conexao* conexao) {
+    pthread_mutex_lock(&fila->trava);
+    if (fila->quantidade == fila->capacidade) {
+        // Dobra o vetor desfazendo a volta circular
+        size_t capacidade = fila->capacidade ? fila->capacidade * 2 : 64;
+        Conexao** itens = (Conexao**)malloc(capacidade * sizeof(Conexao*));
+        if (itens == NULL) {
+            printf("Erro de alocação de memória!\n");
+            exit(1);
+        }
+        for (size_t i = 0; i < fila->quantidade; i++) {
+            itens[i] = fila->itens[(fila->inicio + i) % fila->capacidade];
+        }
+        free(fila->itens);
+        fila->itens = itens;
+        fila->capacidade = capacidade;
+        fila->inicio = 0;
+    }
+    fila->itens[(fila->inicio + fila->quantidade) % fila->capacidade] = conexao;
+    fila->quantidade++;
+    pthread_cond_signal(&fila->temItens);
+    pthread_mutex_unlock(&fila->trava);
+}
+
+/**
+ * @brief Retira a conexão mais antiga da fila
+ * @param fila Fila de origem
+ * @param esperar 1 para bloquear até haver item ou a fila encerrar
+ * @return Conexão retirada ou NULL (fila vazia ou encerrando)
+ */
+Conexao* retirarFila(FilaConexoes* fila, int esperar) {
+    pthread_mutex_lock(&fila->trava);
+    while (esperar && fila->quantidade == 0 && !fila->encerrando) {
+        pthread_cond_wait(&fila->temItens, &fila->trava);
+    }
+    Conexao* conexao = NULL;
+    if (fila->quantidade > 0) {
+        conexao = fila->itens[fila->inicio];
+        fila->inicio = (fila->inicio + 1) % fila->capacidade;
+        fila->quantidade--;
+    }
+    pthread_mutex_unlock(&fila->trava);
+    return conexao;
+}
+
+/**
+ * @brief Libera a fila (as conexões restantes pertencem ao chamador)
+ * @param fila Fila a ser liberada
+ */
+void liberarFila(FilaConexoes* fila) {
+    free(fila->itens);
+    pthread_mutex_destroy(&fila->trava);
+    pthread_cond_destroy(&fila->temItens);
+}
+
+/**
+ * @brief Escreve todo o buffer no descritor, repetindo escritas parciais
+ * @param fd Descritor de destino
+ * @param dados Bytes a escrever
+ * @param tamanho Quantidade de bytes
+ * @return 1 em caso de sucesso, 0 em erro
+ */
+int escreverTudo(int fd, const char* dados, size_t tamanho) {
+    while (tamanho > 0) {
+        ssize_t escritos = write(fd, dados, tamanho);
+        if (escritos < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        dados += escritos;
+        tamanho -= (size_t)escritos;
+    }
+    return 1;
+}
+
+/**
+ * @brief Envia respostas à conexão sem bloquear
+ *
+ * Havendo algo pendente, os dados vão para o fim dele, para manter a
+ * ordem; senão, o que o socket não aceitar agora fica pendente, e o poll
+ * passa a esperar que a conexão aceite escrita.
+ *
+ * @param conexao Conexão de destino
+ * @param dados Bytes a enviar
+ * @param tamanho Quantidade de bytes
+ * @return 1 em caso de sucesso, 0 em erro (a conexão deve ser fechada)
+ */
+int enviarParaConexao(Conexao* conexao, const char* dados, size_t tamanho) {
+    size_t enviados = 0;
+    while (conexao->pendente == NULL && enviados < tamanho) {
+        ssize_t escritos = send(conexao->fd, dados + enviados, tamanho - enviados, MSG_NOSIGNAL);
+        if (escritos < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return 0;
+        }
+        enviados += (size_t)escritos;
+    }
+    if (enviados == tamanho) return 1;
+
+    conexao->pendente = (char*)realloc(conexao->pendente, conexao->tamanhoPendente + tamanho - enviados);
+    if (conexao->pendente == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    memcpy(conexao->pendente + conexao->tamanhoPendente, dados + enviados, tamanho - enviados);
+    conexao->tamanhoPendente += tamanho - enviados;
+    return 1;
+}
+
+/**
+ * @brief Envia o que estava pendente, até o socket voltar a recusar
+ * @param conexao Conexão com respostas pendentes
+ * @return 1 em caso de sucesso (pode sobrar algo pendente), 0 em erro
+ */
+int continuarEnvioConexao(Conexao* conexao) {
+    size_t enviados = 0;
+    while (enviados < conexao->tamanhoPendente) {
+        ssize_t escritos = send(conexao->fd, conexao->pendente + enviados,
+                                conexao->tamanhoPendente - enviados, MSG_NOSIGNAL);
+        if (escritos < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return 0;
+        }
+        enviados += (size_t)escritos;
+    }
+
+    conexao->tamanhoPendente -= enviados;
+    if (conexao->tamanhoPendente > 0) {
+        memmove(conexao->pendente, conexao->pendente + enviados, conexao->tamanhoPendente);
+    } else {
+        free(conexao->pendente);
+        conexao->pendente = NULL;
+    }
+    return 1;
+}
+
+/**
+ * @brief Lê o que chegou na conexão e responde a cada linha completa
+ *
+ * Com respostas pendentes, o poll viu o socket aceitar escrita: o trabalhador
+ * só as envia e, se tudo saiu, responde às linhas que já estavam no buffer,
+ * sem ler mais. Um cliente que não lê as respostas não prende o trabalhador:
+ * assim que o socket recusa, a conexão para de ser atendida até poder
+ * receber de novo.
+ *
+ * @param trabalhador Thread que atende a conexão
+ * @param conexao Conexão com dados disponíveis (ou escrita liberada)
+ */
+void atenderConexao(Trabalhador* trabalhador, Conexao* conexao) {
+    if (conexao->pendente != NULL) {
+        if (!continuarEnvioConexao(conexao)) {
+            conexao->fechar = 1;
+            return;
+        }
+        if (conexao->pendente != NULL) return;
+    } else {
+        ssize_t lidos;
+        do {
+            lidos = read(conexao->fd, conexao->entrada + conexao->usados,
+                         sizeof(conexao->entrada) - conexao->usados);
+        } while (lidos < 0 && errno == EINTR);
+        if (lidos < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        if (lidos <= 0) {
+            conexao->fechar = 1;
+            return;
+        }
+        conexao->usados += (size_t)lidos;
+    }
+
+    char saida[TAMANHO_SAIDA_SERVIDOR];
+    size_t tamanhoSaida = 0;
+    size_t consumidos = 0;
+    char* fim;
+    while (conexao->pendente == NULL &&
+           (fim = memchr(conexao->entrada + consumidos, '\n',
+                         conexao->usados - consumidos)) != NULL) {
+        if (tamanhoSaida + TAMANHO_LINHA_SERVIDOR * 2 > sizeof(saida)) {
+            if (!enviarParaConexao(conexao, saida, tamanhoSaida)) {
+                conexao->fechar = 1;
+                return;
+            }
+            tamanhoSaida = 0;
+            continue; // Se o socket recusou, as linhas restantes esperam
+        }
+        *fim = '\0';
+        tamanhoSaida += responderLinha(&conexao->sessao, conexao->entrada + consumidos,
+                                       saida + tamanhoSaida, TAMANHO_LINHA_SERVIDOR * 2);
+        consumidos = (size_t)(fim - conexao->entrada) + 1;
+        trabalhador->comandos++;
+    }
+
+    // Guarda o resto; uma linha maior que o buffer é descartada
+    memmove(conexao->entrada, conexao->entrada + consumidos, conexao->usados - consumidos);
+    conexao->usados -= consumidos;
+    if (conexao->usados == sizeof(conexao->entrada) &&
+        memchr(conexao->entrada, '\n', conexao->usados) == NULL) {
+        static const char erro[] = "erro|linha longa demais\n";
+        memcpy(saida + tamanhoSaida, erro, sizeof(erro) - 1);
+        tamanhoSaida += sizeof(erro) - 1;
+        conexao->usados = 0;
+    }
+
+    if (tamanhoSaida > 0 && !enviarParaConexao(conexao, saida, tamanhoSaida)) {
+        conexao->fechar = 1;
+    }
+}
+
+/**
+ * @brief Laço de um trabalhador: atende conexões prontas e as devolve
+ * @param argumento Trabalhador (Trabalhador*)
+ * @return NULL
+ */
+void* executarTrabalhador(void* argumento) {
+    Trabalhador* trabalhador = (Trabalhador*)argumento;
+    Servidor* servidor = trabalhador->servidor;
+    Conexao* conexao;
+    
+    while ((conexao = retirarFila(&servidor->prontas, 1)) != NULL) {
+        atenderConexao(trabalhador, conexao);
+        empurrarFila(&servidor->devolvidas, conexao);
+        
+        // Acorda o poll da thread principal para reativar a conexão
+        char sinal = 1;
+        while (write(servidor->aviso[1], &sinal, 1) < 0 && errno == EINTR) {
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Fecha o socket e libera a sessão de uma conexão
+ * @param conexao Conexão a encerrar
+ */
+void fecharConexao(Conexao* conexao) {
+    close(conexao->fd);
+    free(conexao->pendente);
+    liberarSessao(&conexao->sessao);
+    free(conexao);
+}
+
+/**
+ * @brief Tratador de SIGINT/SIGTERM: pede o encerramento do servidor
+ * @param sinal Número do sinal (não usado)
+ */
+void pedirEncerramento(int sinal) {
+    (void)sinal;
+    servidorEncerrando = 1;
+}
+
+/**
+ * @brief Servidor de sessões em um socket Unix, com pool de trabalhadores
+ *
+ * A thread principal espera com poll() nas conexões ociosas; quando uma
+ * tem dados (ou, com respostas pendentes, volta a aceitar escrita), ela vai
+ * para a fila "prontas" e um trabalhador processa suas linhas. Nenhum
+ * socket de cliente bloqueia, então um cliente que não lê não prende
+ * trabalhador. O caso é único e somente leitura; cada conexão carrega apenas a
+ * própria sessão (posição, caderno, placar e arena). No modo cooperativo
+ * todas as sessões formam uma equipe e anotam as pistas também num caderno
+ * compartilhado, sem trava. Encerra com SIGINT ou SIGTERM.
+ *
+ * @param caso Caso compartilhado
+ * @param caminho Caminho do socket Unix (recriado se já existir)
+ * @param numTrabalhadores Threads do pool
+ * @param diario Diário onde cada sessão é registrada (NULL: nenhum)
+ * @param cooperativo 1 para compartilhar o caderno entre as sessões
+ * @return 1 em caso de encerramento normal, 0 em erro de configuração
+ */
+int executarServidor(const Caso* caso, const char* caminho, int numTrabalhadores, Diario* diario,
+                     int cooperativo) {
+    struct sockaddr_un endereco;
+    memset(&endereco, 0, sizeof(endereco));
+    endereco.sun_family = AF_UNIX;
+    if (strlen(caminho) >= sizeof(endereco.sun_path)) {
+        fprintf(stderr, "❌ Caminho de socket longo demais: %s\n", caminho);
+        return 0;
+    }
+    strcpy(endereco.sun_path, caminho);
+    
+    int escuta = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(caminho);
+    if (escuta < 0 || bind(escuta, (struct sockaddr*)&endereco, sizeof(endereco)) < 0 ||
+        listen(escuta, 128) < 0) {
+        fprintf(stderr, "❌ Não foi possível escutar em '%s'\n", caminho);
+        if (escuta >= 0) close(escuta);
+        return 0;
+    }
+    
+    Servidor servidor;
+    CadernoCompartilhado equipe;
+    servidor.caso = caso;
+    servidor.equipe = NULL;
+    if (cooperativo) {
+        inicializarCadernoCompartilhado(&equipe, caso);
+        servidor.equipe = &equipe;
+    }
+    inicializarFila(&servidor.prontas);
+    inicializarFila(&servidor.devolvidas);
+    if (pipe(servidor.aviso) < 0) {
+        fprintf(stderr, "❌ Não foi possível criar o pipe de aviso\n");
+        close(escuta);
+        return 0;
+    }
+    fcntl(servidor.aviso[0], F_SETFL, O_NONBLOCK);
+    fcntl(servidor.aviso[1], F_SETFL, O_NONBLOCK); // Pipe cheio já é um aviso pendente
+    
+    // Os trabalhadores nascem com os sinais bloqueados, para que SIGINT
+    // interrompa o poll da thread principal
+    struct sigaction acao;
+    memset(&acao, 0, sizeof(acao));
+    acao.sa_handler = pedirEncerramento;
+    sigaction(SIGINT, &acao, NULL);
+    sigaction(SIGTERM, &acao, NULL);
+    signal(SIGPIPE, SIG_IGN);
+    
+    sigset_t sinais, anteriores;
+    sigemptyset(&sinais);
+    sigaddset(&sinais, SIGINT);
+    sigaddset(&sinais, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &sinais, &anteriores);
+    
+    Trabalhador* trabalhadores = (Trabalhador*)calloc((size_t)numTrabalhadores, sizeof(Trabalhador));
+    if (trabalhadores == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    for (int i = 0; i < numTrabalhadores; i++) {
+        trabalhadores[i].servidor = &servidor;
+        pthread_create(&trabalhadores[i].thread, NULL, executarTrabalhador, &trabalhadores[i]);
+    }
+    pthread_sigmask(SIG_SETMASK, &anteriores, NULL);
+    
+    printf("🛰️  Servidor em '%s' com %d trabalhadores%s (Ctrl+C encerra)\n",
+           caminho, numTrabalhadores, cooperativo ? ", caderno da equipe compartilhado" : "");
+    fflush(stdout);
+    
+    // Conexões ociosas, vigiadas pelo poll (índice i ↔ descritores[i + 2])
+    Conexao** ociosas = NULL;
+    struct pollfd* descritores = NULL;
+    size_t numOciosas = 0, capacidadeOciosas = 0;
+    unsigned long long sessoes = 0;
+    
+    while (!servidorEncerrando) {
+        if (numOciosas + 2 > capacidadeOciosas) {
+            capacidadeOciosas = capacidadeOciosas ? capacidadeOciosas * 2 : 64;
+            ociosas = (Conexao**)realloc(ociosas, capacidadeOciosas * sizeof(Conexao*));
+            descritores = (struct pollfd*)realloc(descritores,
+                                                  (capacidadeOciosas + 2) * sizeof(struct pollfd));
+            if (ociosas == NULL || descritores == NULL) {
+                printf("Erro de alocação de memória!\n");
+                exit(1);
+            }
+        }
+        
+        descritores[0].fd = escuta;
+        descritores[1].fd = servidor.aviso[0];
+        for (size_t i = 0; i < numOciosas; i++) descritores[i + 2].fd = ociosas[i]->fd;
+        for (size_t i = 0; i < numOciosas + 2; i++) {
+            // Com respostas pendentes, espera-se a escrita, e a conexão não é lida
+            descritores[i].events = i >= 2 && ociosas[i - 2]->pendente != NULL ? POLLOUT : POLLIN;
+            descritores[i].revents = 0;
+        }
+        
+        if (poll(descritores, (nfds_t)(numOciosas + 2), -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        
+        // Conexões com dados vão para os trabalhadores (de trás para frente,
+        // pois a remoção traz o último elemento para a posição atual)
+        for (size_t i = numOciosas; i-- > 0;) {
+            if (descritores[i + 2].revents == 0) continue;
+            empurrarFila(&servidor.prontas, ociosas[i]);
+            ociosas[i] = ociosas[--numOciosas];
+        }
+        
+        // Conexões devolvidas voltam ao poll ou são fechadas
+        if (descritores[1].revents != 0) {
+            char descarte[256];
+            while (read(servidor.aviso[0], descarte, sizeof(descarte)) > 0) {
+            }
+            Conexao* conexao;
+            while ((conexao = retirarFila(&servidor.devolvidas, 0)) != NULL) {
+                if (conexao->fechar) {
+                    fecharConexao(conexao);
+                    continue;
+                }
+                if (numOciosas == capacidadeOciosas) {
+                    capacidadeOciosas *= 2;
+                    ociosas = (Conexao**)realloc(ociosas, capacidadeOciosas * sizeof(Conexao*));
+                    descritores = (struct pollfd*)realloc(descritores,
+                                                          (capacidadeOciosas + 2) * sizeof(struct pollfd));
+                    if (ociosas == NULL || descritores == NULL) {
+                        printf("Erro de alocação de memória!\n");
+                        exit(1);
+                    }
+                }
+                ociosas[numOciosas++] = conexao;
+            }
+        }
+        
+        // Novo cliente: cria a sessão e anuncia a sala de entrada
+        if (descritores[0].revents != 0) {
+            int fd = accept(escuta, NULL, NULL);
+            if (fd < 0) continue;
+            fcntl(fd, F_SETFL, O_NONBLOCK);
+            
+            Conexao* conexao = (Conexao*)malloc(sizeof(Conexao));
+            if (conexao == NULL) {
+                printf("Erro de alocação de memória!\n");
+                exit(1);
+            }
+            conexao->fd = fd;
+            conexao->fechar = 0;
+            conexao->pendente = NULL;
+            conexao->tamanhoPendente = 0;
+            conexao->usados = 0;
+            iniciarSessao(&conexao->sessao, caso);
+            conexao->sessao.equipe = servidor.equipe;
+            if (diario != NULL) ligarDiario(&conexao->sessao, diario);
+            sessoes++;
+            
+            char saudacao[TAMANHO_LINHA_SERVIDOR];
+            int tamanho = snprintf(saudacao, sizeof(saudacao), "sala|%s\n",
+                                   nomeSala(&servidor.caso->mansao,
+                                            conexao->sessao.salaAtual));
+            if (!enviarParaConexao(conexao, saudacao, (size_t)tamanho)) {
+                fecharConexao(conexao);
+                continue;
+            }
+            empurrarFila(&servidor.devolvidas, conexao);
+            char sinal = 1;
+            if (write(servidor.aviso[1], &sinal, 1) < 0) {
+                // Pipe cheio: o próximo poll já será acordado
+            }
+        }
+    }
+    
+    // Encerramento: dispensa os trabalhadores e fecha todas as conexões
+    pthread_mutex_lock(&servidor.prontas.trava);
+    servidor.prontas.encerrando = 1;
+    pthread_cond_broadcast(&servidor.prontas.temItens);
+    pthread_mutex_unlock(&servidor.prontas.trava);
+    
+    unsigned long long comandos = 0;
+    for (int i = 0; i < numTrabalhadores; i++) {
+        pthread_join(trabalhadores[i].thread, NULL);
+        comandos += trabalhadores[i].comandos;
+    }
+    
+    Conexao* conexao;
+    while ((conexao = retirarFila(&servidor.prontas, 0)) != NULL) fecharConexao(conexao);
+    while ((conexao = retirarFila(&servidor.devolvidas, 0)) != NULL) fecharConexao(conexao);
+    for (size_t i = 0; i < numOciosas; i++) fecharConexao(ociosas[i]);
+    
+    printf("\n🛰️  Servidor encerrado: %llu sessões, %llu comandos\n", sessoes, comandos);
+    if (servidor.equipe != NULL) {
+        printf("👥 Caderno da equipe: %llu pistas\n",
+               (unsigned long long)atomic_load(&equipe.publicadas));
+        liberarCadernoCompartilhado(&equipe);
+    }
+    
+    free(ociosas);
+    free(descritores);
+    free(trabalhadores);
+    liberarFila(&servidor.prontas);
+    liberarFila(&servidor.devolvidas);
+    close(servidor.aviso[0]);
+    close(servidor.aviso[1]);
+    close(escuta);
+    unlink(caminho);
+    return 1;
+}
+#endif
+
+// ========== FUNÇÕES DO ANFITRIÃO DE PARTIDAS ==========
+
+#ifdef __linux__
+/**
+ * @brief Passa a sessão de trabalho à partida de uma conexão
+ *
+ * A conexão que já está na sessão continua de onde parou, sem custo. Senão,
+ * a dona anterior é estacionada e a sessão é remontada: as pistas voltam ao
+ * caderno, ao índice e ao placar (com o ranking guardado, para que os
+ * empates não mudem de ordem), e a partida volta à etapa em que esperava.
+ *
+ * @param anfitriao Anfitrião de partidas
+ * @param espera Conexão que vai jogar
+ */
+void retomarPartida(Anfitriao* anfitriao, PartidaEmEspera* espera) {
+    if (anfitriao->ativa == espera) return;
+    if (anfitriao->ativa != NULL) suspenderPartida(anfitriao, anfitriao->ativa);
+
+    Sessao* sessao = &anfitriao->sessao;
+    Partida* partida = &anfitriao->partida;
+    reiniciarSessao(sessao);
+    for (uint32_t i = 0; i < espera->numPistas; i++) anotarPista(sessao, espera->pistas[i]);
+    if (espera->numPistas > 0) {
+        restaurarRankingPlacar(&sessao->placar, espera->pistas + espera->numPistas);
+    }
+    sessao->salaAtual = espera->salaAtual;
+    sessao->estado = (EstadoSessao)espera->estado;
+
+    partida->etapa = (EtapaPartida)espera->etapa;
+    partida->turno = espera->turno;
+    partida->exibidas = espera->exibidas;
+    snprintf(partida->consulta, sizeof(partida->consulta), "%s",
+             espera->consulta != NULL ? espera->consulta : "");
+    recolherPistasAdiante(&partida->adiante, &sessao->caderno);
+
+    anfitriao->ativa = espera;
+    anfitriao->retomadas++;
+}
+
+/**
+ * @brief Estaciona a partida da sessão de trabalho na sua conexão
+ *
+ * Guarda a sala, a etapa e, se alguma pista foi coletada desde a última
+ * vez, as pistas do caderno e o ranking do placar. A consulta só é guardada
+ * enquanto a busca tem páginas por mostrar.
+ *
+ * @param anfitriao Anfitrião de partidas
+ * @param espera Conexão dona da sessão de trabalho
+ */
+void suspenderPartida(Anfitriao* anfitriao, PartidaEmEspera* espera) {
+    const Sessao* sessao = &anfitriao->sessao;
+    const Partida* partida = &anfitriao->partida;
+    espera->salaAtual = sessao->salaAtual;
+    espera->estado = (uint8_t)sessao->estado;
+    espera->etapa = (uint8_t)partida->etapa;
+    espera->turno = partida->turno;
+    espera->exibidas = (uint32_t)partida->exibidas;
+
+    free(espera->consulta);
+    espera->consulta = NULL;
+    if (partida->etapa == ETAPA_PAGINA) {
+        size_t tamanho = strlen(partida->consulta) + 1;
+        espera->consulta = (char*)malloc(tamanho);
+        if (espera->consulta == NULL) {
+            printf("Erro de alocação de memória!\n");
+            exit(1);
+        }
+        memcpy(espera->consulta, partida->consulta, tamanho);
+    }
+
+    // O placar só muda quando uma pista entra no caderno
+    if (sessao->caderno.quantidade != espera->numPistas) {
+        uint32_t numPistas = (uint32_t)sessao->caderno.quantidade;
+        uint32_t numSuspeitos = sessao->placar.numSuspeitos;
+        espera->pistas = (uint32_t*)realloc(espera->pistas,
+                                            ((size_t)numPistas + numSuspeitos) * sizeof(uint32_t));
+        if (espera->pistas == NULL) {
+            printf("Erro de alocação de memória!\n");
+            exit(1);
+        }
+        IteradorCaderno iterador;
+        iniciarIteradorCaderno(&iterador, &sessao->caderno);
+        for (uint32_t i = 0; i < numPistas; i++) proximaPistaCaderno(&iterador, &espera->pistas[i]);
+        memcpy(espera->pistas + numPistas, sessao->placar.ranking, numSuspeitos * sizeof(uint32_t));
+        espera->numPistas = numPistas;
+    }
+}
+
+/**
+ * @brief Ajusta o que o epoll vigia na conexão: a escrita enquanto há
+ *        resposta pendente, senão a leitura (nunca as duas)
+ * @param anfitriao Anfitrião de partidas
+ * @param espera Conexão
+ * @return 1 em caso de sucesso, 0 em erro
+ */
+int vigiarConexao(Anfitriao* anfitriao, PartidaEmEspera* espera) {
+    struct epoll_event evento;
+    memset(&evento, 0, sizeof(evento));
+    evento.events = espera->saida != NULL ? EPOLLOUT : EPOLLIN;
+    evento.data.fd = espera->fd;
+    return epoll_ctl(anfitriao->epoll, EPOLL_CTL_MOD, espera->fd, &evento) == 0;
+}
+
+/**
+ * @brief Envia o que a partida escreveu na tela, sem nunca bloquear
+ *
+ * O que o socket não aceitar agora fica na conexão, e ela deixa de ser
+ * lida até a resposta sair inteira: um cliente lento não segura o laço nem
+ * acumula mais de uma resposta.
+ *
+ * @param anfitriao Anfitrião de partidas (a tela é esvaziada)
+ * @param espera Conexão de destino, sem resposta pendente
+ * @return 1 em caso de sucesso, 0 se a conexão deve ser fechada
+ */
+int enviarResposta(Anfitriao* anfitriao, PartidaEmEspera* espera) {
+    Tela* tela = &anfitriao->tela;
+    size_t enviados = 0;
+    while (enviados < tela->tamanho) {
+        ssize_t escritos = send(espera->fd, tela->dados + enviados, tela->tamanho - enviados,
+                                MSG_NOSIGNAL);
+        if (escritos < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            tela->tamanho = 0;
+            return 0;
+        }
+        enviados += (size_t)escritos;
+    }
+
+    size_t resto = tela->tamanho - enviados;
+    tela->tamanho = 0;
+    if (resto == 0) return 1;
+    espera->saida = (char*)malloc(resto);
+    if (espera->saida == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    memcpy(espera->saida, tela->dados + enviados, resto);
+    espera->tamanhoSaida = (uint32_t)resto;
+    return vigiarConexao(anfitriao, espera);
+}
+
+/**
+ * @brief Continua o envio de uma resposta pendente quando o socket aceita
+ * @param anfitriao Anfitrião de partidas
+ * @param espera Conexão com resposta pendente
+ * @return 1 em caso de sucesso, 0 se a conexão deve ser fechada
+ */
+int continuarEnvio(Anfitriao* anfitriao, PartidaEmEspera* espera) {
+    size_t enviados = 0;
+    while (enviados < espera->tamanhoSaida) {
+        ssize_t escritos = send(espera->fd, espera->saida + enviados, espera->tamanhoSaida - enviados,
+                                MSG_NOSIGNAL);
+        if (escritos < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return 0;
+        }
+        enviados += (size_t)escritos;
+    }
+
+    espera->tamanhoSaida -= (uint32_t)enviados;
+    if (espera->tamanhoSaida > 0) {
+        memmove(espera->saida, espera->saida + enviados, espera->tamanhoSaida);
+        return 1;
+    }
+    free(espera->saida);
+    espera->saida = NULL;
+    return espera->fechar || vigiarConexao(anfitriao, espera);
+}
+
+/**
+ * @brief Lê o que chegou numa conexão e avança a partida linha a linha
+ *
+ * Cada linha completa vai para avancarPartida; o começo de uma linha que
+ * ainda não terminou fica na conexão. Quando o cliente fecha a escrita, a
+ * partida vai até o veredicto como no terminal (a última linha vale mesmo
+ * sem '\n'). Uma partida encerrada, ou uma linha maior que
+ * TAMANHO_LINHA_ANFITRIAO, fecha a conexão depois da resposta.
+ *
+ * @param anfitriao Anfitrião de partidas
+ * @param espera Conexão com dados (ou fim de entrada) a receber
+ * @return 1 em caso de sucesso, 0 se a conexão deve ser fechada
+ */
+int atenderPartida(Anfitriao* anfitriao, PartidaEmEspera* espera) {
+    Partida* partida = &anfitriao->partida;
+    Tela* tela = &anfitriao->tela;
+    char* leitura = anfitriao->leitura;
+    size_t usados = espera->tamanhoLinha;
+    if (usados > 0) memcpy(leitura, espera->linha, usados);
+
+    ssize_t lidos;
+    do {
+        lidos = recv(espera->fd, leitura + usados, TAMANHO_LINHA_ANFITRIAO, 0);
+    } while (lidos < 0 && errno == EINTR);
+    if (lidos < 0) return errno == EAGAIN || errno == EWOULDBLOCK;
+    usados += (size_t)lidos;
+
+    retomarPartida(anfitriao, espera);
+    size_t consumidos = 0;
+    char* fim;
+    while (!partidaConcluida(partida) &&
+           (fim = memchr(leitura + consumidos, '\n', usados - consumidos)) != NULL) {
+        *fim = '\0';
+        if (fim > leitura + consumidos && fim[-1] == '\r') fim[-1] = '\0';
+        avancarPartida(partida, tela, leitura + consumidos);
+        consumidos = (size_t)(fim - leitura) + 1;
+        anfitriao->linhas++;
+    }
+
+    size_t resto = usados - consumidos;
+    if (lidos == 0) {
+        if (resto > 0 && !partidaConcluida(partida)) {
+            leitura[usados] = '\0';
+            avancarPartida(partida, tela, leitura + consumidos);
+            anfitriao->linhas++;
+        }
+        while (!partidaConcluida(partida)) avancarPartida(partida, tela, NULL);
+    } else if (resto >= TAMANHO_LINHA_ANFITRIAO && !partidaConcluida(partida)) {
+        if (tela->modo == SAIDA_NORMAL) {
+            escreverTela(tela, "\n❌ Linha com mais de %d bytes; conexão encerrada.\n",
+                         TAMANHO_LINHA_ANFITRIAO);
+        } else if (tela->modo == SAIDA_JSON) {
+            escreverTela(tela, "{\"erro\":\"linha longa demais\"}\n");
+        }
+        espera->fechar = 1;
+    }
+    if (partidaConcluida(partida)) espera->fechar = 1;
+
+    // Guarda o começo da próxima linha
+    if (espera->fechar) resto = 0;
+    if (resto == 0) {
+        free(espera->linha);
+        espera->linha = NULL;
+    } else {
+        espera->linha = (char*)realloc(espera->linha, resto);
+        if (espera->linha == NULL) {
+            printf("Erro de alocação de memória!\n");
+            exit(1);
+        }
+        memcpy(espera->linha, leitura + consumidos, resto);
+    }
+    espera->tamanhoLinha = (uint32_t)resto;
+
+    return enviarResposta(anfitriao, espera);
+}
+
+/**
+ * @brief Aceita as conexões pendentes e começa uma partida para cada uma
+ *
+ * Cada conexão recebe a abertura do jogo (no modo normal) e a primeira
+ * sala. Sem descritores livres, a escuta sai do epoll até alguma conexão
+ * fechar, em vez de acordar o laço à toa.
+ *
+ * @param anfitriao Anfitrião de partidas
+ */
+void receberConexoes(Anfitriao* anfitriao) {
+    Tela* tela = &anfitriao->tela;
+    for (int i = 0; i < EVENTOS_POR_ESPERA_ANFITRIAO; i++) {
+        int fd = accept(anfitriao->escuta, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EMFILE || errno == ENFILE) {
+                struct epoll_event evento;
+                memset(&evento, 0, sizeof(evento));
+                evento.data.fd = anfitriao->escuta;
+                epoll_ctl(anfitriao->epoll, EPOLL_CTL_MOD, anfitriao->escuta, &evento);
+                anfitriao->aceitando = 0;
+            }
+            return;
+        }
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+
+        if ((size_t)fd >= anfitriao->capacidadeDescritores) {
+            size_t capacidade = anfitriao->capacidadeDescritores ? anfitriao->capacidadeDescritores : 1024;
+            while (capacidade <= (size_t)fd) capacidade *= 2;
+            anfitriao->porDescritor = (PartidaEmEspera**)realloc(anfitriao->porDescritor,
+                                                                 capacidade * sizeof(PartidaEmEspera*));
+            if (anfitriao->porDescritor == NULL) {
+                printf("Erro de alocação de memória!\n");
+                exit(1);
+            }
+            memset(anfitriao->porDescritor + anfitriao->capacidadeDescritores, 0,
+                   (capacidade - anfitriao->capacidadeDescritores) * sizeof(PartidaEmEspera*));
+            anfitriao->capacidadeDescritores = capacidade;
+        }
+
+        PartidaEmEspera* espera = (PartidaEmEspera*)calloc(1, sizeof(PartidaEmEspera));
+        if (espera == NULL) {
+            printf("Erro de alocação de memória!\n");
+            exit(1);
+        }
+        espera->fd = fd;
+        espera->etapa = ETAPA_COMANDOS;
+        espera->estado = SESSAO_EXPLORANDO;
+        anfitriao->porDescritor[fd] = espera;
+        anfitriao->abertas++;
+        if (anfitriao->abertas > anfitriao->picoAbertas) anfitriao->picoAbertas = anfitriao->abertas;
+        anfitriao->partidas++;
+
+        struct epoll_event evento;
+        memset(&evento, 0, sizeof(evento));
+        evento.events = EPOLLIN;
+        evento.data.fd = fd;
+        if (epoll_ctl(anfitriao->epoll, EPOLL_CTL_ADD, fd, &evento) < 0) {
+            fecharPartidaEmEspera(anfitriao, espera);
+            continue;
+        }
+
+        // Abertura do jogo e primeira sala
+        retomarPartida(anfitriao, espera);
+        if (tela->modo == SAIDA_NORMAL) {
+            exibirTitulo(tela);
+            exibirInstrucoes(tela);
+            escreverTela(tela, "\n🚪 ADENTRANDO A MANSÃO BLACKWOOD...\n");
+            if (anfitriao->caso->introducao != NULL) {
+                escreverTela(tela, "%s\n", anfitriao->caso->introducao);
+            }
+        }
+        comecarPartida(&anfitriao->partida, tela);
+        if (!enviarResposta(anfitriao, espera)) fecharPartidaEmEspera(anfitriao, espera);
+    }
+}
+
+/**
+ * @brief Fecha o socket e libera a partida estacionada de uma conexão
+ * @param anfitriao Anfitrião de partidas
+ * @param espera Conexão a encerrar
+ */
+void fecharPartidaEmEspera(Anfitriao* anfitriao, PartidaEmEspera* espera) {
+    close(espera->fd);
+    anfitriao->porDescritor[espera->fd] = NULL;
+    if (anfitriao->ativa == espera) anfitriao->ativa = NULL;
+    free(espera->pistas);
+    free(espera->consulta);
+    free(espera->linha);
+    free(espera->saida);
+    free(espera);
+    anfitriao->abertas--;
+
+    // Um descritor voltou a ficar livre: a escuta volta ao epoll
+    if (!anfitriao->aceitando) {
+        struct epoll_event evento;
+        memset(&evento, 0, sizeof(evento));
+        evento.events = EPOLLIN;
+        evento.data.fd = anfitriao->escuta;
+        epoll_ctl(anfitriao->epoll, EPOLL_CTL_MOD, anfitriao->escuta, &evento);
+        anfitriao->aceitando = 1;
+    }
+}
+
+/**
+ * @brief Anfitrião de partidas em um socket Unix: o jogo interativo para
+ *        muitas conexões numa só thread, com epoll
+ *
+ * Cada conexão joga a partida do terminal (as mesmas telas, ou uma linha
+ * JSON por turno). A partida nunca bloqueia à espera do jogador: entre duas
+ * linhas ela fica estacionada na conexão (veja PartidaEmEspera), e a sessão
+ * de trabalho serve a conexão que tiver dados. Os sockets não bloqueiam, e
+ * uma resposta que o cliente não lê para a leitura só daquela conexão.
+ * Encerra com SIGINT ou SIGTERM.
+ *
+ * @param caso Caso compartilhado
+ * @param caminho Caminho do socket Unix (recriado se já existir)
+ * @param modo Normal ou JSON
+ * @return 1 em caso de encerramento normal, 0 em erro de configuração
+ */
+int executarAnfitriao(const Caso* caso, const char* caminho, ModoSaida modo) {
+    struct sockaddr_un endereco;
+    memset(&endereco, 0, sizeof(endereco));
+    endereco.sun_family = AF_UNIX;
+    if (strlen(caminho) >= sizeof(endereco.sun_path)) {
+        fprintf(stderr, "❌ Caminho de socket longo demais: %s\n", caminho);
+        return 0;
+    }
+    strcpy(endereco.sun_path, caminho);
+
+    int escuta = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(caminho);
+    if (escuta < 0 || bind(escuta, (struct sockaddr*)&endereco, sizeof(endereco)) < 0 ||
+        listen(escuta, SOMAXCONN) < 0) {
+        fprintf(stderr, "❌ Não foi possível escutar em '%s'\n", caminho);
+        if (escuta >= 0) close(escuta);
+        return 0;
+    }
+    fcntl(escuta, F_SETFL, O_NONBLOCK);
+
+    Anfitriao anfitriao;
+    memset(&anfitriao, 0, sizeof(anfitriao));
+    anfitriao.caso = caso;
+    anfitriao.escuta = escuta;
+    anfitriao.aceitando = 1;
+    anfitriao.epoll = epoll_create1(0);
+    struct epoll_event evento;
+    memset(&evento, 0, sizeof(evento));
+    evento.events = EPOLLIN;
+    evento.data.fd = escuta;
+    if (anfitriao.epoll < 0 || epoll_ctl(anfitriao.epoll, EPOLL_CTL_ADD, escuta, &evento) < 0) {
+        fprintf(stderr, "❌ Não foi possível criar o epoll\n");
+        if (anfitriao.epoll >= 0) close(anfitriao.epoll);
+        close(escuta);
+        unlink(caminho);
+        return 0;
+    }
+
+    // Cada conexão ocupa um descritor: o limite flexível sobe até o rígido
+    struct rlimit limite;
+    getrlimit(RLIMIT_NOFILE, &limite);
+    if (limite.rlim_cur < limite.rlim_max) {
+        limite.rlim_cur = limite.rlim_max;
+        if (setrlimit(RLIMIT_NOFILE, &limite) < 0) getrlimit(RLIMIT_NOFILE, &limite);
+    }
+
+    iniciarSessao(&anfitriao.sessao, caso);
+    inicializarTela(&anfitriao.tela, modo);
+    inicializarPartida(&anfitriao.partida, &anfitriao.sessao, NULL, modo == SAIDA_NORMAL);
+    anfitriao.leitura = (char*)malloc(2 * TAMANHO_LINHA_ANFITRIAO + 1);
+    if (anfitriao.leitura == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+
+    struct sigaction acao;
+    memset(&acao, 0, sizeof(acao));
+    acao.sa_handler = pedirEncerramento;
+    sigaction(SIGINT, &acao, NULL);
+    sigaction(SIGTERM, &acao, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    printf("🏠 Anfitrião de partidas em '%s': uma thread, até %llu descritores (Ctrl+C encerra)\n",
+           caminho, (unsigned long long)limite.rlim_cur);
+    fflush(stdout);
+
+    struct epoll_event eventos[EVENTOS_POR_ESPERA_ANFITRIAO];
+    while (!servidorEncerrando) {
+        int prontos = epoll_wait(anfitriao.epoll, eventos, EVENTOS_POR_ESPERA_ANFITRIAO, -1);
+        if (prontos < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        for (int i = 0; i < prontos; i++) {
+            int fd = eventos[i].data.fd;
+            if (fd == escuta) {
+                receberConexoes(&anfitriao);
+                continue;
+            }
+
+            // O estado da conexão decide o que fazer: um evento antigo de um
+            // descritor fechado e reaproveitado neste lote só dá EAGAIN
+            PartidaEmEspera* espera = anfitriao.porDescritor[fd];
+            if (espera == NULL) continue;
+            int continua = espera->saida != NULL ? continuarEnvio(&anfitriao, espera)
+                                                 : atenderPartida(&anfitriao, espera);
+            if (!continua || (espera->fechar && espera->saida == NULL)) {
+                fecharPartidaEmEspera(&anfitriao, espera);
+            }
+        }
+    }
+
+    size_t abertas = anfitriao.abertas;
+    for (size_t fd = 0; fd < anfitriao.capacidadeDescritores; fd++) {
+        if (anfitriao.porDescritor[fd] != NULL) fecharPartidaEmEspera(&anfitriao, anfitriao.porDescritor[fd]);
+    }
+    printf("\n🏠 Anfitrião encerrado: %llu partidas (%zu ainda abertas, pico de %zu), %llu linhas, "
+           "%llu sessões remontadas\n",
+           anfitriao.partidas, abertas, anfitriao.picoAbertas, anfitriao.linhas, anfitriao.retomadas);
+
+    liberarPartida(&anfitriao.partida);
+    liberarSessao(&anfitriao.sessao);
+    liberarTela(&anfitriao.tela);
+    free(anfitriao.leitura);
+    free(anfitriao.porDescritor);
+    close(anfitriao.epoll);
+    close(escuta);
+    unlink(caminho);
+    return 1;
+}
+#endif
+
+// ========== FUNÇÕES DE ESTATÍSTICAS DE EXECUÇÃO ==========
+
+/**
+ * @brief Soma um valor a um histograma em potências de 2
+ * @param histograma Histograma de destino
+ * @param valor Valor medido
+ */
+void registrarEmHistograma(HistogramaEstatistica* histograma, uint64_t valor) {
+    uint32_t balde = valor <= 1 ? 0 : 64 - (uint32_t)__builtin_clzll(valor - 1);
+    if (balde >= BALDES_HISTOGRAMA) balde = BALDES_HISTOGRAMA - 1;
+    atomic_fetch_add_explicit(&histograma->baldes[balde], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histograma->soma, valor, memory_order_relaxed);
+}
+
+/**
+ * @brief Registra as alocações de uma sessão prestes a ser descartada
+ * @param memoria Memória da sessão (uma sessão que nada alocou é ignorada)
+ */
+void registrarMemoriaDaSessao(const MemoriaSessao* memoria) {
+    if (memoria->arena.alocacoes == 0) return;
+    registrarEmHistograma(&estatisticas.alocacoesSessao, memoria->arena.alocacoes);
+    registrarEmHistograma(&estatisticas.bytesSessao, memoria->arena.bytesAlocados);
+}
+
+/**
+ * @brief Mede a descida de uma inserção no caderno: nós visitados até a
+ *        folha (ou até a pista repetida) e comparações da busca binária
+ * @param caderno Caderno antes da inserção
+ * @param pista ID da pista a ser inserida
+ */
+void medirInsercaoCaderno(const CadernoPistas* caderno, uint32_t pista) {
+    uint64_t niveis = 0, comparacoes = 0;
+    const NoCaderno* no = caderno->raiz;
+
+    while (no != NULL) {
+        int inicio = 0, fim = no->quantidade;
+        niveis++;
+        while (inicio < fim) {
+            int meio = (inicio + fim) / 2;
+            comparacoes++;
+            if (no->pistas[meio] < pista) inicio = meio + 1;
+            else fim = meio;
+        }
+        if (no->folha || (inicio < no->quantidade && no->pistas[inicio] == pista)) break;
+        no = no->filhos[inicio];
+    }
+    registrarEmHistograma(&estatisticas.profundidadeCaderno, niveis);
+    registrarEmHistograma(&estatisticas.comparacoesCaderno, comparacoes);
+}
+
+/**
+ * @brief Escreve um histograma em JSON (baldes não cumulativos, só até o
+ *        último não vazio) ou no formato de texto do Prometheus
+ * @param tela Buffer de saída
+ * @param prometheus 1: texto do Prometheus; 0: campo de um objeto JSON
+ * @param nome Nome da métrica, sem prefixo
+ * @param ajuda Descrição da métrica (só no Prometheus)
+ * @param histograma Histograma lido
+ */
+void escreverHistograma(Tela* tela, int prometheus, const char* nome, const char* ajuda,
+                        const HistogramaEstatistica* histograma) {
+    uint64_t baldes[BALDES_HISTOGRAMA];
+    uint64_t total = 0;
+    int ultimo = -1;
+    for (int i = 0; i < BALDES_HISTOGRAMA; i++) {
+        baldes[i] = atomic_load_explicit(&histograma->baldes[i], memory_order_relaxed);
+        total += baldes[i];
+        if (baldes[i] != 0) ultimo = i;
+    }
+    unsigned long long soma = atomic_load_explicit(&histograma->soma, memory_order_relaxed);
+
+    if (prometheus) {
+        escreverTela(tela, "# HELP detetive_%s %s\n# TYPE detetive_%s histogram\n",
+                     nome, ajuda, nome);
+        uint64_t acumulado = 0;
+        for (int i = 0; i <= ultimo && i < BALDES_HISTOGRAMA - 1; i++) {
+            acumulado += baldes[i];
+            escreverTela(tela, "detetive_%s_bucket{le=\"%llu\"} %llu\n", nome, 1ull << i,
+                         (unsigned long long)acumulado);
+        }
+        escreverTela(tela, "detetive_%s_bucket{le=\"+Inf\"} %llu\n"
+                     "detetive_%s_sum %llu\ndetetive_%s_count %llu\n",
+                     nome, (unsigned long long)total, nome, soma, nome, (unsigned long long)total);
+        return;
+    }
+
+    escreverTela(tela, ",\"%s\":{\"contagem\":%llu,\"soma\":%llu,\"baldes\":{", nome,
+                 (unsigned long long)total, soma);
+    for (int i = 0; i <= ultimo; i++) {
+        if (i < BALDES_HISTOGRAMA - 1) {
+            escreverTela(tela, "%s\"%llu\":%llu", i > 0 ? "," : "", 1ull << i,
+                         (unsigned long long)baldes[i]);
+        } else {
+            escreverTela(tela, "%s\"+Inf\":%llu", i > 0 ? "," : "", (unsigned long long)baldes[i]);
+        }
+    }
+    escreverTela(tela, "}}");
+}
+
+/**
+ * @brief Monta uma foto de todas as estatísticas
+ * @param tela Buffer de saída (o conteúdo anterior é descartado)
+ * @param prometheus 1: texto do Prometheus; 0: uma linha JSON
+ * @param segundos Tempo desde que as estatísticas foram ligadas
+ */
+void montarEstatisticas(Tela* tela, int prometheus, double segundos) {
+    static const struct {
+        const char *nome;
+        const char *ajuda;
+        const HistogramaEstatistica *histograma;
+    } histogramas[] = {
+        {"sondagens_hash", "Posições visitadas por busca de texto nas tabelas hash",
+         &estatisticas.sondagensHash},
+        {"profundidade_caderno", "Nós da árvore B do caderno visitados por inserção",
+         &estatisticas.profundidadeCaderno},
+        {"comparacoes_caderno", "Comparações de IDs por inserção no caderno",
+         &estatisticas.comparacoesCaderno},
+        {"alocacoes_sessao", "Alocações na arena por sessão",
+         &estatisticas.alocacoesSessao},
+        {"bytes_sessao", "Bytes alocados na arena por sessão",
+         &estatisticas.bytesSessao},
+        {"latencia_comando_ns", "Nanossegundos para aplicar e narrar um comando",
+         &estatisticas.latenciaComando},
+    };
+
+    tela->tamanho = 0;
+    if (prometheus) {
+        escreverTela(tela, "# HELP detetive_segundos_ligado Segundos desde o início da coleta\n"
+                     "# TYPE detetive_segundos_ligado gauge\ndetetive_segundos_ligado %.3f\n",
+                     segundos);
+    } else {
+        escreverTela(tela, "{\"segundos\":%.3f", segundos);
+    }
+    for (size_t i = 0; i < sizeof(histogramas) / sizeof(histogramas[0]); i++) {
+        escreverHistograma(tela, prometheus, histogramas[i].nome, histogramas[i].ajuda,
+                           histogramas[i].histograma);
+    }
+
+    if (prometheus) {
+        escreverTela(tela, "# HELP detetive_veredictos_total Sessões encerradas por veredicto\n"
+                     "# TYPE detetive_veredictos_total counter\n");
+    } else {
+        escreverTela(tela, ",\"veredictos\":{");
+    }
+    for (int v = VEREDICTO_ARQUIVADO; v <= VEREDICTO_SUSTENTADA; v++) {
+        unsigned long long contagem =
+            atomic_load_explicit(&estatisticas.veredictos[v], memory_order_relaxed);
+        if (prometheus) {
+            escreverTela(tela, "detetive_veredictos_total{veredicto=\"%s\"} %llu\n",
+                         nomeVeredicto((Veredicto)v), contagem);
+        } else {
+            escreverTela(tela, "%s\"%s\":%llu", v > VEREDICTO_ARQUIVADO ? "," : "",
+                         nomeVeredicto((Veredicto)v), contagem);
+        }
+    }
+    if (!prometheus) escreverTela(tela, "}}\n");
+}
+
+#ifndef _WIN32
+static ExportadorEstatisticas exportador = {.escuta = -1, .aviso = {-1, -1}};
+
+/**
+ * @brief Grava a foto montada em um arquivo temporário e o renomeia sobre o
+ *        destino, para que um leitor nunca veja um arquivo pela metade
+ * @param caminho Arquivo de destino
+ * @param tela Foto já montada
+ * @return 1 em caso de sucesso, 0 em erro
+ */
+int gravarEstatisticas(const char* caminho, Tela* tela) {
+    char temporario[4096];
+    if (snprintf(temporario, sizeof(temporario), "%s.tmp", caminho) >= (int)sizeof(temporario)) {
+        return 0;
+    }
+    int fd = open(temporario, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return 0;
+    int sucesso = escreverTudo(fd, tela->dados, tela->tamanho);
+    if (close(fd) < 0) sucesso = 0;
+    if (sucesso && rename(temporario, caminho) < 0) sucesso = 0;
+    if (!sucesso) unlink(temporario);
+    return sucesso;
+}
+
+/**
+ * @brief Thread do exportador: regrava o arquivo a cada intervalo ou
+ *        responde cada conexão do socket com uma foto, até ser avisada
+ * @param argumento ExportadorEstatisticas*
+ * @return NULL
+ */
+void* executarExportador(void* argumento) {
+    ExportadorEstatisticas* exportador = (ExportadorEstatisticas*)argumento;
+    Tela tela;
+    inicializarTela(&tela, SAIDA_NORMAL);
+    struct pollfd esperas[2] = {
+        {.fd = exportador->aviso[0], .events = POLLIN},
+        {.fd = exportador->escuta, .events = POLLIN},
+    };
+    int porSocket = exportador->escuta >= 0;
+
+    for (;;) {
+        int prontos = poll(esperas, porSocket ? 2 : 1,
+                           porSocket ? -1 : INTERVALO_ESTATISTICAS * 1000);
+        if (prontos < 0 && errno == EINTR) continue;
+        if (prontos < 0 || esperas[0].revents != 0) break;
+
+        montarEstatisticas(&tela, exportador->prometheus, agoraEmSegundos() - exportador->inicio);
+        if (!porSocket) {
+            gravarEstatisticas(exportador->destino, &tela);
+        } else if (esperas[1].revents & POLLIN) {
+            int cliente = accept(exportador->escuta, NULL, NULL);
+            if (cliente >= 0) {
+                escreverTudo(cliente, tela.dados, tela.tamanho);
+                close(cliente);
+            }
+        }
+    }
+    liberarTela(&tela);
+    return NULL;
+}
+
+/**
+ * @brief Liga as estatísticas e a thread que as exporta
+ *
+ * "unix:<caminho>" abre um socket Unix que responde cada conexão com uma
+ * foto; qualquer outro destino é um arquivo regravado a cada
+ * INTERVALO_ESTATISTICAS segundos e ao sair. Destinos terminados em ".json"
+ * recebem uma linha JSON; os demais, o formato de texto do Prometheus.
+ *
+ * @param destino Arquivo ou "unix:<caminho do socket>"
+ * @return 1 em caso de sucesso, 0 em erro (já avisado)
+ */
+int ligarEstatisticas(const char* destino) {
+    size_t comprimento = strlen(destino);
+    exportador.prometheus = !(comprimento >= 5 && strcmp(destino + comprimento - 5, ".json") == 0);
+    exportador.destino = destino;
+    exportador.escuta = -1;
+
+    if (strncmp(destino, "unix:", 5) == 0) {
+        exportador.destino = destino + 5;
+        struct sockaddr_un endereco;
+        memset(&endereco, 0, sizeof(endereco));
+        endereco.sun_family = AF_UNIX;
+        if (strlen(exportador.destino) >= sizeof(endereco.sun_path)) {
+            fprintf(stderr, "❌ Caminho de socket longo demais: %s\n", exportador.destino);
+            return 0;
+        }
+        strcpy(endereco.sun_path, exportador.destino);
+        exportador.escuta = socket(AF_UNIX, SOCK_STREAM, 0);
+        unlink(exportador.destino);
+        if (exportador.escuta < 0 ||
+            bind(exportador.escuta, (struct sockaddr*)&endereco, sizeof(endereco)) < 0 ||
+            listen(exportador.escuta, 16) < 0) {
+            fprintf(stderr, "❌ Não foi possível escutar em '%s'\n", exportador.destino);
+            if (exportador.escuta >= 0) close(exportador.escuta);
+            return 0;
+        }
+    } else {
+        // Confere já o destino: um erro aparece agora, não no fim da execução
+        Tela tela;
+        inicializarTela(&tela, SAIDA_NORMAL);
+        montarEstatisticas(&tela, exportador.prometheus, 0.0);
+        int sucesso = gravarEstatisticas(destino, &tela);
+        liberarTela(&tela);
+        if (!sucesso) {
+            fprintf(stderr, "❌ Não foi possível gravar as estatísticas em '%s'\n", destino);
+            return 0;
+        }
+    }
+
+    if (pipe(exportador.aviso) < 0) {
+        fprintf(stderr, "❌ Não foi possível criar o pipe de aviso\n");
+        if (exportador.escuta >= 0) close(exportador.escuta);
+        return 0;
+    }
+    exportador.inicio = agoraEmSegundos();
+    estatisticas.ligadas = 1;
+
+    // A thread nasce com os sinais bloqueados: SIGINT continua com a thread
+    // principal e um cliente que fecha o socket não gera SIGPIPE
+    sigset_t sinais, anteriores;
+    sigfillset(&sinais);
+    pthread_sigmask(SIG_BLOCK, &sinais, &anteriores);
+    int erro = pthread_create(&exportador.thread, NULL, executarExportador, &exportador);
+    pthread_sigmask(SIG_SETMASK, &anteriores, NULL);
+    if (erro != 0) {
+        fprintf(stderr, "❌ Não foi possível criar a thread das estatísticas\n");
+        return 0;
+    }
+    atexit(desligarEstatisticas);
+    return 1;
+}
+
+/**
+ * @brief Encerra a thread do exportador e grava a foto final (registrada
+ *        com atexit, vale para qualquer saída do programa)
+ */
+void desligarEstatisticas(void) {
+    char byte = 1;
+    while (write(exportador.aviso[1], &byte, 1) < 0 && errno == EINTR) {
+    }
+    pthread_join(exportador.thread, NULL);
+    close(exportador.aviso[0]);
+    close(exportador.aviso[1]);
+
+    if (exportador.escuta >= 0) {
+        close(exportador.escuta);
+        unlink(exportador.destino);
+    } else {
+        Tela tela;
+        inicializarTela(&tela, SAIDA_NORMAL);
+        montarEstatisticas(&tela, exportador.prometheus, agoraEmSegundos() - exportador.inicio);
+        gravarEstatisticas(exportador.destino, &tela);
+        liberarTela(&tela);
+    }
+}
+#endif
+
+// ========== FUNÇÕES DE BENCHMARK ==========
+
+/**
+ * @brief Gerador pseudoaleatório xorshift64* (reprodutível em qualquer plataforma)
+ * @param estado Estado do gerador (nunca zero)
+ * @return Próximo número de 64 bits
+ */
+uint64_t proximoAleatorio(uint64_t* estado) {
+    uint64_t x = *estado;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *estado = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * @brief Gera um caso sintético: mansão completa, uma pista por sala
+ *
+ * A sala i tem filhos 2i+1 e 2i+2, que já é a ordem de largura da mansão
+ * compacta, montada diretamente. Cerca de 80% das pistas apontam para um
+ * dos SUSPEITOS_SINTETICOS; os textos começam com um prefixo aleatório, para
+ * que a ordem alfabética não coincida com a ordem das salas. Os textos das
+ * pistas e dos suspeitos ficam em um único bloco, liberado por liberarCaso.
+ *
+ * Com corredores, cada cômodo tem passagens nos dois sentidos para os
+ * vizinhos da mesma profundidade, e o primeiro de cada nível, mais cerca de
+ * 1 em ESCADAS_SINTETICAS dos demais, uma escada só de ida para o pai: a
+ * mansão vira um grafo em que todo cômodo alcança todos os outros. As
+ * escadas são sorteadas por uma mistura do índice, sem tocar no gerador
+ * das pistas, então o resto do caso não muda.
+ *
+ * @param caso Caso a ser preenchido
+ * @param numSalas Quantidade de salas (e de pistas)
+ * @param semente Semente do gerador
+ * @param corredores 1 para acrescentar corredores e escadas
+ */
+void gerarCasoSintetico(Caso* caso, uint32_t numSalas, uint64_t semente, int corredores) {
+    memset(caso, 0, sizeof(Caso));
+    uint64_t estado = semente ? semente : 1;
+
+    // Pista (≤ 40 bytes) de cada sala e suspeitos; nomes (≤ 16 bytes) na mansão
+    size_t tamanhoDados = (size_t)numSalas * 40 + SUSPEITOS_SINTETICOS * 16;
+    caso->dados = (char*)malloc(tamanhoDados);
+    if (caso->dados == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    caso->tamanhoDados = tamanhoDados;
+    char* cursor = caso->dados;
+
+    // Passagens de cada cômodo, em ordem crescente: escada, esquerda e
+    // direita. A primeira etapa só conta, para reservar a mansão de uma vez
+    uint32_t numPassagens = 0;
+    for (int etapa = 0; etapa < 2; etapa++) {
+        for (uint32_t i = 0; corredores && i < numSalas; i++) {
+            int primeiroDoNivel = ((i + 1) & i) == 0;
+            int escada = i > 0 && (primeiroDoNivel ||
+                                   ((((uint64_t)i * 0x9E3779B97F4A7C15ull) ^ semente) >> 32) %
+                                           ESCADAS_SINTETICAS == 0);
+            uint32_t destinos[3], quantidade = 0;
+            if (escada) destinos[quantidade++] = (i - 1) / 2;
+            if (!primeiroDoNivel) destinos[quantidade++] = i - 1;
+            if (i + 1 < numSalas && ((i + 2) & (i + 1)) != 0) destinos[quantidade++] = i + 1;
+            if (etapa == 1 && caso->mansao.numPassagens > 0) {
+                caso->mansao.inicioPassagens[i] = numPassagens;
+                memcpy(caso->mansao.passagens + numPassagens, destinos, quantidade * sizeof(uint32_t));
+            }
+            numPassagens += quantidade;
+        }
+        if (etapa == 0) {
+            reservarMansao(&caso->mansao, numSalas, numPassagens, (size_t)numSalas * 16);
+            numPassagens = 0;
+        } else if (caso->mansao.numPassagens > 0) {
+            caso->mansao.inicioPassagens[numSalas] = numPassagens;
+        }
+    }
+    char* nomes = (char*)caso->mansao.textos;
+    size_t usados = 0;
+
+    reservarInternador(&caso->pistas, numSalas);
+    reservarInternador(&caso->suspeitos, SUSPEITOS_SINTETICOS);
+    const char* suspeitos[SUSPEITOS_SINTETICOS];
+    for (int i = 0; i < SUSPEITOS_SINTETICOS; i++) {
+        suspeitos[i] = cursor;
+        cursor += sprintf(cursor, "suspeito%d", i) + 1;
+        declararSuspeito(caso, suspeitos[i], suspeitos[i]);
+    }
+
+    for (uint32_t i = 0; i < numSalas; i++) {
+        NoMansao* sala = &caso->mansao.nos[i];
+        caso->mansao.nomes[i] = (uint32_t)usados;
+        usados += (size_t)sprintf(nomes + usados, "Sala %u", i) + 1;
+
+        const char* pista = cursor;
+        cursor += sprintf(cursor, "pista %08x no comodo %u",
+                          (unsigned)(proximoAleatorio(&estado) >> 32), i) + 1;
+        uint64_t sorteio = proximoAleatorio(&estado);
+        if (sorteio % 10 < 8) {
+            associarPista(caso, pista, suspeitos[(sorteio >> 8) % SUSPEITOS_SINTETICOS]);
+        }
+        sala->pista = internarPista(caso, pista);
+
+        uint64_t esquerda = 2 * (uint64_t)i + 1, direita = 2 * (uint64_t)i + 2;
+        sala->esquerda = esquerda < numSalas ? (uint32_t)esquerda : SEM_INDICE;
+        sala->direita = direita < numSalas ? (uint32_t)direita : SEM_INDICE;
+    }
+
+    ordenarPistasDoCaso(caso);
+    concluirEvidencias(caso);
+}
+
+/**
+ * @brief Grava um caso no formato texto (usado por --gerar)
+ * @param caso Caso a gravar
+ * @param caminho Arquivo de destino
+ * @return 1 em caso de sucesso, 0 em erro
+ */
+int salvarCasoTexto(const Caso* caso, const char* caminho) {
+    FILE* arquivo = fopen(caminho, "w");
+    if (arquivo == NULL) {
+        fprintf(stderr, "❌ Não foi possível gravar o caso em '%s'\n", caminho);
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < caso->suspeitos.quantidade; i++) {
+        fprintf(arquivo, "suspeito|%s|%s\n", caso->suspeitos.textos[i],
+                caso->descricoesSuspeitos[i]);
+    }
+    for (uint32_t i = 0; i < caso->mansao.numSalas; i++) {
+        const NoMansao* sala = &caso->mansao.nos[i];
+        fprintf(arquivo, "sala|%u|%s|%s|", i, nomeSala(&caso->mansao, i),
+                sala->pista != SEM_INDICE ? caso->pistas.textos[sala->pista] : "");
+        if (sala->esquerda != SEM_INDICE) fprintf(arquivo, "%u|", sala->esquerda);
+        else fprintf(arquivo, "-|");
+        if (sala->direita != SEM_INDICE) fprintf(arquivo, "%u\n", sala->direita);
+        else fprintf(arquivo, "-\n");
+    }
+    // Passagens: um par de sentidos vira uma linha só, na origem menor
+    for (uint32_t i = 0; i < caso->mansao.numSalas; i++) {
+        const uint32_t* destinos;
+        uint32_t numDestinos = passagensDaSala(&caso->mansao, i, &destinos);
+        for (uint32_t k = 0; k < numDestinos; k++) {
+            int volta = temPassagem(&caso->mansao, destinos[k], i);
+            if (volta && destinos[k] < i) continue;
+            fprintf(arquivo, "passagem|%u|%u%s\n", i, destinos[k], volta ? "" : "|ida");
+        }
+    }
+    for (uint32_t i = 0; i < caso->pistas.quantidade; i++) {
+        uint32_t principal = caso->suspeitoDaPista[i];
+        if (principal == SEM_INDICE) continue;
+        fprintf(arquivo, "pista|%s|", caso->pistas.textos[i]);
+        
+        // Evidências detalhadas: o principal primeiro, depois os demais
+        uint32_t fim;
+        uint32_t inicio = buscarEvidencias(caso, i, &fim);
+        if (inicio == fim) {
+            fprintf(arquivo, "%s\n", caso->suspeitos.textos[principal]);
+            continue;
+        }
+        for (uint32_t j = inicio; j < fim; j++) {
+            if (caso->evidencias[j].suspeito == principal) {
+                fprintf(arquivo, "%s*%u", caso->suspeitos.textos[principal], caso->evidencias[j].peso);
+            }
+        }
+        for (uint32_t j = inicio; j < fim; j++) {
+            if (caso->evidencias[j].suspeito == principal) continue;
+            fprintf(arquivo, ",%s*%u", caso->suspeitos.textos[caso->evidencias[j].suspeito],
+                    caso->evidencias[j].peso);
+        }
+        fprintf(arquivo, "\n");
+    }
+
+    int sucesso = !ferror(arquivo);
+    sucesso = (fclose(arquivo) == 0) && sucesso;
+    if (!sucesso) fprintf(stderr, "❌ Não foi possível gravar o caso em '%s'\n", caminho);
+    return sucesso;
+}
+
+/**
+ * @brief Embaralha um vetor de IDs (Fisher-Yates)
+ * @param ids Vetor de IDs
+ * @param quantidade Tamanho do vetor
+ * @param estado Estado do gerador pseudoaleatório
+ */
+void embaralharIds(uint32_t* ids, uint32_t quantidade, uint64_t* estado) {
+    for (uint32_t i = quantidade; i > 1; i--) {
+        uint32_t j = (uint32_t)(proximoAleatorio(estado) % i);
+        uint32_t troca = ids[i - 1];
+        ids[i - 1] = ids[j];
+        ids[j] = troca;
+    }
+}
+
+/**
+ * @brief Reconstrói a árvore de ponteiros equivalente a uma mansão compacta
+ *
+ * Cada sala é um malloc próprio, feito em ordem aleatória, como numa árvore
+ * montada aos poucos no heap; serve de referência para os benchmarks.
+ *
+ * @param mansao Mansão compacta
+ * @param estado Estado do gerador pseudoaleatório
+ * @return Vetor índice → sala (a entrada é o 0); liberar cada sala e o vetor
+ */
+Sala** criarArvoreDePonteiros(const Mansao* mansao, uint64_t* estado) {
+    uint32_t n = mansao->numSalas;
+    Sala** salas = (Sala**)malloc(((size_t)n + 1) * sizeof(Sala*));
+    uint32_t* ordem = (uint32_t*)malloc(((size_t)n + 1) * sizeof(uint32_t));
+    if (salas == NULL || ordem == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    for (uint32_t i = 0; i < n; i++) ordem[i] = i;
+    embaralharIds(ordem, n, estado);
+    for (uint32_t i = 0; i < n; i++) {
+        salas[ordem[i]] = (Sala*)malloc(sizeof(Sala));
+        if (salas[ordem[i]] == NULL) {
+            printf("Erro de alocação de memória!\n");
+            exit(1);
+        }
+    }
+    free(ordem);
+
+    for (uint32_t i = 0; i < n; i++) {
+        const NoMansao* no = &mansao->nos[i];
+        salas[i]->nome = nomeSala(mansao, i);
+        salas[i]->pista = no->pista;
+        salas[i]->esquerda = no->esquerda != SEM_INDICE ? salas[no->esquerda] : NULL;
+        salas[i]->direita = no->direita != SEM_INDICE ? salas[no->direita] : NULL;
+    }
+    return salas;
+}
+
+/**
+ * @brief Compara a mansão compacta com a árvore de ponteiros equivalente
+ *
+ * "descida": caminhos da entrada até uma folha, com o lado sorteado a cada
+ * passo (a mesma sequência nas duas formas), como no jogo.
+ * "percurso": visita de todos os cômodos somando as pistas; a árvore de
+ * ponteiros usa uma pilha explícita e a forma compacta, um passe linear.
+ * As operações contadas são cômodos visitados.
+ *
+ * @param relatorio Destino dos resultados
+ * @param caso Caso sintético
+ * @param semente Semente dos sorteios
+ */
+void medirMansao(RelatorioBench* relatorio, const Caso* caso, uint64_t semente) {
+    const Mansao* mansao = &caso->mansao;
+    uint32_t n = mansao->numSalas;
+    uint64_t estado = semente;
+    volatile uint64_t sumidouro = 0;
+    Sala** salas = criarArvoreDePonteiros(mansao, &estado);
+
+    // Descidas: o mesmo total de passos nas duas formas
+    uint64_t passosPonteiros = 0, passosCompacta = 0, acumulado = 0;
+    uint64_t sorteio = semente | 1;
+    double inicio = agoraEmSegundos();
+    while (passosPonteiros < OPERACOES_MINIMAS_BENCH) {
+        const Sala* sala = salas[0];
+        while (sala != NULL) {
+            acumulado += sala->pista;
+            passosPonteiros++;
+            const Sala* proxima = proximoAleatorio(&sorteio) & 1 ? sala->direita : sala->esquerda;
+            sala = proxima != NULL ? proxima : (sala->esquerda != NULL ? sala->esquerda : sala->direita);
+        }
+    }
+    registrarResultadoBench(relatorio, "descida_ponteiros", n, passosPonteiros,
+                            agoraEmSegundos() - inicio);
+
+    sorteio = semente | 1;
+    inicio = agoraEmSegundos();
+    while (passosCompacta < passosPonteiros) {
+        uint32_t sala = 0;
+        while (sala != SEM_INDICE) {
+            const NoMansao* no = &mansao->nos[sala];
+            acumulado += no->pista;
+            passosCompacta++;
+            uint32_t proxima = proximoAleatorio(&sorteio) & 1 ? no->direita : no->esquerda;
+            sala = proxima != SEM_INDICE ? proxima : (no->esquerda != SEM_INDICE ? no->esquerda : no->direita);
+        }
+    }
+    registrarResultadoBench(relatorio, "descida_compacta", n, passosCompacta,
+                            agoraEmSegundos() - inicio);
+
+    // Percursos completos, repetidos até somar o mínimo de operações
+    uint32_t rodadas = n >= OPERACOES_MINIMAS_BENCH ? 1 : OPERACOES_MINIMAS_BENCH / n;
+    const Sala** pilha = (const Sala**)malloc(((size_t)n + 1) * sizeof(Sala*));
+    if (pilha == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    inicio = agoraEmSegundos();
+    for (uint32_t r = 0; r < rodadas; r++) {
+        size_t topo = 0;
+        pilha[topo++] = salas[0];
+        while (topo > 0) {
+            const Sala* sala = pilha[--topo];
+            acumulado += sala->pista;
+            if (sala->direita != NULL) pilha[topo++] = sala->direita;
+            if (sala->esquerda != NULL) pilha[topo++] = sala->esquerda;
+        }
+    }
+    registrarResultadoBench(relatorio, "percurso_ponteiros", n, (uint64_t)rodadas * n,
+                            agoraEmSegundos() - inicio);
+    free(pilha);
+
+    inicio = agoraEmSegundos();
+    for (uint32_t r = 0; r < rodadas; r++) {
+        for (uint32_t i = 0; i < n; i++) acumulado += mansao->nos[i].pista;
+    }
+    registrarResultadoBench(relatorio, "percurso_compacto", n, (uint64_t)rodadas * n,
+                            agoraEmSegundos() - inicio);
+
+    sumidouro += acumulado;
+    for (uint32_t i = 0; i < n; i++) free(salas[i]);
+    free(salas);
+    (void)sumidouro;
+}
+
+/**
+ * @brief Emite uma linha de resultado em CSV ou um objeto JSON
+ * @param relatorio Destino e formato
+ * @param teste Nome do teste
+ * @param tamanho Salas do caso usado
+ * @param operacoes Operações medidas
+ * @param segundos Tempo total das operações
+ */
+void registrarResultadoBench(RelatorioBench* relatorio, const char* teste, uint32_t tamanho,
+                             uint64_t operacoes, double segundos) {
+    double nsPorOperacao = operacoes ? segundos * 1e9 / (double)operacoes : 0.0;
+    if (relatorio->formato == FORMATO_JSON) {
+        printf("%s  {\"teste\": \"%s\", \"tamanho\": %u, \"operacoes\": %llu, "
+               "\"segundos\": %.6f, \"ns_por_operacao\": %.2f}",
+               relatorio->resultados ? ",\n" : "", teste, tamanho,
+               (unsigned long long)operacoes, segundos, nsPorOperacao);
+    } else {
+        printf("%s,%u,%llu,%.6f,%.2f\n", teste, tamanho, (unsigned long long)operacoes,
+               segundos, nsPorOperacao);
+    }
+    relatorio->resultados++;
+    fflush(stdout);
+}
+
+/**
+ * @brief Roda todos os microbenchmarks e o teste ponta a ponta em um caso
+ * @param relatorio Destino dos resultados
+ * @param caso Caso sintético
+ * @param semente Semente para as ordens aleatórias
+ */
+void medirCaso(RelatorioBench* relatorio, const Caso* caso, uint64_t semente) {
+    uint32_t n = caso->pistas.quantidade;
+    uint32_t tamanho = caso->mansao.numSalas;
+    uint64_t estado = semente;
+    uint32_t rodadas = n >= OPERACOES_MINIMAS_BENCH ? 1 : OPERACOES_MINIMAS_BENCH / n;
+    volatile uint64_t sumidouro = 0; // Impede que o compilador descarte os laços
+
+    uint32_t* aleatorios = (uint32_t*)malloc((size_t)n * sizeof(uint32_t));
+    if (aleatorios == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    for (uint32_t i = 0; i < n; i++) aleatorios[i] = i;
+    embaralharIds(aleatorios, n, &estado);
+
+    // hash: só a função de espalhamento sobre os textos das pistas
+    uint64_t acumulado = 0;
+    double inicio = agoraEmSegundos();
+    for (uint32_t r = 0; r < rodadas; r++) {
+        for (uint32_t i = 0; i < n; i++) acumulado += hash(caso->pistas.textos[i]);
+    }
+    registrarResultadoBench(relatorio, "hash", tamanho, (uint64_t)rodadas * n,
+                            agoraEmSegundos() - inicio);
+    sumidouro += acumulado;
+
+    // inserirNaHash: tabela nova a cada rodada, crescendo a partir de vazia
+    inicio = agoraEmSegundos();
+    for (uint32_t r = 0; r < rodadas; r++) {
+        TabelaHash tabela;
+        inicializarHash(&tabela);
+        for (uint32_t i = 0; i < n; i++) {
+            inserirNaHash(&tabela, caso->pistas.textos[aleatorios[i]], aleatorios[i]);
+        }
+        sumidouro += tabela.quantidade;
+        liberarHash(&tabela);
+    }
+    registrarResultadoBench(relatorio, "inserirNaHash", tamanho, (uint64_t)rodadas * n,
+                            agoraEmSegundos() - inicio);
+
+    // encontrarSuspeito: texto da pista → suspeito, em ordem aleatória
+    inicio = agoraEmSegundos();
+    for (uint32_t r = 0; r < rodadas; r++) {
+        for (uint32_t i = 0; i < n; i++) {
+            sumidouro += encontrarSuspeito(caso, caso->pistas.textos[aleatorios[i]]) != NULL;
+        }
+    }
+    registrarResultadoBench(relatorio, "encontrarSuspeito", tamanho, (uint64_t)rodadas * n,
+                            agoraEmSegundos() - inicio);
+
+    // Mesma busca com a tabela perfeita, montada aqui como --gerar-hash faria
+    TabelaPerfeita tabela;
+    if (construirTabelaPerfeita(&tabela, caso)) {
+        Caso comTabela = *caso;
+        comTabela.pistasPerfeitas = &tabela;
+        inicio = agoraEmSegundos();
+        for (uint32_t r = 0; r < rodadas; r++) {
+            for (uint32_t i = 0; i < n; i++) {
+                sumidouro += encontrarSuspeito(&comTabela, caso->pistas.textos[aleatorios[i]]) != NULL;
+            }
+        }
+        registrarResultadoBench(relatorio, "encontrarSuspeito_perfeito", tamanho,
+                                (uint64_t)rodadas * n, agoraEmSegundos() - inicio);
+        liberarTabelaPerfeita(&tabela);
+    }
+
+    // inserirPista (aleatória e ordenada) e percurso em ordem do caderno
+    MemoriaSessao memoria;
+    inicializarMemoriaSessao(&memoria);
+    double tempoAleatorio = 0, tempoOrdenado = 0, tempoPercurso = 0;
+    for (uint32_t r = 0; r < rodadas; r++) {
+        CadernoPistas caderno;
+        reiniciarMemoriaSessao(&memoria);
+        inicializarCaderno(&caderno, &memoria.pistas);
+        inicio = agoraEmSegundos();
+        for (uint32_t i = 0; i < n; i++) inserirPista(&caderno, aleatorios[i]);
+        tempoAleatorio += agoraEmSegundos() - inicio;
+
+        // Percurso: o mesmo de listarPistasOrdenadas, sem imprimir
+        inicio = agoraEmSegundos();
+        IteradorCaderno iterador;
+        iniciarIteradorCaderno(&iterador, &caderno);
+        uint32_t pista;
+        while (proximaPistaCaderno(&iterador, &pista)) sumidouro += pista;
+        tempoPercurso += agoraEmSegundos() - inicio;
+
+        reiniciarMemoriaSessao(&memoria);
+        inicializarCaderno(&caderno, &memoria.pistas);
+        inicio = agoraEmSegundos();
+        for (uint32_t i = 0; i < n; i++) inserirPista(&caderno, i);
+        tempoOrdenado += agoraEmSegundos() - inicio;
+    }
+    registrarResultadoBench(relatorio, "inserirPista_aleatoria", tamanho, (uint64_t)rodadas * n,
+                            tempoAleatorio);
+    registrarResultadoBench(relatorio, "inserirPista_ordenada", tamanho, (uint64_t)rodadas * n,
+                            tempoOrdenado);
+    registrarResultadoBench(relatorio, "listarPistasOrdenadas", tamanho, (uint64_t)rodadas * n,
+                            tempoPercurso);
+
+    // Placar: cada pista coletada soma evidência; o veredicto é uma leitura
+    inicio = agoraEmSegundos();
+    for (uint32_t r = 0; r < rodadas; r++) {
+        PlacarSuspeitos placar;
+        reiniciarMemoriaSessao(&memoria);
+        inicializarPlacar(&placar, caso->suspeitos.quantidade, caso->pontuacaoMaxima, &memoria.arena);
+        for (uint32_t i = 0; i < n; i++) registrarEvidenciasDaPista(&placar, caso, aleatorios[i]);
+        sumidouro += pistasContraSuspeito(&placar, suspeitoNaPosicao(&placar, 0));
+    }
+    registrarResultadoBench(relatorio, "placarSuspeitos", tamanho, (uint64_t)rodadas * n,
+                            agoraEmSegundos() - inicio);
+
+    // Matriz de evidências: cadernos de PISTAS_CADERNO_BENCH pistas sorteadas
+    // pontuados contra todos os suspeitos, um por vez e todos juntos
+    MatrizEvidencias matriz;
+    montarMatrizEvidencias(caso, &matriz);
+    uint32_t pistasPorCaderno = n < PISTAS_CADERNO_BENCH ? n : PISTAS_CADERNO_BENCH;
+    BitsCaderno* cadernos = (BitsCaderno*)malloc(CADERNOS_BENCH * sizeof(BitsCaderno));
+    uint32_t* ids = (uint32_t*)malloc(PISTAS_CADERNO_BENCH * sizeof(uint32_t));
+    uint32_t* pontuacoes =
+        (uint32_t*)malloc(((size_t)CADERNOS_BENCH * matriz.numSuspeitos + 1) * sizeof(uint32_t));
+    if (cadernos == NULL || ids == NULL || pontuacoes == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    for (uint32_t c = 0; c < CADERNOS_BENCH; c++) {
+        for (uint32_t k = 0; k < pistasPorCaderno; k++) {
+            ids[k] = aleatorios[((uint64_t)c * pistasPorCaderno + k) % n];
+        }
+        qsort(ids, pistasPorCaderno, sizeof(uint32_t), compararIds);
+        inicializarBitsCaderno(&cadernos[c]);
+        montarBitsCaderno(&cadernos[c], ids, pistasPorCaderno);
+    }
+    inicio = agoraEmSegundos();
+    for (uint32_t r = 0; r < PONTUACOES_BENCH / CADERNOS_BENCH; r++) {
+        for (uint32_t c = 0; c < CADERNOS_BENCH; c++) {
+            pontuarCadernos(&matriz, &cadernos[c], 1, pontuacoes);
+            sumidouro += pontuacoes[0];
+        }
+    }
+    registrarResultadoBench(relatorio, "pontuarSuspeitos", tamanho, PONTUACOES_BENCH,
+                            agoraEmSegundos() - inicio);
+    inicio = agoraEmSegundos();
+    for (uint32_t r = 0; r < PONTUACOES_BENCH / CADERNOS_BENCH; r++) {
+        pontuarCadernos(&matriz, cadernos, CADERNOS_BENCH, pontuacoes);
+        sumidouro += pontuacoes[0];
+    }
+    registrarResultadoBench(relatorio, "pontuarCadernos_lote", tamanho, PONTUACOES_BENCH,
+                            agoraEmSegundos() - inicio);
+    for (uint32_t c = 0; c < CADERNOS_BENCH; c++) liberarBitsCaderno(&cadernos[c]);
+    free(cadernos);
+    free(ids);
+    free(pontuacoes);
+    liberarMatrizEvidencias(&matriz);
+
+    // Índice de palavras: todas as pistas indexadas em ordem aleatória e
+    // buscas pelo prefixo de 3 letras da última palavra de pistas sorteadas
+    uint32_t numBuscas = n < BUSCAS_BENCH ? n : BUSCAS_BENCH;
+    double tempoIndexar = 0, tempoBuscar = 0;
+    ResultadoBusca busca;
+    inicializarResultadoBusca(&busca);
+    for (uint32_t r = 0; r < rodadas; r++) {
+        IndicePistas indice;
+        reiniciarMemoriaSessao(&memoria);
+        inicializarIndicePistas(&indice, &memoria.arena);
+        inicio = agoraEmSegundos();
+        for (uint32_t i = 0; i < n; i++) {
+            indexarPista(&indice, caso->pistas.textos[aleatorios[i]], aleatorios[i]);
+        }
+        tempoIndexar += agoraEmSegundos() - inicio;
+
+        inicio = agoraEmSegundos();
+        for (uint32_t i = 0; i < numBuscas; i++) {
+            const char* texto = caso->pistas.textos[aleatorios[i]];
+            const char* ultima = strrchr(texto, ' ');
+            char prefixo[4];
+            snprintf(prefixo, sizeof(prefixo), "%s", ultima != NULL ? ultima + 1 : texto);
+            sumidouro += buscarPistas(&indice, prefixo, &busca);
+        }
+        tempoBuscar += agoraEmSegundos() - inicio;
+    }
+    registrarResultadoBench(relatorio, "indexarPista", tamanho, (uint64_t)rodadas * n, tempoIndexar);
+    registrarResultadoBench(relatorio, "buscarPistas_prefixo", tamanho, (uint64_t)rodadas * numBuscas,
+                            tempoBuscar);
+    liberarResultadoBusca(&busca);
+    liberarMemoriaSessao(&memoria);
+    free(aleatorios);
+
+    // Ponta a ponta: roteiros aleatórios de exploração terminados em acusação
+    static const char COMANDOS[] = "CCEDEDP";
+    char* textos = (char*)malloc((size_t)SESSOES_BENCH * (COMANDOS_ROTEIRO_BENCH + 1));
+    Roteiro* roteiros = (Roteiro*)malloc(SESSOES_BENCH * sizeof(Roteiro));
+    if (textos == NULL || roteiros == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    for (uint32_t i = 0; i < SESSOES_BENCH; i++) {
+        char* comandos = textos + (size_t)i * (COMANDOS_ROTEIRO_BENCH + 1);
+        for (int j = 0; j < COMANDOS_ROTEIRO_BENCH - 1; j++) {
+            comandos[j] = COMANDOS[proximoAleatorio(&estado) % (sizeof(COMANDOS) - 1)];
+        }
+        comandos[COMANDOS_ROTEIRO_BENCH - 1] = 'S';
+        comandos[COMANDOS_ROTEIRO_BENCH] = '\0';
+        roteiros[i].comandos = comandos;
+        roteiros[i].numComandos = COMANDOS_ROTEIRO_BENCH;
+        roteiros[i].acusado =
+            caso->suspeitos.textos[proximoAleatorio(&estado) % caso->suspeitos.quantidade];
+    }
+
+    Sessao sessao;
+    iniciarSessao(&sessao, caso);
+    inicio = agoraEmSegundos();
+    for (uint32_t i = 0; i < SESSOES_BENCH; i++) {
+        reiniciarSessao(&sessao);
+        sumidouro += executarRoteiro(&sessao, &roteiros[i]);
+    }
+    registrarResultadoBench(relatorio, "sessoes", tamanho, SESSOES_BENCH,
+                            agoraEmSegundos() - inicio);
+    
+    // Suspender e retomar: cada sessão explorada vira instantâneo e volta
+    // numa segunda sessão, como na migração entre processos
+    Sessao retomada;
+    iniciarSessao(&retomada, caso);
+    uint64_t* instantaneo = (uint64_t*)malloc(tamanhoInstantaneo(caso));
+    if (instantaneo == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    double segundosGravar = 0.0, segundosRestaurar = 0.0;
+    for (uint32_t i = 0; i < SESSOES_BENCH; i++) {
+        reiniciarSessao(&sessao);
+        for (size_t j = 0; j + 1 < roteiros[i].numComandos; j++) {
+            aplicarComando(&sessao, roteiros[i].comandos[j]);
+        }
+        inicio = agoraEmSegundos();
+        gravarInstantaneo(&sessao, instantaneo);
+        double meio = agoraEmSegundos();
+        sumidouro += (uint64_t)restaurarInstantaneo(&retomada, instantaneo, tamanhoInstantaneo(caso));
+        segundosGravar += meio - inicio;
+        segundosRestaurar += agoraEmSegundos() - meio;
+        sumidouro += retomada.caderno.quantidade;
+    }
+    registrarResultadoBench(relatorio, "instantaneo_gravar", tamanho, SESSOES_BENCH, segundosGravar);
+    registrarResultadoBench(relatorio, "instantaneo_restaurar", tamanho, SESSOES_BENCH,
+                            segundosRestaurar);
+    free(instantaneo);
+    liberarSessao(&retomada);
+    liberarSessao(&sessao);
+    free(roteiros);
+    free(textos);
+    (void)sumidouro;
+}
+
+/**
+ * @brief Mede o índice de rotas do comando "ir" e as consultas de rota
+ *
+ * Na árvore, cada consulta parte de um ancestral sorteado do destino (só
+ * se desce); no grafo, origem e destino são sorteados. As operações da
+ * montagem são cômodos; as das consultas, rotas calculadas.
+ *
+ * @param relatorio Destino dos resultados
+ * @param caso Caso sintético, com ou sem corredores
+ * @param semente Semente dos sorteios
+ */
+void medirRotas(RelatorioBench* relatorio, const Caso* caso, uint64_t semente) {
+    const Mansao* mansao = &caso->mansao;
+    uint32_t n = mansao->numSalas;
+    int grafo = mansao->numPassagens > 0;
+    uint64_t estado = semente;
+    volatile uint64_t sumidouro = 0;
+
+    IndiceRotas indice;
+    inicializarIndiceRotas(&indice);
+    double inicio = agoraEmSegundos();
+    montarIndiceRotas(&indice, mansao);
+    registrarResultadoBench(relatorio, grafo ? "montarIndiceRotas_grafo" : "montarIndiceRotas_arvore",
+                            n, n, agoraEmSegundos() - inicio);
+
+    uint32_t* origens = (uint32_t*)malloc(ROTAS_BENCH * sizeof(uint32_t));
+    uint32_t* destinos = (uint32_t*)malloc(ROTAS_BENCH * sizeof(uint32_t));
+    if (origens == NULL || destinos == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    for (uint32_t i = 0; i < ROTAS_BENCH; i++) {
+        destinos[i] = (uint32_t)(proximoAleatorio(&estado) % n);
+        if (grafo) {
+            origens[i] = (uint32_t)(proximoAleatorio(&estado) % n);
+        } else {
+            uint32_t origem = destinos[i];
+            for (uint64_t subidas = proximoAleatorio(&estado) % 32;
+                 subidas > 0 && indice.pais[origem] != SEM_INDICE; subidas--) {
+                origem = indice.pais[origem];
+            }
+            origens[i] = origem;
+        }
+    }
+
+    inicio = agoraEmSegundos();
+    for (uint32_t i = 0; i < ROTAS_BENCH; i++) {
+        sumidouro += (uint64_t)calcularRota(&indice, mansao, origens[i], nomeSala(mansao, destinos[i]));
+    }
+    registrarResultadoBench(relatorio, grafo ? "calcularRota_grafo" : "calcularRota_arvore", n,
+                            ROTAS_BENCH, agoraEmSegundos() - inicio);
+
+    free(origens);
+    free(destinos);
+    liberarIndiceRotas(&indice);
+    (void)sumidouro;
+}
+
+/**
+ * @brief Mede a montagem das pistas adiante e as dicas do menu
+ *
+ * As dicas são medidas como no jogo: descidas da entrada até uma folha,
+ * coletando a pista de cada cômodo e pedindo a dica das duas saídas; cada
+ * descida é uma sessão nova. As operações da montagem são cômodos; as das
+ * dicas, saídas consultadas. Numa mansão cuja entrada não tem saídas, só a
+ * montagem é medida.
+ *
+ * @param relatorio Destino dos resultados
+ * @param caso Caso sintético
+ * @param semente Semente dos sorteios
+ */
+void medirPistasAdiante(RelatorioBench* relatorio, const Caso* caso, uint64_t semente) {
+    const Mansao* mansao = &caso->mansao;
+    uint64_t estado = semente;
+    volatile uint64_t sumidouro = 0;
+    Sessao sessao;
+    iniciarSessao(&sessao, caso);
+
+    PistasAdiante adiante;
+    double inicio = agoraEmSegundos();
+    montarPistasAdiante(&adiante, &sessao);
+    registrarResultadoBench(relatorio, "montarPistasAdiante", mansao->numSalas, mansao->numSalas,
+                            agoraEmSegundos() - inicio);
+
+    // Sem saídas na entrada não há dica a pedir: a linha das dicas é omitida
+    const NoMansao* entrada = salaDaMansao(mansao, 0);
+    uint64_t consultas = 0;
+    inicio = agoraEmSegundos();
+    while ((entrada->esquerda != SEM_INDICE || entrada->direita != SEM_INDICE) &&
+           consultas < OPERACOES_MINIMAS_BENCH) {
+        reiniciarSessao(&sessao);
+        adiante.numColetadas = 0;
+        for (uint32_t sala = 0; sala != SEM_INDICE;) {
+            const NoMansao* no = salaDaMansao(mansao, sala);
+            if (no->pista != SEM_INDICE && anotarPista(&sessao, no->pista)) {
+                descontarPistaAdiante(&adiante, no->pista);
+            }
+            uint32_t filhos[2] = {no->esquerda, no->direita};
+            for (int lado = 0; lado < 2; lado++) {
+                if (filhos[lado] == SEM_INDICE) continue;
+                sumidouro += contarPistasAdiante(&adiante, caso, filhos[lado])[0];
+                consultas++;
+            }
+            sala = filhos[proximoAleatorio(&estado) & 1];
+            if (sala == SEM_INDICE) sala = filhos[0] != SEM_INDICE ? filhos[0] : filhos[1];
+        }
+    }
+    if (consultas > 0) {
+        registrarResultadoBench(relatorio, "contarPistasAdiante", mansao->numSalas, consultas,
+                                agoraEmSegundos() - inicio);
+    }
+
+    liberarPistasAdiante(&adiante);
+    liberarSessao(&sessao);
+    (void)sumidouro;
+}
+
+#ifndef _WIN32
+/**
+ * @brief Thread do benchmark do caderno da equipe: anota a sua fatia das pistas
+ * @param argumento InsercoesBench da thread
+ * @return NULL
+ */
+void* executarInsercoesBench(void* argumento) {
+    InsercoesBench* insercoes = (InsercoesBench*)argumento;
+    for (uint32_t i = 0; i < insercoes->numPistas; i++) {
+        uint32_t pista = insercoes->pistas[i];
+        if (insercoes->trava == NULL) {
+            inserirNoCompartilhado(insercoes->equipe, pista);
+            continue;
+        }
+        pthread_mutex_lock(insercoes->trava);
+        if (inserirPista(insercoes->caderno, pista)) {
+            registrarEvidenciasDaPista(insercoes->placar, insercoes->caso, pista);
+        }
+        pthread_mutex_unlock(insercoes->trava);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Mede a disputa pelo caderno da equipe com 1 a 64 threads
+ *
+ * Cada rodada sorteia IDs de pistas com repetição (cerca de duas vezes o
+ * número de pistas do caso, no mínimo INSERCOES_EQUIPE_BENCH) e os reparte
+ * entre as threads, que os anotam ao mesmo tempo num caderno vazio: as
+ * pistas repetidas disputam o mesmo lugar da lista. "cadernoEquipe_*" usa a
+ * lista com saltos sem trava; "cadernoComTrava_*" faz o mesmo trabalho
+ * (árvore B e placar) sob uma trava única. As operações são as pistas
+ * anotadas, novas ou repetidas. "fotoCadernoEquipe" mede a foto do caderno
+ * cheio, por pista.
+ *
+ * @param relatorio Destino dos resultados
+ * @param caso Caso sintético
+ * @param semente Semente dos sorteios
+ */
+void medirCadernoCompartilhado(RelatorioBench* relatorio, const Caso* caso, uint64_t semente) {
+    static const int numThreads[] = {1, 2, 4, 8, 16, 32, MAX_THREADS_BENCH_EQUIPE};
+    uint32_t numPistas = caso->pistas.quantidade;
+    if (numPistas == 0) return;
+    uint64_t estado = semente;
+    uint32_t porRodada = numPistas > INSERCOES_EQUIPE_BENCH / 2 ? 2 * numPistas : INSERCOES_EQUIPE_BENCH;
+    uint32_t* pistas = (uint32_t*)malloc((size_t)porRodada * sizeof(uint32_t));
+    if (pistas == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    for (uint32_t i = 0; i < porRodada; i++) pistas[i] = (uint32_t)(proximoAleatorio(&estado) % numPistas);
+
+    pthread_t threads[MAX_THREADS_BENCH_EQUIPE];
+    InsercoesBench insercoes[MAX_THREADS_BENCH_EQUIPE];
+    CadernoCompartilhado equipe;
+    CadernoPistas caderno;
+    PlacarSuspeitos placar;
+    MemoriaSessao memoria;
+    pthread_mutex_t trava;
+    pthread_mutex_init(&trava, NULL);
+    inicializarMemoriaSessao(&memoria);
+
+    for (int comTrava = 0; comTrava < 2; comTrava++) {
+        for (size_t k = 0; k < sizeof(numThreads) / sizeof(numThreads[0]); k++) {
+            int t = numThreads[k];
+            uint64_t operacoes = 0;
+            double segundos = 0;
+            while (operacoes < OPERACOES_MINIMAS_BENCH) {
+                if (comTrava) {
+                    reiniciarMemoriaSessao(&memoria);
+                    inicializarCaderno(&caderno, &memoria.pistas);
+                    inicializarPlacar(&placar, caso->suspeitos.quantidade, caso->pontuacaoMaxima,
+                                      &memoria.arena);
+                } else {
+                    inicializarCadernoCompartilhado(&equipe, caso);
+                }
+                for (int i = 0; i < t; i++) {
+                    uint32_t inicio = (uint32_t)((uint64_t)porRodada * i / t);
+                    uint32_t fim = (uint32_t)((uint64_t)porRodada * (i + 1) / t);
+                    insercoes[i].equipe = &equipe;
+                    insercoes[i].caderno = &caderno;
+                    insercoes[i].placar = &placar;
+                    insercoes[i].caso = caso;
+                    insercoes[i].trava = comTrava ? &trava : NULL;
+                    insercoes[i].pistas = pistas + inicio;
+                    insercoes[i].numPistas = fim - inicio;
+                }
+
+                double inicio = agoraEmSegundos();
+                for (int i = 1; i < t; i++) {
+                    pthread_create(&threads[i], NULL, executarInsercoesBench, &insercoes[i]);
+                }
+                executarInsercoesBench(&insercoes[0]);
+                for (int i = 1; i < t; i++) pthread_join(threads[i], NULL);
+                segundos += agoraEmSegundos() - inicio;
+                operacoes += porRodada;
+
+                if (!comTrava && operacoes < OPERACOES_MINIMAS_BENCH) liberarCadernoCompartilhado(&equipe);
+            }
+
+            char teste[64];
+            snprintf(teste, sizeof(teste), "%s_%dthreads", comTrava ? "cadernoComTrava" : "cadernoEquipe", t);
+            registrarResultadoBench(relatorio, teste, numPistas, operacoes, segundos);
+            if (comTrava) continue;
+
+            if (t == MAX_THREADS_BENCH_EQUIPE) {
+                // A foto é medida no caderno cheio da última rodada
+                uint64_t fotografadas = 0;
+                double inicio = agoraEmSegundos();
+                while (fotografadas < OPERACOES_MINIMAS_BENCH) {
+                    size_t quantidade;
+                    free(fotografarCadernoCompartilhado(&equipe, &quantidade));
+                    fotografadas += quantidade;
+                }
+                registrarResultadoBench(relatorio, "fotoCadernoEquipe", numPistas, fotografadas,
+                                        agoraEmSegundos() - inicio);
+            }
+            liberarCadernoCompartilhado(&equipe);
+        }
+    }
+
+    liberarMemoriaSessao(&memoria);
+    pthread_mutex_destroy(&trava);
+    free(pistas);
+}
+
+/**
+ * @brief Thread do --testar-equipe: escreve e confere, ou só fotografa
+ *
+ * Um escritor fotografa o caderno a cada CONFERENCIA_TESTE_EQUIPE pistas e
+ * procura nela a última que anotou (lê o que escreveu). Um leitor confere
+ * que cada foto está em ordem estrita e contém a foto anterior inteira.
+ *
+ * @param argumento TesteEquipe da thread
+ * @return NULL
+ */
+void* executarTesteEquipe(void* argumento) {
+    TesteEquipe* teste = (TesteEquipe*)argumento;
+    uint32_t numPistas = teste->equipe->caso->pistas.quantidade;
+    uint64_t estado = teste->semente;
+    for (uint32_t i = 0; i < teste->numPistas; i++) {
+        uint32_t pista = (uint32_t)(proximoAleatorio(&estado) % numPistas);
+        inserirNoCompartilhado(teste->equipe, pista);
+        if (i % CONFERENCIA_TESTE_EQUIPE != 0) continue;
+        size_t quantidade;
+        uint32_t* foto = fotografarCadernoCompartilhado(teste->equipe, &quantidade);
+        size_t k = 0;
+        while (k < quantidade && foto[k] < pista) k++;
+        if (k == quantidade || foto[k] != pista) teste->falhas++;
+        teste->fotos++;
+        free(foto);
+    }
+    if (teste->numPistas > 0) return NULL;
+
+    uint32_t* anterior = NULL;
+    size_t quantidadeAnterior = 0;
+    while (!atomic_load(teste->encerrar)) {
+        size_t quantidade;
+        uint32_t* foto = fotografarCadernoCompartilhado(teste->equipe, &quantidade);
+        for (size_t k = 1; k < quantidade; k++) {
+            if (foto[k] <= foto[k - 1]) {
+                teste->falhas++;
+                break;
+            }
+        }
+        // Pistas nunca saem do caderno: a foto anterior é um subconjunto
+        size_t j = 0;
+        for (size_t k = 0; k < quantidadeAnterior; k++) {
+            while (j < quantidade && foto[j] < anterior[k]) j++;
+            if (j == quantidade || foto[j] != anterior[k]) {
+                teste->falhas++;
+                break;
+            }
+        }
+        teste->fotos++;
+        free(anterior);
+        anterior = foto;
+        quantidadeAnterior = quantidade;
+    }
+    free(anterior);
+    return NULL;
+}
+
+/**
+ * @brief Modo --testar-equipe: confere o caderno da equipe sob disputa
+ *
+ * Escritores e LEITORES_TESTE_EQUIPE leitores usam o mesmo caderno ao mesmo
+ * tempo (veja executarTesteEquipe). No fim, uma sessão comum anota em série
+ * as mesmas pistas: o caderno da equipe deve ter exatamente as pistas do
+ * caderno da sessão, na mesma ordem, e os mesmos pontos por suspeito, e
+ * cada nível da lista com saltos deve estar em ordem. Feito para rodar
+ * também sob -fsanitize=thread e -fsanitize=address.
+ *
+ * @param numSalas Salas do caso sintético
+ * @param numEscritores Threads que anotam pistas
+ * @param pistasPorEscritor Pistas sorteadas por escritor
+ * @return 1 se todas as conferências passaram, 0 caso contrário
+ */
+int testarCadernoCompartilhado(uint32_t numSalas, int numEscritores, uint32_t pistasPorEscritor) {
+    Caso caso;
+    gerarCasoSintetico(&caso, numSalas, 0x9E3779B97F4A7C15ULL + numSalas, 0);
+    if (caso.pistas.quantidade == 0) {
+        printf("❌ O caso gerado não tem pistas\n");
+        liberarCaso(&caso);
+        return 0;
+    }
+    CadernoCompartilhado equipe;
+    inicializarCadernoCompartilhado(&equipe, &caso);
+    _Atomic int encerrar = 0;
+
+    int numThreads = numEscritores + LEITORES_TESTE_EQUIPE;
+    TesteEquipe testes[MAX_THREADS_BENCH_EQUIPE + LEITORES_TESTE_EQUIPE];
+    pthread_t threads[MAX_THREADS_BENCH_EQUIPE + LEITORES_TESTE_EQUIPE];
+    for (int i = 0; i < numThreads; i++) {
+        testes[i].equipe = &equipe;
+        testes[i].encerrar = &encerrar;
+        testes[i].semente = 0xA0761D6478BD642FULL * (uint64_t)(i + 1);
+        testes[i].numPistas = i < numEscritores ? pistasPorEscritor : 0;
+        testes[i].falhas = 0;
+        testes[i].fotos = 0;
+    }
+    double inicio = agoraEmSegundos();
+    for (int i = numEscritores; i < numThreads; i++) {
+        pthread_create(&threads[i], NULL, executarTesteEquipe, &testes[i]);
+    }
+    for (int i = 0; i < numEscritores; i++) {
+        pthread_create(&threads[i], NULL, executarTesteEquipe, &testes[i]);
+    }
+    for (int i = 0; i < numEscritores; i++) pthread_join(threads[i], NULL);
+    atomic_store(&encerrar, 1);
+    for (int i = numEscritores; i < numThreads; i++) pthread_join(threads[i], NULL);
+    double segundos = agoraEmSegundos() - inicio;
+
+    uint64_t falhasEscritores = 0, falhasLeitores = 0, fotos = 0;
+    for (int i = 0; i < numThreads; i++) {
+        if (i < numEscritores) falhasEscritores += testes[i].falhas;
+        else falhasLeitores += testes[i].falhas;
+        fotos += testes[i].fotos;
+    }
+
+    // Referência: as mesmas pistas anotadas em série por uma sessão comum
+    Sessao sessao;
+    iniciarSessao(&sessao, &caso);
+    for (int i = 0; i < numEscritores; i++) {
+        uint64_t estado = testes[i].semente;
+        for (uint32_t k = 0; k < pistasPorEscritor; k++) {
+            anotarPista(&sessao, (uint32_t)(proximoAleatorio(&estado) % caso.pistas.quantidade));
+        }
+    }
+    size_t quantidade;
+    uint32_t* foto = fotografarCadernoCompartilhado(&equipe, &quantidade);
+    int conjuntoIgual = quantidade == sessao.caderno.quantidade;
+    IteradorCaderno iterador;
+    iniciarIteradorCaderno(&iterador, &sessao.caderno);
+    uint32_t pista;
+    for (size_t k = 0; conjuntoIgual && proximaPistaCaderno(&iterador, &pista); k++) {
+        conjuntoIgual = foto[k] == pista;
+    }
+    int pontosIguais = 1;
+    for (uint32_t s = 0; s < caso.suspeitos.quantidade; s++) {
+        if (atomic_load(&equipe.pontos[s]) != pistasContraSuspeito(&sessao.placar, s)) pontosIguais = 0;
+    }
+    int niveisOrdenados = 1;
+    for (int nivel = 0; nivel < NIVEIS_CADERNO_COMPARTILHADO; nivel++) {
+        for (NoCompartilhado* no = atomic_load(&equipe.cabeca->proximos[nivel]); no != NULL;
+             no = atomic_load(&no->proximos[nivel])) {
+            NoCompartilhado* seguinte = atomic_load(&no->proximos[nivel]);
+            if (seguinte != NULL && seguinte->pista <= no->pista) niveisOrdenados = 0;
+        }
+    }
+
+    printf("Caderno da equipe: %d escritores e %d leitores, %zu pistas distintas em %.3f s\n",
+           numEscritores, LEITORES_TESTE_EQUIPE, quantidade, segundos);
+    printf("%s Fotos em ordem, cada uma contendo a anterior (%llu fotos, %llu falhas)\n",
+           falhasLeitores == 0 ? "✅" : "❌", (unsigned long long)fotos, (unsigned long long)falhasLeitores);
+    printf("%s Cada escritor lê o que escreveu (%llu falhas)\n",
+           falhasEscritores == 0 ? "✅" : "❌", (unsigned long long)falhasEscritores);
+    printf("%s Mesmas pistas de uma sessão em série\n", conjuntoIgual ? "✅" : "❌");
+    printf("%s Mesmos pontos por suspeito\n", pontosIguais ? "✅" : "❌");
+    printf("%s Níveis da lista com saltos em ordem\n", niveisOrdenados ? "✅" : "❌");
+
+    free(foto);
+    liberarSessao(&sessao);
+    liberarCadernoCompartilhado(&equipe);
+    liberarCaso(&caso);
+    return falhasLeitores == 0 && falhasEscritores == 0 && conjuntoIgual && pontosIguais && niveisOrdenados;
+}
+#endif
+
+/**
+ * @brief Modo benchmark: gera casos sintéticos e mede cada estrutura
+ *
+ * A saída vai inteira para stdout, em CSV (com cabeçalho) ou em um vetor
+ * JSON, para comparação entre compilações.
+ *
+ * @param formato CSV ou JSON
+ * @param tamanhos Quantidades de salas a medir
+ * @param numTamanhos Número de tamanhos
+ * @return 1 (sempre)
+ */
+int executarBench(FormatoBench formato, const uint32_t* tamanhos, int numTamanhos) {
+    RelatorioBench relatorio;
+    relatorio.formato = formato;
+    relatorio.resultados = 0;
+
+    if (formato == FORMATO_JSON) printf("[\n");
+    else printf("teste,tamanho,operacoes,segundos,ns_por_operacao\n");
+
+    for (int i = 0; i < numTamanhos; i++) {
+        Caso caso;
+        double inicio = agoraEmSegundos();
+        gerarCasoSintetico(&caso, tamanhos[i], 0x9E3779B97F4A7C15ULL + tamanhos[i], 0);
+        registrarResultadoBench(&relatorio, "gerarCaso", tamanhos[i], tamanhos[i],
+                                agoraEmSegundos() - inicio);
+        medirCaso(&relatorio, &caso, 0xD1B54A32D192ED03ULL + tamanhos[i]);
+        medirMansao(&relatorio, &caso, 0x94D049BB133111EBULL + tamanhos[i]);
+        medirRotas(&relatorio, &caso, 0xBF58476D1CE4E5B9ULL + tamanhos[i]);
+        medirPistasAdiante(&relatorio, &caso, 0x2545F4914F6CDD1DULL + tamanhos[i]);
+#ifndef _WIN32
+        medirCadernoCompartilhado(&relatorio, &caso, 0x9FB21C651E98DF25ULL + tamanhos[i]);
+#endif
+        liberarCaso(&caso);
+
+        // A mesma mansão com corredores e escadas, para as rotas no grafo
+        gerarCasoSintetico(&caso, tamanhos[i], 0x9E3779B97F4A7C15ULL + tamanhos[i], 1);
+        medirRotas(&relatorio, &caso, 0xBF58476D1CE4E5B9ULL + tamanhos[i]);
+        liberarCaso(&caso);
+    }
+
+    if (formato == FORMATO_JSON) printf("\n]\n");
+    return 1;
+}
+
+// ========== FUNÇÕES DO RESOLVEDOR DE ROTAS ==========
+
+/**
+ * @brief Calcula pais, profundidades e o resumo de pistas de cada subárvore
+ *
+ * Na mansão compacta os filhos vêm sempre depois do pai: uma passada para
+ * frente propaga pais e profundidades, e uma de trás para frente acumula as
+ * máscaras das folhas até a entrada.
+ *
+ * @param resolvedor Resolvedor a ser preenchido
+ * @param caso Caso a resolver (somente leitura)
+ */
+void prepararResolvedor(Resolvedor* resolvedor, const Caso* caso) {
+    memset(resolvedor, 0, sizeof(Resolvedor));
+    const Mansao* mansao = &caso->mansao;
+    uint32_t n = mansao->numSalas;
+    uint32_t numSuspeitos = caso->suspeitos.quantidade;
+    resolvedor->caso = caso;
+    resolvedor->nos = mansao->nos;
+    resolvedor->numNos = n;
+
+    resolvedor->pai = (uint32_t*)malloc(((size_t)n + 1) * sizeof(uint32_t));
+    resolvedor->profundidade = (uint32_t*)malloc(((size_t)n + 1) * sizeof(uint32_t));
+    resolvedor->mascaras = (uint64_t*)malloc(((size_t)n + 1) * sizeof(uint64_t));
+    resolvedor->melhores = (_Atomic uint64_t*)malloc((numSuspeitos + 1) * sizeof(uint64_t));
+    if (resolvedor->pai == NULL || resolvedor->profundidade == NULL ||
+        resolvedor->mascaras == NULL || resolvedor->melhores == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    for (uint32_t s = 0; s < numSuspeitos; s++) {
+        atomic_init(&resolvedor->melhores[s], UINT64_MAX);
+    }
+    atomic_init(&resolvedor->pendentes, 0);
+    atomic_init(&resolvedor->ociosos, 0);
+
+    if (n > 0) {
+        resolvedor->pai[0] = SEM_INDICE;
+        resolvedor->profundidade[0] = 0;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t filhos[2] = {mansao->nos[i].esquerda, mansao->nos[i].direita};
+        for (int j = 0; j < 2; j++) {
+            if (filhos[j] == SEM_INDICE) continue;
+            resolvedor->pai[filhos[j]] = i;
+            resolvedor->profundidade[filhos[j]] = resolvedor->profundidade[i] + 1;
+        }
+    }
+
+    // Resumo das subárvores, das folhas para a raiz
+    for (uint32_t i = n; i-- > 0;) {
+        const NoMansao* no = &mansao->nos[i];
+        uint64_t mascara = 0;
+        if (no->pista != SEM_INDICE && caso->suspeitoDaPista[no->pista] != SEM_INDICE) {
+            mascara = 1ULL << (caso->suspeitoDaPista[no->pista] & 63);
+        }
+        if (no->esquerda != SEM_INDICE) mascara |= resolvedor->mascaras[no->esquerda];
+        if (no->direita != SEM_INDICE) mascara |= resolvedor->mascaras[no->direita];
+        resolvedor->mascaras[i] = mascara;
+    }
+}
+
+/**
+ * @brief Libera os vetores do resolvedor (o caso não é tocado)
+ * @param resolvedor Resolvedor preparado
+ */
+void liberarResolvedor(Resolvedor* resolvedor) {
+    free(resolvedor->pai);
+    free(resolvedor->profundidade);
+    free(resolvedor->mascaras);
+    free((void*)resolvedor->melhores);
+    memset(resolvedor, 0, sizeof(Resolvedor));
+}
+
+/**
+ * @brief Inicializa uma deque de tarefas vazia
+ * @param deque Deque a ser inicializada
+ */
+void inicializarDeque(DequeTarefas* deque) {
+    deque->itens = (uint32_t*)malloc(CAPACIDADE_INICIAL_TAREFAS * sizeof(uint32_t));
+    if (deque->itens == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    deque->inicio = 0;
+    deque->fim = 0;
+    deque->capacidade = CAPACIDADE_INICIAL_TAREFAS;
+#ifndef _WIN32
+    pthread_mutex_init(&deque->trava, NULL);
+#endif
+}
+
+/**
+ * @brief Acrescenta uma tarefa no fim da deque (usado só pelo dono)
+ * @param deque Deque do buscador
+ * @param no Índice da raiz da subárvore
+ */
+void empurrarTarefa(DequeTarefas* deque, uint32_t no) {
+#ifndef _WIN32
+    pthread_mutex_lock(&deque->trava);
+#endif
+    if (deque->inicio == deque->fim) {
+        deque->inicio = deque->fim = 0;
+    }
+    if (deque->fim == deque->capacidade) {
+        // Desloca o que sobrou para o começo antes de decidir se cresce
+        size_t quantidade = deque->fim - deque->inicio;
+        memmove(deque->itens, deque->itens + deque->inicio, quantidade * sizeof(uint32_t));
+        deque->inicio = 0;
+        deque->fim = quantidade;
+        if (quantidade * 2 > deque->capacidade) {
+            uint32_t* itens = (uint32_t*)realloc(deque->itens,
+                                                 deque->capacidade * 2 * sizeof(uint32_t));
+            if (itens == NULL) {
+                printf("Erro de alocação de memória!\n");
+                exit(1);
+            }
+            deque->itens = itens;
+            deque->capacidade *= 2;
+        }
+    }
+    deque->itens[deque->fim++] = no;
+#ifndef _WIN32
+    pthread_mutex_unlock(&deque->trava);
+#endif
+}
+
+/**
+ * @brief Retira a tarefa mais recente (a mais funda) da própria deque
+ * @param deque Deque do buscador
+ * @param no Recebe o índice da raiz da subárvore
+ * @return 1 se havia tarefa, 0 se a deque estava vazia
+ */
+int retirarTarefa(DequeTarefas* deque, uint32_t* no) {
+    int encontrada = 0;
+#ifndef _WIN32
+    pthread_mutex_lock(&deque->trava);
+#endif
+    if (deque->fim > deque->inicio) {
+        *no = deque->itens[--deque->fim];
+        encontrada = 1;
+    }
+#ifndef _WIN32
+    pthread_mutex_unlock(&deque->trava);
+#endif
+    return encontrada;
+}
+
+/**
+ * @brief Rouba a tarefa mais antiga (a subárvore mais rasa) de outra deque
+ * @param deque Deque de outro buscador
+ * @param no Recebe o índice da raiz da subárvore
+ * @return 1 se havia tarefa, 0 se a deque estava vazia
+ */
+int roubarTarefa(DequeTarefas* deque, uint32_t* no) {
+    int encontrada = 0;
+#ifndef _WIN32
+    pthread_mutex_lock(&deque->trava);
+#endif
+    if (deque->fim > deque->inicio) {
+        *no = deque->itens[deque->inicio++];
+        encontrada = 1;
+    }
+#ifndef _WIN32
+    pthread_mutex_unlock(&deque->trava);
+#endif
+    return encontrada;
+}
+
+/**
+ * @brief Libera a memória de uma deque
+ * @param deque Deque a ser liberada
+ */
+void liberarDeque(DequeTarefas* deque) {
+    free(deque->itens);
+#ifndef _WIN32
+    pthread_mutex_destroy(&deque->trava);
+#endif
+}
+
+/**
+ * @brief Acrescenta um cômodo ao caminho atual do buscador
+ *
+ * Pistas repetidas no caminho não contam de novo, como no caderno. Com
+ * "registrar", o cômodo que completa PISTAS_PARA_SUSTENTAR pistas contra um
+ * suspeito disputa a melhor rota dele: vence a menor profundidade e, no
+ * empate, o menor índice, o que torna o resultado independente das threads.
+ *
+ * @param buscador Buscador dono do caminho
+ * @param no Índice do cômodo
+ * @param registrar 1 para avaliar o cômodo como fim de rota
+ */
+void entrarNoCaminho(BuscadorRota* buscador, uint32_t no, int registrar) {
+    const Resolvedor* resolvedor = buscador->resolvedor;
+    uint32_t pista = resolvedor->nos[no].pista;
+    if (pista == SEM_INDICE || buscador->ocorrencias[pista]++ > 0) return;
+    uint32_t suspeito = resolvedor->caso->suspeitoDaPista[pista];
+    if (suspeito == SEM_INDICE) return;
+    uint32_t contagem = ++buscador->contagens[suspeito];
+    if (contagem > buscador->maximos[suspeito]) buscador->maximos[suspeito] = contagem;
+    if (contagem != PISTAS_PARA_SUSTENTAR || !registrar) return;
+
+    uint64_t candidato = (uint64_t)resolvedor->profundidade[no] << 32 | no;
+    uint64_t atual = atomic_load_explicit(&resolvedor->melhores[suspeito], memory_order_relaxed);
+    while (candidato < atual &&
+           !atomic_compare_exchange_weak_explicit(&resolvedor->melhores[suspeito], &atual,
+                                                  candidato, memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief Desfaz entrarNoCaminho ao deixar um cômodo
+ * @param buscador Buscador dono do caminho
+ * @param no Índice do cômodo
+ */
+void sairDoCaminho(BuscadorRota* buscador, uint32_t no) {
+    const Resolvedor* resolvedor = buscador->resolvedor;
+    uint32_t pista = resolvedor->nos[no].pista;
+    if (pista == SEM_INDICE || --buscador->ocorrencias[pista] > 0) return;
+    uint32_t suspeito = resolvedor->caso->suspeitoDaPista[pista];
+    if (suspeito != SEM_INDICE) buscador->contagens[suspeito]--;
+}
+
+/**
+ * @brief Poda: a subárvore ainda pode melhorar a rota de algum suspeito?
+ *
+ * Para um suspeito com c pistas no caminho, a rota mais curta possível
+ * dentro da subárvore termina pelo menos PISTAS_PARA_SUSTENTAR - c - 1
+ * níveis abaixo da raiz dela, e só vale a pena se ele aparece na máscara.
+ * Com mais de 64 suspeitos um bit representa vários, o que só deixa a poda
+ * mais conservadora.
+ *
+ * @param buscador Buscador com o caminho até o pai do nó
+ * @param no Raiz da subárvore
+ * @return 1 se é preciso explorá-la, 0 se pode ser descartada
+ */
+int subarvorePromissora(const BuscadorRota* buscador, uint32_t no) {
+    const Resolvedor* resolvedor = buscador->resolvedor;
+    uint32_t numSuspeitos = resolvedor->caso->suspeitos.quantidade;
+    for (uint64_t mascara = resolvedor->mascaras[no]; mascara != 0; mascara &= mascara - 1) {
+        for (uint32_t s = (uint32_t)__builtin_ctzll(mascara); s < numSuspeitos; s += 64) {
+            if (buscador->contagens[s] >= PISTAS_PARA_SUSTENTAR) continue;
+            uint64_t profundidadeMinima = (uint64_t)resolvedor->profundidade[no] +
+                                          PISTAS_PARA_SUSTENTAR - buscador->contagens[s] - 1;
+            uint64_t limite = profundidadeMinima << 32 | no;
+            if (limite < atomic_load_explicit(&resolvedor->melhores[s], memory_order_relaxed)) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Busca em profundidade numa subárvore, com poda
+ *
+ * Primeiro reconstrói o caminho da entrada até o pai da raiz (subindo pelos
+ * pais) e, ao final, o desfaz, deixando o estado do buscador zerado. Se há
+ * buscadores ociosos, o filho direito de nós rasos vira uma nova tarefa na
+ * deque, de onde pode ser roubado, em vez de ser explorado aqui.
+ *
+ * @param buscador Buscador que executa a tarefa
+ * @param raiz Índice da raiz da subárvore
+ */
+void explorarTarefa(BuscadorRota* buscador, uint32_t raiz) {
+    Resolvedor* resolvedor = buscador->resolvedor;
+    for (uint32_t no = resolvedor->pai[raiz]; no != SEM_INDICE; no = resolvedor->pai[no]) {
+        entrarNoCaminho(buscador, no, 0);
+    }
+
+    size_t topo = 0;
+    buscador->pilha[topo++] = (uint64_t)raiz << 1;
+    while (topo > 0) {
+        uint64_t item = buscador->pilha[--topo];
+        uint32_t no = (uint32_t)(item >> 1);
+        if (item & 1) {
+            sairDoCaminho(buscador, no);
+            continue;
+        }
+        if (!subarvorePromissora(buscador, no)) continue;
+
+        buscador->visitados++;
+        entrarNoCaminho(buscador, no, 1);
+        if (topo + 3 > buscador->capacidadePilha) {
+            buscador->capacidadePilha *= 2;
+            buscador->pilha = (uint64_t*)realloc(buscador->pilha,
+                                                 buscador->capacidadePilha * sizeof(uint64_t));
+            if (buscador->pilha == NULL) {
+                printf("Erro de alocação de memória!\n");
+                exit(1);
+            }
+        }
+        buscador->pilha[topo++] = (uint64_t)no << 1 | 1;
+
+        uint32_t direito = resolvedor->nos[no].direita;
+        uint32_t esquerdo = resolvedor->nos[no].esquerda;
+        if (direito != SEM_INDICE) {
+            if (esquerdo != SEM_INDICE && resolvedor->profundidade[no] < PROFUNDIDADE_MAXIMA_DIVISAO &&
+                atomic_load_explicit(&resolvedor->ociosos, memory_order_relaxed) > 0) {
+                atomic_fetch_add(&resolvedor->pendentes, 1);
+                empurrarTarefa(&buscador->tarefas, direito);
+            } else {
+                buscador->pilha[topo++] = (uint64_t)direito << 1;
+            }
+        }
+        if (esquerdo != SEM_INDICE) buscador->pilha[topo++] = (uint64_t)esquerdo << 1;
+    }
+
+    for (uint32_t no = resolvedor->pai[raiz]; no != SEM_INDICE; no = resolvedor->pai[no]) {
+        sairDoCaminho(buscador, no);
+    }
+}
+
+/**
+ * @brief Laço de um buscador: executa tarefas próprias ou roubadas até não
+ *        restar nenhuma em nenhuma deque
+ * @param argumento Ponteiro para o BuscadorRota
+ * @return NULL
+ */
+void* executarBuscador(void* argumento) {
+    BuscadorRota* buscador = (BuscadorRota*)argumento;
+    Resolvedor* resolvedor = buscador->resolvedor;
+    int ocioso = 0;
+
+    for (;;) {
+        uint32_t tarefa;
+        int encontrada = retirarTarefa(&buscador->tarefas, &tarefa);
+        for (int i = 1; !encontrada && i < buscador->numBuscadores; i++) {
+            int vitima = (buscador->id + i) % buscador->numBuscadores;
+            encontrada = roubarTarefa(&buscador->vizinhos[vitima].tarefas, &tarefa);
+            if (encontrada) buscador->roubos++;
+        }
+
+        if (encontrada) {
+            if (ocioso) {
+                atomic_fetch_sub(&resolvedor->ociosos, 1);
+                ocioso = 0;
+            }
+            explorarTarefa(buscador, tarefa);
+            atomic_fetch_sub(&resolvedor->pendentes, 1);
+        } else {
+            if (atomic_load(&resolvedor->pendentes) == 0) break;
+            if (!ocioso) {
+                atomic_fetch_add(&resolvedor->ociosos, 1);
+                ocioso = 1;
+            }
+#ifndef _WIN32
+            sched_yield();
+#endif
+        }
+    }
+    if (ocioso) atomic_fetch_sub(&resolvedor->ociosos, 1);
+    return NULL;
+}
+
+/**
+ * @brief Escreve a rota mínima de um suspeito como comandos E/D/C
+ *
+ * Sobe do cômodo final até a entrada pelos pais e percorre o caminho de
+ * volta, coletando só as primeiras pistas distintas contra o suspeito.
+ *
+ * @param resolvedor Resolvedor após a busca
+ * @param suspeito ID do suspeito
+ * @param rota Destino (profundidade + PISTAS_PARA_SUSTENTAR + 1 bytes)
+ * @return Tamanho da rota, ou 0 se o suspeito não tem rota
+ */
+size_t montarRota(const Resolvedor* resolvedor, uint32_t suspeito, char* rota) {
+    uint64_t melhor = atomic_load(&resolvedor->melhores[suspeito]);
+    if (melhor == UINT64_MAX) return 0;
+    uint32_t alvo = (uint32_t)melhor;
+    uint32_t profundidade = resolvedor->profundidade[alvo];
+
+    uint32_t* caminho = (uint32_t*)malloc(((size_t)profundidade + 1) * sizeof(uint32_t));
+    if (caminho == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    for (uint32_t no = alvo, i = profundidade + 1; no != SEM_INDICE; no = resolvedor->pai[no]) {
+        caminho[--i] = no;
+    }
+
+    const Caso* caso = resolvedor->caso;
+    uint32_t coletadas[PISTAS_PARA_SUSTENTAR];
+    uint32_t numColetadas = 0;
+    size_t tamanho = 0;
+    for (uint32_t i = 0; i <= profundidade; i++) {
+        uint32_t pista = resolvedor->nos[caminho[i]].pista;
+        if (pista != SEM_INDICE && caso->suspeitoDaPista[pista] == suspeito &&
+            numColetadas < PISTAS_PARA_SUSTENTAR) {
+            uint32_t j = 0;
+            while (j < numColetadas && coletadas[j] != pista) j++;
+            if (j == numColetadas) {
+                coletadas[numColetadas++] = pista;
+                rota[tamanho++] = 'C';
+            }
+        }
+        if (i < profundidade) {
+            rota[tamanho++] = caminho[i + 1] == resolvedor->nos[caminho[i]].esquerda ? 'E' : 'D';
+        }
+    }
+    rota[tamanho] = '\0';
+    free(caminho);
+    return tamanho;
+}
+
+/**
+ * @brief Confere uma rota jogando-a numa sessão de verdade
+ * @param caso Caso resolvido
+ * @param suspeito ID do suspeito acusado ao final
+ * @param rota Comandos E/D/C
+ * @return 1 se a acusação termina sustentada
+ */
+int conferirRota(const Caso* caso, uint32_t suspeito, const char* rota) {
+    Sessao sessao;
+    iniciarSessao(&sessao, caso);
+    for (const char* c = rota; *c != '\0'; c++) {
+        aplicarComando(&sessao, *c);
+    }
+    aplicarComando(&sessao, 'S');
+    int sustentada = acusarSuspeito(&sessao, caso->suspeitos.textos[suspeito]) ==
+                     VEREDICTO_SUSTENTADA;
+    liberarSessao(&sessao);
+    return sustentada;
+}
+
+/**
+ * @brief Modo --resolver: rota mínima até a acusação sustentada de cada suspeito
+ *
+ * A busca começa com uma única tarefa (a entrada) na deque do primeiro
+ * buscador; os demais ficam ociosos até que ele ceda subárvores. Cada rota
+ * encontrada é conferida numa sessão antes de ser exibida. A busca só segue
+ * as saídas E/D: num caso com passagens, o resolvedor avisa que as rotas
+ * podem não ser as menores e que cômodos alcançados só por passagens ficam
+ * de fora.
+ *
+ * @param caso Caso a resolver
+ * @param numBuscadores Threads da busca (1 sem pthreads)
+ * @return 1 se ao menos um suspeito pode ser acusado com sucesso
+ */
+int resolverCaso(const Caso* caso, int numBuscadores) {
+#ifdef _WIN32
+    numBuscadores = 1;
+#endif
+    if (caso->mansao.numPassagens > 0) {
+        fprintf(stderr, "⚠️  O caso tem %u passagens, mas o resolvedor só segue as saídas E/D: "
+                "as rotas podem não ser as menores, e cômodos alcançados só por passagens "
+                "ficam de fora\n", caso->mansao.numPassagens);
+    }
+    double inicio = agoraEmSegundos();
+    Resolvedor resolvedor;
+    prepararResolvedor(&resolvedor, caso);
+    double preparado = agoraEmSegundos();
+
+    BuscadorRota* buscadores = (BuscadorRota*)calloc((size_t)numBuscadores, sizeof(BuscadorRota));
+    if (buscadores == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    for (int i = 0; i < numBuscadores; i++) {
+        BuscadorRota* buscador = &buscadores[i];
+        buscador->resolvedor = &resolvedor;
+        buscador->id = i;
+        buscador->numBuscadores = numBuscadores;
+        buscador->vizinhos = buscadores;
+        buscador->ocorrencias = (uint32_t*)calloc((size_t)caso->pistas.quantidade + 1,
+                                                  sizeof(uint32_t));
+        buscador->contagens = (uint32_t*)calloc((size_t)caso->suspeitos.quantidade + 1,
+                                                sizeof(uint32_t));
+        buscador->maximos = (uint32_t*)calloc((size_t)caso->suspeitos.quantidade + 1,
+                                              sizeof(uint32_t));
+        buscador->capacidadePilha = 256;
+        buscador->pilha = (uint64_t*)malloc(buscador->capacidadePilha * sizeof(uint64_t));
+        if (buscador->ocorrencias == NULL || buscador->contagens == NULL ||
+            buscador->maximos == NULL || buscador->pilha == NULL) {
+            printf("Erro de alocação de memória!\n");
+            exit(1);
+        }
+        inicializarDeque(&buscador->tarefas);
+    }
+
+    if (resolvedor.numNos > 0) {
+        atomic_store(&resolvedor.pendentes, 1);
+        empurrarTarefa(&buscadores[0].tarefas, 0);
+    }
+#ifndef _WIN32
+    for (int i = 1; i < numBuscadores; i++) {
+        pthread_create(&buscadores[i].thread, NULL, executarBuscador, &buscadores[i]);
+    }
+#endif
+    executarBuscador(&buscadores[0]);
+#ifndef _WIN32
+    for (int i = 1; i < numBuscadores; i++) {
+        pthread_join(buscadores[i].thread, NULL);
+    }
+#endif
+    double fim = agoraEmSegundos();
+
+    // Os máximos só são exatos para suspeitos sem rota: a poda nunca
+    // descarta uma subárvore com pistas contra eles
+    unsigned long long visitados = 0, roubos = 0;
+    for (int i = 0; i < numBuscadores; i++) {
+        visitados += buscadores[i].visitados;
+        roubos += buscadores[i].roubos;
+        for (uint32_t s = 0; i > 0 && s < caso->suspeitos.quantidade; s++) {
+            if (buscadores[i].maximos[s] > buscadores[0].maximos[s]) {
+                buscadores[0].maximos[s] = buscadores[i].maximos[s];
+            }
+        }
+    }
+
+    printf("🧭 ROTAS MÍNIMAS ATÉ A ACUSAÇÃO SUSTENTADA (%d+ pistas)\n", PISTAS_PARA_SUSTENTAR);
+    printf("   %u cômodos, %d buscadores: preparo %.2f ms, busca %.2f ms, "
+           "%llu cômodos visitados, %llu roubos\n",
+           resolvedor.numNos, numBuscadores, (preparado - inicio) * 1000.0,
+           (fim - preparado) * 1000.0, visitados, roubos);
+
+    int solucionaveis = 0, sucesso = 1;
+    for (uint32_t s = 0; s < caso->suspeitos.quantidade; s++) {
+        uint64_t melhor = atomic_load(&resolvedor.melhores[s]);
+        if (melhor == UINT64_MAX) {
+            printf("   %-12s sem rota (no máximo %u pistas num mesmo caminho)\n",
+                   caso->suspeitos.textos[s], buscadores[0].maximos[s]);
+            continue;
+        }
+        char* rota = (char*)malloc((size_t)(melhor >> 32) + PISTAS_PARA_SUSTENTAR + 1);
+        if (rota == NULL) {
+            printf("Erro de alocação de memória!\n");
+            exit(1);
+        }
+        size_t tamanho = montarRota(&resolvedor, s, rota);
+        int conferida = conferirRota(caso, s, rota);
+        printf("   %-12s %zu comandos: %s%s\n", caso->suspeitos.textos[s], tamanho, rota,
+               conferida ? "" : "  ❌ não confere");
+        if (!conferida) sucesso = 0;
+        solucionaveis++;
+        free(rota);
+    }
+
+    if (solucionaveis == 0) {
+        printf("❌ Nenhum suspeito pode ser acusado com sucesso neste caso%s\n",
+               caso->mansao.numPassagens > 0 ? " só pelas saídas E/D" : "");
+    }
+    for (int i = 0; i < numBuscadores; i++) {
+        free(buscadores[i].ocorrencias);
+        free(buscadores[i].contagens);
+        free(buscadores[i].maximos);
+        free(buscadores[i].pilha);
+        liberarDeque(&buscadores[i].tarefas);
+    }
+    free(buscadores);
+    liberarResolvedor(&resolvedor);
+    return sucesso && solucionaveis > 0;
+}
+
+// ========== FUNÇÕES DO SIMULADOR DE JOGADORES ==========
+
+/**
+ * @brief Deriva a semente de um bloco de passeios (etapa do SplitMix64)
+ * @param semente Semente da simulação
+ * @param bloco Índice do bloco
+ * @return Estado inicial do gerador do bloco (nunca zero)
+ */
+uint64_t sementeDoBloco(uint64_t semente, unsigned long long bloco) {
+    uint64_t z = semente + (bloco + 1) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    return z ? z : 1;
+}
+
+/**
+ * @brief Sorteia um inteiro em [0, limite) sem divisão
+ * @param estado Estado do gerador
+ * @param limite Quantidade de valores possíveis (maior que zero)
+ * @return Valor sorteado
+ */
+uint32_t sortearAte(uint64_t* estado, uint32_t limite) {
+    return (uint32_t)(((proximoAleatorio(estado) >> 32) * limite) >> 32);
+}
+
+/**
+ * @brief Joga uma sessão inteira com um jogador simulado, sem nenhuma saída
+ *
+ * O jogador aleatório sorteia C, E, D ou S (a saída com chance 1/7) e acusa
+ * um suspeito qualquer. O heurístico coleta toda pista nova, sai assim que o
+ * líder do placar tem pistas para a acusação sustentada ou num beco sem
+ * saída, desce para um lado sorteado e acusa o líder. Passeios que chegam a
+ * MAX_COMANDOS_SIMULACAO - 1 comandos são encerrados com S.
+ *
+ * @param sessao Sessão já iniciada; é reiniciada aqui
+ * @param perfil Perfil do jogador
+ * @param estado Estado do gerador da thread
+ * @param comandos Recebe os comandos aplicados, incluindo a saída
+ * @return Veredicto da sessão
+ */
+Veredicto simularPasseio(Sessao* sessao, PerfilJogador perfil, uint64_t* estado,
+                         uint32_t* comandos) {
+    const Caso* caso = sessao->caso;
+    uint32_t usados = 0;
+    reiniciarSessao(sessao);
+
+    while (sessao->estado == SESSAO_EXPLORANDO && usados < MAX_COMANDOS_SIMULACAO - 1) {
+        char comando;
+        if (perfil == PERFIL_ALEATORIO) {
+            uint32_t sorteio = sortearAte(estado, 7);
+            comando = sorteio == 0 ? 'S' : "CED"[(sorteio - 1) % 3];
+        } else {
+            const NoMansao* no = salaDaMansao(&caso->mansao, sessao->salaAtual);
+            uint32_t lider = suspeitoNaPosicao(&sessao->placar, 0);
+            if (no->pista != SEM_INDICE && !buscarPista(&sessao->caderno, no->pista)) {
+                comando = 'C';
+            } else if (lider != SEM_INDICE &&
+                       pistasContraSuspeito(&sessao->placar, lider) >= PISTAS_PARA_SUSTENTAR) {
+                comando = 'S';
+            } else if (no->esquerda == SEM_INDICE && no->direita == SEM_INDICE) {
+                comando = 'S';
+            } else if (no->esquerda == SEM_INDICE || no->direita == SEM_INDICE) {
+                comando = no->esquerda == SEM_INDICE ? 'D' : 'E';
+            } else {
+                comando = sortearAte(estado, 2) ? 'D' : 'E';
+            }
+        }
+        aplicarComando(sessao, comando);
+        usados++;
+    }
+    if (sessao->estado == SESSAO_EXPLORANDO) {
+        aplicarComando(sessao, 'S');
+        usados++;
+    }
+
+    if (sessao->estado == SESSAO_AGUARDANDO_ACUSACAO) {
+        uint32_t acusado = perfil == PERFIL_HEURISTICO ? suspeitoNaPosicao(&sessao->placar, 0)
+                                                       : SEM_INDICE;
+        if ((acusado == SEM_INDICE || pistasContraSuspeito(&sessao->placar, acusado) == 0) &&
+            caso->suspeitos.quantidade > 0) {
+            acusado = sortearAte(estado, caso->suspeitos.quantidade);
+        }
+        acusarSuspeito(sessao, acusado != SEM_INDICE ? caso->suspeitos.textos[acusado] : "");
+    }
+    *comandos = usados;
+    return sessao->veredicto;
+}
+
+/**
+ * @brief Thread do simulador: pega blocos de passeios até acabarem
+ *
+ * A única operação compartilhada é o contador de blocos, uma vez a cada
+ * PASSEIOS_POR_BLOCO passeios; sessão, gerador e histogramas são da thread.
+ *
+ * @param argumento SimuladorJogador da thread
+ * @return NULL
+ */
+void* executarSimulador(void* argumento) {
+    SimuladorJogador* simulador = (SimuladorJogador*)argumento;
+    Simulacao* simulacao = simulador->simulacao;
+
+    // Reservados pela própria thread, longe dos contadores das demais
+    simulador->histogramas = (HistogramaSimulacao*)calloc(NUM_PERFIS,
+                                                          sizeof(HistogramaSimulacao));
+    if (simulador->histogramas == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    Sessao sessao;
+    iniciarSessao(&sessao, simulacao->caso);
+
+    for (;;) {
+        unsigned long long bloco = atomic_fetch_add(&simulacao->proximoBloco, 1);
+        unsigned long long inicio = bloco * PASSEIOS_POR_BLOCO;
+        if (inicio >= simulacao->numPasseios) break;
+        unsigned long long fim = inicio + PASSEIOS_POR_BLOCO;
+        if (fim > simulacao->numPasseios) fim = simulacao->numPasseios;
+
+        uint64_t estado = sementeDoBloco(simulacao->semente, bloco);
+        for (unsigned long long i = inicio; i < fim; i++) {
+            for (int perfil = 0; perfil < NUM_PERFIS; perfil++) {
+                uint32_t comandos;
+                Veredicto veredicto = simularPasseio(&sessao, (PerfilJogador)perfil, &estado,
+                                                     &comandos);
+                simulador->histogramas[perfil].veredictos[veredicto]++;
+                simulador->histogramas[perfil].comandos[comandos]++;
+            }
+        }
+        simulador->blocos++;
+    }
+
+    liberarSessao(&sessao);
+    return NULL;
+}
+
+/**
+ * @brief Mostra a distribuição de veredictos e de comandos de um perfil
+ * @param histograma Histograma já somado de todas as threads
+ * @param perfil Nome do perfil
+ */
+void exibirHistograma(const HistogramaSimulacao* histograma, const char* perfil) {
+    unsigned long long total = 0, somaComandos = 0;
+    for (uint32_t c = 0; c <= MAX_COMANDOS_SIMULACAO; c++) {
+        total += histograma->comandos[c];
+        somaComandos += histograma->comandos[c] * c;
+    }
+    printf("\n👤 Jogador %s (%llu passeios)\n", perfil, total);
+    if (total == 0) return;
+
+    for (int v = VEREDICTO_SUSTENTADA; v >= VEREDICTO_ARQUIVADO; v--) {
+        printf("   %-11s %12llu  %6.2f%%\n", nomeVeredicto((Veredicto)v),
+               histograma->veredictos[v], 100.0 * (double)histograma->veredictos[v] / (double)total);
+    }
+
+    // Percentis lidos do histograma acumulado
+    const double fracoes[] = {0.50, 0.90, 0.99};
+    uint32_t percentis[3] = {0, 0, 0}, maximo = 0;
+    unsigned long long acumulado = 0;
+    int proximo = 0;
+    for (uint32_t c = 0; c <= MAX_COMANDOS_SIMULACAO; c++) {
+        if (histograma->comandos[c] == 0) continue;
+        acumulado += histograma->comandos[c];
+        maximo = c;
+        while (proximo < 3 && (double)acumulado >= fracoes[proximo] * (double)total) {
+            percentis[proximo++] = c;
+        }
+    }
+    printf("   comandos: média %.2f, p50 %u, p90 %u, p99 %u, máximo %u\n",
+           (double)somaComandos / (double)total, percentis[0], percentis[1], percentis[2],
+           maximo);
+}
+
+/**
+ * @brief Simula jogadores aleatórios e heurísticos e mostra os veredictos
+ *
+ * Cada passeio é jogado pela mesma lógica de sessão do jogo
+ * (aplicarComando, coletarPista, acusarSuspeito), sem terminal. As threads
+ * (POSIX) dividem os blocos de passeios e somam seus histogramas no final;
+ * a mesma semente dá o mesmo resultado com qualquer número de threads.
+ *
+ * @param caso Caso compartilhado, somente leitura
+ * @param numPasseios Passeios por perfil
+ * @param numThreads Threads simuladoras
+ * @param semente Semente da simulação
+ * @return 1 (a simulação sempre termina)
+ */
+int simularJogadores(const Caso* caso, unsigned long long numPasseios, int numThreads,
+                     uint64_t semente) {
+#ifdef _WIN32
+    numThreads = 1;
+#endif
+    Simulacao simulacao;
+    simulacao.caso = caso;
+    simulacao.numPasseios = numPasseios;
+    simulacao.semente = semente;
+    atomic_init(&simulacao.proximoBloco, 0);
+
+    SimuladorJogador* simuladores = (SimuladorJogador*)calloc((size_t)numThreads,
+                                                              sizeof(SimuladorJogador));
+    if (simuladores == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    for (int i = 0; i < numThreads; i++) {
+        simuladores[i].simulacao = &simulacao;
+    }
+
+    double inicio = agoraEmSegundos();
+#ifndef _WIN32
+    for (int i = 1; i < numThreads; i++) {
+        pthread_create(&simuladores[i].thread, NULL, executarSimulador, &simuladores[i]);
+    }
+#endif
+    executarSimulador(&simuladores[0]);
+#ifndef _WIN32
+    for (int i = 1; i < numThreads; i++) {
+        pthread_join(simuladores[i].thread, NULL);
+    }
+#endif
+    double segundos = agoraEmSegundos() - inicio;
+
+    HistogramaSimulacao totais[NUM_PERFIS];
+    memset(totais, 0, sizeof(totais));
+    for (int i = 0; i < numThreads; i++) {
+        for (int perfil = 0; perfil < NUM_PERFIS; perfil++) {
+            const HistogramaSimulacao* parcial = &simuladores[i].histogramas[perfil];
+            for (int v = 0; v <= VEREDICTO_SUSTENTADA; v++) {
+                totais[perfil].veredictos[v] += parcial->veredictos[v];
+            }
+            for (uint32_t c = 0; c <= MAX_COMANDOS_SIMULACAO; c++) {
+                totais[perfil].comandos[c] += parcial->comandos[c];
+            }
+        }
+    }
+
+    unsigned long long passeios = numPasseios * NUM_PERFIS;
+    printf("🎲 SIMULAÇÃO DE JOGADORES (semente %llu)\n", (unsigned long long)semente);
+    printf("   %u cômodos, %d threads: %llu passeios em %.3f s (%.0f passeios/s)\n",
+           caso->mansao.numSalas, numThreads, passeios, segundos,
+           segundos > 0 ? (double)passeios / segundos : 0.0);
+    exibirHistograma(&totais[PERFIL_ALEATORIO], "aleatório");
+    exibirHistograma(&totais[PERFIL_HEURISTICO], "heurístico");
+
+    for (int i = 0; i < numThreads; i++) {
+        free(simuladores[i].histogramas);
+    }
+    free(simuladores);
+    return 1;
+}
+
+// ========== FUNÇÕES PARA O PLACAR DE EVIDÊNCIAS ==========
+
+/**
+ * @brief Prepara um placar zerado para os suspeitos do caso
+ * @param placar Placar a ser inicializado
+ * @param numSuspeitos Quantidade de suspeitos do caso
+ * @param pontuacaoMaxima Maior contagem possível (Caso.pontuacaoMaxima)
+ * @param arena Arena da sessão, dona dos vetores do placar
+ */
+void inicializarPlacar(PlacarSuspeitos* placar, uint32_t numSuspeitos, uint32_t pontuacaoMaxima,
+                       Arena* arena) {
+    size_t bytesSuspeitos = (numSuspeitos + 1) * sizeof(uint32_t);
+    placar->contagens = (uint32_t*)alocarNaArena(arena, bytesSuspeitos);
+    placar->ranking = (uint32_t*)alocarNaArena(arena, bytesSuspeitos);
+    placar->posicao = (uint32_t*)alocarNaArena(arena, bytesSuspeitos);
+    placar->inicioFaixa = (uint32_t*)alocarNaArena(arena, ((size_t)pontuacaoMaxima + 2) * sizeof(uint32_t));
+    placar->numSuspeitos = numSuspeitos;
+
+    // Todos começam com zero pistas, em uma única faixa iniciada na posição 0
+    for (uint32_t i = 0; i < numSuspeitos; i++) {
+        placar->contagens[i] = 0;
+        placar->ranking[i] = i;
+        placar->posicao[i] = i;
+    }
+    placar->inicioFaixa[0] = 0;
+}
+
+/**
+ * @brief Soma uma evidência contra o suspeito e mantém o ranking ordenado
+ *
+ * Cada ponto de peso é um passo O(1); o peso é no máximo MAX_PESO_EVIDENCIA.
+ *
+ * @param placar Placar da sessão
+ * @param suspeito ID do suspeito apontado pela pista
+ * @param peso Peso da evidência (1 para pistas simples)
+ */
+void registrarEvidencia(PlacarSuspeitos* placar, uint32_t suspeito, uint32_t peso) {
+    for (uint32_t passo = 0; passo < peso; passo++) {
+        uint32_t contagem = placar->contagens[suspeito];
+        uint32_t atual = placar->posicao[suspeito];
+        uint32_t primeira = placar->inicioFaixa[contagem];
+
+        // Troca o suspeito com o primeiro da sua faixa; ao subir um ponto, ele
+        // passa a ser o último da faixa acima, sem quebrar a ordem do ranking
+        uint32_t outro = placar->ranking[primeira];
+        placar->ranking[primeira] = suspeito;
+        placar->ranking[atual] = outro;
+        placar->posicao[suspeito] = primeira;
+        placar->posicao[outro] = atual;
+
+        placar->inicioFaixa[contagem] = primeira + 1;
+        placar->contagens[suspeito] = contagem + 1;
+        if (primeira == 0 ||
+            placar->contagens[placar->ranking[primeira - 1]] != contagem + 1) {
+            placar->inicioFaixa[contagem + 1] = primeira;
+        }
+    }
+}
+
+/**
+ * @brief Consulta quantas pistas coletadas apontam para o suspeito
+ * @param placar Placar da sessão
+ * @param suspeito ID do suspeito
+ * @return Número de pistas contra o suspeito
+ */
+uint32_t pistasContraSuspeito(const PlacarSuspeitos* placar, uint32_t suspeito) {
+    return placar->contagens[suspeito];
+}
+
+/**
+ * @brief Retorna o suspeito em uma posição do ranking de evidências
+ * @param placar Placar da sessão
+ * @param posicao Posição no ranking (0 é o mais provável)
+ * @return ID do suspeito ou SEM_INDICE se a posição não existe
+ */
+uint32_t suspeitoNaPosicao(const PlacarSuspeitos* placar, uint32_t posicao) {
+    return posicao < placar->numSuspeitos ? placar->ranking[posicao] : SEM_INDICE;
+}
+
+/**
+ * @brief Devolve ao placar a ordem de um ranking guardado
+ *
+ * Refazer as mesmas pistas em outra ordem dá as mesmas contagens, mas pode
+ * trocar de lugar suspeitos empatados; com o ranking de antes, os empates
+ * voltam à ordem em que estavam. As faixas não mudam, pois dependem só das
+ * contagens.
+ *
+ * @param placar Placar com as mesmas contagens de quando o ranking foi guardado
+ * @param ranking IDs dos suspeitos na ordem guardada
+ */
+void restaurarRankingPlacar(PlacarSuspeitos* placar, const uint32_t* ranking) {
+    for (uint32_t i = 0; i < placar->numSuspeitos; i++) {
+        placar->ranking[i] = ranking[i];
+        placar->posicao[ranking[i]] = i;
+    }
+}
+
+/**
+ * @brief Mostra os k suspeitos com mais evidências coletadas
+ * @param tela Tela de saída
+ * @param placar Placar da sessão
+ * @param caso Caso em andamento (nomes dos suspeitos)
+ * @param k Quantidade máxima de suspeitos exibidos
+ */
+void exibirPalpite(Tela* tela, const PlacarSuspeitos* placar, const Caso* caso, uint32_t k) {
+    escreverTela(tela, "\n💡 PALPITE DO ASSISTENTE:\n");
+    if (placar->numSuspeitos == 0 || placar->contagens[placar->ranking[0]] == 0) {
+        escreverTela(tela, "Ainda não há evidências contra ninguém.\n");
+        return;
+    }
+
+    for (uint32_t i = 0; i < k && i < placar->numSuspeitos; i++) {
+        uint32_t suspeito = placar->ranking[i];
+        if (placar->contagens[suspeito] == 0) break;
+        escreverTela(tela, "%u. %s — %u pista(s)\n", i + 1, caso->suspeitos.textos[suspeito],
+                     placar->contagens[suspeito]);
+    }
+}
+
+// ========== FUNÇÕES DA MATRIZ DE EVIDÊNCIAS ==========
+
+/**
+ * @brief Localiza as evidências detalhadas de uma pista (busca binária)
+ * @param caso Caso com as evidências ordenadas por pista
+ * @param pista ID da pista
+ * @param fim Recebe a posição depois da última evidência da pista
+ * @return Posição da primeira evidência (igual a *fim se a pista não tem nenhuma)
+ */
+uint32_t buscarEvidencias(const Caso* caso, uint32_t pista, uint32_t* fim) {
+    uint32_t inicio = 0, limite = caso->numEvidencias;
+    while (inicio < limite) {
+        uint32_t meio = inicio + (limite - inicio) / 2;
+        if (caso->evidencias[meio].pista < pista) inicio = meio + 1;
+        else limite = meio;
+    }
+    
+    uint32_t ultima = inicio;
+    while (ultima < caso->numEvidencias && caso->evidencias[ultima].pista == pista) ultima++;
+    *fim = ultima;
+    return inicio;
+}
+
+/**
+ * @brief Soma ao placar as evidências de uma pista recém-coletada
+ *
+ * Sem evidências detalhadas a pista vale 1 contra o suspeito principal.
+ *
+ * @param placar Placar da sessão
+ * @param caso Caso em andamento
+ * @param pista ID da pista
+ */
+void registrarEvidenciasDaPista(PlacarSuspeitos* placar, const Caso* caso, uint32_t pista) {
+    uint32_t fim;
+    uint32_t i = buscarEvidencias(caso, pista, &fim);
+    if (i == fim) {
+        uint32_t suspeito = suspeitoDePista(caso, pista);
+        if (suspeito != SEM_INDICE) registrarEvidencia(placar, suspeito, 1);
+        return;
+    }
+    for (; i < fim; i++) {
+        registrarEvidencia(placar, caso->evidencias[i].suspeito, caso->evidencias[i].peso);
+    }
+}
+
+/**
+ * @brief Ordena evidências por pista e, na mesma pista, por suspeito
+ */
+int compararEvidencias(const void* a, const void* b) {
+    const RegistroEvidencia* x = (const RegistroEvidencia*)a;
+    const RegistroEvidencia* y = (const RegistroEvidencia*)b;
+    if (x->pista != y->pista) return (x->pista > y->pista) - (x->pista < y->pista);
+    return (x->suspeito > y->suspeito) - (x->suspeito < y->suspeito);
+}
+
+/**
+ * @brief Define a maior pontuação possível contra um suspeito do caso
+ *
+ * É o tamanho das faixas do placar: com pesos, passa do número de pistas.
+ *
+ * @param caso Caso carregado
+ * @param totais Por suspeito, as pistas sem evidências detalhadas que
+ *               apontam para ele (recebe também os pesos detalhados)
+ */
+void calcularPontuacaoMaxima(Caso* caso, uint32_t* totais) {
+    for (uint32_t i = 0; i < caso->numEvidencias; i++) {
+        totais[caso->evidencias[i].suspeito] += caso->evidencias[i].peso;
+    }
+    caso->pontuacaoMaxima = 0;
+    for (uint32_t s = 0; s < caso->suspeitos.quantidade; s++) {
+        if (totais[s] > caso->pontuacaoMaxima) caso->pontuacaoMaxima = totais[s];
+    }
+}
+
+/**
+ * @brief Fecha as evidências de um caso montado na memória
+ *
+ * Descarta as evidências substituídas (peso 0), ordena as demais, já com
+ * os IDs finais das pistas, e calcula a pontuação máxima.
+ *
+ * @param caso Caso com as pistas já em ordem alfabética
+ */
+void concluirEvidencias(Caso* caso) {
+    uint32_t usadas = 0;
+    for (uint32_t i = 0; i < caso->numEvidencias; i++) {
+        if (caso->evidencias[i].peso != 0) caso->evidencias[usadas++] = caso->evidencias[i];
+    }
+    caso->numEvidencias = usadas;
+    if (usadas > 1) {
+        qsort(caso->evidencias, usadas, sizeof(RegistroEvidencia), compararEvidencias);
+    }
+    
+    uint32_t* totais = (uint32_t*)calloc((size_t)caso->suspeitos.quantidade + 1, sizeof(uint32_t));
+    if (totais == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    for (uint32_t i = 0, j = 0; i < caso->pistas.quantidade; i++) {
+        if (j < usadas && caso->evidencias[j].pista == i) {
+            while (j < usadas && caso->evidencias[j].pista == i) j++;
+            continue;
+        }
+        if (caso->suspeitoDaPista[i] != SEM_INDICE) totais[caso->suspeitoDaPista[i]]++;
+    }
+    calcularPontuacaoMaxima(caso, totais);
+    free(totais);
+}
+
+/**
+ * @brief Monta a matriz de evidências de um caso carregado na memória
+ *
+ * Os planos são só os necessários para o maior peso do caso; sem
+ * evidências detalhadas há um plano, e a pontuação é um popcount.
+ *
+ * @param caso Caso carregado (não sob demanda)
+ * @param matriz Matriz a preencher (liberar com liberarMatrizEvidencias)
+ */
+void montarMatrizEvidencias(const Caso* caso, MatrizEvidencias* matriz) {
+    uint32_t maiorPeso = 1;
+    for (uint32_t i = 0; i < caso->numEvidencias; i++) {
+        if (caso->evidencias[i].peso > maiorPeso) maiorPeso = caso->evidencias[i].peso;
+    }
+    
+    uint32_t numSuspeitos = caso->suspeitos.quantidade;
+    matriz->numPalavras = (uint32_t)(((uint64_t)caso->pistas.quantidade + 63) / 64);
+    matriz->numPlanos = 32 - (uint32_t)__builtin_clz(maiorPeso);
+    matriz->numSuspeitos = numSuspeitos;
+    size_t porPalavra = (size_t)matriz->numPlanos * numSuspeitos;
+    matriz->bits = (uint64_t*)calloc((size_t)matriz->numPalavras * porPalavra + 1, sizeof(uint64_t));
+    if (matriz->bits == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    
+    uint32_t j = 0;
+    for (uint32_t pista = 0; pista < caso->pistas.quantidade; pista++) {
+        uint64_t bit = 1ull << (pista & 63);
+        uint64_t* linha = matriz->bits + (size_t)(pista >> 6) * porPalavra;
+        if (j < caso->numEvidencias && caso->evidencias[j].pista == pista) {
+            for (; j < caso->numEvidencias && caso->evidencias[j].pista == pista; j++) {
+                const RegistroEvidencia* evidencia = &caso->evidencias[j];
+                for (uint32_t p = 0; p < matriz->numPlanos; p++) {
+                    if ((evidencia->peso >> p) & 1) linha[p * numSuspeitos + evidencia->suspeito] |= bit;
+                }
+            }
+        } else if (caso->suspeitoDaPista[pista] != SEM_INDICE) {
+            linha[caso->suspeitoDaPista[pista]] |= bit;
+        }
+    }
+}
+
+/**
+ * @brief Libera a matriz de evidências
+ * @param matriz Matriz montada por montarMatrizEvidencias
+ */
+void liberarMatrizEvidencias(MatrizEvidencias* matriz) {
+    free(matriz->bits);
+    memset(matriz, 0, sizeof(MatrizEvidencias));
+}
+
+/**
+ * @brief Prepara um caderno esparso vazio
+ * @param caderno Caderno a iniciar
+ */
+void inicializarBitsCaderno(BitsCaderno* caderno) {
+    memset(caderno, 0, sizeof(BitsCaderno));
+}
+
+/**
+ * @brief Acrescenta uma palavra não vazia ao fim do caderno esparso
+ * @param caderno Caderno esparso
+ * @param posicao Índice da palavra, maior que o da anterior
+ * @param palavra Bits das pistas coletadas nessa palavra
+ */
+void acrescentarPalavraCaderno(BitsCaderno* caderno, uint32_t posicao, uint64_t palavra) {
+    if (caderno->quantidade == caderno->capacidade) {
+        caderno->capacidade = caderno->capacidade ? caderno->capacidade * 2 : 16;
+        caderno->posicoes = (uint32_t*)realloc(caderno->posicoes,
+                                               caderno->capacidade * sizeof(uint32_t));
+        caderno->palavras = (uint64_t*)realloc(caderno->palavras,
+                                               caderno->capacidade * sizeof(uint64_t));
+        if (caderno->posicoes == NULL || caderno->palavras == NULL) {
+            printf("Erro de alocação de memória!\n");
+            exit(1);
+        }
+    }
+    caderno->posicoes[caderno->quantidade] = posicao;
+    caderno->palavras[caderno->quantidade++] = palavra;
+}
+
+/**
+ * @brief Converte IDs de pistas em ordem crescente num caderno esparso
+ * @param caderno Caderno esparso (o conteúdo anterior é descartado)
+ * @param pistas IDs em ordem crescente
+ * @param quantidade Quantidade de IDs
+ */
+void montarBitsCaderno(BitsCaderno* caderno, const uint32_t* pistas, uint32_t quantidade) {
+    caderno->quantidade = 0;
+    for (uint32_t i = 0; i < quantidade; ) {
+        uint32_t posicao = pistas[i] >> 6;
+        uint64_t palavra = 0;
+        for (; i < quantidade && (pistas[i] >> 6) == posicao; i++) palavra |= 1ull << (pistas[i] & 63);
+        acrescentarPalavraCaderno(caderno, posicao, palavra);
+    }
+}
+
+/**
+ * @brief Libera os vetores de um caderno esparso
+ * @param caderno Caderno esparso
+ */
+void liberarBitsCaderno(BitsCaderno* caderno) {
+    free(caderno->posicoes);
+    free(caderno->palavras);
+    inicializarBitsCaderno(caderno);
+}
+
+/**
+ * @brief Pontua todos os suspeitos contra vários cadernos de uma vez
+ *
+ * A matriz é percorrida uma vez, em trechos de BYTES_BLOCO_PONTUACAO; cada
+ * trecho é usado por todos os cadernos antes do seguinte, então continua na
+ * cache enquanto eles são pontuados. Dentro de uma palavra do caderno, o
+ * laço sobre os suspeitos lê memória contígua e não tem dependências, o que
+ * deixa o compilador vetorizá-lo com -march=native em processadores com
+ * popcount vetorial; sem isso, VERSOES_POPCOUNT garante ao menos o POPCNT.
+ *
+ * @param matriz Matriz de evidências do caso
+ * @param cadernos Cadernos esparsos (posições menores que matriz->numPalavras)
+ * @param numCadernos Quantidade de cadernos
+ * @param pontuacoes Recebe numCadernos × numSuspeitos pontuações, por caderno
+ */
+VERSOES_POPCOUNT
+void pontuarCadernos(const MatrizEvidencias* matriz, const BitsCaderno* cadernos,
+                     uint32_t numCadernos, uint32_t* pontuacoes) {
+    uint32_t numSuspeitos = matriz->numSuspeitos;
+    size_t porPalavra = (size_t)matriz->numPlanos * numSuspeitos;
+    memset(pontuacoes, 0, (size_t)numCadernos * numSuspeitos * sizeof(uint32_t));
+    if (porPalavra == 0 || numCadernos == 0) return;
+    
+    size_t porBloco = BYTES_BLOCO_PONTUACAO / (porPalavra * sizeof(uint64_t));
+    if (porBloco == 0) porBloco = 1;
+    uint32_t cursorUnico = 0;
+    uint32_t* cursores = numCadernos == 1 ? &cursorUnico
+                                          : (uint32_t*)calloc(numCadernos, sizeof(uint32_t));
+    if (cursores == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    
+    for (size_t inicio = 0; inicio < matriz->numPalavras; inicio += porBloco) {
+        size_t fim = inicio + porBloco;
+        for (uint32_t c = 0; c < numCadernos; c++) {
+            const BitsCaderno* caderno = &cadernos[c];
+            uint32_t* pontos = pontuacoes + (size_t)c * numSuspeitos;
+            uint32_t i = cursores[c];
+            for (; i < caderno->quantidade && caderno->posicoes[i] < fim; i++) {
+                uint64_t palavra = caderno->palavras[i];
+                const uint64_t* linha = matriz->bits + caderno->posicoes[i] * porPalavra;
+                for (uint32_t p = 0; p < matriz->numPlanos; p++, linha += numSuspeitos) {
+                    for (uint32_t s = 0; s < numSuspeitos; s++) {
+                        pontos[s] += (uint32_t)__builtin_popcountll(palavra & linha[s]) << p;
+                    }
+                }
+            }
+            cursores[c] = i;
+        }
+    }
+    if (cursores != &cursorUnico) free(cursores);
+}
+
+// ========== FUNÇÕES PARA ARQUIVOS DE CASO ==========
+
+// Suspeitos do caso embutido da Mansão Blackwood: nome e descrição
+static const char* const SUSPEITOS_PADRAO[][2] = {
+    {"ana", "Ana - A herdeira desfavorecida"},
+    {"bruno", "Bruno - O mordomo leal"},
+    {"carlos", "Carlos - O sócio traído"},
+    {"diana", "Diana - A rival de negócios"},
+    {"eduardo", "Eduardo - O filho pródigo"}
+};
+
+/**
+ * @brief Monta o caso embutido da Mansão Blackwood (usado sem arquivo de caso)
+ *
+ * Com a tabela perfeita compilada no programa, as pistas são internadas por
+ * ela; se a tabela não for deste caso, a montagem é refeita sem ela.
+ *
+ * @param caso Caso a ser preenchido
+ */
+void construirCasoPadrao(Caso* caso) {
+    const TabelaPerfeita* tabela = tabelaPerfeitaCompilada();
+    if (tabela != NULL && montarCasoPadrao(caso, tabela)) return;
+    if (tabela != NULL) liberarCaso(caso);
+    montarCasoPadrao(caso, NULL);
+}
+
+/**
+ * @brief Monta o caso embutido, internando as pistas pela tabela perfeita
+ *        dada ou pelo índice dinâmico
+ * @param caso Caso a ser preenchido
+ * @param tabela Tabela perfeita esperada (NULL: índice dinâmico)
+ * @return 1 em caso de sucesso, 0 se a tabela não é deste caso
+ */
+int montarCasoPadrao(Caso* caso, const TabelaPerfeita* tabela) {
+    memset(caso, 0, sizeof(Caso));
+    if (tabela != NULL) prepararCargaPerfeita(caso, tabela);
+
+    // 1. Constrói a mansão (árvore binária compilada para a forma compacta)
+    construirMansao(caso);
+
+    // 2. Cadastra os suspeitos (IDs na ordem da lista exibida)
+    for (size_t i = 0; i < sizeof(SUSPEITOS_PADRAO) / sizeof(SUSPEITOS_PADRAO[0]); i++) {
+        declararSuspeito(caso, SUSPEITOS_PADRAO[i][0], SUSPEITOS_PADRAO[i][1]);
+    }
+
+    // 3. Preenche a tabela de associações pista-suspeito
+
+    // Associações pré-definidas (pista → suspeito)
+    associarPista(caso,
+        "Uma carta rasgada com a assinatura 'A' parcialmente visível",
+        "ana");
+    associarPista(caso,
+        "Um livro sobre venenos com a página 13 marcada",
+        "diana");
+    associarPista(caso,
+        "Um copo quebrado com resíduos de um líquido roxo",
+        "bruno");
+    associarPista(caso,
+        "Extrato bancário mostrando uma grande transferência para 'Carlos'",
+        "carlos");
+    associarPista(caso,
+        "Uma luva de jardinagem manchada de terra vermelha",
+        "bruno");
+    associarPista(caso,
+        "Uma faca de chef ausente do estojo",
+        "carlos");
+    associarPista(caso,
+        "Um diário com a entrada do dia do crime apagada",
+        "eduardo");
+    associarPista(caso,
+        "Uma caixa com documentos antigos sobre herança familiar",
+        "ana");
+    associarPista(caso,
+        "Pegadas de sapato masculino tamanho 42 na lama",
+        "carlos");
+    associarPista(caso,
+        "Uma chave enferrujada com a inscrição 'Porão Secreto'",
+        "carlos");
+
+    // 4. Renumera as pistas para que a ordem dos IDs seja a alfabética
+    if (!concluirPistasDoCaso(caso)) return 0;
+    concluirEvidencias(caso);
+
+    caso->introducao = "O corpo foi encontrado na biblioteca. Boa sorte, detetive!";
+    caso->segredo = "O culpado real do caso é 'Carlos', com 4 pistas contra ele.\n"
+                    "Para resolver o caso, colete pelo menos 3 pistas!";
+    return 1;
+}
+
+/**
+ * @brief Interna o texto de uma pista do caso
+ * @param caso Caso em construção
+ * @param texto Texto da pista (vazio indica cômodo sem pista)
+ * @return ID da pista ou SEM_INDICE para texto vazio
+ */
+uint32_t internarPista(Caso* caso, const char* texto) {
+    if (texto[0] == '\0') return SEM_INDICE;
+    if (caso->pistasPerfeitas != NULL) return internarPistaPerfeita(caso, texto);
+
+    uint32_t id = internarTexto(&caso->pistas, texto);
+    if (id >= caso->capacidadePistas) {
+        uint32_t capacidade = caso->pistas.capacidade;
+        caso->suspeitoDaPista = (uint32_t*)realloc(caso->suspeitoDaPista,
+                                                   capacidade * sizeof(uint32_t));
+        if (caso->suspeitoDaPista == NULL) {
+            printf("Erro de alocação de memória!\n");
+            exit(1);
+        }
+        for (uint32_t i = caso->capacidadePistas; i < capacidade; i++) {
+            caso->suspeitoDaPista[i] = SEM_INDICE;
+        }
+        caso->capacidadePistas = capacidade;
+    }
+    return id;
+}
+
+/**
+ * @brief Interna o nome de um suspeito do caso
+ * @param caso Caso em construção
+ * @param nome Nome do suspeito (minúsculas)
+ * @return ID do suspeito
+ */
+uint32_t internarSuspeito(Caso* caso, const char* nome) {
+    uint32_t quantidadeAnterior = caso->suspeitos.quantidade;
+    uint32_t id = internarTexto(&caso->suspeitos, nome);
+    if (id >= caso->capacidadeSuspeitos) {
+        uint32_t capacidade = caso->suspeitos.capacidade;
+        caso->descricoesSuspeitos = (const char**)realloc((void*)caso->descricoesSuspeitos,
+                                                          capacidade * sizeof(const char*));
+        if (caso->descricoesSuspeitos == NULL) {
+            printf("Erro de alocação de memória!\n");
+            exit(1);
+        }
+        caso->capacidadeSuspeitos = capacidade;
+    }
+    if (caso->suspeitos.quantidade > quantidadeAnterior) {
+        caso->descricoesSuspeitos[id] = nome; // Sem descrição própria: exibe o nome
+    }
+    return id;
+}
+
+/**
+ * @brief Associa uma pista a um suspeito (a associação mais recente prevalece)
+ * @param caso Caso em construção
+ * @param pista Texto da pista
+ * @param suspeito Nome do suspeito
+ */
+void associarPista(Caso* caso, const char* pista, const char* suspeito) {
+    uint32_t idPista = internarPista(caso, pista);
+    if (idPista == SEM_INDICE) return;
+
+    uint32_t idSuspeito = internarSuspeito(caso, suspeito);
+    if (caso->suspeitoDaPista[idPista] == SEM_INDICE) {
+        caso->numAssociacoes++;
+    }
+    caso->suspeitoDaPista[idPista] = idSuspeito;
+}
+
+/**
+ * @brief Associa uma pista a um ou mais suspeitos, com pesos (a associação
+ *        mais recente prevalece)
+ *
+ * A lista tem o formato "suspeito[*peso],suspeito[*peso]...", e o primeiro
+ * é o suspeito principal. Um único suspeito com peso 1 é uma associação
+ * simples, sem evidências detalhadas. Os nomes são separados no próprio
+ * texto, como os demais campos do caso.
+ *
+ * @param caso Caso em construção
+ * @param pista Texto da pista
+ * @param lista Suspeitos e pesos, em minúsculas (o texto é modificado)
+ * @return NULL em caso de sucesso, ou a descrição do erro
+ */
+const char* associarEvidencias(Caso* caso, const char* pista, char* lista) {
+    uint32_t idPista = internarPista(caso, pista);
+    if (idPista == SEM_INDICE) return NULL;
+    
+    // Uma associação repetida substitui as evidências anteriores da pista;
+    // elas ficam com peso 0 e são descartadas por concluirEvidencias
+    if (caso->suspeitoDaPista[idPista] != SEM_INDICE) {
+        for (uint32_t i = 0; i < caso->numEvidencias; i++) {
+            if (caso->evidencias[i].pista == idPista) caso->evidencias[i].peso = 0;
+        }
+    }
+    
+    uint32_t inicio = caso->numEvidencias;
+    char* cursor = lista;
+    while (cursor != NULL) {
+        char* nome = cursor;
+        cursor = strchr(cursor, ',');
+        if (cursor != NULL) *cursor++ = '\0';
+        
+        long peso = 1;
+        char* marca = strchr(nome, '*');
+        if (marca != NULL) {
+            char* fim;
+            *marca = '\0';
+            peso = strtol(marca + 1, &fim, 10);
+            if (fim == marca + 1 || *fim != '\0' || peso < 1 || peso > MAX_PESO_EVIDENCIA) {
+                caso->numEvidencias = inicio;
+                return "peso de evidência inválido";
+            }
+        }
+        if (nome[0] == '\0') {
+            caso->numEvidencias = inicio;
+            return "suspeito vazio na pista";
+        }
+        
+        uint32_t idSuspeito = internarSuspeito(caso, nome);
+        for (uint32_t i = inicio; i < caso->numEvidencias; i++) {
+            if (caso->evidencias[i].suspeito == idSuspeito) {
+                caso->numEvidencias = inicio;
+                return "suspeito repetido na pista";
+            }
+        }
+        if (caso->numEvidencias == caso->capacidadeEvidencias) {
+            caso->capacidadeEvidencias = caso->capacidadeEvidencias ? caso->capacidadeEvidencias * 2 : 64;
+            caso->evidencias = (RegistroEvidencia*)realloc(
+                caso->evidencias, caso->capacidadeEvidencias * sizeof(RegistroEvidencia));
+            if (caso->evidencias == NULL) {
+                printf("Erro de alocação de memória!\n");
+                exit(1);
+            }
+        }
+        caso->evidencias[caso->numEvidencias++] =
+            (RegistroEvidencia){idPista, idSuspeito, (uint32_t)peso};
+    }
+    
+    if (caso->suspeitoDaPista[idPista] == SEM_INDICE) caso->numAssociacoes++;
+    caso->suspeitoDaPista[idPista] = caso->evidencias[inicio].suspeito;
+    if (caso->numEvidencias == inicio + 1 && caso->evidencias[inicio].peso == 1) {
+        caso->numEvidencias = inicio;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Cadastra um suspeito com a descrição exibida no julgamento
+ * @param caso Caso em construção
+ * @param nome Nome do suspeito (minúsculas)
+ * @param descricao Texto exibido na lista de suspeitos
+ */
+void declararSuspeito(Caso* caso, const char* nome, const char* descricao) {
+    uint32_t id = internarSuspeito(caso, nome);
+    caso->descricoesSuspeitos[id] = descricao;
+}
+
+/**
+ * @brief Compara dois textos para qsort
+ */
+int compararTextos(const void* a, const void* b) {
+    return strcmp(*(const char* const*)a, *(const char* const*)b);
+}
+
+/**
+ * @brief Renumera as pistas do caso para que a ordem dos IDs seja a ordem
+ *        alfabética dos textos, atualizando salas e associações. Assim o
+ *        caderno ordena pistas comparando apenas inteiros.
+ * @param caso Caso recém-montado
+ */
+void ordenarPistasDoCaso(Caso* caso) {
+    uint32_t quantidade = caso->pistas.quantidade;
+    if (quantidade == 0) return;
+
+    uint32_t* novoId = (uint32_t*)malloc(quantidade * sizeof(uint32_t));
+    uint32_t* suspeitos = (uint32_t*)malloc(caso->capacidadePistas * sizeof(uint32_t));
+    if (novoId == NULL || suspeitos == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+
+    qsort((void*)caso->pistas.textos, quantidade, sizeof(const char*), compararTextos);
+    for (uint32_t i = 0; i < quantidade; i++) {
+        novoId[buscarIdTexto(&caso->pistas, caso->pistas.textos[i])] = i;
+    }
+
+    // Índice de textos e associações passam a usar os novos IDs
+    TabelaHash* indice = &caso->pistas.indice;
+    for (size_t i = 0; i < indice->capacidade; i++) {
+        if (indice->entradas[i].hash != 0) {
+            indice->entradas[i].valor = novoId[indice->entradas[i].valor];
+        }
+    }
+    for (uint32_t i = 0; i < caso->capacidadePistas; i++) suspeitos[i] = SEM_INDICE;
+    for (uint32_t i = 0; i < quantidade; i++) {
+        suspeitos[novoId[i]] = caso->suspeitoDaPista[i];
+    }
+    free(caso->suspeitoDaPista);
+    caso->suspeitoDaPista = suspeitos;
+    for (uint32_t i = 0; i < caso->numEvidencias; i++) {
+        caso->evidencias[i].pista = novoId[caso->evidencias[i].pista];
+    }
+
+    // Salas: um passe sobre a mansão compacta
+    for (uint32_t i = 0; i < caso->mansao.numSalas; i++) {
+        NoMansao* sala = &caso->mansao.nos[i];
+        if (sala->pista != SEM_INDICE) sala->pista = novoId[sala->pista];
+    }
+
+    free(novoId);
+}
+
+/**
+ * @brief Conclui as pistas de um caso montado: renumera pelo índice
+ *        dinâmico ou, se foram internadas pela tabela perfeita, confere a
+ *        tabela (os IDs já estão em ordem alfabética)
+ * @param caso Caso recém-montado
+ * @return 1 em caso de sucesso, 0 se a tabela perfeita não é deste caso
+ */
+int concluirPistasDoCaso(Caso* caso) {
+    if (caso->pistasPerfeitas == NULL) {
+        ordenarPistasDoCaso(caso);
+        return 1;
+    }
+    return conferirTabelaPerfeita(caso, caso->pistasPerfeitas, 1);
+}
+
+/**
+ * @brief Carrega um arquivo de caso, detectando o formato pela assinatura
+ * @param caso Caso a ser preenchido
+ * @param caminho Caminho do arquivo (texto ou binário)
+ * @return 1 em caso de sucesso, 0 em caso de erro
+ */
+int carregarCaso(Caso* caso, const char* caminho) {
+    char assinatura[sizeof(((CabecalhoCaso*)0)->assinatura)] = {0};
+
+    FILE* arquivo = fopen(caminho, "rb");
+    if (arquivo == NULL) {
+        fprintf(stderr, "❌ Não foi possível abrir o caso '%s'\n", caminho);
+        return 0;
+    }
+    size_t lidos = fread(assinatura, 1, sizeof(assinatura), arquivo);
+    fclose(arquivo);
+
+    int sucesso;
+    if (lidos == sizeof(assinatura) &&
+        memcmp(assinatura, ASSINATURA_CASO, sizeof(assinatura)) == 0) {
+        sucesso = carregarCasoBinario(caso, caminho);
+        if (sucesso) associarTabelaPerfeita(caso);
+    } else {
+        sucesso = carregarCasoTexto(caso, caminho, tabelaPerfeitaCompilada());
+    }
+    return sucesso;
+}
+
+/**
+ * @brief Separa o próximo campo de uma linha delimitada por '|'
+ * @param cursor Posição atual na linha; avança para o campo seguinte
+ * @return Início do campo (terminado em '\0') ou NULL se a linha acabou
+ */
+char* proximoCampo(char** cursor) {
+    char* inicio = *cursor;
+    if (inicio == NULL) return NULL;
+
+    char* separador = strchr(inicio, '|');
+    if (separador != NULL) {
+        *separador = '\0';
+        *cursor = separador + 1;
+    } else {
+        *cursor = NULL;
+    }
+    return inicio;
+}
+
+/**
+ * @brief Converte o campo de índice de sala do formato texto
+ * @param campo Texto do campo ("-" indica ausência de sala)
+ * @param numSalas Quantidade de salas do caso
+ * @return Índice da sala, -1 para ausência ou -2 se inválido
+ */
+long lerIndiceSala(const char* campo, long numSalas) {
+    if (strcmp(campo, "-") == 0) return -1;
+
+    char* fim;
+    long indice = strtol(campo, &fim, 10);
+    if (fim == campo || *fim != '\0' || indice < 0 || indice >= numSalas) {
+        return -2;
+    }
+    return indice;
+}
+
+/**
+ * @brief Carrega um caso no formato texto. Cada linha não vazia que não
+ *        começa com '#' é um registro com campos separados por '|':
+ *          sala|<índice>|<nome>|<pista>|<esquerda ou ->|<direita ou ->
+ *          passagem|<índice>|<índice>[|ida]
+ *          pista|<texto da pista>|<suspeito>[*peso][,<suspeito>[*peso]...]
+ *          suspeito|<nome>|<descrição>
+ *          introducao|<texto>
+ *          segredo|<texto>
+ *        A sala 0 é a entrada da mansão. Uma passagem liga dois cômodos
+ *        nos dois sentidos (só no primeiro, com "ida"). O arquivo é lido para um único
+ *        buffer e os textos são separados ali mesmo; só os nomes das salas
+ *        são copiados, para a mansão compacta. Com uma tabela perfeita, as
+ *        pistas são internadas por ela; se a tabela não for deste caso, a
+ *        carga é refeita sem ela.
+ * @param caso Caso a ser preenchido
+ * @param caminho Caminho do arquivo de texto
+ * @param tabela Tabela perfeita esperada (NULL: índice dinâmico)
+ * @return 1 em caso de sucesso, 0 em caso de erro
+ */
+int carregarCasoTexto(Caso* caso, const char* caminho, const TabelaPerfeita* tabela) {
+    memset(caso, 0, sizeof(Caso));
+
+    caso->dados = lerArquivo(caminho, &caso->tamanhoDados);
+    if (caso->dados == NULL) {
+        fprintf(stderr, "❌ Não foi possível ler o caso '%s'\n", caminho);
+        return 0;
+    }
+
+    // 1ª passada: conta os registros para alocar cada estrutura de uma vez
+    long numSalas = 0, numAssociacoes = 0, numSuspeitos = 0, numPassagens = 0;
+    for (char* linha = caso->dados; linha != NULL; ) {
+        if (strncmp(linha, "sala|", 5) == 0) numSalas++;
+        else if (strncmp(linha, "passagem|", 9) == 0) numPassagens++;
+        else if (strncmp(linha, "pista|", 6) == 0) numAssociacoes++;
+        else if (strncmp(linha, "suspeito|", 9) == 0) numSuspeitos++;
+
+        linha = strchr(linha, '\n');
+        if (linha != NULL) linha++;
+    }
+
+    if (numSalas == 0) {
+        fprintf(stderr, "❌ %s: o caso não tem nenhuma sala\n", caminho);
+        liberarCaso(caso);
+        return 0;
+    }
+
+    // As salas são ligadas por ponteiros, na ordem do arquivo, e compiladas
+    // para a mansão compacta no fim
+    char* temPai = (char*)calloc(numSalas, 1);
+    Sala* salas = (Sala*)calloc(numSalas, sizeof(Sala));
+    PassagemSala* passagens = (PassagemSala*)malloc((2 * (size_t)numPassagens + 1) * sizeof(PassagemSala));
+    if (temPai == NULL || salas == NULL || passagens == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    for (long i = 0; i < numSalas; i++) {
+        salas[i].passagens = SEM_INDICE;
+        salas[i].indice = SEM_INDICE;
+    }
+    uint32_t passagensLigadas = 0;
+
+    // Cada sala e cada associação trazem no máximo uma pista nova
+    if (tabela != NULL) prepararCargaPerfeita(caso, tabela);
+    else reservarInternador(&caso->pistas, (uint32_t)(numSalas + numAssociacoes));
+    reservarInternador(&caso->suspeitos, (uint32_t)numSuspeitos + 1);
+
+    // 2ª passada: separa os campos no próprio buffer e liga as estruturas
+    const char* erro = NULL;
+    int numeroLinha = 0;
+    char* proximaLinha = caso->dados;
+
+    while (erro == NULL && proximaLinha != NULL) {
+        char* linha = proximaLinha;
+        numeroLinha++;
+
+        proximaLinha = strchr(linha, '\n');
+        if (proximaLinha != NULL) *proximaLinha++ = '\0';
+        linha[strcspn(linha, "\r")] = '\0';
+
+        if (linha[0] == '\0' || linha[0] == '#') continue;
+
+        char* campos[7];
+        int numCampos = 0;
+        char* cursor = linha;
+        while (numCampos < 7 && (campos[numCampos] = proximoCampo(&cursor)) != NULL) {
+            numCampos++;
+        }
+
+        if (strcmp(campos[0], "sala") == 0) {
+            if (numCampos != 6) { erro = "sala espera 6 campos"; break; }
+
+            long indice = lerIndiceSala(campos[1], numSalas);
+            long esquerda = lerIndiceSala(campos[4], numSalas);
+            long direita = lerIndiceSala(campos[5], numSalas);
+            if (indice < 0 || esquerda == -2 || direita == -2) {
+                erro = "índice de sala inválido";
+                break;
+            }
+
+            Sala* sala = &salas[indice];
+            if (sala->nome != NULL) { erro = "sala definida duas vezes"; break; }
+            sala->nome = campos[2];
+            sala->pista = internarPista(caso, campos[3]);
+
+            long filhos[2] = {esquerda, direita};
+            for (int i = 0; i < 2 && erro == NULL; i++) {
+                if (filhos[i] < 0) continue;
+                if (filhos[i] == 0 || temPai[filhos[i]]) {
+                    erro = "a mansão não forma uma árvore";
+                }
+                temPai[filhos[i]] = 1;
+            }
+            sala->esquerda = esquerda >= 0 ? &salas[esquerda] : NULL;
+            sala->direita = direita >= 0 ? &salas[direita] : NULL;
+        } else if (strcmp(campos[0], "passagem") == 0) {
+            int soIda = numCampos == 4 && strcmp(campos[3], "ida") == 0;
+            if (numCampos != 3 && !soIda) { erro = "passagem espera 3 campos (ou 4, com 'ida')"; break; }
+
+            long extremos[2] = {lerIndiceSala(campos[1], numSalas), lerIndiceSala(campos[2], numSalas)};
+            if (extremos[0] < 0 || extremos[1] < 0 || extremos[0] == extremos[1]) {
+                erro = "passagem inválida";
+                break;
+            }
+            for (int i = 0; i < (soIda ? 1 : 2); i++) {
+                Sala* origem = &salas[extremos[i]];
+                passagens[passagensLigadas].destino = &salas[extremos[1 - i]];
+                passagens[passagensLigadas].proxima = origem->passagens;
+                origem->passagens = passagensLigadas++;
+            }
+        } else if (strcmp(campos[0], "pista") == 0) {
+            if (numCampos != 3) { erro = "pista espera 3 campos"; break; }
+
+            toLowerString(campos[2]);
+            erro = associarEvidencias(caso, campos[1], campos[2]);
+        } else if (strcmp(campos[0], "suspeito") == 0) {
+            if (numCampos != 3) { erro = "suspeito espera 3 campos"; break; }
+
+            toLowerString(campos[1]);
+            declararSuspeito(caso, campos[1], campos[2]);
+        } else if (strcmp(campos[0], "introducao") == 0 && numCampos == 2) {
+            caso->introducao = campos[1];
+        } else if (strcmp(campos[0], "segredo") == 0 && numCampos == 2) {
+            caso->segredo = campos[1];
+        } else {
+            erro = "registro desconhecido";
+        }
+    }
+
+    for (long i = 0; erro == NULL && i < numSalas; i++) {
+        if (salas[i].nome == NULL) {
+            erro = "existem salas sem definição";
+            numeroLinha = 0;
+        }
+    }
+    free(temPai);
+
+    if (erro == NULL && !compilarMansao(&caso->mansao, &salas[0], (uint32_t)numSalas, passagens)) {
+        erro = "as saídas E/D de cômodos alcançados por passagens formam um ciclo";
+        numeroLinha = 0;
+    }
+    free(salas);
+    free(passagens);
+    if (erro != NULL) {
+        fprintf(stderr, "❌ %s:%d: %s\n", caminho, numeroLinha, erro);
+        liberarCaso(caso);
+        return 0;
+    }
+
+    if (!concluirPistasDoCaso(caso)) {
+        liberarCaso(caso);
+        return carregarCasoTexto(caso, caminho, NULL);
+    }
+    concluirEvidencias(caso);
+    return 1;
+}
+
+/**
+ * @brief Carrega um caso no formato binário mapeando o arquivo em memória.
+ *        A mansão compacta é usada direto do mapeamento, sem cópia; a
+ *        tabela de suspeitos é dimensionada uma única vez e os textos
+ *        apontam para o mapeamento.
+ * @param caso Caso a ser preenchido
+ * @param caminho Caminho do arquivo binário
+ * @return 1 em caso de sucesso, 0 em caso de erro
+ */
+int carregarCasoBinario(Caso* caso, const char* caminho) {
+    memset(caso, 0, sizeof(Caso));
+
+    caso->dados = mapearArquivo(caminho, &caso->tamanhoDados, &caso->dadosMapeados);
+    if (caso->dados == NULL) {
+        fprintf(stderr, "❌ Não foi possível mapear o caso '%s'\n", caminho);
+        return 0;
+    }
+
+    const CabecalhoCaso* cabecalho = (const CabecalhoCaso*)caso->dados;
+    const char* erro = caso->tamanhoDados < sizeof(CabecalhoCaso)
+                           ? "assinatura inválida"
+                           : conferirCabecalhoCaso(cabecalho, caso->tamanhoDados);
+    if (erro != NULL) {
+        fprintf(stderr, "❌ %s: %s\n", caminho, erro);
+        liberarCaso(caso);
+        return 0;
+    }
+
+    const NoMansao* nos = (const NoMansao*)(cabecalho + 1);
+    const uint32_t* nomes = (const uint32_t*)(nos + cabecalho->numSalas);
+    const uint32_t* inicioPassagens = nomes + cabecalho->numSalas;
+    const uint32_t* passagens =
+        inicioPassagens + (cabecalho->numPassagens > 0 ? cabecalho->numSalas + 1 : 0);
+    const RegistroPista* regPistas = (const RegistroPista*)(passagens + cabecalho->numPassagens);
+    const RegistroSuspeito* regSuspeitos =
+        (const RegistroSuspeito*)(regPistas + cabecalho->numPistas);
+    const RegistroEvidencia* regEvidencias =
+        (const RegistroEvidencia*)(regSuspeitos + cabecalho->numSuspeitos);
+    const char* textos = (const char*)(regEvidencias + cabecalho->numEvidencias);
+    uint32_t tamanhoTextos = cabecalho->tamanhoTextos;
+    uint32_t numSalas = cabecalho->numSalas;
+    uint32_t numPistas = cabecalho->numPistas;
+
+    if (textos[tamanhoTextos - 1] != '\0') {
+        fprintf(stderr, "❌ %s: bloco de textos sem terminador\n", caminho);
+        liberarCaso(caso);
+        return 0;
+    }
+
+    erro = registrarSuspeitos(caso, regSuspeitos, cabecalho->numSuspeitos, textos, tamanhoTextos);
+    if (erro == NULL) erro = registrarPistas(caso, regPistas, numPistas, textos, tamanhoTextos);
+    if (erro == NULL) erro = registrarEvidencias(caso, regEvidencias, cabecalho->numEvidencias);
+
+    // A mansão só é aceita em ordem de largura, com cada filho depois do
+    // pai e com um único pai: isso garante uma árvore sem ciclos
+    char* temPai = (char*)calloc(numSalas, 1);
+    if (temPai == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    for (uint32_t i = 0; erro == NULL && i < numSalas; i++) {
+        if (nomes[i] >= tamanhoTextos) {
+            erro = "texto de sala fora do arquivo";
+            break;
+        }
+        if (nos[i].pista != SEM_INDICE && nos[i].pista >= numPistas) {
+            erro = "sala aponta para pista inexistente";
+            break;
+        }
+
+        uint32_t filhos[2] = {nos[i].esquerda, nos[i].direita};
+        for (int j = 0; j < 2; j++) {
+            if (filhos[j] == SEM_INDICE) continue;
+            if (filhos[j] >= numSalas || filhos[j] <= i || temPai[filhos[j]]) {
+                erro = "a mansão não forma uma árvore";
+                break;
+            }
+            temPai[filhos[j]] = 1;
+        }
+    }
+    free(temPai);
+    if (erro == NULL && cabecalho->numPassagens > 0) {
+        erro = conferirPassagens(inicioPassagens, passagens, numSalas, cabecalho->numPassagens);
+    }
+
+    if (erro == NULL && cabecalho->introducao != SEM_INDICE) {
+        if (cabecalho->introducao < tamanhoTextos) caso->introducao = textos + cabecalho->introducao;
+        else erro = "introdução fora do arquivo";
+    }
+    if (erro == NULL && cabecalho->segredo != SEM_INDICE) {
+        if (cabecalho->segredo < tamanhoTextos) caso->segredo = textos + cabecalho->segredo;
+        else erro = "segredo fora do arquivo";
+    }
+
+    if (erro != NULL) {
+        fprintf(stderr, "❌ %s: %s\n", caminho, erro);
+        liberarCaso(caso);
+        return 0;
+    }
+
+    // O mapeamento é somente leitura; a mansão nunca é alterada depois da carga
+    concluirEvidencias(caso);
+    caso->mansao.nos = (NoMansao*)nos;
+    caso->mansao.nomes = (uint32_t*)nomes;
+    caso->mansao.textos = textos;
+    caso->mansao.numSalas = numSalas;
+    if (cabecalho->numPassagens > 0) {
+        caso->mansao.inicioPassagens = (uint32_t*)inicioPassagens;
+        caso->mansao.passagens = (uint32_t*)passagens;
+        caso->mansao.numPassagens = cabecalho->numPassagens;
+    }
+    return 1;
+}
+
+/**
+ * @brief Confere assinatura, versão e tamanhos do cabeçalho de um caso binário
+ * @param cabecalho Cabeçalho lido do arquivo
+ * @param tamanhoArquivo Tamanho total do arquivo em bytes
+ * @return NULL se o cabeçalho é válido, ou a descrição do erro
+ */
+const char* conferirCabecalhoCaso(const CabecalhoCaso* cabecalho, uint64_t tamanhoArquivo) {
+    // As seções declaradas devem ocupar exatamente o arquivo
+    uint64_t esperado = sizeof(CabecalhoCaso) + bytesMansaoNoArquivo(cabecalho) +
+                        (uint64_t)cabecalho->numPistas * sizeof(RegistroPista) +
+                        (uint64_t)cabecalho->numSuspeitos * sizeof(RegistroSuspeito) +
+                        (uint64_t)cabecalho->numEvidencias * sizeof(RegistroEvidencia) +
+                        cabecalho->tamanhoTextos;
+
+    if (memcmp(cabecalho->assinatura, ASSINATURA_CASO, sizeof(cabecalho->assinatura)) != 0) {
+        return "assinatura inválida";
+    }
+    if (cabecalho->versao != VERSAO_CASO) return "versão de arquivo não suportada";
+    if (esperado != tamanhoArquivo || cabecalho->numSalas == 0 ||
+        cabecalho->numSalas > INT32_MAX || cabecalho->numPistas >= SEM_INDICE ||
+        cabecalho->numSuspeitos >= SEM_INDICE || cabecalho->tamanhoTextos == 0) {
+        return "arquivo truncado ou corrompido";
+    }
+    return NULL;
+}
+
+/**
+ * @brief Bytes da mansão compacta no arquivo: cômodos, nomes e, se houver, passagens
+ * @param cabecalho Cabeçalho do caso binário
+ * @return Tamanho das seções da mansão
+ */
+uint64_t bytesMansaoNoArquivo(const CabecalhoCaso* cabecalho) {
+    uint64_t bytes = (uint64_t)cabecalho->numSalas * (sizeof(NoMansao) + sizeof(uint32_t));
+    if (cabecalho->numPassagens > 0) {
+        bytes += ((uint64_t)cabecalho->numSalas + 1 + cabecalho->numPassagens) * sizeof(uint32_t);
+    }
+    return bytes;
+}
+
+/**
+ * @brief Confere as passagens de um caso binário: CSR bem formado, destinos
+ *        existentes, em ordem crescente, sem repetição e sem laços
+ * @param inicio Início das passagens de cada cômodo (numSalas + 1 posições)
+ * @param passagens Destinos das passagens
+ * @param numSalas Quantidade de cômodos
+ * @param numPassagens Quantidade de passagens
+ * @return NULL se as passagens são válidas, ou a descrição do erro
+ */
+const char* conferirPassagens(const uint32_t* inicio, const uint32_t* passagens, uint32_t numSalas,
+                              uint32_t numPassagens) {
+    if (inicio[0] != 0 || inicio[numSalas] != numPassagens) return "passagens corrompidas";
+    for (uint32_t i = 0; i < numSalas; i++) {
+        if (inicio[i + 1] < inicio[i] || inicio[i + 1] > numPassagens) return "passagens corrompidas";
+        for (uint32_t k = inicio[i]; k < inicio[i + 1]; k++) {
+            if (passagens[k] >= numSalas || passagens[k] == i ||
+                (k > inicio[i] && passagens[k] <= passagens[k - 1])) {
+                return "passagem para cômodo inválido";
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Monta a tabela de suspeitos a partir dos registros do arquivo
+ * @param caso Caso sendo carregado
+ * @param regSuspeitos Registros dos suspeitos
+ * @param numSuspeitos Quantidade de registros
+ * @param textos Bloco de textos referenciado pelos registros
+ * @param tamanhoTextos Tamanho do bloco de textos
+ * @return NULL em caso de sucesso, ou a descrição do erro
+ */
+const char* registrarSuspeitos(Caso* caso, const RegistroSuspeito* regSuspeitos,
+                              uint32_t numSuspeitos, const char* textos, uint32_t tamanhoTextos) {
+    const char* erro = NULL;
+    caso->descricoesSuspeitos = (const char**)malloc((numSuspeitos + 1) * sizeof(const char*));
+    if (caso->descricoesSuspeitos == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    caso->capacidadeSuspeitos = numSuspeitos + 1;
+
+    reservarInternador(&caso->suspeitos, numSuspeitos);
+    for (uint32_t i = 0; erro == NULL && i < numSuspeitos; i++) {
+        if (regSuspeitos[i].nome >= tamanhoTextos ||
+            regSuspeitos[i].descricao >= tamanhoTextos) {
+            erro = "texto de suspeito fora do arquivo";
+            break;
+        }
+        if (internarTexto(&caso->suspeitos, textos + regSuspeitos[i].nome) != i) {
+            erro = "suspeito repetido";
+            break;
+        }
+        caso->descricoesSuspeitos[i] = textos + regSuspeitos[i].descricao;
+    }
+    return erro;
+}
 
 /**
- * @brief Cria um novo nó para a árvore BST de pistas
- * @param descricao Descrição da pista
- * @return Ponteiro para o nó criado
+ * @brief Monta a tabela de pistas a partir dos registros do arquivo
+ * @param caso Caso sendo carregado, com os suspeitos já registrados
+ * @param regPistas Registros das pistas
+ * @param numPistas Quantidade de registros
+ * @param textos Bloco de textos referenciado pelos registros
+ * @param tamanhoTextos Tamanho do bloco de textos
+ * @return NULL em caso de sucesso, ou a descrição do erro
  */
-PistaBST* criarNoPista(const char* descricao) {
-    PistaBST* novoNo = (PistaBST*)malloc(sizeof(PistaBST));
-    if (novoNo == NULL) {
+const char* registrarPistas(Caso* caso, const RegistroPista* regPistas, uint32_t numPistas,
+                            const char* textos, uint32_t tamanhoTextos) {
+    const char* erro = NULL;
+    caso->suspeitoDaPista = (uint32_t*)malloc((numPistas + 1) * sizeof(uint32_t));
+    if (caso->suspeitoDaPista == NULL) {
         printf("Erro de alocação de memória!\n");
         exit(1);
     }
-    
-    strcpy(novoNo->descricao, descricao);
-    novoNo->esquerda = NULL;
-    novoNo->direita = NULL;
-    
-    return novoNo;
+    caso->capacidadePistas = numPistas + 1;
+
+    // Pistas em ordem estritamente crescente: o ID é a posição do registro.
+    // Ninguém interna pistas novas depois da carga, então a tabela hash é
+    // dispensada e as buscas por texto viram buscas binárias
+    caso->pistas.textos = (const char**)malloc((numPistas + 1) * sizeof(const char*));
+    if (caso->pistas.textos == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
+    caso->pistas.capacidade = numPistas + 1;
+    caso->pistas.somenteOrdenado = 1;
+    for (uint32_t i = 0; erro == NULL && i < numPistas; i++) {
+        const RegistroPista* reg = &regPistas[i];
+        if (reg->texto >= tamanhoTextos) {
+            erro = "texto de pista fora do arquivo";
+            break;
+        }
+        if (reg->suspeito != SEM_INDICE && reg->suspeito >= caso->suspeitos.quantidade) {
+            erro = "pista aponta para suspeito inexistente";
+            break;
+        }
+        const char* texto = textos + reg->texto;
+        if (i > 0 && strcmp(caso->pistas.textos[i - 1], texto) >= 0) {
+            erro = "pistas fora de ordem alfabética";
+            break;
+        }
+        caso->pistas.textos[caso->pistas.quantidade++] = texto;
+        caso->suspeitoDaPista[i] = reg->suspeito;
+        if (reg->suspeito != SEM_INDICE) caso->numAssociacoes++;
+    }
+    return erro;
 }
 
 /**
- * @brief Insere uma pista na árvore BST em ordem alfabética
- * @param raiz Raiz da árvore BST
- * @param descricao Descrição da pista a ser inserida
- * @return Raiz atualizada da árvore
+ * @brief Copia e confere as evidências detalhadas de um caso binário
+ *
+ * Os registros devem vir em ordem estritamente crescente de pista e
+ * suspeito, com pesos válidos; se as pistas já estão registradas, cada
+ * pista com evidências precisa ter entre elas o seu suspeito principal.
+ *
+ * @param caso Caso sendo carregado, com os suspeitos já registrados
+ * @param registros Registros de evidência do arquivo
+ * @param numEvidencias Quantidade de registros
+ * @return NULL em caso de sucesso, ou a descrição do erro
  */
-PistaBST* inserirPista(PistaBST* raiz, const char* descricao) {
-    if (raiz == NULL) {
-        return criarNoPista(descricao);
+const char* registrarEvidencias(Caso* caso, const RegistroEvidencia* registros,
+                                uint32_t numEvidencias) {
+    caso->evidencias = (RegistroEvidencia*)malloc(((size_t)numEvidencias + 1) * sizeof(RegistroEvidencia));
+    if (caso->evidencias == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
     }
+    caso->capacidadeEvidencias = numEvidencias + 1;
     
-    // Compara as descrições para decidir onde inserir
-    int comparacao = strcmp(descricao, raiz->descricao);
-    
-    if (comparacao < 0) {
-        // Inserir na subárvore esquerda
-        raiz->esquerda = inserirPista(raiz->esquerda, descricao);
-    } else if (comparacao > 0) {
-        // Inserir na subárvore direita
-        raiz->direita = inserirPista(raiz->direita, descricao);
-    } else {
-        // Pista duplicada (não insere)
-        printf("⚠️  Pista já coletada!\n");
+    for (uint32_t i = 0; i < numEvidencias; i++) {
+        const RegistroEvidencia* reg = &registros[i];
+        if (reg->pista >= caso->pistas.quantidade || reg->suspeito >= caso->suspeitos.quantidade) {
+            return "evidência aponta para pista ou suspeito inexistente";
+        }
+        if (reg->peso < 1 || reg->peso > MAX_PESO_EVIDENCIA) return "peso de evidência inválido";
+        if (i > 0 && compararEvidencias(&registros[i - 1], reg) >= 0) {
+            return "evidências fora de ordem";
+        }
+        caso->evidencias[caso->numEvidencias++] = *reg;
     }
     
-    return raiz;
+    if (caso->suspeitoDaPista == NULL) return NULL;
+    for (uint32_t i = 0; i < numEvidencias; ) {
+        uint32_t pista = registros[i].pista;
+        int temPrincipal = 0;
+        for (; i < numEvidencias && registros[i].pista == pista; i++) {
+            if (registros[i].suspeito == caso->suspeitoDaPista[pista]) temPrincipal = 1;
+        }
+        if (!temPrincipal) return "evidências sem o suspeito principal da pista";
+    }
+    return NULL;
 }
 
 /**
- * @brief Lista todas as pistas coletadas em ordem alfabética (in-order traversal)
- * @param raiz Raiz da árvore BST de pistas
+ * @brief Ordena pedidos de texto pela posição no bloco do arquivo
  */
-void listarPistasOrdenadas(PistaBST* raiz) {
-    if (raiz == NULL) return;
-    
-    listarPistasOrdenadas(raiz->esquerda);
-    printf("• %s\n", raiz->descricao);
-    listarPistasOrdenadas(raiz->direita);
+int compararPedidosTexto(const void* a, const void* b) {
+    uint32_t origemA = ((const PedidoTexto*)a)->origem;
+    uint32_t origemB = ((const PedidoTexto*)b)->origem;
+    return (origemA > origemB) - (origemA < origemB);
 }
 
+#ifndef _WIN32
 /**
- * @brief Libera a memória alocada para a árvore BST de pistas
- * @param raiz Raiz da árvore BST
+ * @brief Copia textos do bloco do arquivo para a memória numa só passada
+ *
+ * Os pedidos são ordenados pela posição e lidos por uma janela de
+ * TAMANHO_JANELA_TEXTOS bytes que só avança; trechos sem pedidos (os nomes
+ * dos cômodos) nunca são lidos.
+ *
+ * @param fd Descritor do arquivo
+ * @param inicioTextos Posição do bloco de textos no arquivo
+ * @param tamanhoTextos Tamanho do bloco de textos
+ * @param pedidos Textos pedidos; cada destino passa a ser o deslocamento na cópia
+ * @param numPedidos Quantidade de pedidos
+ * @param bloco Recebe a cópia dos textos
+ * @param tamanho Recebe o tamanho da cópia
+ * @return NULL em caso de sucesso, ou a descrição do erro
  */
-void liberarPistas(PistaBST* raiz) {
-    if (raiz == NULL) return;
-    
-    liberarPistas(raiz->esquerda);
-    liberarPistas(raiz->direita);
-    free(raiz);
-}
+const char* copiarTextosDoArquivo(int fd, uint64_t inicioTextos, uint32_t tamanhoTextos,
+                                  PedidoTexto* pedidos, size_t numPedidos, char** bloco,
+                                  size_t* tamanho) {
+    qsort(pedidos, numPedidos, sizeof(PedidoTexto), compararPedidosTexto);
+    char* janela = (char*)malloc(TAMANHO_JANELA_TEXTOS);
+    if (janela == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
+    }
 
-// ========== FUNÇÕES PARA TABELA HASH ==========
+    uint32_t inicioJanela = 0, lidos = 0; // A janela cobre [inicioJanela, inicioJanela + lidos)
+    uint32_t ultimaOrigem = SEM_INDICE, ultimaCopia = SEM_INDICE;
+    size_t capacidade = 0;
+    const char* erro = NULL;
+    for (size_t i = 0; i < numPedidos; i++) {
+        uint32_t origem = pedidos[i].origem;
+        if (origem == ultimaOrigem) {
+            *pedidos[i].destino = ultimaCopia;
+            continue;
+        }
+        if (origem >= tamanhoTextos) {
+            erro = "texto fora do arquivo";
+            break;
+        }
 
-/**
- * @brief Função hash que converte uma string em um índice
- * @param chave String a ser hasheada
- * @return Índice na tabela hash
- */
-unsigned int hash(const char* chave) {
-    unsigned int valor = 0;
-    
-    for (int i = 0; chave[i] != '\0'; i++) {
-        valor = (valor * 31 + chave[i]) % TAMANHO_HASH;
+        // O texto precisa estar inteiro na janela; se não está, ela recomeça nele
+        if (origem < inicioJanela || origem >= inicioJanela + lidos ||
+            memchr(janela + (origem - inicioJanela), '\0', inicioJanela + lidos - origem) == NULL) {
+            inicioJanela = origem;
+            lidos = tamanhoTextos - origem < TAMANHO_JANELA_TEXTOS ? tamanhoTextos - origem
+                                                                   : TAMANHO_JANELA_TEXTOS;
+            if (!lerNoArquivo(fd, janela, lidos, inicioTextos + origem)) {
+                erro = "arquivo truncado ou corrompido";
+                break;
+            }
+            if (memchr(janela, '\0', lidos) == NULL) {
+                erro = "texto sem terminador ou maior que a janela de leitura";
+                break;
+            }
+        }
+
+        ultimaOrigem = origem;
+        ultimaCopia = acrescentarTexto(bloco, tamanho, &capacidade, janela + (origem - inicioJanela));
+        *pedidos[i].destino = ultimaCopia;
     }
-    
-    return valor;
+
+    free(janela);
+    return erro;
 }
+#endif
 
 /**
- * @brief Inicializa a tabela hash
- * @param tabela Ponteiro para a tabela hash
+ * @brief Abre um caso binário sem trazer a mansão para a memória
+ *
+ * Só suspeitos, introdução e segredo são copiados; cômodos e pistas são
+ * lidos com pread quando a sessão chega a eles e ficam numa cache LRU de
+ * tamanho fixo, então a memória usada não depende do tamanho da mansão.
+ * A árvore é conferida cômodo a cômodo, à medida que é lida. Como os
+ * textos das pistas não ficam na memória, não há índice de texto para
+ * pista: o caso serve só ao jogo (sem encontrarSuspeito nem hash perfeito).
+ *
+ * @param caso Caso a ser preenchido
+ * @param caminho Caminho do arquivo binário
+ * @param capacidadeCache Cômodos mantidos na memória
+ * @return 1 em caso de sucesso, 0 em caso de erro
  */
-void inicializarHash(TabelaHash* tabela) {
-    for (int i = 0; i < TAMANHO_HASH; i++) {
-        tabela->tabela[i] = NULL;
+int carregarCasoSobDemanda(Caso* caso, const char* caminho, uint32_t capacidadeCache) {
+    memset(caso, 0, sizeof(Caso));
+#ifndef _WIN32
+    int fd = open(caminho, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "❌ Não foi possível abrir o caso '%s'\n", caminho);
+        return 0;
     }
-}
 
-/**
- * @brief Insere uma associação pista-suspeito na tabela hash
- * @param tabela Ponteiro para a tabela hash
- * @param pista Chave: descrição da pista
- * @param suspeito Valor: nome do suspeito
- */
-void inserirNaHash(TabelaHash* tabela, const char* pista, const char* suspeito) {
-    unsigned int indice = hash(pista);
-    
-    // Cria nova entrada
-    EntradaHash* novaEntrada = (EntradaHash*)malloc(sizeof(EntradaHash));
-    if (novaEntrada == NULL) {
+    CabecalhoCaso cabecalho;
+    struct stat info;
+    const char* erro = NULL;
+    if (fstat(fd, &info) != 0 || !lerNoArquivo(fd, &cabecalho, sizeof(cabecalho), 0)) {
+        erro = "assinatura inválida";
+    } else {
+        erro = conferirCabecalhoCaso(&cabecalho, (uint64_t)info.st_size);
+    }
+    if (erro != NULL) {
+        fprintf(stderr, "❌ %s: %s (o modo sob demanda requer um caso binário)\n", caminho, erro);
+        close(fd);
+        return 0;
+    }
+
+    uint32_t numPistas = cabecalho.numPistas;
+    uint32_t numSuspeitos = cabecalho.numSuspeitos;
+    uint64_t inicioPistas = sizeof(CabecalhoCaso) + bytesMansaoNoArquivo(&cabecalho);
+    uint64_t inicioSuspeitos = inicioPistas + (uint64_t)numPistas * sizeof(RegistroPista);
+    uint64_t inicioEvidencias = inicioSuspeitos + (uint64_t)numSuspeitos * sizeof(RegistroSuspeito);
+    uint64_t inicioTextos = inicioEvidencias +
+                            (uint64_t)cabecalho.numEvidencias * sizeof(RegistroEvidencia);
+    if (numPistas >= CHAVE_PISTA) {
+        fprintf(stderr, "❌ %s: pistas demais para o modo sob demanda\n", caminho);
+        close(fd);
+        return 0;
+    }
+
+    RegistroSuspeito* regSuspeitos =
+        (RegistroSuspeito*)malloc((numSuspeitos + 1) * sizeof(RegistroSuspeito));
+    PedidoTexto* pedidos = (PedidoTexto*)malloc((2 * (size_t)numSuspeitos + 2) * sizeof(PedidoTexto));
+    RegistroPista* lote = (RegistroPista*)malloc(TAMANHO_JANELA_TEXTOS);
+    RegistroEvidencia* regEvidencias =
+        (RegistroEvidencia*)malloc(((size_t)cabecalho.numEvidencias + 1) * sizeof(RegistroEvidencia));
+    uint32_t* totais = (uint32_t*)calloc((size_t)numSuspeitos + 1, sizeof(uint32_t));
+    if (regSuspeitos == NULL || pedidos == NULL || lote == NULL || regEvidencias == NULL ||
+        totais == NULL) {
         printf("Erro de alocação de memória!\n");
         exit(1);
     }
-    
-    strcpy(novaEntrada->pista, pista);
-    strcpy(novaEntrada->suspeito, suspeito);
-    novaEntrada->proximo = NULL;
-    
-    // Verifica se há colisão
-    if (tabela->tabela[indice] == NULL) {
-        // Primeira entrada neste índice
-        tabela->tabela[indice] = novaEntrada;
-    } else {
-        // Encadeamento: insere no início da lista
-        novaEntrada->proximo = tabela->tabela[indice];
-        tabela->tabela[indice] = novaEntrada;
+    if (!lerNoArquivo(fd, regSuspeitos, numSuspeitos * sizeof(RegistroSuspeito), inicioSuspeitos)) {
+        erro = "arquivo truncado ou corrompido";
     }
-}
 
-/**
- * @brief Busca um suspeito associado a uma pista na tabela hash
- * @param tabela Ponteiro para a tabela hash
- * @param pista Pista a ser buscada
- * @return Nome do suspeito ou NULL se não encontrado
- */
-const char* encontrarSuspeito(TabelaHash* tabela, const char* pista) {
-    unsigned int indice = hash(pista);
-    EntradaHash* atual = tabela->tabela[indice];
+    // Só suspeitos, introdução e segredo vêm para a memória; nomes de
+    // cômodos e textos de pistas ficam no arquivo até serem pedidos
+    size_t numPedidos = 0;
+    for (uint32_t i = 0; i < numSuspeitos; i++) {
+        pedidos[numPedidos++] = (PedidoTexto){regSuspeitos[i].nome, &regSuspeitos[i].nome};
+        pedidos[numPedidos++] = (PedidoTexto){regSuspeitos[i].descricao, &regSuspeitos[i].descricao};
+    }
+    if (cabecalho.introducao != SEM_INDICE) {
+        pedidos[numPedidos++] = (PedidoTexto){cabecalho.introducao, &cabecalho.introducao};
+    }
+    if (cabecalho.segredo != SEM_INDICE) {
+        pedidos[numPedidos++] = (PedidoTexto){cabecalho.segredo, &cabecalho.segredo};
+    }
+
+    char* textos = NULL;
+    size_t tamanhoTextos = 0;
+    if (erro == NULL) {
+        erro = copiarTextosDoArquivo(fd, inicioTextos, cabecalho.tamanhoTextos, pedidos, numPedidos,
+                                     &textos, &tamanhoTextos);
+    }
+    caso->dados = textos;
+    caso->tamanhoDados = tamanhoTextos;
+    if (erro == NULL) {
+        erro = registrarSuspeitos(caso, regSuspeitos, numSuspeitos, textos, (uint32_t)tamanhoTextos);
+    }
+    if (erro == NULL) {
+        if (cabecalho.introducao != SEM_INDICE) caso->introducao = textos + cabecalho.introducao;
+        if (cabecalho.segredo != SEM_INDICE) caso->segredo = textos + cabecalho.segredo;
+    }
     
-    // Percorre a lista encadeada neste índice
-    while (atual != NULL) {
-        if (strcmp(atual->pista, pista) == 0) {
-            return atual->suspeito;
+    // As evidências detalhadas são poucas e ficam na memória, para que o
+    // placar não precise ler o arquivo
+    caso->pistas.quantidade = numPistas;
+    if (erro == NULL &&
+        !lerNoArquivo(fd, regEvidencias, cabecalho.numEvidencias * sizeof(RegistroEvidencia),
+                      inicioEvidencias)) {
+        erro = "arquivo truncado ou corrompido";
+    }
+    if (erro == NULL) erro = registrarEvidencias(caso, regEvidencias, cabecalho.numEvidencias);
+
+    // Os registros das pistas são percorridos uma vez, em lotes, só para
+    // conferir os suspeitos, contar as associações e somar a pontuação
+    // máxima; pistas com evidências detalhadas precisam ter o principal
+    // entre elas
+    uint32_t porLote = TAMANHO_JANELA_TEXTOS / sizeof(RegistroPista);
+    uint32_t proximaEvidencia = 0;
+    for (uint32_t inicio = 0; erro == NULL && inicio < numPistas; inicio += porLote) {
+        uint32_t quantidade = numPistas - inicio < porLote ? numPistas - inicio : porLote;
+        if (!lerNoArquivo(fd, lote, quantidade * sizeof(RegistroPista),
+                          inicioPistas + (uint64_t)inicio * sizeof(RegistroPista))) {
+            erro = "arquivo truncado ou corrompido";
+            break;
+        }
+        for (uint32_t i = 0; i < quantidade; i++) {
+            if (lote[i].texto >= cabecalho.tamanhoTextos) {
+                erro = "texto de pista fora do arquivo";
+                break;
+            }
+            if (lote[i].suspeito == SEM_INDICE) continue;
+            if (lote[i].suspeito >= numSuspeitos) {
+                erro = "pista aponta para suspeito inexistente";
+                break;
+            }
+            caso->numAssociacoes++;
+            
+            int detalhada = 0, temPrincipal = 0;
+            for (; proximaEvidencia < caso->numEvidencias &&
+                   caso->evidencias[proximaEvidencia].pista == inicio + i; proximaEvidencia++) {
+                detalhada = 1;
+                if (caso->evidencias[proximaEvidencia].suspeito == lote[i].suspeito) temPrincipal = 1;
+            }
+            if (detalhada && !temPrincipal) {
+                erro = "evidências sem o suspeito principal da pista";
+                break;
+            }
+            if (!detalhada) totais[lote[i].suspeito]++;
         }
-        atual = atual->proximo;
     }
-    
-    return NULL; // Pista não encontrada
-}
+    if (erro == NULL && proximaEvidencia != caso->numEvidencias) {
+        erro = "evidências de pista sem suspeito";
+    }
+    if (erro == NULL) calcularPontuacaoMaxima(caso, totais);
+    caso->pistas.somenteOrdenado = 1;
 
-/**
- * @brief Libera a memória alocada para a tabela hash
- * @param tabela Ponteiro para a tabela hash
- */
-void liberarHash(TabelaHash* tabela) {
-    for (int i = 0; i < TAMANHO_HASH; i++) {
-        EntradaHash* atual = tabela->tabela[i];
-        while (atual != NULL) {
-            EntradaHash* proximo = atual->proximo;
-            free(atual);
-            atual = proximo;
+    // As passagens (4 bytes por cômodo e por passagem) ficam inteiras na
+    // memória, para o comando "ir"; nomes e pistas continuam sob demanda
+    if (erro == NULL && cabecalho.numPassagens > 0) {
+        size_t numInteiros = (size_t)cabecalho.numSalas + 1 + cabecalho.numPassagens;
+        uint32_t* inicioPassagens = (uint32_t*)malloc(numInteiros * sizeof(uint32_t));
+        if (inicioPassagens == NULL) {
+            printf("Erro de alocação de memória!\n");
+            exit(1);
+        }
+        caso->mansao.bloco = inicioPassagens;
+        caso->mansao.inicioPassagens = inicioPassagens;
+        caso->mansao.passagens = inicioPassagens + cabecalho.numSalas + 1;
+        caso->mansao.numPassagens = cabecalho.numPassagens;
+        if (!lerNoArquivo(fd, inicioPassagens, numInteiros * sizeof(uint32_t),
+                          sizeof(CabecalhoCaso) + (uint64_t)cabecalho.numSalas *
+                                                      (sizeof(NoMansao) + sizeof(uint32_t)))) {
+            erro = "arquivo truncado ou corrompido";
+        } else {
+            erro = conferirPassagens(inicioPassagens, caso->mansao.passagens, cabecalho.numSalas,
+                                     cabecalho.numPassagens);
         }
-        tabela->tabela[i] = NULL;
     }
-}
+    free(regSuspeitos);
+    free(pedidos);
+    free(lote);
+    free(regEvidencias);
+    free(totais);
 
-// ========== FUNÇÕES DE JOGO ==========
+    if (erro != NULL) {
+        fprintf(stderr, "❌ %s: %s\n", caminho, erro);
+        close(fd);
+        liberarCaso(caso);
+        return 0;
+    }
 
-/**
- * @brief Coleta uma pista da sala atual e a adiciona às estruturas
- * @param sala Sala atual do jogador
- * @param raizPistas Raiz da árvore BST de pistas
- * @param tabela Tabela hash de associações
- */
-void coletarPista(Sala* sala, PistaBST** raizPistas, TabelaHash* tabela) {
-    printf("\n🔎 COLETANDO PISTA...\n");
-    printf("Pista coletada: %s\n", sala->pista);
-    
-    // Insere na árvore BST
-    *raizPistas = inserirPista(*raizPistas, sala->pista);
-    
-    printf("✅ Pista adicionada ao seu caderno de investigação!\n");
-    
-    // Conta pistas coletadas
-    static int contadorPistas = 0;
-    contadorPistas++;
-    printf("Pistas coletadas até agora: %d\n", contadorPistas);
+    caso->mansao.cache = criarCacheSalas(fd, &cabecalho, capacidadeCache);
+    caso->mansao.numSalas = cabecalho.numSalas;
+    return 1;
+#else
+    (void)capacidadeCache;
+    fprintf(stderr, "❌ O modo sob demanda requer pread (POSIX); abra '%s' sem ele\n", caminho);
+    return 0;
+#endif
 }
 
 /**
- * @brief Conta quantas pistas apontam para um determinado suspeito
- * @param tabela Tabela hash de associações
- * @param suspeito Suspeito a ser verificado
- * @param raizPistas Raiz da árvore BST de pistas
- * @return Número de pistas que apontam para o suspeito
+ * @brief Acrescenta um texto ao bloco de textos do arquivo binário
+ * @param bloco Bloco de textos (realocado conforme necessário)
+ * @param tamanho Bytes já ocupados no bloco
+ * @param capacidade Capacidade atual do bloco
+ * @param texto Texto a ser acrescentado (NULL gera SEM_INDICE)
+ * @return Deslocamento do texto no bloco
  */
-int contarPistasPorSuspeito(TabelaHash* tabela, const char* suspeito, PistaBST* raizPistas) {
-    if (raizPistas == NULL) return 0;
-    
-    int contagem = 0;
-    
-    // Função auxiliar recursiva para percorrer a BST
-    void contarRecursivo(PistaBST* no) {
-        if (no == NULL) return;
-        
-        // Verifica a subárvore esquerda
-        contarRecursivo(no->esquerda);
-        
-        // Verifica o nó atual
-        const char* suspeitoDaPista = encontrarSuspeito(tabela, no->descricao);
-        if (suspeitoDaPista != NULL && strcmp(suspeitoDaPista, suspeito) == 0) {
-            contagem++;
+uint32_t acrescentarTexto(char** bloco, size_t* tamanho, size_t* capacidade,
+                          const char* texto) {
+    if (texto == NULL) return SEM_INDICE;
+
+    size_t comprimento = strlen(texto) + 1;
+    if (*tamanho + comprimento > *capacidade) {
+        while (*tamanho + comprimento > *capacidade) {
+            *capacidade = *capacidade ? *capacidade * 2 : 4096;
+        }
+        *bloco = (char*)realloc(*bloco, *capacidade);
+        if (*bloco == NULL) {
+            printf("Erro de alocação de memória!\n");
+            exit(1);
         }
-        
-        // Verifica a subárvore direita
-        contarRecursivo(no->direita);
     }
-    
-    contarRecursivo(raizPistas);
-    return contagem;
+
+    uint32_t deslocamento = (uint32_t)*tamanho;
+    memcpy(*bloco + *tamanho, texto, comprimento);
+    *tamanho += comprimento;
+    return deslocamento;
 }
 
 /**
- * @brief Conduz à fase final de julgamento e verifica a acusação
- * @param tabela Tabela hash de associações
- * @param raizPistas Raiz da árvore BST de pistas
+ * @brief Grava um caso no formato binário
+ * @param caso Caso a gravar (a mansão compacta vai para o arquivo como está)
+ * @param caminho Caminho do arquivo de saída
+ * @return 1 em caso de sucesso, 0 em caso de erro
  */
-void verificarSuspeitoFinal(TabelaHash* tabela, PistaBST* raizPistas) {
-    printf("\n══════════════════════════════════════════════════════\n");
-    printf("                    FASE FINAL                       \n");
-    printf("                 JULGAMENTO DO CRIME                 \n");
-    printf("══════════════════════════════════════════════════════\n");
-    
-    // Lista as pistas coletadas
-    printf("\n📋 PISTAS COLETADAS (em ordem alfabética):\n");
-    printf("══════════════════════════════════════════════════════\n");
-    
-    if (raizPistas == NULL) {
-        printf("❌ Nenhuma pista coletada! Você não tem evidências suficientes.\n");
-        printf("💀 RESULTADO: Caso arquivado por falta de provas.\n");
-        return;
+int salvarCasoBinario(const Caso* caso, const char* caminho) {
+    uint32_t numPistas = caso->pistas.quantidade;
+    uint32_t numSuspeitos = caso->suspeitos.quantidade;
+    const Mansao* mansao = &caso->mansao;
+    uint32_t* nomes = (uint32_t*)malloc(((size_t)mansao->numSalas + 1) * sizeof(uint32_t));
+    RegistroPista* regPistas = (RegistroPista*)malloc((numPistas + 1) * sizeof(RegistroPista));
+    RegistroSuspeito* regSuspeitos =
+        (RegistroSuspeito*)malloc((numSuspeitos + 1) * sizeof(RegistroSuspeito));
+    if (nomes == NULL || regPistas == NULL || regSuspeitos == NULL) {
+        printf("Erro de alocação de memória!\n");
+        exit(1);
     }
-    
-    listarPistasOrdenadas(raizPistas);
-    
-    // Lista os suspeitos possíveis
-    printf("\n🔎 SUSPEITOS POSSÍVEIS:\n");
-    printf("1. Ana - A herdeira desfavorecida\n");
-    printf("2. Bruno - O mordomo leal\n");
-    printf("3. Carlos - O sócio traído\n");
-    printf("4. Diana - A rival de negócios\n");
-    printf("5. Eduardo - O filho pródigo\n");
-    
-    // Solicita a acusação do jogador
-    printf("\n🕵️  QUEM É O CULPADO?\n");
-    printf("Digite o nome do suspeito (exatamente como listado): ");
-    
-    char acusacao[30];
-    fgets(acusacao, sizeof(acusacao), stdin);
-    acusacao[strcspn(acusacao, "\n")] = '\0'; // Remove newline
-    
-    // Converte para minúsculas para comparação case-insensitive
-    toLowerString(acusacao);
-    
-    // Conta pistas que apontam para o suspeito acusado
-    int pistasParaSuspeito = contarPistasPorSuspeito(tabela, acusacao, raizPistas);
-    
-    printf("\n══════════════════════════════════════════════════════\n");
-    printf("                    VEREDICTO                         \n");
-    printf("══════════════════════════════════════════════════════\n");
-    
-    printf("Suspeito acusado: %s\n", acusacao);
-    printf("Pistas que apontam para %s: %d\n", acusacao, pistasParaSuspeito);
-    
-    // Determina o resultado baseado nas pistas
-    if (pistasParaSuspeito >= 3) {
-        printf("\n🎉 RESULTADO: ACUSAÇÃO SUSTENTADA!\n");
-        printf("✅ O júri aceitou as evidências contra %s!\n", acusacao);
-        printf("🏆 DETETIVE BEM-SUCEDIDO! Caso resolvido com maestria!\n");
-    } else if (pistasParaSuspeito >= 2) {
-        printf("\n⚠️  RESULTADO: ACUSAÇÃO PARCIALMENTE SUSTENTADA\n");
-        printf("📋 Há algumas evidências, mas não são conclusivas.\n");
-        printf("💼 O caso permanece em investigação.\n");
-    } else if (pistasParaSuspeito == 1) {
-        printf("\n❌ RESULTADO: ACUSAÇÃO FRACA\n");
-        printf("📉 Evidências insuficientes para sustentar a acusação.\n");
-        printf("🔍 Continue investigando!\n");
-    } else {
-        printf("\n💀 RESULTADO: ACUSAÇÃO INFUNDADA\n");
-        printf("🚫 Nenhuma pista aponta para %s!\n", acusacao);
-        printf("😞 O verdadeiro culpado escapou da justiça...\n");
+
+    char* textos = NULL;
+    size_t tamanhoTextos = 0, capacidade = 0;
+
+    // Os IDs já estão em ordem alfabética, então basta gravar na ordem dos IDs
+    for (uint32_t i = 0; i < mansao->numSalas; i++) {
+        nomes[i] = acrescentarTexto(&textos, &tamanhoTextos, &capacidade, nomeSala(mansao, i));
     }
-    
-    // Revela o culpado real (para fins educacionais)
-    printf("\n🤫 SEGREDO DO DESENVOLVEDOR:\n");
-    printf("O culpado real do caso é 'Carlos', com 4 pistas contra ele.\n");
-    printf("Para resolver o caso, colete pelo menos 3 pistas!\n");
+    for (uint32_t i = 0; i < numPistas; i++) {
+        regPistas[i].texto = acrescentarTexto(&textos, &tamanhoTextos, &capacidade, caso->pistas.textos[i]);
+        regPistas[i].suspeito = caso->suspeitoDaPista[i];
+    }
+    for (uint32_t i = 0; i < numSuspeitos; i++) {
+        regSuspeitos[i].nome = acrescentarTexto(&textos, &tamanhoTextos, &capacidade, caso->suspeitos.textos[i]);
+        regSuspeitos[i].descricao = acrescentarTexto(&textos, &tamanhoTextos, &capacidade, caso->descricoesSuspeitos[i]);
+    }
+
+    CabecalhoCaso cabecalho;
+    memset(&cabecalho, 0, sizeof(cabecalho));
+    memcpy(cabecalho.assinatura, ASSINATURA_CASO, sizeof(cabecalho.assinatura));
+    cabecalho.versao = VERSAO_CASO;
+    cabecalho.numSalas = mansao->numSalas;
+    cabecalho.numPistas = numPistas;
+    cabecalho.numSuspeitos = numSuspeitos;
+    cabecalho.numEvidencias = caso->numEvidencias;
+    cabecalho.numPassagens = mansao->numPassagens;
+    cabecalho.introducao = acrescentarTexto(&textos, &tamanhoTextos, &capacidade, caso->introducao);
+    cabecalho.segredo = acrescentarTexto(&textos, &tamanhoTextos, &capacidade, caso->segredo);
+    cabecalho.tamanhoTextos = (uint32_t)tamanhoTextos;
+
+    int sucesso = 0;
+    FILE* arquivo = fopen(caminho, "wb");
+    if (arquivo != NULL) {
+        sucesso = fwrite(&cabecalho, sizeof(cabecalho), 1, arquivo) == 1 &&
+                  fwrite(mansao->nos, sizeof(NoMansao), mansao->numSalas, arquivo) == mansao->numSalas &&
+                  fwrite(nomes, sizeof(uint32_t), mansao->numSalas, arquivo) == mansao->numSalas &&
+                  (mansao->numPassagens == 0 ||
+                   (fwrite(mansao->inicioPassagens, sizeof(uint32_t), (size_t)mansao->numSalas + 1,
+                           arquivo) == (size_t)mansao->numSalas + 1 &&
+                    fwrite(mansao->passagens, sizeof(uint32_t), mansao->numPassagens, arquivo) ==
+                        mansao->numPassagens)) &&
+                  fwrite(regPistas, sizeof(RegistroPista), numPistas, arquivo) == numPistas &&
+                  fwrite(regSuspeitos, sizeof(RegistroSuspeito), numSuspeitos, arquivo) == numSuspeitos &&
+                  fwrite(caso->evidencias, sizeof(RegistroEvidencia), caso->numEvidencias,
+                         arquivo) == caso->numEvidencias &&
+                  fwrite(textos, 1, tamanhoTextos, arquivo) == tamanhoTextos;
+        sucesso = (fclose(arquivo) == 0) && sucesso;
+    }
+    if (!sucesso) {
+        fprintf(stderr, "❌ Não foi possível gravar o caso em '%s'\n", caminho);
+    }
+
+    free(nomes);
+    free(regPistas);
+    free(regSuspeitos);
+    free(textos);
+    return sucesso;
+}
+
+/**
+ * @brief Libera todos os recursos de um caso (embutido ou carregado)
+ * @param caso Caso a ser liberado
+ */
+void liberarCaso(Caso* caso) {
+    liberarMansao(&caso->mansao);
+    liberarInternador(&caso->pistas);
+    liberarInternador(&caso->suspeitos);
+    free(caso->suspeitoDaPista);
+    free(caso->evidencias);
+    free((void*)caso->descricoesSuspeitos);
+
+    if (caso->dados != NULL) {
+        desmapearArquivo(caso->dados, caso->tamanhoDados, caso->dadosMapeados);
+    }
+
+    memset(caso, 0, sizeof(Caso));
 }
 
 // ========== FUNÇÕES AUXILIARES ==========
 
 /**
- * @brief Limpa o buffer de entrada
+ * @brief Compara dois textos sem diferenciar maiúsculas (letras ASCII)
+ * @param a Primeiro texto
+ * @param b Segundo texto
+ * @return 1 se são iguais, 0 caso contrário
  */
-void limparBuffer() {
-    int c;
-    while ((c = getchar()) != '\n' && c != EOF);
+int mesmoNomeSemCaixa(const char* a, const char* b) {
+    while (*a != '\0' && tolower((unsigned char)*a) == tolower((unsigned char)*b)) {
+        a++;
+        b++;
+    }
+    return *a == *b;
 }
 
 /**
  * @brief Exibe o título do jogo
+ * @param tela Tela de saída
  */
-void exibirTitulo() {
-    printf("\n╔══════════════════════════════════════════════════════╗\n");
-    printf("║              DETECTIVE QUEST: O MISTÉRIO            ║\n");
-    printf("║               DA MANSÃO BLACKWOOD                  ║\n");
-    printf("╚══════════════════════════════════════════════════════╝\n");
+void exibirTitulo(Tela* tela) {
+    escreverTela(tela, "\n╔══════════════════════════════════════════════════════╗\n");
+    escreverTela(tela, "║              DETECTIVE QUEST: O MISTÉRIO            ║\n");
+    escreverTela(tela, "║               DA MANSÃO BLACKWOOD                  ║\n");
+    escreverTela(tela, "╚══════════════════════════════════════════════════════╝\n");
 }
 
 /**
  * @brief Exibe as instruções do jogo
+ * @param tela Tela de saída
  */
-void exibirInstrucoes() {
-    printf("\n📖 INSTRUÇÕES DO JOGO:\n");
-    printf("══════════════════════════════════════════════════════\n");
-    printf("• Explore a mansão coletando pistas em cada cômodo\n");
-    printf("• Use [E] para ir à esquerda, [D] para direita\n");
-    printf("• Use [C] para coletar a pista do cômodo atual\n");
-    printf("• Use [S] para sair e fazer sua acusação final\n");
-    printf("• Você precisa de pelo menos 3 pistas contra um suspeito\n");
-    printf("  para sustentar uma acusação!\n");
-    printf("══════════════════════════════════════════════════════\n");
+void exibirInstrucoes(Tela* tela) {
+    escreverTela(tela, "\n📖 INSTRUÇÕES DO JOGO:\n");
+    escreverTela(tela, "══════════════════════════════════════════════════════\n");
+    escreverTela(tela, "• Explore a mansão coletando pistas em cada cômodo\n");
+    escreverTela(tela, "• Use [E] para ir à esquerda, [D] para direita\n");
+    escreverTela(tela, "• Use [C] para coletar a pista do cômodo atual\n");
+    escreverTela(tela, "• Use [P] para ver os suspeitos com mais evidências\n");
+    escreverTela(tela, "• Use [B] para buscar por palavra nas pistas coletadas\n");
+    escreverTela(tela, "• Use [S] para sair e fazer sua acusação final\n");
+    escreverTela(tela, "• Você precisa de pelo menos 3 pistas contra um suspeito\n");
+    escreverTela(tela, "  para sustentar uma acusação!\n");
+    escreverTela(tela, "══════════════════════════════════════════════════════\n");
 }
 
 /**
@@ -560,82 +11385,526 @@ void toLowerString(char* str) {
     }
 }
 
+/**
+ * @brief Retorna o tempo de um relógio monotônico, em segundos
+ * @return Segundos desde uma origem arbitrária
+ */
+double agoraEmSegundos() {
+    struct timespec agora;
+    clock_gettime(CLOCK_MONOTONIC, &agora);
+    return agora.tv_sec + agora.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Retorna o tempo do relógio monotônico, em nanossegundos
+ * @return Nanossegundos desde uma origem arbitrária
+ */
+uint64_t agoraEmNanossegundos() {
+    struct timespec agora;
+    clock_gettime(CLOCK_MONOTONIC, &agora);
+    return (uint64_t)agora.tv_sec * 1000000000ull + (uint64_t)agora.tv_nsec;
+}
+
+/**
+ * @brief Lê um arquivo inteiro para um buffer terminado em '\0'
+ * @param caminho Caminho do arquivo
+ * @param tamanho Recebe o tamanho do arquivo em bytes
+ * @return Buffer alocado (liberar com free) ou NULL em caso de erro
+ */
+char* lerArquivo(const char* caminho, size_t* tamanho) {
+    FILE* arquivo = fopen(caminho, "rb");
+    if (arquivo == NULL) return NULL;
+
+    char* dados = NULL;
+    long fim = -1;
+    if (fseek(arquivo, 0, SEEK_END) == 0) fim = ftell(arquivo);
+    if (fim >= 0 && fseek(arquivo, 0, SEEK_SET) == 0) {
+        dados = (char*)malloc((size_t)fim + 1);
+        if (dados == NULL) {
+            printf("Erro de alocação de memória!\n");
+            exit(1);
+        }
+        if (fread(dados, 1, (size_t)fim, arquivo) != (size_t)fim) {
+            free(dados);
+            dados = NULL;
+        } else {
+            dados[fim] = '\0';
+            *tamanho = (size_t)fim;
+        }
+    }
+
+    fclose(arquivo);
+    return dados;
+}
+
+/**
+ * @brief Mapeia um arquivo somente leitura na memória (lê para um buffer
+ *        nas plataformas sem mmap)
+ * @param caminho Caminho do arquivo
+ * @param tamanho Recebe o tamanho do arquivo em bytes
+ * @param mapeado Recebe 1 se o arquivo foi mapeado, 0 se foi lido
+ * @return Início dos dados ou NULL em caso de erro
+ */
+char* mapearArquivo(const char* caminho, size_t* tamanho, int* mapeado) {
+#ifndef _WIN32
+    int fd = open(caminho, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return NULL;
+    }
+
+    void* dados = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (dados == MAP_FAILED) return NULL;
+
+    *tamanho = (size_t)info.st_size;
+    *mapeado = 1;
+    return (char*)dados;
+#else
+    *mapeado = 0;
+    return lerArquivo(caminho, tamanho);
+#endif
+}
+
+/**
+ * @brief Desfaz o mapeamento (ou libera o buffer) de mapearArquivo/lerArquivo
+ * @param dados Início dos dados
+ * @param tamanho Tamanho em bytes
+ * @param mapeado 1 se os dados vieram de mmap
+ */
+void desmapearArquivo(char* dados, size_t tamanho, int mapeado) {
+    if (dados == NULL) return;
+#ifndef _WIN32
+    if (mapeado) {
+        munmap(dados, tamanho);
+        return;
+    }
+#else
+    (void)tamanho;
+    (void)mapeado;
+#endif
+    free(dados);
+}
+
 // ============================================
 // FUNÇÃO PRINCIPAL
 // ============================================
 
-int main() {
-    // Estruturas principais do jogo
-    Sala* mansao = NULL;
-    PistaBST* pistasColetadas = NULL;
-    TabelaHash tabelaHash;
+int main(int argc, char* argv[]) {
+    // Opções globais, antes do modo, em qualquer ordem:
+    // diário de eventos (jogo, --lote e --servidor): --diario <arquivo>
+    // estatísticas de execução: --estatisticas <arquivo|unix:socket>
+    const char* caminhoDiario = NULL;
+    const char* destinoEstatisticas = NULL;
+    while (argc >= 3 && (strcmp(argv[1], "--diario") == 0 ||
+                         strcmp(argv[1], "--estatisticas") == 0)) {
+#ifdef _WIN32
+        fprintf(stderr, strcmp(argv[1], "--diario") == 0
+                            ? "❌ O diário de eventos requer um sistema POSIX\n"
+                            : "❌ As estatísticas de execução requerem um sistema POSIX\n");
+        return 1;
+#endif
+        if (strcmp(argv[1], "--diario") == 0) caminhoDiario = argv[2];
+        else destinoEstatisticas = argv[2];
+        argv[2] = argv[0];
+        argv += 2;
+        argc -= 2;
+    }
+#ifndef _WIN32
+    Diario diario;
+    if (destinoEstatisticas != NULL && !ligarEstatisticas(destinoEstatisticas)) return 1;
+#endif
+    
+    // Modo de conversão: detetive --compilar caso.txt caso.bin
+    if (argc >= 2 && strcmp(argv[1], "--compilar") == 0) {
+        if (argc != 4) {
+            fprintf(stderr, "Uso: %s --compilar <caso.txt> <caso.bin>\n", argv[0]);
+            return 1;
+        }
+        Caso caso;
+        if (!carregarCaso(&caso, argv[2])) return 1;
+        int sucesso = salvarCasoBinario(&caso, argv[3]);
+        if (sucesso) {
+            printf("✅ Caso compilado: %u cômodos, %d associações → %s\n",
+                   caso.mansao.numSalas, caso.numAssociacoes, argv[3]);
+        }
+        liberarCaso(&caso);
+        return sucesso ? 0 : 1;
+    }
+    
+    // Geração do hash perfeito: detetive --gerar-hash <caso|-> caso_hash.h
+    if (argc >= 2 && strcmp(argv[1], "--gerar-hash") == 0) {
+        if (argc != 4) {
+            fprintf(stderr, "Uso: %s --gerar-hash <caso|-> <caso_hash.h>\n", argv[0]);
+            return 1;
+        }
+        Caso caso;
+        if (strcmp(argv[2], "-") == 0) construirCasoPadrao(&caso);
+        else if (!carregarCaso(&caso, argv[2])) return 1;
+        int sucesso = gerarHashPerfeito(&caso, strcmp(argv[2], "-") == 0 ? "embutido" : argv[2],
+                                        argv[3]);
+        liberarCaso(&caso);
+        return sucesso ? 0 : 1;
+    }
+    
+    // Modo em lote: detetive --lote roteiros.txt <caso|-> [repetições]
+    if (argc >= 2 && strcmp(argv[1], "--lote") == 0) {
+        if (argc < 4 || argc > 5) {
+            fprintf(stderr, "Uso: %s --lote <roteiros.txt> <caso|-> [repetições]\n", argv[0]);
+            return 1;
+        }
+        long repeticoes = argc == 5 ? strtol(argv[4], NULL, 10) : 1;
+        if (repeticoes < 1) repeticoes = 1;
+        
+        Caso caso;
+        if (strcmp(argv[3], "-") == 0) construirCasoPadrao(&caso);
+        else if (!carregarCaso(&caso, argv[3])) return 1;
+#ifndef _WIN32
+        // Sem espera pelo disco: o lote confirma só os grupos cheios e no fim
+        if (caminhoDiario != NULL && !abrirDiario(&diario, caminhoDiario, &caso, 0)) return 1;
+        int sucesso = executarLote(&caso, argv[2], repeticoes, caminhoDiario ? &diario : NULL);
+        if (caminhoDiario != NULL) {
+            fecharDiario(&diario);
+            printf("# diário: %llu registros em %llu gravações\n",
+                   (unsigned long long)diario.gravados, diario.grupos);
+        }
+#else
+        int sucesso = executarLote(&caso, argv[2], repeticoes, NULL);
+#endif
+        liberarCaso(&caso);
+        return sucesso ? 0 : 1;
+    }
+
+    // Modo de geração: detetive --gerar <salas> caso.txt [--corredores]
+    if (argc >= 2 && strcmp(argv[1], "--gerar") == 0) {
+        int corredores = argc == 5 && strcmp(argv[4], "--corredores") == 0;
+        long numSalas = argc == 4 || corredores ? strtol(argv[2], NULL, 10) : 0;
+        if (numSalas < 1 || numSalas > INT32_MAX) {
+            fprintf(stderr, "Uso: %s --gerar <salas> <caso.txt> [--corredores]\n", argv[0]);
+            return 1;
+        }
+        Caso caso;
+        gerarCasoSintetico(&caso, (uint32_t)numSalas, 1, corredores);
+        int sucesso = salvarCasoTexto(&caso, argv[3]);
+        liberarCaso(&caso);
+        return sucesso ? 0 : 1;
+    }
+    
+    // Modo benchmark: detetive --bench [csv|json] [salas...]
+    if (argc >= 2 && strcmp(argv[1], "--bench") == 0) {
+        FormatoBench formato = FORMATO_CSV;
+        int primeiro = 2;
+        if (argc > 2 && (strcmp(argv[2], "csv") == 0 || strcmp(argv[2], "json") == 0)) {
+            formato = strcmp(argv[2], "json") == 0 ? FORMATO_JSON : FORMATO_CSV;
+            primeiro = 3;
+        }
+        
+        uint32_t tamanhos[32] = {10, 1000, 100000, 1000000};
+        int numTamanhos = 4;
+        if (argc > primeiro) {
+            numTamanhos = 0;
+            for (int i = primeiro; i < argc && numTamanhos < 32; i++) {
+                long salas = strtol(argv[i], NULL, 10);
+                if (salas < 1 || salas > INT32_MAX) {
+                    fprintf(stderr, "❌ Tamanho inválido: %s\n", argv[i]);
+                    return 1;
+                }
+                tamanhos[numTamanhos++] = (uint32_t)salas;
+            }
+        }
+        return executarBench(formato, tamanhos, numTamanhos) ? 0 : 1;
+    }
     
-    // Configuração inicial
-    exibirTitulo();
-    exibirInstrucoes();
+#ifndef _WIN32
+    // Teste do caderno da equipe: detetive --testar-equipe [salas] [escritores] [pistas]
+    if (argc >= 2 && strcmp(argv[1], "--testar-equipe") == 0) {
+        long salas = argc > 2 ? strtol(argv[2], NULL, 10) : 20000;
+        long escritores = argc > 3 ? strtol(argv[3], NULL, 10) : 8;
+        long pistas = argc > 4 ? strtol(argv[4], NULL, 10) : 20000;
+        if (argc > 5 || salas < 1 || salas > INT32_MAX || escritores < 1 ||
+            escritores > MAX_THREADS_BENCH_EQUIPE || pistas < 1 || pistas > INT32_MAX) {
+            fprintf(stderr, "Uso: %s --testar-equipe [salas] [escritores (1 a %d)] [pistas por escritor]\n",
+                    argv[0], MAX_THREADS_BENCH_EQUIPE);
+            return 1;
+        }
+        return testarCadernoCompartilhado((uint32_t)salas, (int)escritores, (uint32_t)pistas) ? 0 : 1;
+    }
+#endif
+
+    // Modo resolvedor: detetive --resolver <caso|-> [buscadores]
+    if (argc >= 2 && strcmp(argv[1], "--resolver") == 0) {
+        if (argc < 3 || argc > 4) {
+            fprintf(stderr, "Uso: %s --resolver <caso|-> [buscadores]\n", argv[0]);
+            return 1;
+        }
+        int numBuscadores = argc == 4 ? atoi(argv[3]) : TRABALHADORES_PADRAO;
+        if (numBuscadores < 1) numBuscadores = 1;
+
+        Caso caso;
+        if (strcmp(argv[2], "-") == 0) construirCasoPadrao(&caso);
+        else if (!carregarCaso(&caso, argv[2])) return 1;
+        int sucesso = resolverCaso(&caso, numBuscadores);
+        liberarCaso(&caso);
+        return sucesso ? 0 : 1;
+    }
     
-    printf("\n🔨 CONSTRUINDO O CENÁRIO DO CRIME...\n");
+    // Repetição de um diário: detetive --repetir <diario> <caso|-> [sessão]
+    if (argc >= 2 && strcmp(argv[1], "--repetir") == 0) {
+        if (argc < 4 || argc > 5) {
+            fprintf(stderr, "Uso: %s --repetir <diário> <caso|-> [sessão]\n", argv[0]);
+            return 1;
+        }
+        long sessaoEscolhida = argc == 5 ? strtol(argv[4], NULL, 10) : -1;
+        if (argc == 5 && (sessaoEscolhida < 0 || sessaoEscolhida > (long)UINT32_MAX)) {
+            fprintf(stderr, "❌ Sessão inválida: %s\n", argv[4]);
+            return 1;
+        }
+        
+        Caso caso;
+        if (strcmp(argv[3], "-") == 0) construirCasoPadrao(&caso);
+        else if (!carregarCaso(&caso, argv[3])) return 1;
+        int sucesso = repetirDiario(&caso, argv[2], sessaoEscolhida);
+        liberarCaso(&caso);
+        return sucesso ? 0 : 1;
+    }
     
-    // 1. Constrói a mansão (árvore binária)
-    construirMansao(&mansao);
+    // Modo simulador: detetive --simular <caso|-> [passeios] [threads] [semente]
+    if (argc >= 2 && strcmp(argv[1], "--simular") == 0) {
+        if (argc < 3 || argc > 6) {
+            fprintf(stderr, "Uso: %s --simular <caso|-> [passeios] [threads] [semente]\n",
+                    argv[0]);
+            return 1;
+        }
+        unsigned long long numPasseios = argc >= 4 ? strtoull(argv[3], NULL, 10)
+                                                   : PASSEIOS_PADRAO;
+        int numThreads = argc >= 5 ? atoi(argv[4]) : TRABALHADORES_PADRAO;
+        uint64_t semente = argc == 6 ? strtoull(argv[5], NULL, 10) : 1;
+        if (numPasseios < 1) numPasseios = 1;
+        if (numThreads < 1) numThreads = 1;
+
+        Caso caso;
+        if (strcmp(argv[2], "-") == 0) construirCasoPadrao(&caso);
+        else if (!carregarCaso(&caso, argv[2])) return 1;
+        int sucesso = simularJogadores(&caso, numPasseios, numThreads, semente);
+        liberarCaso(&caso);
+        return sucesso ? 0 : 1;
+    }
     
-    // 2. Inicializa a tabela hash
-    inicializarHash(&tabelaHash);
+    // Modo hipóteses: detetive --hipoteses <caso|-> <instantâneo>...
+    if (argc >= 2 && strcmp(argv[1], "--hipoteses") == 0) {
+        if (argc < 4) {
+            fprintf(stderr, "Uso: %s --hipoteses <caso|-> <instantâneo> [instantâneo...]\n",
+                    argv[0]);
+            return 1;
+        }
+        
+        Caso caso;
+        if (strcmp(argv[2], "-") == 0) construirCasoPadrao(&caso);
+        else if (!carregarCaso(&caso, argv[2])) return 1;
+        int sucesso = executarHipoteses(&caso, argv + 3, argc - 3);
+        liberarCaso(&caso);
+        return sucesso ? 0 : 1;
+    }
     
-    // 3. Preenche a tabela hash com associações pista-suspeito
-    printf("\n🔗 ESTABELECENDO CONEXÕES ENTRE PISTAS E SUSPEITOS...\n");
+    // Modo servidor: detetive --servidor <caso|-> <socket> [trabalhadores] [--cooperativo]
+    if (argc >= 2 && strcmp(argv[1], "--servidor") == 0) {
+#ifndef _WIN32
+        int cooperativo = argc >= 5 && strcmp(argv[argc - 1], "--cooperativo") == 0;
+        int numArgumentos = argc - cooperativo;
+        if (numArgumentos < 4 || numArgumentos > 5) {
+            fprintf(stderr, "Uso: %s --servidor <caso|-> <socket> [trabalhadores] [--cooperativo]\n",
+                    argv[0]);
+            return 1;
+        }
+        int numTrabalhadores = numArgumentos == 5 ? atoi(argv[4]) : TRABALHADORES_PADRAO;
+        if (numTrabalhadores < 1) numTrabalhadores = 1;
+        
+        Caso caso;
+        if (strcmp(argv[2], "-") == 0) construirCasoPadrao(&caso);
+        else if (!carregarCaso(&caso, argv[2])) return 1;
+        if (caminhoDiario != NULL && !abrirDiario(&diario, caminhoDiario, &caso, 1)) return 1;
+        int sucesso = executarServidor(&caso, argv[3], numTrabalhadores,
+                                       caminhoDiario ? &diario : NULL, cooperativo);
+        if (caminhoDiario != NULL) {
+            fecharDiario(&diario);
+            printf("📓 Diário: %llu registros em %llu gravações\n",
+                   (unsigned long long)diario.gravados, diario.grupos);
+        }
+        liberarCaso(&caso);
+        return sucesso ? 0 : 1;
+#else
+        fprintf(stderr, "❌ O modo servidor requer sockets Unix e pthreads\n");
+        return 1;
+#endif
+    }
     
-    // Associações pré-definidas (pista → suspeito)
-    inserirNaHash(&tabelaHash, 
-        "Uma carta rasgada com a assinatura 'A' parcialmente visível", 
-        "ana");
-    inserirNaHash(&tabelaHash, 
-        "Um livro sobre venenos com a página 13 marcada", 
-        "diana");
-    inserirNaHash(&tabelaHash, 
-        "Um copo quebrado com resíduos de um líquido roxo", 
-        "bruno");
-    inserirNaHash(&tabelaHash, 
-        "Extrato bancário mostrando uma grande transferência para 'Carlos'", 
-        "carlos");
-    inserirNaHash(&tabelaHash, 
-        "Uma luva de jardinagem manchada de terra vermelha", 
-        "bruno");
-    inserirNaHash(&tabelaHash, 
-        "Uma faca de chef ausente do estojo", 
-        "carlos");
-    inserirNaHash(&tabelaHash, 
-        "Um diário com a entrada do dia do crime apagada", 
-        "eduardo");
-    inserirNaHash(&tabelaHash, 
-        "Uma caixa com documentos antigos sobre herança familiar", 
-        "ana");
-    inserirNaHash(&tabelaHash, 
-        "Pegadas de sapato masculino tamanho 42 na lama", 
-        "carlos");
-    inserirNaHash(&tabelaHash, 
-        "Uma chave enferrujada com a inscrição 'Porão Secreto'", 
-        "carlos");
+    // Anfitrião de partidas: detetive --anfitriao <caso|-> <socket> [--json]
+    if (argc >= 2 && strcmp(argv[1], "--anfitriao") == 0) {
+#ifdef __linux__
+        int json = argc == 5 && strcmp(argv[4], "--json") == 0;
+        if (argc != 4 && !json) {
+            fprintf(stderr, "Uso: %s --anfitriao <caso|-> <socket> [--json]\n", argv[0]);
+            return 1;
+        }
+        if (caminhoDiario != NULL) {
+            fprintf(stderr, "❌ O anfitrião de partidas não grava diário\n");
+            return 1;
+        }
+        
+        Caso caso;
+        if (strcmp(argv[2], "-") == 0) construirCasoPadrao(&caso);
+        else if (!carregarCaso(&caso, argv[2])) return 1;
+        int sucesso = executarAnfitriao(&caso, argv[3], json ? SAIDA_JSON : SAIDA_NORMAL);
+        liberarCaso(&caso);
+        return sucesso ? 0 : 1;
+#else
+        fprintf(stderr, "❌ O anfitrião de partidas requer epoll (Linux)\n");
+        return 1;
+#endif
+    }
+
+    // Modo de saída do jogo: --json (uma linha por turno) ou --silencioso
+    ModoSaida modo = SAIDA_NORMAL;
+    if (argc >= 2 && (strcmp(argv[1], "--json") == 0 || strcmp(argv[1], "--silencioso") == 0)) {
+        modo = strcmp(argv[1], "--json") == 0 ? SAIDA_JSON : SAIDA_SILENCIOSA;
+        argv++;
+        argc--;
+    }
+    
+    // Sessão guardada e retomada: --guardar <arquivo> (o comando G grava nele)
+    const char* caminhoInstantaneo = NULL;
+    if (argc >= 3 && strcmp(argv[1], "--guardar") == 0) {
+        if (caminhoDiario != NULL) {
+            fprintf(stderr, "❌ Sessões retomadas não podem ser gravadas no diário\n");
+            return 1;
+        }
+        caminhoInstantaneo = argv[2];
+        argv[2] = argv[0];
+        argv += 2;
+        argc -= 2;
+    }
+    
+    // Mansão lida do arquivo à medida que é visitada: --sob-demanda caso.caso
+    int sobDemanda = 0;
+    if (argc >= 2 && strcmp(argv[1], "--sob-demanda") == 0) {
+        if (argc != 3) {
+            fprintf(stderr, "Uso: %s [--json|--silencioso] [--guardar <arquivo>] --sob-demanda <caso.caso>\n",
+                    argv[0]);
+            return 1;
+        }
+        sobDemanda = 1;
+        argv++;
+        argc--;
+    }
+
+    // Estruturas principais do jogo
+    Caso caso;
+    Sessao sessao;
+    Tela tela;
+    Entrada entrada;
+    inicializarTela(&tela, modo);
+    inicializarEntrada(&entrada);
+    
+    // Configuração inicial (só no modo normal; os outros modos não narram)
+    int narrar = modo == SAIDA_NORMAL;
+    if (narrar) {
+        exibirTitulo(&tela);
+        exibirInstrucoes(&tela);
+        escreverTela(&tela, "\n🔨 CONSTRUINDO O CENÁRIO DO CRIME...\n");
+        descarregarTela(&tela);
+    }
     
-    printf("✅ Conexões estabelecidas! Tabela hash pronta.\n");
+    if (argc >= 2) {
+        // Caso carregado de arquivo (texto ou binário)
+        double inicio = agoraEmSegundos();
+        if (sobDemanda) {
+            if (!carregarCasoSobDemanda(&caso, argv[1], CAPACIDADE_CACHE_SALAS)) return 1;
+        } else if (!carregarCaso(&caso, argv[1])) {
+            return 1;
+        }
+        if (narrar) {
+            escreverTela(&tela, "✅ Caso '%s' carregado: %u cômodos e %d associações em %.2f ms\n",
+                         argv[1], caso.mansao.numSalas, caso.numAssociacoes,
+                         (agoraEmSegundos() - inicio) * 1000.0);
+        }
+    } else {
+        // Caso embutido da Mansão Blackwood (construído sem imprimir nada,
+        // para servir também ao modo em lote)
+        construirCasoPadrao(&caso);
+        if (narrar) {
+            escreverTela(&tela, "✅ Mansão construída com 10 cômodos misteriosos!\n");
+            escreverTela(&tela, "\n🔗 ESTABELECENDO CONEXÕES ENTRE PISTAS E SUSPEITOS...\n");
+            escreverTela(&tela, "✅ Conexões estabelecidas! Tabela hash pronta.\n");
+        }
+    }
+    
+    if (narrar && caso.pistasPerfeitas != NULL) {
+        escreverTela(&tela, "⚡ Hash perfeito compilado ligado ao caso (%u pistas)\n",
+                     caso.pistasPerfeitas->numPistas);
+    }
+    if (narrar) {
+        escreverTela(&tela, "\n🚪 ADENTRANDO A MANSÃO BLACKWOOD...\n");
+        if (caso.introducao != NULL) {
+            escreverTela(&tela, "%s\n", caso.introducao);
+        }
+    }
     
-    printf("\n🚪 ADENTRANDO A MANSÃO BLACKWOOD...\n");
-    printf("O corpo foi encontrado na biblioteca. Boa sorte, detetive!\n");
+    // 4. Inicia a exploração da mansão (ou retoma a investigação guardada)
+    iniciarSessao(&sessao, &caso);
+    if (caminhoInstantaneo != NULL) {
+        FILE* existente = fopen(caminhoInstantaneo, "rb");
+        if (existente != NULL) {
+            fclose(existente);
+            if (!carregarInstantaneo(&sessao, caminhoInstantaneo)) {
+                liberarSessao(&sessao);
+                liberarCaso(&caso);
+                liberarTela(&tela);
+                return 1;
+            }
+            if (narrar) {
+                escreverTela(&tela, "\n💾 Investigação retomada de '%s': %zu pistas, em %s\n",
+                             caminhoInstantaneo, sessao.caderno.quantidade,
+                             nomeSala(&caso.mansao, sessao.salaAtual));
+            }
+        }
+        if (narrar) {
+            escreverTela(&tela, "💾 Digite G para guardar a investigação e continuar depois.\n");
+        }
+    }
+#ifndef _WIN32
+    if (caminhoDiario != NULL) {
+        if (!abrirDiario(&diario, caminhoDiario, &caso, 1)) return 1;
+        ligarDiario(&sessao, &diario);
+    }
+#endif
     
-    // 4. Inicia a exploração da mansão
-    explorarMansao(mansao, &pistasColetadas, &tabelaHash);
+    // 5. Exploração e fase final de julgamento, uma linha do jogador por vez
+    int guardada = jogarPartida(&sessao, &tela, &entrada, caminhoInstantaneo);
     
-    // 5. Fase final de julgamento
-    verificarSuspeitoFinal(&tabelaHash, pistasColetadas);
+    // Caso julgado: a próxima partida com --guardar começa do zero
+    if (caminhoInstantaneo != NULL && !guardada) remove(caminhoInstantaneo);
     
     // 6. Limpeza de memória
-    printf("\n🧹 FINALIZANDO O JOGO E LIBERANDO RECURSOS...\n");
-    liberarMansao(mansao);
-    liberarPistas(pistasColetadas);
-    liberarHash(&tabelaHash);
-    
-    printf("\n🎬 FIM DO DETECTIVE QUEST!\n");
-    printf("Obrigado por jogar! 🕵️‍♂️\n\n");
+    if (narrar) {
+        escreverTela(&tela, "\n🧹 FINALIZANDO O JOGO E LIBERANDO RECURSOS...\n");
+        exibirMemoriaSessao(&tela, &sessao.memoria);
+#ifndef _WIN32
+        if (caso.mansao.cache != NULL) exibirCacheSalas(&tela, caso.mansao.cache);
+#endif
+        escreverTela(&tela, "\n🎬 FIM DO DETECTIVE QUEST!\n");
+        escreverTela(&tela, "Obrigado por jogar! 🕵️‍♂️\n\n");
+        descarregarTela(&tela);
+    }
+    liberarSessao(&sessao);
+#ifndef _WIN32
+    if (caminhoDiario != NULL) fecharDiario(&diario);
+#endif
+    liberarCaso(&caso);
+    liberarTela(&tela);
+    liberarEntrada(&entrada);
     
     return 0;
-}
\ No newline at end of file
+}